@@ -1174,7 +1174,6 @@ protected:
     QString iconFromDesktopFile() const;
 
     void loadGioDesktopFileName();
-    QString iconFromGioDesktopFile() const;
 
     void updateApplicationMenuServiceName(const QString &serviceName);
     void updateApplicationMenuObjectPath(const QString &objectPath);
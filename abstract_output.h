@@ -129,6 +129,13 @@ public:
         return false;
     }
     virtual const ColorCorrect::GammaRamp* getGammaRamp();
+    /**
+     * Whether a ramp passed to setGammaRamp goes out within the atomic commit of the next
+     * presented frame instead of being applied on its own.
+     **/
+    virtual bool presentsGammaRampWithFrame() const {
+        return false;
+    }
 
     virtual void updateEnablement(bool enable) {
         Q_UNUSED(enable);
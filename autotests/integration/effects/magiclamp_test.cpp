@@ -0,0 +1,89 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "effects.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "effect_builtins.h"
+
+#include <KConfigGroup>
+
+using namespace KWin;
+static const QString s_socketName = QStringLiteral("wayland_test_effects_magiclamp-0");
+
+class MagicLampTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testDeformationShader();
+};
+
+void MagicLampTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Effect*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    qputenv("KWIN_EFFECTS_FORCE_ANIMATIONS", "1");
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QCOMPARE(scene->compositingType(), KWin::OpenGL2Compositing);
+}
+
+void MagicLampTest::cleanup()
+{
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl*>(effects);
+    while (!e->loadedEffects().isEmpty()) {
+        const QString effect = e->loadedEffects().first();
+        e->unloadEffect(effect);
+        QVERIFY(!e->isEffectLoaded(effect));
+    }
+}
+
+void MagicLampTest::testDeformationShader()
+{
+    // the deformation snippet gets pasted into the generated vertex shader, it must not
+    // redeclare anything of it, otherwise every window falls back to the CPU deformation
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl*>(effects);
+    const QString name = BuiltInEffects::nameForEffect(BuiltInEffect::MagicLamp);
+    QVERIFY(e->loadEffect(name));
+    Effect *effect = e->findEffect(name);
+    QVERIFY(effect);
+
+    QVERIFY(effects->makeOpenGLContextCurrent());
+    bool deformsOnGpu = false;
+    QVERIFY(QMetaObject::invokeMethod(effect, "deformsOnGpu", Qt::DirectConnection, Q_RETURN_ARG(bool, deformsOnGpu)));
+    QVERIFY(deformsOnGpu);
+}
+
+WAYLANDTEST_MAIN(MagicLampTest)
+#include "magiclamp_test.moc"
@@ -28,6 +28,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "effect_builtins.h"
 
 #include <KConfigGroup>
+
+#include <KWayland/Client/subcompositor.h>
+#include <KWayland/Client/subsurface.h>
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
 using namespace KWin;
 static const QString s_socketName = QStringLiteral("wayland_test_kwin_scene_opengl-0");
 
@@ -114,3 +119,61 @@ void GenericSceneOpenGLTest::testRestart()
     QTest::qWait(100);
     testPrintlog();
 }
+
+void GenericSceneOpenGLTest::testFrameCounters()
+{
+    // every window painted in a frame costs at least one draw call
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<KWayland::Client::XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    auto client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+
+    auto scene = KWin::Compositor::self()->scene();
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    KWin::Compositor::self()->addRepaintFull();
+    // the spy returns to the test once the whole frame is painted and the counters published
+    QVERIFY(frameRenderedSpy.wait());
+
+    const Scene::FrameCounters counters = scene->frameCounters();
+    QVERIFY(counters.windows >= 1);
+    QVERIFY(counters.drawCalls >= counters.windows);
+    testPrintlog();
+}
+
+void GenericSceneOpenGLTest::testFrameCountersSubSurface()
+{
+    // a sub-surface is uploaded with its window and drawn with its shader, it costs one draw call
+    QVERIFY(Test::setupWaylandConnection(Test::AdditionalWaylandInterface::SubCompositor));
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<KWayland::Client::XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    auto client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+
+    auto scene = KWin::Compositor::self()->scene();
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    KWin::Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    const Scene::FrameCounters withoutSubSurface = scene->frameCounters();
+
+    QScopedPointer<KWayland::Client::Surface> childSurface(Test::createSurface());
+    QScopedPointer<KWayland::Client::SubSurface> subSurface(Test::waylandSubCompositor()->createSubSurface(childSurface.data(), surface.data()));
+    QVERIFY(subSurface->isValid());
+    subSurface->setPosition(QPoint(10, 10));
+    QSignalSpy damagedSpy(client, &Toplevel::damaged);
+    QVERIFY(damagedSpy.isValid());
+    Test::render(childSurface.data(), QSize(20, 20), Qt::red);
+    // the sub-surface is synchronized, it shows up with the next commit of its parent
+    Test::render(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(damagedSpy.wait());
+
+    frameRenderedSpy.clear();
+    KWin::Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    const Scene::FrameCounters withSubSurface = scene->frameCounters();
+    QCOMPARE(withSubSurface.windows, withoutSubSurface.windows);
+    QCOMPARE(withSubSurface.drawCalls, withoutSubSurface.drawCalls + 1);
+    testPrintlog();
+}
@@ -34,6 +34,8 @@ private Q_SLOTS:
     void cleanup();
     void testRestart_data();
     void testRestart();
+    void testFrameCounters();
+    void testFrameCountersSubSurface();
 
 private:
     QByteArray m_envVariable;
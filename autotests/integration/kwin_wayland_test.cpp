@@ -11,28 +11,21 @@
 #include "../../wayland_server.h"
 #include "../../workspace.h"
 #include "../../xcbutils.h"
+#include "../../xwl/xwayland.h"
 
 #include <KPluginMetaData>
 
-#include <QAbstractEventDispatcher>
 #include <QPluginLoader>
-#include <QSocketNotifier>
 #include <QStyle>
-#include <QThread>
-#include <QtConcurrentRun>
 
 // system
-#include <unistd.h>
-#include <sys/socket.h>
 #include <iostream>
 
 namespace KWin
 {
 
-static void readDisplay(int pipe);
-
 WaylandTestApplication::WaylandTestApplication(OperationMode mode, int &argc, char **argv)
-    : Application(mode, argc, argv)
+    : ApplicationWaylandAbstract(mode, argc, argv)
 {
     QStandardPaths::setTestModeEnabled(true);
     // TODO: add a test move to kglobalaccel instead?
@@ -70,26 +63,18 @@ WaylandTestApplication::~WaylandTestApplication()
     if (effects) {
         static_cast<EffectsHandlerImpl*>(effects)->unloadAllEffects();
     }
+    if (m_xwayland) {
+        // needs to be done before workspace gets destroyed
+        m_xwayland->prepareDestroy();
+    }
     destroyWorkspace();
     waylandServer()->dispatch();
-    disconnect(m_xwaylandFailConnection);
-    if (x11Connection()) {
-        Xcb::setInputFocus(XCB_INPUT_FOCUS_POINTER_ROOT);
-        destroyAtoms();
-        emit x11ConnectionAboutToBeDestroyed();
-        xcb_disconnect(x11Connection());
-        setX11Connection(nullptr);
-    }
-    if (m_xwaylandProcess) {
-        m_xwaylandProcess->terminate();
-        while (m_xwaylandProcess->state() != QProcess::NotRunning) {
-            processEvents(QEventLoop::WaitForMoreEvents);
-        }
-        waylandServer()->destroyXWaylandConnection();
-    }
     if (QStyle *s = style()) {
         s->unpolish(this);
     }
+    // kill Xwayland before terminating its connection
+    delete m_xwayland;
+    m_xwayland = nullptr;
     waylandServer()->terminateClientConnections();
     destroyCompositor();
 }
@@ -102,6 +87,7 @@ void WaylandTestApplication::performStartup()
 
     // try creating the Wayland Backend
     createInput();
+    prepareWorkspace();
     createBackend();
 }
 
@@ -122,181 +108,28 @@ void WaylandTestApplication::continueStartupWithScreens()
 {
     disconnect(kwinApp()->platform(), &Platform::screensQueried, this, &WaylandTestApplication::continueStartupWithScreens);
     createScreens();
-
-    if (operationMode() == OperationModeWaylandOnly) {
-        createCompositor();
-        connect(Compositor::self(), &Compositor::sceneCreated, this, &WaylandTestApplication::continueStartupWithSceen);
-        return;
-    }
     createCompositor();
-    connect(Compositor::self(), &Compositor::sceneCreated, this, &WaylandTestApplication::startXwaylandServer);
+    connect(Compositor::self(), &Compositor::sceneCreated, this, &WaylandTestApplication::continueStartupWithSceen);
 }
 
 void WaylandTestApplication::continueStartupWithSceen()
 {
     disconnect(Compositor::self(), &Compositor::sceneCreated, this, &WaylandTestApplication::continueStartupWithSceen);
-    createWorkspace();
-}
-
-void WaylandTestApplication::continueStartupWithX()
-{
-    createX11Connection();
-    xcb_connection_t *c = x11Connection();
-    if (!c) {
-        // about to quit
+    if (operationMode() == OperationModeWaylandOnly) {
+        createWorkspace();
         return;
     }
-    QSocketNotifier *notifier = new QSocketNotifier(xcb_get_file_descriptor(c), QSocketNotifier::Read, this);
-    auto processXcbEvents = [this, c] {
-        while (auto event = xcb_poll_for_event(c)) {
-            updateX11Time(event);
-            long result = 0;
-            if (QThread::currentThread()->eventDispatcher()->filterNativeEvent(QByteArrayLiteral("xcb_generic_event_t"), event, &result)) {
-                free(event);
-                continue;
-            }
-            if (Workspace::self()) {
-                Workspace::self()->workspaceEvent(event);
-            }
-            free(event);
-        }
-        xcb_flush(c);
-    };
-    connect(notifier, &QSocketNotifier::activated, this, processXcbEvents);
-    connect(QThread::currentThread()->eventDispatcher(), &QAbstractEventDispatcher::aboutToBlock, this, processXcbEvents);
-    connect(QThread::currentThread()->eventDispatcher(), &QAbstractEventDispatcher::awake, this, processXcbEvents);
-
-    // create selection owner for WM_S0 - magic X display number expected by XWayland
-    KSelectionOwner owner("WM_S0", c, x11RootWindow());
-    owner.claim(true);
-
-    createAtoms();
-
-    setupEventFilters();
 
-    // Check  whether another windowmanager is running
-    const uint32_t maskValues[] = {XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT};
-    ScopedCPointer<xcb_generic_error_t> redirectCheck(xcb_request_check(connection(),
-                                                                        xcb_change_window_attributes_checked(connection(),
-                                                                                                                rootWindow(),
-                                                                                                                XCB_CW_EVENT_MASK,
-                                                                                                                maskValues)));
-    if (!redirectCheck.isNull()) {
-        ::exit(1);
+    // same order as ApplicationWayland, the workspace comes up while Xwayland starts
+    m_xwayland = new Xwl::Xwayland(this);
+    connect(m_xwayland, &Xwl::Xwayland::criticalError, this, [](int code) {
+        std::cerr << "Xwayland had a critical error. Going to exit now." << std::endl;
+        exit(code);
+    });
+    if (!m_lazyXwayland || !m_xwayland->listen()) {
+        m_xwayland->init();
     }
-
     createWorkspace();
-
-    Xcb::sync(); // Trigger possible errors, there's still a chance to abort
-}
-
-void WaylandTestApplication::createX11Connection()
-{
-    int screenNumber = 0;
-    xcb_connection_t *c = nullptr;
-    if (m_xcbConnectionFd == -1) {
-        c = xcb_connect(nullptr, &screenNumber);
-    } else {
-        c = xcb_connect_to_fd(m_xcbConnectionFd, nullptr);
-    }
-    if (int error = xcb_connection_has_error(c)) {
-        std::cerr << "FATAL ERROR: Creating connection to XServer failed: " << error << std::endl;
-        exit(1);
-        return;
-    }
-    setX11Connection(c);
-    // we don't support X11 multi-head in Wayland
-    setX11ScreenNumber(screenNumber);
-    setX11RootWindow(defaultScreen()->root);
-}
-
-void WaylandTestApplication::startXwaylandServer()
-{
-    disconnect(Compositor::self(), &Compositor::sceneCreated, this, &WaylandTestApplication::startXwaylandServer);
-    int pipeFds[2];
-    if (pipe(pipeFds) != 0) {
-        std::cerr << "FATAL ERROR failed to create pipe to start Xwayland " << std::endl;
-        exit(1);
-        return;
-    }
-    int sx[2];
-    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sx) < 0) {
-        std::cerr << "FATAL ERROR: failed to open socket to open XCB connection" << std::endl;
-        exit(1);
-        return;
-    }
-    int fd = dup(sx[1]);
-    if (fd < 0) {
-        std::cerr << "FATAL ERROR: failed to open socket to open XCB connection" << std::endl;
-        exit(20);
-        return;
-    }
-
-    const int waylandSocket = waylandServer()->createXWaylandConnection();
-    if (waylandSocket == -1) {
-        std::cerr << "FATAL ERROR: failed to open socket for Xwayland" << std::endl;
-        exit(1);
-        return;
-    }
-    const int wlfd = dup(waylandSocket);
-    if (wlfd < 0) {
-        std::cerr << "FATAL ERROR: failed to open socket for Xwayland" << std::endl;
-        exit(20);
-        return;
-    }
-
-    m_xcbConnectionFd = sx[0];
-
-    m_xwaylandProcess = new QProcess(kwinApp());
-    m_xwaylandProcess->setProgram(QStringLiteral("Xwayland"));
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    env.insert("WAYLAND_SOCKET", QByteArray::number(wlfd));
-    m_xwaylandProcess->setProcessEnvironment(env);
-    m_xwaylandProcess->setArguments({QStringLiteral("-displayfd"),
-                           QString::number(pipeFds[1]),
-                           QStringLiteral("-rootless"),
-                           QStringLiteral("-wm"),
-                           QString::number(fd)});
-    m_xwaylandFailConnection = connect(m_xwaylandProcess, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error), this,
-        [] (QProcess::ProcessError error) {
-            if (error == QProcess::FailedToStart) {
-                std::cerr << "FATAL ERROR: failed to start Xwayland" << std::endl;
-            } else {
-                std::cerr << "FATAL ERROR: Xwayland failed, going to exit now" << std::endl;
-            }
-            exit(1);
-        }
-    );
-    const int xDisplayPipe = pipeFds[0];
-    connect(m_xwaylandProcess, &QProcess::started, this,
-        [this, xDisplayPipe] {
-            QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
-            QObject::connect(watcher, &QFutureWatcher<void>::finished, this, &WaylandTestApplication::continueStartupWithX, Qt::QueuedConnection);
-            QObject::connect(watcher, &QFutureWatcher<void>::finished, watcher, &QFutureWatcher<void>::deleteLater, Qt::QueuedConnection);
-            watcher->setFuture(QtConcurrent::run(readDisplay, xDisplayPipe));
-        }
-    );
-    m_xwaylandProcess->start();
-    close(pipeFds[1]);
-}
-
-static void readDisplay(int pipe)
-{
-    QFile readPipe;
-    if (!readPipe.open(pipe, QIODevice::ReadOnly)) {
-        std::cerr << "FATAL ERROR failed to open pipe to start X Server" << std::endl;
-        exit(1);
-    }
-    QByteArray displayNumber = readPipe.readLine();
-
-    displayNumber.prepend(QByteArray(":"));
-    displayNumber.remove(displayNumber.size() -1, 1);
-    std::cout << "X-Server started on display " << displayNumber.constData() << std::endl;
-
-    setenv("DISPLAY", displayNumber.constData(), true);
-
-    // close our pipe
-    close(pipe);
 }
 
 }
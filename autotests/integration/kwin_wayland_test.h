@@ -32,6 +32,7 @@ class ShadowManager;
 class Shell;
 class ShellSurface;
 class ShmPool;
+class SubCompositor;
 class Surface;
 class XdgDecorationManager;
 }
@@ -43,27 +44,35 @@ namespace KWin
 class AbstractClient;
 class ShellClient;
 
-class WaylandTestApplication : public Application
+namespace Xwl
+{
+class Xwayland;
+}
+
+class WaylandTestApplication : public ApplicationWaylandAbstract
 {
     Q_OBJECT
 public:
     WaylandTestApplication(OperationMode mode, int &argc, char **argv);
     virtual ~WaylandTestApplication();
 
+    /**
+     * Only start Xwayland once the first X11 client connects, needs to be set before start().
+     **/
+    void setLazyXwayland(bool lazy) {
+        m_lazyXwayland = lazy;
+    }
+
 protected:
     void performStartup() override;
 
 private:
     void createBackend();
-    void createX11Connection();
     void continueStartupWithScreens();
     void continueStartupWithSceen();
-    void continueStartupWithX();
-    void startXwaylandServer();
 
-    int m_xcbConnectionFd = -1;
-    QProcess *m_xwaylandProcess = nullptr;
-    QMetaObject::Connection m_xwaylandFailConnection;
+    Xwl::Xwayland *m_xwayland = nullptr;
+    bool m_lazyXwayland = false;
 };
 
 namespace Test
@@ -79,6 +88,7 @@ enum class AdditionalWaylandInterface {
     AppMenu = 1 << 6,
     ShadowManager = 1 << 7,
     XdgDecoration = 1 << 8,
+    SubCompositor = 1 << 9,
 };
 Q_DECLARE_FLAGS(AdditionalWaylandInterfaces, AdditionalWaylandInterface)
 /**
@@ -110,6 +120,7 @@ KWayland::Client::PointerConstraints *waylandPointerConstraints();
 KWayland::Client::IdleInhibitManager *waylandIdleInhibitManager();
 KWayland::Client::AppMenuManager *waylandAppMenuManager();
 KWayland::Client::XdgDecorationManager *xdgDecorationManager();
+KWayland::Client::SubCompositor *waylandSubCompositor();
 
 bool waitForWaylandPointer();
 bool waitForWaylandTouch();
@@ -0,0 +1,80 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "kwin_wayland_test.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include "../testprintasanbase.h"
+
+#include <QtConcurrentRun>
+
+#include <xcb/xcb.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_lazy_xwayland-0");
+
+class LazyXwaylandTest : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testNotStartedWithoutClient();
+    void testStartedByFirstClient();
+};
+
+static bool hasStartupStep(const QByteArray &name)
+{
+    const auto steps = kwinApp()->startupSteps();
+    return std::any_of(steps.begin(), steps.end(), [&name] (const auto &step) { return step.first == name; });
+}
+
+void LazyXwaylandTest::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    static_cast<WaylandTestApplication*>(kwinApp())->setLazyXwayland(true);
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+}
+
+void LazyXwaylandTest::testNotStartedWithoutClient()
+{
+    QVERIFY(Workspace::self());
+    // the display is reserved, but nothing connected to it yet
+    QVERIFY(!qgetenv("DISPLAY").isEmpty());
+    QVERIFY(!kwinApp()->x11Connection());
+    QVERIFY(!hasStartupStep(QByteArrayLiteral("xwayland")));
+    testPrintlog();
+}
+
+void LazyXwaylandTest::testStartedByFirstClient()
+{
+    QSignalSpy x11ConnectionChangedSpy(kwinApp(), &Application::x11ConnectionChanged);
+    QVERIFY(x11ConnectionChangedSpy.isValid());
+
+    // xcb_connect blocks until Xwayland accepted the connection, which needs the event loop
+    auto future = QtConcurrent::run([] { return xcb_connect(nullptr, nullptr); });
+    QVERIFY(x11ConnectionChangedSpy.wait());
+    QVERIFY(kwinApp()->x11Connection());
+    QVERIFY(hasStartupStep(QByteArrayLiteral("xwayland")));
+
+    future.waitForFinished();
+    xcb_connection_t *c = future.result();
+    QVERIFY(c);
+    QVERIFY(!xcb_connection_has_error(c));
+    xcb_disconnect(c);
+    testPrintlog();
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::LazyXwaylandTest)
+#include "lazy_xwayland_test.moc"
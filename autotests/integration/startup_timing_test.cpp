@@ -0,0 +1,101 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "kwin_wayland_test.h"
+#include "atoms.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "xcbutils.h"
+
+#include "../testprintasanbase.h"
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_startup_timing-0");
+
+class StartupTimingTest : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testStepsRecorded();
+    void testXwaylandStep();
+    void testStepsOnlyOnce();
+};
+
+void StartupTimingTest::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    QSignalSpy x11ConnectionChangedSpy(kwinApp(), &Application::x11ConnectionChanged);
+    QVERIFY(x11ConnectionChangedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    if (kwinApp()->operationMode() == Application::OperationModeXwayland) {
+        // the workspace comes up while Xwayland is still starting
+        QVERIFY(x11ConnectionChangedSpy.wait());
+        QVERIFY(kwinApp()->x11Connection());
+    }
+}
+
+void StartupTimingTest::testStepsRecorded()
+{
+    const auto steps = kwinApp()->startupSteps();
+    QStringList names;
+    qint64 previous = 0;
+    for (const auto &step : steps) {
+        names << QString::fromLatin1(step.first);
+        QVERIFY(step.second >= previous);
+        previous = step.second;
+    }
+    // the dependencies of the steps determine their order
+    QVERIFY(names.contains(QStringLiteral("input")));
+    QVERIFY(names.indexOf(QStringLiteral("input")) < names.indexOf(QStringLiteral("screens")));
+    QVERIFY(names.indexOf(QStringLiteral("screens")) < names.indexOf(QStringLiteral("scene")));
+    QVERIFY(names.indexOf(QStringLiteral("scene")) < names.indexOf(QStringLiteral("workspace")));
+    testPrintlog();
+}
+
+void StartupTimingTest::testXwaylandStep()
+{
+    QStringList names;
+    const auto steps = kwinApp()->startupSteps();
+    for (const auto &step : steps) {
+        names << QString::fromLatin1(step.first);
+    }
+    if (kwinApp()->operationMode() != Application::OperationModeXwayland) {
+        QVERIFY(!names.contains(QStringLiteral("xwayland")));
+        return;
+    }
+    QVERIFY(names.contains(QStringLiteral("xwayland")));
+    QVERIFY(names.indexOf(QStringLiteral("scene")) < names.indexOf(QStringLiteral("xwayland")));
+
+    // the atoms exist by the time the D-Bus service got announced on the root window
+    QVERIFY(atoms);
+    Xcb::Property service(false, kwinApp()->x11RootWindow(), atoms->kwin_dbus_service, atoms->utf8_string, 0, 32);
+    QVERIFY(!service.isNull());
+    QVERIFY(service.toByteArray(8, atoms->utf8_string).startsWith(QByteArrayLiteral("org.kde.KWin")));
+    testPrintlog();
+}
+
+void StartupTimingTest::testStepsOnlyOnce()
+{
+    const int count = kwinApp()->startupSteps().count();
+    kwinApp()->markStartupStep(QByteArrayLiteral("workspace"));
+    QCOMPARE(kwinApp()->startupSteps().count(), count);
+    kwinApp()->markStartupStep(QByteArrayLiteral("test"));
+    QCOMPARE(kwinApp()->startupSteps().count(), count + 1);
+    QCOMPARE(kwinApp()->startupSteps().last().first, QByteArrayLiteral("test"));
+    testPrintlog();
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::StartupTimingTest)
+#include "startup_timing_test.moc"
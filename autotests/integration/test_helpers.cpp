@@ -22,6 +22,7 @@
 #include <KWayland/Client/shadow.h>
 #include <KWayland/Client/shell.h>
 #include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/subcompositor.h>
 #include <KWayland/Client/output.h>
 #include <KWayland/Client/surface.h>
 #include <KWayland/Client/appmenu.h>
@@ -67,6 +68,7 @@ static struct {
     IdleInhibitManager *idleInhibit = nullptr;
     AppMenuManager *appMenu = nullptr;
     XdgDecorationManager *xdgDecoration = nullptr;
+    SubCompositor *subCompositor = nullptr;
 } s_waylandConnection;
 
 bool setupWaylandConnection(AdditionalWaylandInterfaces flags)
@@ -213,6 +215,12 @@ bool setupWaylandConnection(AdditionalWaylandInterfaces flags)
             return false;
         }
     }
+    if (flags.testFlag(AdditionalWaylandInterface::SubCompositor)) {
+        s_waylandConnection.subCompositor = registry->createSubCompositor(registry->interface(Registry::Interface::SubCompositor).name, registry->interface(Registry::Interface::SubCompositor).version);
+        if (!s_waylandConnection.subCompositor->isValid()) {
+            return false;
+        }
+    }
 
     return true;
 }
@@ -255,6 +263,8 @@ void destroyWaylandConnection()
     s_waylandConnection.appMenu = nullptr;
     delete s_waylandConnection.xdgDecoration;
     s_waylandConnection.xdgDecoration = nullptr;
+    delete s_waylandConnection.subCompositor;
+    s_waylandConnection.subCompositor = nullptr;
     if (s_waylandConnection.thread) {
         QSignalSpy spy(s_waylandConnection.connection, &QObject::destroyed);
         s_waylandConnection.connection->deleteLater();
@@ -334,6 +344,11 @@ XdgDecorationManager *xdgDecorationManager()
     return s_waylandConnection.xdgDecoration;
 }
 
+SubCompositor *waylandSubCompositor()
+{
+    return s_waylandConnection.subCompositor;
+}
+
 
 bool waitForWaylandPointer()
 {
@@ -0,0 +1,159 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <kwineffects.h>
+#include <QMatrix4x4>
+#include <QTest>
+#include "testprintasanbase.h"
+
+#include <stdlib.h>
+
+#ifndef GL_TRIANGLES
+#  define GL_TRIANGLES      0x0004
+#endif
+
+class WindowQuadListBenchmark : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testInterleavedArrays();
+    void benchmarkMakeGrid_data();
+    void benchmarkMakeGrid();
+    void benchmarkMakeRegularGrid_data();
+    void benchmarkMakeRegularGrid();
+    void benchmarkInterleavedArrays_data();
+    void benchmarkInterleavedArrays();
+
+private:
+    KWin::WindowQuadList makeWindow() const;
+};
+
+KWin::WindowQuadList WindowQuadListBenchmark::makeWindow() const
+{
+    // a decorated 1920x1080 window: contents plus the four decoration quads
+    const QRectF rects[] = {
+        QRectF(5, 30, 1910, 1045),
+        QRectF(0, 0, 1920, 30),
+        QRectF(0, 30, 5, 1045),
+        QRectF(1915, 30, 5, 1045),
+        QRectF(0, 1075, 1920, 5)
+    };
+    KWin::WindowQuadList quads;
+    for (const QRectF &r : rects) {
+        KWin::WindowQuad quad(r == rects[0] ? KWin::WindowQuadContents : KWin::WindowQuadDecoration);
+        quad[ 0 ] = KWin::WindowVertex(r.x(), r.y(), r.x(), r.y());
+        quad[ 1 ] = KWin::WindowVertex(r.x() + r.width(), r.y(), r.x() + r.width(), r.y());
+        quad[ 2 ] = KWin::WindowVertex(r.x() + r.width(), r.y() + r.height(), r.x() + r.width(), r.y() + r.height());
+        quad[ 3 ] = KWin::WindowVertex(r.x(), r.y() + r.height(), r.x(), r.y() + r.height());
+        quads.append(quad);
+    }
+    return quads;
+}
+
+void WindowQuadListBenchmark::testInterleavedArrays()
+{
+    const KWin::WindowQuadList quads = makeWindow().makeRegularGrid(4, 4);
+    QMatrix4x4 textureMatrix;
+    textureMatrix.scale(0.5, 0.25);
+    textureMatrix.translate(2, 4);
+
+    // raw storage, so the target can start 16 byte aligned or 8 bytes off, which
+    // takes the aligned and the unaligned path of the SIMD implementations
+    const int vertexCount = quads.count() * 6;
+    QByteArray storage(vertexCount * sizeof(KWin::GLVertex2D) + 32, 0);
+    char *aligned = reinterpret_cast<char *>((quintptr(storage.data()) + 15) & ~quintptr(15));
+    KWin::GLVertex2D *alignedVertices = reinterpret_cast<KWin::GLVertex2D *>(aligned);
+    KWin::GLVertex2D *unalignedVertices = reinterpret_cast<KWin::GLVertex2D *>(aligned + 8);
+    QCOMPARE(quintptr(unalignedVertices) & 15, quintptr(8));
+
+    const int index[] = { 1, 0, 3, 3, 2, 1 };
+    KWin::GLVertex2D *targets[] = { alignedVertices, unalignedVertices };
+    QByteArray results[2];
+    for (int t = 0; t < 2; ++t) {
+        KWin::GLVertex2D *vertices = targets[t];
+        quads.makeInterleavedArrays(GL_TRIANGLES, vertices, textureMatrix);
+
+        for (int i = 0; i < quads.count(); ++i) {
+            for (int j = 0; j < 6; ++j) {
+                const KWin::WindowVertex &wv = quads.at(i)[index[j]];
+                const KWin::GLVertex2D &v = vertices[i * 6 + j];
+                QCOMPARE(v.position, QVector2D(wv.x(), wv.y()));
+                QCOMPARE(v.texcoord, QVector2D((wv.u() + 2) * 0.5, (wv.v() + 4) * 0.25));
+            }
+        }
+        results[t] = QByteArray(reinterpret_cast<const char *>(vertices), vertexCount * sizeof(KWin::GLVertex2D));
+    }
+    // both paths produce the same bits
+    QCOMPARE(results[0], results[1]);
+    testPrintlog();
+}
+
+void WindowQuadListBenchmark::benchmarkMakeGrid_data()
+{
+    QTest::addColumn<int>("quadSize");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("40") << 40;
+    QTest::newRow("10") << 10;
+}
+
+void WindowQuadListBenchmark::benchmarkMakeGrid()
+{
+    QFETCH(int, quadSize);
+    const KWin::WindowQuadList quads = makeWindow();
+    QBENCHMARK {
+        quads.makeGrid(quadSize);
+    }
+    testPrintlog();
+}
+
+void WindowQuadListBenchmark::benchmarkMakeRegularGrid_data()
+{
+    QTest::addColumn<int>("subdivisions");
+
+    QTest::newRow("4") << 4;
+    QTest::newRow("20") << 20;
+    QTest::newRow("100") << 100;
+}
+
+void WindowQuadListBenchmark::benchmarkMakeRegularGrid()
+{
+    QFETCH(int, subdivisions);
+    const KWin::WindowQuadList quads = makeWindow();
+    QBENCHMARK {
+        quads.makeRegularGrid(subdivisions, subdivisions);
+    }
+    testPrintlog();
+}
+
+void WindowQuadListBenchmark::benchmarkInterleavedArrays_data()
+{
+    QTest::addColumn<int>("subdivisions");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("20") << 20;
+    QTest::newRow("100") << 100;
+}
+
+void WindowQuadListBenchmark::benchmarkInterleavedArrays()
+{
+    QFETCH(int, subdivisions);
+    const KWin::WindowQuadList quads = makeWindow().makeRegularGrid(subdivisions, subdivisions);
+    QMatrix4x4 textureMatrix;
+    textureMatrix.scale(1.0 / 1920, 1.0 / 1080);
+
+    void *buffer = nullptr;
+    QVERIFY(posix_memalign(&buffer, 16, quads.count() * 6 * sizeof(KWin::GLVertex2D)) == 0);
+    KWin::GLVertex2D *vertices = static_cast<KWin::GLVertex2D *>(buffer);
+    QBENCHMARK {
+        quads.makeInterleavedArrays(GL_TRIANGLES, vertices, textureMatrix);
+    }
+    free(buffer);
+    testPrintlog();
+}
+
+QTEST_MAIN(WindowQuadListBenchmark)
+
+#include "windowquadlistbenchmark.moc"
@@ -30,6 +30,7 @@ private Q_SLOTS:
     void testMakeGrid();
     void testMakeRegularGrid_data();
     void testMakeRegularGrid();
+    void testGridCache();
 
 private:
     KWin::WindowQuad makeQuad(const QRectF &rect);
@@ -217,6 +218,40 @@ void WindowQuadListTest::testMakeRegularGrid()
     testPrintlog();
 }
 
+void WindowQuadListTest::testGridCache()
+{
+    // the cache never dereferences the window, it is only used as key
+    const KWin::EffectWindow *w1 = reinterpret_cast<const KWin::EffectWindow*>(0x1);
+    const KWin::EffectWindow *w2 = reinterpret_cast<const KWin::EffectWindow*>(0x2);
+
+    KWin::WindowQuadList orig;
+    orig.append(makeQuad(QRectF(0, 0, 10, 10)));
+
+    KWin::WindowQuadGridCache cache;
+    const KWin::WindowQuadList grid = cache.regularGrid(w1, orig, 2, 2);
+    QCOMPARE(grid.count(), 4);
+    // same input gives the same shared list back instead of subdividing again
+    const KWin::WindowQuadList cached = cache.regularGrid(w1, orig, 2, 2);
+    QVERIFY(cached.isSharedWith(grid));
+    // another window has its own entry
+    QVERIFY(!cache.regularGrid(w2, orig, 2, 2).isSharedWith(grid));
+
+    // different subdivisions or different quads invalidate the cache
+    QCOMPARE(cache.regularGrid(w1, orig, 5, 5).count(), 25);
+    KWin::WindowQuadList resized;
+    resized.append(makeQuad(QRectF(0, 0, 20, 10)));
+    const KWin::WindowQuadList resizedGrid = cache.regularGrid(w1, resized, 5, 5);
+    QCOMPARE(resizedGrid.count(), 25);
+    QCOMPARE(resizedGrid.last().right(), 20.0);
+
+    // the irregular grid does not reuse the regular one
+    QCOMPARE(cache.grid(w1, resized, 10).count(), 2);
+
+    cache.remove(w1);
+    QVERIFY(!cache.grid(w1, resized, 10).isSharedWith(resizedGrid));
+    testPrintlog();
+}
+
 QTEST_MAIN(WindowQuadListTest)
 
 #include "windowquadlisttest.moc"
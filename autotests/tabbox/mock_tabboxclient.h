@@ -66,6 +66,9 @@ public:
     }
     virtual void setMinimized(bool set) {
     }
+    void setCaption(const QString &caption) {
+        m_caption = caption;
+    }
 
 private:
     QString m_caption;
@@ -47,9 +47,14 @@ void MockTabBoxHandler::setActiveClient(const QWeakPointer< TabBox::TabBoxClient
     m_activeClient = client;
 }
 
-QWeakPointer< TabBox::TabBoxClient > MockTabBoxHandler::clientToAddToList(TabBox::TabBoxClient *client, int desktop) const
+QWeakPointer< TabBox::TabBoxClient > MockTabBoxHandler::clientToAddToList(TabBox::TabBoxClient *client, int desktop, const TabBox::TabBoxClientList &clientList) const
 {
     Q_UNUSED(desktop)
+    const QWeakPointer< TabBox::TabBoxClient > modal = m_modals.value(client);
+    if (!modal.isNull()) {
+        // like the real handler: the modal dialog replaces the client unless it is already listed
+        return clientList.contains(modal) ? QWeakPointer< TabBox::TabBoxClient >() : modal;
+    }
     QList< QSharedPointer< TabBox::TabBoxClient > >::const_iterator it = m_windows.constBegin();
     for (; it != m_windows.constEnd(); ++it) {
         if ((*it).data() == client) {
@@ -119,4 +124,13 @@ void MockTabBoxHandler::closeWindow(TabBox::TabBoxClient *client)
     }
 }
 
+void MockTabBoxHandler::setModal(TabBox::TabBoxClient *client, const QWeakPointer<TabBox::TabBoxClient> &modal)
+{
+    if (modal.isNull()) {
+        m_modals.remove(client);
+    } else {
+        m_modals.insert(client, modal);
+    }
+}
+
 } // namespace KWin
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "test_tabbox_clientmodel.h"
 #include "mock_tabboxhandler.h"
+#include "mock_tabboxclient.h"
 #include "clientmodel.h"
 #include "../testutils.h"
 
@@ -91,5 +92,104 @@ void TestTabBoxClientModel::testCreateClientListActiveClientNotInFocusChain()
     testPrintlog();
 }
 
+void TestTabBoxClientModel::testCreateClientListIncremental()
+{
+    MockTabBoxHandler tabboxhandler;
+    tabboxhandler.setConfig(TabBox::TabBoxConfig());
+    TabBox::ClientModel *clientModel = new TabBox::ClientModel(&tabboxhandler);
+    tabboxhandler.createMockWindow(QString("test"), 1);
+    QWeakPointer<TabBox::TabBoxClient> client = tabboxhandler.createMockWindow(QString("test2"), 2);
+    clientModel->createClientList();
+    QCOMPARE(clientModel->rowCount(), 2);
+
+    QSignalSpy resetSpy(clientModel, &QAbstractItemModel::modelReset);
+    QVERIFY(resetSpy.isValid());
+    QSignalSpy insertedSpy(clientModel, &QAbstractItemModel::rowsInserted);
+    QVERIFY(insertedSpy.isValid());
+    QSignalSpy removedSpy(clientModel, &QAbstractItemModel::rowsRemoved);
+    QVERIFY(removedSpy.isValid());
+
+    // the same list again does not change any rows
+    clientModel->createClientList();
+    QCOMPARE(clientModel->rowCount(), 2);
+    QCOMPARE(insertedSpy.count(), 0);
+    QCOMPARE(removedSpy.count(), 0);
+
+    // a new window gets inserted
+    QWeakPointer<TabBox::TabBoxClient> client3 = tabboxhandler.createMockWindow(QString("test3"), 3);
+    clientModel->createClientList(true);
+    QCOMPARE(clientModel->rowCount(), 3);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(removedSpy.count(), 0);
+    QVERIFY(clientModel->index(client3).isValid());
+
+    // a closed window gets removed
+    QSharedPointer<TabBox::TabBoxClient> clientOwner = client.toStrongRef();
+    tabboxhandler.closeWindow(client.data());
+    clientModel->createClientList(true);
+    QCOMPARE(clientModel->rowCount(), 2);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(removedSpy.count(), 1);
+    QVERIFY(!clientModel->index(client).isValid());
+    QVERIFY(clientModel->index(client3).isValid());
+
+    QCOMPARE(resetSpy.count(), 0);
+    testPrintlog();
+}
+
+void TestTabBoxClientModel::testCreateClientListModal()
+{
+    MockTabBoxHandler tabboxhandler;
+    tabboxhandler.setConfig(TabBox::TabBoxConfig());
+    TabBox::ClientModel *clientModel = new TabBox::ClientModel(&tabboxhandler);
+    QWeakPointer<TabBox::TabBoxClient> client = tabboxhandler.createMockWindow(QString("test"), 1);
+    QWeakPointer<TabBox::TabBoxClient> dialog = tabboxhandler.createMockWindow(QString("dialog"), 2);
+    // the dialog gets found for the window, and once more for itself
+    tabboxhandler.setModal(client.data(), dialog);
+    clientModel->createClientList();
+    QCOMPARE(clientModel->rowCount(), 1);
+    QCOMPARE(clientModel->clientList(), TabBox::TabBoxClientList() << dialog);
+
+    QSignalSpy insertedSpy(clientModel, &QAbstractItemModel::rowsInserted);
+    QVERIFY(insertedSpy.isValid());
+    QSignalSpy removedSpy(clientModel, &QAbstractItemModel::rowsRemoved);
+    QVERIFY(removedSpy.isValid());
+    tabboxhandler.setModal(client.data(), QWeakPointer<TabBox::TabBoxClient>());
+    clientModel->createClientList();
+    QCOMPARE(clientModel->rowCount(), 2);
+    QCOMPARE(clientModel->clientList(), TabBox::TabBoxClientList() << client << dialog);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(removedSpy.count(), 0);
+    testPrintlog();
+}
+
+void TestTabBoxClientModel::testCreateClientListDataChanged()
+{
+    MockTabBoxHandler tabboxhandler;
+    tabboxhandler.setConfig(TabBox::TabBoxConfig());
+    TabBox::ClientModel *clientModel = new TabBox::ClientModel(&tabboxhandler);
+    tabboxhandler.createMockWindow(QString("test"), 1);
+    QWeakPointer<TabBox::TabBoxClient> client = tabboxhandler.createMockWindow(QString("test2"), 2);
+    tabboxhandler.createMockWindow(QString("test3"), 3);
+    clientModel->createClientList();
+    QCOMPARE(clientModel->rowCount(), 3);
+
+    QSignalSpy dataChangedSpy(clientModel, &QAbstractItemModel::dataChanged);
+    QVERIFY(dataChangedSpy.isValid());
+    // nothing changed, nothing to repaint
+    clientModel->createClientList();
+    QCOMPARE(dataChangedSpy.count(), 0);
+
+    // only the row of the renamed client changes
+    static_cast<MockTabBoxClient*>(client.data())->setCaption(QStringLiteral("renamed"));
+    clientModel->createClientList();
+    QCOMPARE(dataChangedSpy.count(), 1);
+    const QModelIndex row = clientModel->index(client);
+    QCOMPARE(dataChangedSpy.first().at(0).toModelIndex(), row);
+    QCOMPARE(dataChangedSpy.first().at(1).toModelIndex(), row);
+    QCOMPARE(clientModel->data(row, TabBox::ClientModel::CaptionRole).toString(), QStringLiteral("renamed"));
+    testPrintlog();
+}
+
 Q_CONSTRUCTOR_FUNCTION(forceXcb)
 QTEST_MAIN(TestTabBoxClientModel)
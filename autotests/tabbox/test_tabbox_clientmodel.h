@@ -48,6 +48,21 @@ private slots:
      * See BUG: 306260
      **/
     void testCreateClientListActiveClientNotInFocusChain();
+    /**
+     * Tests that recreating the Client list updates the rows
+     * in place instead of resetting the model.
+     **/
+    void testCreateClientListIncremental();
+    /**
+     * Tests that a modal dialog, found for its parent and for itself,
+     * is listed only once.
+     **/
+    void testCreateClientListModal();
+    /**
+     * Tests that recreating the Client list only emits dataChanged
+     * for the rows whose Client changed.
+     **/
+    void testCreateClientListDataChanged();
 };
 
 #endif
@@ -0,0 +1,104 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../platformsupport/scenes/opengl/client_buffer_cache.h"
+// Qt
+#include <QSharedPointer>
+#include <QtTest>
+#include "testprintasanbase.h"
+
+using namespace KWin;
+
+class TestClientBufferCache : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testSwapChain();
+    void testDestroyBuffer();
+    void testClear();
+    void testReleaseValue();
+};
+
+void TestClientBufferCache::testSwapChain()
+{
+    // a client cycling through three buffers gets each imported only once
+    ClientBufferCache<int> cache;
+    QObject buffers[3];
+    int imports = 0;
+    for (int frame = 0; frame < 300; ++frame) {
+        QObject *buffer = &buffers[frame % 3];
+        if (!cache.contains(buffer)) {
+            cache.insert(buffer, ++imports);
+        }
+        QCOMPARE(cache.value(buffer), frame % 3 + 1);
+    }
+    QCOMPARE(imports, 3);
+    QCOMPARE(cache.count(), 3);
+    QCOMPARE(cache.insertCount(), quint64(3));
+    testPrintlog();
+}
+
+void TestClientBufferCache::testDestroyBuffer()
+{
+    ClientBufferCache<int> cache;
+    QObject kept;
+    QObject *destroyed = new QObject;
+    cache.insert(&kept, 1);
+    cache.insert(destroyed, 2);
+    QCOMPARE(cache.count(), 2);
+
+    delete destroyed;
+    QCOMPARE(cache.count(), 1);
+    QVERIFY(!cache.contains(destroyed));
+    QCOMPARE(cache.value(&kept), 1);
+
+    // replacing a value is another import but no new entry
+    cache.insert(&kept, 3);
+    QCOMPARE(cache.value(&kept), 3);
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.insertCount(), quint64(3));
+
+    cache.remove(&kept);
+    QVERIFY(!cache.contains(&kept));
+    QCOMPARE(cache.value(&kept), 0);
+    testPrintlog();
+}
+
+void TestClientBufferCache::testClear()
+{
+    QScopedPointer<QObject> buffer(new QObject);
+    {
+        ClientBufferCache<int> cache;
+        cache.insert(buffer.data(), 1);
+        cache.clear();
+        QCOMPARE(cache.count(), 0);
+        cache.insert(buffer.data(), 2);
+    }
+    // the cache is gone, destroying the buffer must not touch it
+    buffer.reset();
+    testPrintlog();
+}
+
+void TestClientBufferCache::testReleaseValue()
+{
+    // values shared with a user stay alive after the buffer got destroyed
+    ClientBufferCache<QSharedPointer<int>> cache;
+    QObject *buffer = new QObject;
+    cache.insert(buffer, QSharedPointer<int>::create(42));
+    QWeakPointer<int> weak = cache.value(buffer);
+    QSharedPointer<int> user = cache.value(buffer);
+
+    delete buffer;
+    QCOMPARE(cache.count(), 0);
+    QVERIFY(!weak.isNull());
+    QCOMPARE(*user, 42);
+
+    user.reset();
+    QVERIFY(weak.isNull());
+    testPrintlog();
+}
+
+QTEST_GUILESS_MAIN(TestClientBufferCache)
+#include "test_client_buffer_cache.moc"
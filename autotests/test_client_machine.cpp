@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QApplication>
 #include <QtTest>
 #include <QX11Info>
+#include <netwm.h>
 // xcb
 #include <xcb/xcb.h>
 // system
@@ -46,6 +47,8 @@ private Q_SLOTS:
     void hostName_data();
     void hostName();
     void emptyHostName();
+    void fetchedHostName();
+    void fetchedHostNameFromLeader();
 
 private:
     void setClientMachineProperty(xcb_window_t window, const QByteArray &hostname);
@@ -153,6 +156,59 @@ void TestClientMachine::emptyHostName()
     testPrintlog();
 }
 
+void TestClientMachine::fetchedHostName()
+{
+    // the way Toplevel::getWmClientMachine resolves with the WM_CLIENT_MACHINE of its NETWinInfo
+    const QRect geometry(0, 0, 10, 10);
+    const uint32_t values[] = { true };
+    Xcb::Window window(geometry, XCB_WINDOW_CLASS_INPUT_ONLY, XCB_CW_OVERRIDE_REDIRECT, values);
+    Xcb::Window leader(geometry, XCB_WINDOW_CLASS_INPUT_ONLY, XCB_CW_OVERRIDE_REDIRECT, values);
+    const QByteArray domain("random.name.not.exist.tld");
+    setClientMachineProperty(window, domain);
+    setClientMachineProperty(leader, QByteArrayLiteral("localhost"));
+    const QByteArray fetched = NETWinInfo(connection(), window, rootWindow(), NET::Properties(), NET::WM2ClientMachine).clientMachine();
+    QCOMPARE(fetched, domain);
+
+    ClientMachine clientMachine;
+    clientMachine.resolve(fetched, window, leader);
+    // the property of the leader is not used if the window has its own
+    QCOMPARE(clientMachine.hostName(), domain);
+    int i=0;
+    while (clientMachine.isResolving() && i++ < 50) {
+        QTest::qWait(250);
+    }
+    QVERIFY(!clientMachine.isLocal());
+
+    // resolving again does not change anything
+    clientMachine.resolve(QByteArrayLiteral("localhost"), window, leader);
+    QCOMPARE(clientMachine.hostName(), domain);
+    testPrintlog();
+}
+
+void TestClientMachine::fetchedHostNameFromLeader()
+{
+    const QRect geometry(0, 0, 10, 10);
+    const uint32_t values[] = { true };
+    Xcb::Window window(geometry, XCB_WINDOW_CLASS_INPUT_ONLY, XCB_CW_OVERRIDE_REDIRECT, values);
+    Xcb::Window leader(geometry, XCB_WINDOW_CLASS_INPUT_ONLY, XCB_CW_OVERRIDE_REDIRECT, values);
+    setClientMachineProperty(leader, m_hostName);
+    const QByteArray fetched = NETWinInfo(connection(), window, rootWindow(), NET::Properties(), NET::WM2ClientMachine).clientMachine();
+    QVERIFY(fetched.isEmpty());
+
+    ClientMachine clientMachine;
+    QSignalSpy spy(&clientMachine, SIGNAL(localhostChanged()));
+    // an empty fetched value falls back to the client leader
+    clientMachine.resolve(fetched, window, leader);
+    QCOMPARE(clientMachine.hostName(), m_hostName);
+    int i=0;
+    while (clientMachine.isResolving() && i++ < 50) {
+        QTest::qWait(250);
+    }
+    QVERIFY(clientMachine.isLocal());
+    QCOMPARE(spy.isEmpty(), false);
+    testPrintlog();
+}
+
 Q_CONSTRUCTOR_FUNCTION(forceXcb)
 QTEST_MAIN(TestClientMachine)
 #include "test_client_machine.moc"
@@ -0,0 +1,144 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../configcommitter.h"
+// Qt
+#include <QTemporaryDir>
+#include <QtConcurrentRun>
+#include <QtTest>
+// KF5
+#include <KConfig>
+#include "testprintasanbase.h"
+
+using namespace KWin;
+
+class TestConfigCommitter : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void testCoalesce();
+    void testFlush();
+    void testOtherThread();
+    void testDestroy();
+    void testWithoutCommitter();
+
+private:
+    QString readEntry(const QString &fileName, const QString &key) const;
+    QTemporaryDir m_dir;
+};
+
+QString TestConfigCommitter::readEntry(const QString &fileName, const QString &key) const
+{
+    KConfig config(m_dir.filePath(fileName), KConfig::SimpleConfig);
+    return config.group("Test").readEntry(key, QString());
+}
+
+void TestConfigCommitter::init()
+{
+    QVERIFY(m_dir.isValid());
+    QVERIFY(!ConfigCommitter::self());
+    ConfigCommitter::create(this);
+    QVERIFY(ConfigCommitter::self());
+    ConfigCommitter::self()->setInterval(50);
+}
+
+void TestConfigCommitter::cleanup()
+{
+    delete ConfigCommitter::self();
+    QVERIFY(!ConfigCommitter::self());
+}
+
+void TestConfigCommitter::testCoalesce()
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(m_dir.filePath(QStringLiteral("coalesce")), KConfig::SimpleConfig);
+    KConfigGroup group = config->group("Test");
+    for (int i = 0; i < 100; ++i) {
+        group.writeEntry("Value", i);
+        ConfigCommitter::sync(group);
+    }
+    // nothing is written before the interval passed
+    QCOMPARE(ConfigCommitter::self()->syncCount(), 0);
+    QCOMPARE(readEntry(QStringLiteral("coalesce"), QStringLiteral("Value")), QString());
+
+    QTRY_COMPARE(ConfigCommitter::self()->syncCount(), 1);
+    QCOMPARE(readEntry(QStringLiteral("coalesce"), QStringLiteral("Value")), QStringLiteral("99"));
+
+    // a later change gets written again
+    group.writeEntry("Value", 100);
+    ConfigCommitter::sync(config);
+    QTRY_COMPARE(ConfigCommitter::self()->syncCount(), 2);
+    QCOMPARE(readEntry(QStringLiteral("coalesce"), QStringLiteral("Value")), QStringLiteral("100"));
+    testPrintlog();
+}
+
+void TestConfigCommitter::testFlush()
+{
+    ConfigCommitter::self()->setInterval(60000);
+    KSharedConfigPtr first = KSharedConfig::openConfig(m_dir.filePath(QStringLiteral("first")), KConfig::SimpleConfig);
+    KSharedConfigPtr second = KSharedConfig::openConfig(m_dir.filePath(QStringLiteral("second")), KConfig::SimpleConfig);
+    first->group("Test").writeEntry("Value", 1);
+    second->group("Test").writeEntry("Value", 2);
+    ConfigCommitter::sync(first);
+    ConfigCommitter::sync(second);
+    ConfigCommitter::sync(first->group("Other"));
+    QCOMPARE(ConfigCommitter::self()->syncCount(), 0);
+
+    ConfigCommitter::self()->flush();
+    // one write per config
+    QCOMPARE(ConfigCommitter::self()->syncCount(), 2);
+    QCOMPARE(readEntry(QStringLiteral("first"), QStringLiteral("Value")), QStringLiteral("1"));
+    QCOMPARE(readEntry(QStringLiteral("second"), QStringLiteral("Value")), QStringLiteral("2"));
+
+    // nothing left to write
+    ConfigCommitter::self()->flush();
+    QCOMPARE(ConfigCommitter::self()->syncCount(), 2);
+    testPrintlog();
+}
+
+void TestConfigCommitter::testOtherThread()
+{
+    KSharedConfigPtr config = KSharedConfig::openConfig(m_dir.filePath(QStringLiteral("thread")), KConfig::SimpleConfig);
+    KConfigGroup group = config->group("Test");
+    group.writeEntry("Value", 42);
+    QtConcurrent::run(
+        [group] {
+            ConfigCommitter::sync(group);
+        }
+    ).waitForFinished();
+    // the write still happens in the main thread
+    QCOMPARE(ConfigCommitter::self()->syncCount(), 0);
+    QTRY_COMPARE(ConfigCommitter::self()->syncCount(), 1);
+    QCOMPARE(readEntry(QStringLiteral("thread"), QStringLiteral("Value")), QStringLiteral("42"));
+    testPrintlog();
+}
+
+void TestConfigCommitter::testDestroy()
+{
+    ConfigCommitter::self()->setInterval(60000);
+    KSharedConfigPtr config = KSharedConfig::openConfig(m_dir.filePath(QStringLiteral("destroy")), KConfig::SimpleConfig);
+    config->group("Test").writeEntry("Value", 3);
+    ConfigCommitter::sync(config);
+    // pending changes get written on shutdown
+    delete ConfigCommitter::self();
+    QCOMPARE(readEntry(QStringLiteral("destroy"), QStringLiteral("Value")), QStringLiteral("3"));
+    testPrintlog();
+}
+
+void TestConfigCommitter::testWithoutCommitter()
+{
+    delete ConfigCommitter::self();
+    KSharedConfigPtr config = KSharedConfig::openConfig(m_dir.filePath(QStringLiteral("direct")), KConfig::SimpleConfig);
+    config->group("Test").writeEntry("Value", 4);
+    ConfigCommitter::sync(config);
+    QCOMPARE(readEntry(QStringLiteral("direct"), QStringLiteral("Value")), QStringLiteral("4"));
+    // recreate for cleanup
+    ConfigCommitter::create(this);
+    testPrintlog();
+}
+
+QTEST_GUILESS_MAIN(TestConfigCommitter)
+#include "test_config_committer.moc"
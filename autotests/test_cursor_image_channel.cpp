@@ -0,0 +1,257 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../cursorimagechannel.h"
+// Qt
+#include <QtTest>
+#include <QThread>
+#include "testprintasanbase.h"
+
+using namespace KWin;
+
+typedef CursorImageChannel::Header Header;
+
+class TestCursorImageChannel : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testWritePosition();
+    void testReadDuringWrite();
+    void testConcurrentReaders();
+    void testWriteShape();
+    void testReadShapeDuringWrite();
+    void testReadShapeOutOfBounds();
+    void testConcurrentShapeReaders();
+};
+
+namespace
+{
+
+// a channel mapping with room for a 32x32 cursor, aligned like the memfd mapping
+struct Mapping {
+    Mapping() : words((sizeof(Header) + 32 * 32 * 4) / 4, 0) {
+        header()->dataOffset = sizeof(Header);
+    }
+    Header *header() {
+        return reinterpret_cast<Header*>(words.data());
+    }
+    quint32 size() const {
+        return words.size() * 4;
+    }
+    QVector<quint32> words;
+};
+
+QImage filledImage(int size, QRgb color)
+{
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(color);
+    return image;
+}
+
+}
+
+void TestCursorImageChannel::testWritePosition()
+{
+    Header header = {};
+    QPoint pos;
+    quint32 serial = 1;
+    QVERIFY(CursorImageChannel::readPosition(&header, &pos, &serial));
+    QCOMPARE(serial, 0u);
+    QCOMPARE(pos, QPoint(0, 0));
+
+    CursorImageChannel::writePosition(&header, QPoint(10, -20));
+    QVERIFY(CursorImageChannel::readPosition(&header, &pos, &serial));
+    QCOMPARE(pos, QPoint(10, -20));
+    // the serial stays even once the write completed
+    QCOMPARE(serial, 2u);
+
+    CursorImageChannel::writePosition(&header, QPoint(30, 40));
+    QVERIFY(CursorImageChannel::readPosition(&header, &pos, &serial));
+    QCOMPARE(pos, QPoint(30, 40));
+    QCOMPARE(serial, 4u);
+    testPrintlog();
+}
+
+void TestCursorImageChannel::testReadDuringWrite()
+{
+    Header header = {};
+    CursorImageChannel::writePosition(&header, QPoint(1, 2));
+
+    // a writer which got interrupted between the serial and the position
+    header.positionSerial++;
+    header.x = 3;
+    QPoint pos(-1, -1);
+    QVERIFY(!CursorImageChannel::readPosition(&header, &pos));
+    QCOMPARE(pos, QPoint(-1, -1));
+
+    // the writer finished, the position is accepted again
+    header.y = 4;
+    header.positionSerial++;
+    QVERIFY(CursorImageChannel::readPosition(&header, &pos));
+    QCOMPARE(pos, QPoint(3, 4));
+    testPrintlog();
+}
+
+void TestCursorImageChannel::testConcurrentReaders()
+{
+    // the writer keeps y == -x, a torn read would break that
+    Header header = {};
+    const int writes = 200000;
+    QScopedPointer<QThread> writer(QThread::create([&header, writes] {
+        for (int i = 1; i <= writes; ++i) {
+            CursorImageChannel::writePosition(&header, QPoint(i, -i));
+        }
+    }));
+    writer->start();
+
+    int reads = 0;
+    int torn = 0;
+    quint32 lastSerial = 0;
+    while (!writer->isFinished() || reads == 0) {
+        QPoint pos;
+        quint32 serial = 0;
+        if (!CursorImageChannel::readPosition(&header, &pos, &serial)) {
+            continue;
+        }
+        reads++;
+        if (pos.y() != -pos.x() || (serial & 1) || serial < lastSerial) {
+            torn++;
+        }
+        lastSerial = serial;
+    }
+    QVERIFY(writer->wait());
+    QCOMPARE(torn, 0);
+
+    QPoint pos;
+    quint32 serial = 0;
+    QVERIFY(CursorImageChannel::readPosition(&header, &pos, &serial));
+    QCOMPARE(pos, QPoint(writes, -writes));
+    QCOMPARE(serial, quint32(2 * writes));
+    testPrintlog();
+}
+
+void TestCursorImageChannel::testWriteShape()
+{
+    Mapping mapping;
+    QImage image;
+    QPoint hotSpot;
+    quint32 serial = 1;
+    QVERIFY(CursorImageChannel::readShape(mapping.header(), mapping.size(), &image, &hotSpot, &serial));
+    QVERIFY(image.isNull());
+    QCOMPARE(serial, 0u);
+
+    QImage cursor(5, 3, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < cursor.height(); ++y) {
+        for (int x = 0; x < cursor.width(); ++x) {
+            cursor.setPixel(x, y, qRgba(x * 40, y * 80, 10, 255));
+        }
+    }
+    CursorImageChannel::writeShape(mapping.header(), 0, cursor, QPoint(2, 1));
+    QVERIFY(CursorImageChannel::readShape(mapping.header(), mapping.size(), &image, &hotSpot, &serial));
+    QCOMPARE(image, cursor);
+    QCOMPARE(hotSpot, QPoint(2, 1));
+    QCOMPARE(serial, 2u);
+
+    // an empty cursor, e.g. a hidden one
+    CursorImageChannel::writeShape(mapping.header(), serial, QImage(), QPoint());
+    QVERIFY(CursorImageChannel::readShape(mapping.header(), mapping.size(), &image, &hotSpot, &serial));
+    QVERIFY(image.isNull());
+    QCOMPARE(serial, 4u);
+    testPrintlog();
+}
+
+void TestCursorImageChannel::testReadShapeDuringWrite()
+{
+    Mapping mapping;
+    const QImage red = filledImage(8, qRgba(255, 0, 0, 255));
+    const QImage blue = filledImage(8, qRgba(0, 0, 255, 255));
+    CursorImageChannel::writeShape(mapping.header(), 0, red, QPoint(1, 1));
+
+    // a writer which got interrupted in the middle of the pixels
+    Header *header = mapping.header();
+    header->shapeSerial++;
+    memcpy(reinterpret_cast<uchar*>(header) + header->dataOffset, blue.constBits(), blue.bytesPerLine() * 4);
+    QImage image;
+    QPoint hotSpot;
+    QVERIFY(!CursorImageChannel::readShape(header, mapping.size(), &image, &hotSpot));
+    QVERIFY(image.isNull());
+
+    // the writer finished, the image is accepted again
+    memcpy(reinterpret_cast<uchar*>(header) + header->dataOffset, blue.constBits(), blue.bytesPerLine() * blue.height());
+    header->shapeSerial++;
+    QVERIFY(CursorImageChannel::readShape(header, mapping.size(), &image, &hotSpot));
+    QCOMPARE(image, blue);
+    testPrintlog();
+}
+
+void TestCursorImageChannel::testReadShapeOutOfBounds()
+{
+    Mapping mapping;
+    CursorImageChannel::writeShape(mapping.header(), 0, filledImage(32, qRgba(0, 255, 0, 255)), QPoint());
+    QImage image;
+    QPoint hotSpot;
+    QVERIFY(CursorImageChannel::readShape(mapping.header(), mapping.size(), &image, &hotSpot));
+
+    // the reader maps less than the header claims, e.g. before it fetched a replaced file
+    QVERIFY(!CursorImageChannel::readShape(mapping.header(), mapping.size() - 4, &image, &hotSpot));
+    // a stride too small for the width
+    mapping.header()->stride = 16;
+    QVERIFY(!CursorImageChannel::readShape(mapping.header(), mapping.size(), &image, &hotSpot));
+    testPrintlog();
+}
+
+void TestCursorImageChannel::testConcurrentShapeReaders()
+{
+    // the writer alternates between two cursors which differ in size, color and hot spot,
+    // a torn read would mix them
+    Mapping mapping;
+    const QImage small = filledImage(8, qRgba(255, 0, 0, 255));
+    const QImage large = filledImage(32, qRgba(0, 0, 255, 255));
+    Header *header = mapping.header();
+    const int writes = 20000;
+    QScopedPointer<QThread> writer(QThread::create([header, &small, &large, writes] {
+        for (int i = 0; i < writes; ++i) {
+            const bool isSmall = i % 2;
+            CursorImageChannel::writeShape(header, 2 * i, isSmall ? small : large, isSmall ? QPoint(1, 1) : QPoint(16, 16));
+        }
+    }));
+    writer->start();
+
+    int reads = 0;
+    int torn = 0;
+    quint32 lastSerial = 0;
+    while (!writer->isFinished() || reads == 0) {
+        QImage image;
+        QPoint hotSpot;
+        quint32 serial = 0;
+        if (!CursorImageChannel::readShape(header, mapping.size(), &image, &hotSpot, &serial)) {
+            continue;
+        }
+        reads++;
+        if (serial == 0) {
+            // nothing written yet
+            continue;
+        }
+        const bool isSmall = image.width() == small.width();
+        if (image != (isSmall ? small : large) || hotSpot != (isSmall ? QPoint(1, 1) : QPoint(16, 16))
+                || (serial & 1) || serial < lastSerial) {
+            torn++;
+        }
+        lastSerial = serial;
+    }
+    QVERIFY(writer->wait());
+    QCOMPARE(torn, 0);
+
+    QImage image;
+    QPoint hotSpot;
+    quint32 serial = 0;
+    QVERIFY(CursorImageChannel::readShape(header, mapping.size(), &image, &hotSpot, &serial));
+    QCOMPARE(image, small);
+    QCOMPARE(serial, quint32(2 * writes));
+    testPrintlog();
+}
+
+QTEST_GUILESS_MAIN(TestCursorImageChannel)
+#include "test_cursor_image_channel.moc"
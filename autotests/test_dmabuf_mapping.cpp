@@ -0,0 +1,191 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../dmabufmapping.h"
+#include "../platformsupport/scenes/opengl/drm_fourcc.h"
+// Qt
+#include <QtTest>
+#include "testprintasanbase.h"
+
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace KWin;
+
+/**
+ * Stands in for a dmabuf, memfds support mmap the same way but no sync. They are only accepted
+ * when sealed against shrinking.
+ **/
+class MemFd
+{
+public:
+    explicit MemFd(int size, bool sealed = true)
+        : m_fd(syscall(SYS_memfd_create, "kwin-test-dmabuf", MFD_CLOEXEC | MFD_ALLOW_SEALING))
+    {
+        if (m_fd != -1 && ftruncate(m_fd, size) != 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+        if (m_fd != -1 && sealed && fcntl(m_fd, F_ADD_SEALS, F_SEAL_SHRINK) != 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+    ~MemFd() {
+        if (m_fd != -1) {
+            close(m_fd);
+        }
+    }
+    int fd() const {
+        return m_fd;
+    }
+    bool write(int offset, const QByteArray &data) {
+        return pwrite(m_fd, data.constData(), data.size(), offset) == data.size();
+    }
+
+private:
+    int m_fd;
+};
+
+class TestDmabufMapping : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testImageFormat_data();
+    void testImageFormat();
+    void testLayout_data();
+    void testLayout();
+    void testMapping();
+    void testInvalidMapping();
+    void testUnsealedFile();
+    void testFileOffset();
+};
+
+void TestDmabufMapping::testImageFormat_data()
+{
+    QTest::addColumn<uint>("drmFormat");
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("argb8888") << uint(DRM_FORMAT_ARGB8888) << int(QImage::Format_ARGB32_Premultiplied);
+    QTest::newRow("xrgb8888") << uint(DRM_FORMAT_XRGB8888) << int(QImage::Format_RGB32);
+    QTest::newRow("abgr8888") << uint(DRM_FORMAT_ABGR8888) << int(QImage::Format_RGBA8888_Premultiplied);
+    QTest::newRow("xbgr8888") << uint(DRM_FORMAT_XBGR8888) << int(QImage::Format_RGBX8888);
+    QTest::newRow("rgb565") << uint(DRM_FORMAT_RGB565) << int(QImage::Format_RGB16);
+    QTest::newRow("nv12") << uint(DRM_FORMAT_NV12) << int(QImage::Format_Invalid);
+}
+
+void TestDmabufMapping::testImageFormat()
+{
+    QFETCH(uint, drmFormat);
+    QTEST(int(DmabufMapping::imageFormat(drmFormat)), "format");
+    testPrintlog();
+}
+
+void TestDmabufMapping::testLayout_data()
+{
+    QTest::addColumn<uint>("offset");
+    QTest::addColumn<uint>("stride");
+    QTest::addColumn<uint>("format");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("valid");
+
+    // the file is 4096 bytes
+    QTest::newRow("exact") << 0u << 64u << uint(DRM_FORMAT_ARGB8888) << QSize(16, 64) << true;
+    QTest::newRow("padded stride") << 0u << 128u << uint(DRM_FORMAT_XRGB8888) << QSize(16, 32) << true;
+    // the last row does not need the padding
+    QTest::newRow("unpadded last row") << 64u << 128u << uint(DRM_FORMAT_XRGB8888) << QSize(16, 32) << true;
+    QTest::newRow("rgb565") << 0u << 32u << uint(DRM_FORMAT_RGB565) << QSize(16, 128) << true;
+    QTest::newRow("too high") << 0u << 64u << uint(DRM_FORMAT_ARGB8888) << QSize(16, 65) << false;
+    QTest::newRow("offset too large") << 4u << 64u << uint(DRM_FORMAT_ARGB8888) << QSize(16, 64) << false;
+    QTest::newRow("stride too small") << 0u << 60u << uint(DRM_FORMAT_ARGB8888) << QSize(16, 16) << false;
+    QTest::newRow("empty") << 0u << 64u << uint(DRM_FORMAT_ARGB8888) << QSize(0, 0) << false;
+    QTest::newRow("yuv") << 0u << 16u << uint(DRM_FORMAT_NV12) << QSize(16, 16) << false;
+    QTest::newRow("overflow") << 0xffffff00u << 0xffffff00u << uint(DRM_FORMAT_ARGB8888) << QSize(16, 16) << false;
+}
+
+void TestDmabufMapping::testLayout()
+{
+    MemFd file(4096);
+    QVERIFY(file.fd() != -1);
+    QFETCH(uint, offset);
+    QFETCH(uint, stride);
+    QFETCH(uint, format);
+    QFETCH(QSize, size);
+    QTEST(DmabufMapping::isValidLayout(file.fd(), offset, stride, format, size), "valid");
+    // not a file at all
+    QVERIFY(!DmabufMapping::isValidLayout(-1, offset, stride, format, size));
+    testPrintlog();
+}
+
+void TestDmabufMapping::testMapping()
+{
+    MemFd file(4096);
+    QVERIFY(file.fd() != -1);
+    // a 2x2 xrgb image at an unaligned offset with a padded stride
+    QImage reference(2, 2, QImage::Format_RGB32);
+    reference.setPixel(0, 0, qRgb(255, 0, 0));
+    reference.setPixel(1, 0, qRgb(0, 255, 0));
+    reference.setPixel(0, 1, qRgb(0, 0, 255));
+    reference.setPixel(1, 1, qRgb(255, 255, 255));
+    for (int y = 0; y < 2; ++y) {
+        QVERIFY(file.write(100 + y * 16, QByteArray(reinterpret_cast<const char*>(reference.constScanLine(y)), 8)));
+    }
+
+    DmabufMapping mapping(file.fd(), 100, 16, DRM_FORMAT_XRGB8888, QSize(2, 2));
+    QVERIFY(mapping.isValid());
+    const QImage image = mapping.beginCpuAccess();
+    QCOMPARE(image.size(), QSize(2, 2));
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QCOMPARE(image.bytesPerLine(), 16);
+    QCOMPARE(image, reference);
+
+    // the mapping is shared, later writes by the client show up without a new mapping
+    const QRgb yellow = qRgb(255, 255, 0);
+    QVERIFY(file.write(100, QByteArray(reinterpret_cast<const char*>(&yellow), 4)));
+    QCOMPARE(image.pixel(0, 0), yellow);
+    mapping.endCpuAccess();
+    testPrintlog();
+}
+
+void TestDmabufMapping::testInvalidMapping()
+{
+    MemFd file(64);
+    QVERIFY(file.fd() != -1);
+    DmabufMapping mapping(file.fd(), 0, 64, DRM_FORMAT_ARGB8888, QSize(16, 2));
+    QVERIFY(!mapping.isValid());
+    QVERIFY(mapping.beginCpuAccess().isNull());
+    mapping.endCpuAccess();
+    testPrintlog();
+}
+
+void TestDmabufMapping::testUnsealedFile()
+{
+    // the client could truncate the file while it is mapped
+    MemFd file(4096, false);
+    QVERIFY(file.fd() != -1);
+    QVERIFY(!DmabufMapping::isValidLayout(file.fd(), 0, 64, DRM_FORMAT_ARGB8888, QSize(16, 64)));
+    DmabufMapping mapping(file.fd(), 0, 64, DRM_FORMAT_ARGB8888, QSize(16, 64));
+    QVERIFY(!mapping.isValid());
+    testPrintlog();
+}
+
+void TestDmabufMapping::testFileOffset()
+{
+    // the offset of the file is shared with the client and must not move
+    MemFd file(4096);
+    QVERIFY(file.fd() != -1);
+    QCOMPARE(lseek(file.fd(), 123, SEEK_SET), off_t(123));
+    QVERIFY(DmabufMapping::isValidLayout(file.fd(), 0, 64, DRM_FORMAT_ARGB8888, QSize(16, 64)));
+    DmabufMapping mapping(file.fd(), 0, 64, DRM_FORMAT_ARGB8888, QSize(16, 64));
+    QVERIFY(mapping.isValid());
+    QCOMPARE(lseek(file.fd(), 0, SEEK_CUR), off_t(123));
+    testPrintlog();
+}
+
+QTEST_GUILESS_MAIN(TestDmabufMapping)
+#include "test_dmabuf_mapping.moc"
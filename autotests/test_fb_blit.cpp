@@ -0,0 +1,142 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../plugins/platforms/fbdev/fb_blit.h"
+// Qt
+#include <QTemporaryFile>
+#include <QtTest>
+// system
+#include <cstring>
+#include <sys/mman.h>
+#include "testprintasanbase.h"
+
+using namespace KWin;
+
+Q_DECLARE_METATYPE(QImage::Format)
+
+/**
+ * A regular file mapped like the frame buffer device, stands in for /dev/fb0.
+ **/
+class MappedFile
+{
+public:
+    MappedFile(int length)
+        : m_length(length)
+    {
+        if (!m_file.open() || !m_file.resize(length)) {
+            return;
+        }
+        void *memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, m_file.handle(), 0);
+        if (memory != MAP_FAILED) {
+            m_memory = static_cast<uchar*>(memory);
+        }
+    }
+    ~MappedFile() {
+        if (m_memory) {
+            munmap(m_memory, m_length);
+        }
+    }
+    uchar *memory() const {
+        return m_memory;
+    }
+
+private:
+    QTemporaryFile m_file;
+    int m_length;
+    uchar *m_memory = nullptr;
+};
+
+class TestFramebufferBlit : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testBlit_data();
+    void testBlit();
+    void testClipped();
+
+private:
+    QImage createSource(const QSize &size) const;
+};
+
+QImage TestFramebufferBlit::createSource(const QSize &size) const
+{
+    QImage source(size, QImage::Format_RGB32);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            source.setPixel(x, y, qRgb(x * 7 % 256, y * 13 % 256, (x + y) * 3 % 256));
+        }
+    }
+    return source;
+}
+
+void TestFramebufferBlit::testBlit_data()
+{
+    QTest::addColumn<QImage::Format>("format");
+    QTest::addColumn<int>("bytesPerPixel");
+    QTest::addColumn<bool>("bgr");
+    QTest::addColumn<QRegion>("damage");
+
+    const QRegion odd = QRegion(3, 1, 37, 5) | QRegion(50, 20, 1, 1) | QRegion(10, 30, 21, 9);
+    QTest::newRow("bgr/full") << QImage::Format_RGB888 << 3 << true << QRegion(0, 0, 61, 40);
+    QTest::newRow("bgr/damage") << QImage::Format_RGB888 << 3 << true << odd;
+    QTest::newRow("rgb32/full") << QImage::Format_RGB32 << 4 << false << QRegion(0, 0, 61, 40);
+    QTest::newRow("rgb32/damage") << QImage::Format_RGB32 << 4 << false << odd;
+    QTest::newRow("rgb16/damage") << QImage::Format_RGB16 << 2 << false << odd;
+}
+
+void TestFramebufferBlit::testBlit()
+{
+    QFETCH(QImage::Format, format);
+    QFETCH(int, bytesPerPixel);
+    QFETCH(bool, bgr);
+    QFETCH(QRegion, damage);
+
+    const QSize size(61, 40);
+    // lines are padded like on many frame buffer drivers
+    const int bytesPerLine = (size.width() + 3) * bytesPerPixel;
+    MappedFile file(bytesPerLine * size.height());
+    QVERIFY(file.memory());
+    QImage framebuffer(file.memory(), size.width(), size.height(), bytesPerLine, format);
+    const QRgb background = qRgb(8, 16, 24);
+    framebuffer.fill(background);
+    const QRgb expectedBackground = framebuffer.pixel(0, 0);
+
+    const QImage source = createSource(size);
+    blitToFramebuffer(source, &framebuffer, damage, bgr);
+    QCOMPARE(framebuffer.constBits(), file.memory());
+
+    // the reference is converting a swapped copy of the whole image
+    const QImage expected = (bgr ? source.rgbSwapped() : source).convertToFormat(format);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            if (damage.contains(QPoint(x, y))) {
+                QCOMPARE(framebuffer.pixel(x, y), expected.pixel(x, y));
+            } else {
+                QCOMPARE(framebuffer.pixel(x, y), expectedBackground);
+            }
+        }
+    }
+    testPrintlog();
+}
+
+void TestFramebufferBlit::testClipped()
+{
+    const QSize size(20, 10);
+    const int bytesPerLine = size.width() * 3;
+    // a second page follows, which must not be touched
+    MappedFile file(bytesPerLine * size.height() * 2);
+    QVERIFY(file.memory());
+    std::memset(file.memory(), 0xab, bytesPerLine * size.height() * 2);
+    QImage framebuffer(file.memory(), size.width(), size.height(), bytesPerLine, QImage::Format_RGB888);
+
+    blitToFramebuffer(createSource(size), &framebuffer, QRegion(-5, -5, 100, 100), true);
+    for (int i = bytesPerLine * size.height(); i < bytesPerLine * size.height() * 2; ++i) {
+        QCOMPARE(file.memory()[i], uchar(0xab));
+    }
+    testPrintlog();
+}
+
+QTEST_GUILESS_MAIN(TestFramebufferBlit)
+#include "test_fb_blit.moc"
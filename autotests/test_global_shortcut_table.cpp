@@ -0,0 +1,170 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../globalshortcuttable.h"
+// Qt
+#include <QtTest>
+#include "testprintasanbase.h"
+
+using namespace KWin;
+
+typedef GlobalShortcutTable<int> Table;
+
+class TestGlobalShortcutTable : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testKey_data();
+    void testKey();
+    void testKeyEncoding();
+    void testInsert();
+    void testErase();
+    void benchmarkKey();
+    void benchmarkAxis();
+
+private:
+    Table m_keys;
+    Table m_axes;
+    QVector<int> m_typing;
+};
+
+void TestGlobalShortcutTable::initTestCase()
+{
+    // roughly what a desktop registers: function keys, digits and letters with a few modifiers
+    const Qt::KeyboardModifiers modifiers[] = {
+        Qt::MetaModifier, Qt::ControlModifier | Qt::AltModifier, Qt::AltModifier | Qt::ShiftModifier
+    };
+    int id = 0;
+    for (Qt::KeyboardModifiers mods : modifiers) {
+        for (int key = Qt::Key_F1; key <= Qt::Key_F12; ++key) {
+            m_keys.insert(Table::key(int(mods) | key), ++id);
+        }
+        for (int key = Qt::Key_0; key <= Qt::Key_9; ++key) {
+            m_keys.insert(Table::key(int(mods) | key), ++id);
+        }
+        for (int key = Qt::Key_A; key <= Qt::Key_Z; key += 3) {
+            m_keys.insert(Table::key(int(mods) | key), ++id);
+        }
+    }
+    // up, down, left and right
+    for (int axis = 0; axis < 4; ++axis) {
+        m_axes.insert(Table::key(Qt::MetaModifier | Qt::AltModifier, axis), axis + 1);
+    }
+    // plain typing with an occasional shortcut
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 50 == 0) {
+            m_typing << (Qt::MetaModifier | Qt::Key_F1);
+        } else {
+            m_typing << (int(i % 7 == 0 ? Qt::ShiftModifier : Qt::NoModifier) | (Qt::Key_A + i % 26));
+        }
+    }
+}
+
+void TestGlobalShortcutTable::testKey_data()
+{
+    QTest::addColumn<int>("keyQt");
+    QTest::addColumn<bool>("registered");
+
+    QTest::newRow("meta+f1") << int(Qt::MetaModifier | Qt::Key_F1) << true;
+    QTest::newRow("ctrl+alt+5") << int(Qt::ControlModifier | Qt::AltModifier | Qt::Key_5) << true;
+    QTest::newRow("f1") << int(Qt::Key_F1) << false;
+    QTest::newRow("ctrl+f1") << int(Qt::ControlModifier | Qt::Key_F1) << false;
+    QTest::newRow("meta+b") << int(Qt::MetaModifier | Qt::Key_B) << false;
+    QTest::newRow("alt+shift+d") << int(Qt::AltModifier | Qt::ShiftModifier | Qt::Key_D) << true;
+    QTest::newRow("a") << int(Qt::Key_A) << false;
+}
+
+void TestGlobalShortcutTable::testKey()
+{
+    QFETCH(int, keyQt);
+    QTEST(m_keys.contains(Table::key(keyQt)), "registered");
+    testPrintlog();
+}
+
+void TestGlobalShortcutTable::testKeyEncoding()
+{
+    // the combined Qt key and the separate modifiers end up under the same key
+    QCOMPARE(Table::key(Qt::MetaModifier | Qt::Key_Tab), Table::key(Qt::MetaModifier, Qt::Key_Tab));
+    QCOMPARE(Table::key(Qt::Key_Tab), Table::key(Qt::NoModifier, Qt::Key_Tab));
+    QVERIFY(Table::key(Qt::MetaModifier, Qt::Key_Tab) != Table::key(Qt::MetaModifier | Qt::ShiftModifier, Qt::Key_Tab));
+    // buttons and axes use the whole value range without running into the modifiers
+    QVERIFY(Table::key(Qt::NoModifier, Qt::MaxMouseButton) != Table::key(Qt::ShiftModifier, 0));
+    QVERIFY(Table::key(Qt::KeyboardModifierMask, 0xffffffff) != Table::key(Qt::NoModifier, 0xffffffff));
+    testPrintlog();
+}
+
+void TestGlobalShortcutTable::testInsert()
+{
+    Table table;
+    const quint64 key = Table::key(Qt::MetaModifier, Qt::LeftButton);
+    QCOMPARE(table.insert(key, 1), 0);
+    QCOMPARE(table.value(key), 1);
+    // registering the same combination again replaces the shortcut
+    QCOMPARE(table.insert(key, 2), 1);
+    QCOMPARE(table.value(key), 2);
+    QCOMPARE(table.count(), 1);
+    QCOMPARE(table.value(Table::key(Qt::NoModifier, Qt::LeftButton)), 0);
+    QCOMPARE(table.take(key), 2);
+    QVERIFY(!table.contains(key));
+    testPrintlog();
+}
+
+void TestGlobalShortcutTable::testErase()
+{
+    Table table;
+    for (int i = 0; i < 10; ++i) {
+        table.insert(Table::key(Qt::AltModifier, i), i);
+    }
+    auto it = table.begin();
+    while (it != table.end()) {
+        if (it.value() % 2) {
+            it = table.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    QCOMPARE(table.count(), 5);
+    QVERIFY(table.contains(Table::key(Qt::AltModifier, 4)));
+    QVERIFY(!table.contains(Table::key(Qt::AltModifier, 5)));
+    table.clear();
+    QCOMPARE(table.count(), 0);
+    testPrintlog();
+}
+
+void TestGlobalShortcutTable::benchmarkKey()
+{
+    int triggered = 0;
+    QBENCHMARK {
+        triggered = 0;
+        for (int keyQt : qAsConst(m_typing)) {
+            if (m_keys.contains(Table::key(keyQt))) {
+                triggered++;
+            }
+        }
+    }
+    QCOMPARE(triggered, 20);
+    testPrintlog();
+}
+
+void TestGlobalShortcutTable::benchmarkAxis()
+{
+    // a free-wheeling scroll, with and without the modifiers of the shortcut
+    int triggered = 0;
+    QBENCHMARK {
+        triggered = 0;
+        for (int i = 0; i < 1000; ++i) {
+            const Qt::KeyboardModifiers mods = i % 2 ? Qt::MetaModifier | Qt::AltModifier : Qt::NoModifier;
+            if (m_axes.value(Table::key(mods, i % 2 ? 1 : 0))) {
+                triggered++;
+            }
+        }
+    }
+    QCOMPARE(triggered, 500);
+    testPrintlog();
+}
+
+QTEST_GUILESS_MAIN(TestGlobalShortcutTable)
+#include "test_global_shortcut_table.moc"
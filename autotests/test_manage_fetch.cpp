@@ -0,0 +1,199 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "testutils.h"
+// KWin
+#include "../xcbutils.h"
+// Qt
+#include <QApplication>
+#include <QtTest>
+#include <QX11Info>
+#include <netwm.h>
+// xcb
+#include <xcb/xcb.h>
+#include <xcb/shape.h>
+#include "testprintasanbase.h"
+Q_LOGGING_CATEGORY(KWIN_CORE, "kwin_core")
+
+using namespace KWin;
+
+namespace
+{
+
+// the NET properties Client::manage reads through its WinInfo
+const NET::Properties s_properties = NET::WMDesktop | NET::WMState | NET::WMWindowType | NET::WMStrut
+        | NET::WMName | NET::WMIconGeometry | NET::WMIcon | NET::WMPid | NET::WMIconName;
+const NET::Properties2 s_properties2 = NET::WM2BlockCompositing | NET::WM2WindowClass | NET::WM2WindowRole
+        | NET::WM2UserTime | NET::WM2StartupId | NET::WM2ExtendedStrut | NET::WM2Opacity
+        | NET::WM2FullscreenMonitors | NET::WM2FrameOverlap | NET::WM2GroupLeader | NET::WM2Urgency
+        | NET::WM2Input | NET::WM2Protocols | NET::WM2InitialMappingState | NET::WM2IconPixmap
+        | NET::WM2OpaqueRegion | NET::WM2DesktopFileName | NET::WM2ClientMachine;
+
+}
+
+/**
+ * Tests the helpers Client::manage uses to read the properties of a new window in one batch:
+ * the requests are issued up front and the NETWinInfo flushes them, the replies are read afterwards.
+ * Meant to run against Xvfb like the other X11 tests.
+ **/
+class TestManageFetch : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+    void testTextProperty();
+    void testShape();
+    void testShapeChangedAfterFetch();
+    void benchmarkSerialized();
+    void benchmarkBatched();
+
+private:
+    void setProperty(xcb_window_t window, xcb_atom_t property, xcb_atom_t type, uint8_t format,
+                     const void *data, uint32_t length);
+    void setBoundingShape(xcb_window_t window);
+    QVector<xcb_window_t> m_windows;
+    QScopedPointer<Xcb::Atom> m_utf8String;
+};
+
+void TestManageFetch::initTestCase()
+{
+    qApp->setProperty("x11RootWindow", QVariant::fromValue<quint32>(QX11Info::appRootWindow()));
+    qApp->setProperty("x11Connection", QVariant::fromValue<void*>(QX11Info::connection()));
+    m_utf8String.reset(new Xcb::Atom(QByteArrayLiteral("UTF8_STRING")));
+}
+
+void TestManageFetch::cleanupTestCase()
+{
+    Xcb::Extensions::destroy();
+}
+
+void TestManageFetch::init()
+{
+    // legacy clients without NET names, so WM_NAME and WM_ICON_NAME are needed as well
+    for (int i = 0; i < 20; ++i) {
+        const xcb_window_t w = createWindow();
+        const QByteArray name = QByteArrayLiteral("window ") + QByteArray::number(i);
+        setProperty(w, XCB_ATOM_WM_NAME, *m_utf8String, 8, name.constData(), name.length());
+        setProperty(w, XCB_ATOM_WM_ICON_NAME, XCB_ATOM_STRING, 8, name.constData(), name.length());
+        m_windows << w;
+    }
+    xcb_flush(connection());
+}
+
+void TestManageFetch::cleanup()
+{
+    for (xcb_window_t w : qAsConst(m_windows)) {
+        xcb_destroy_window(connection(), w);
+    }
+    m_windows.clear();
+    xcb_flush(connection());
+}
+
+void TestManageFetch::setProperty(xcb_window_t window, xcb_atom_t property, xcb_atom_t type, uint8_t format,
+                                  const void *data, uint32_t length)
+{
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, window, property, type, format, length, data);
+}
+
+void TestManageFetch::setBoundingShape(xcb_window_t window)
+{
+    const xcb_rectangle_t rect = { 0, 0, 5, 5 };
+    xcb_shape_rectangles(connection(), XCB_SHAPE_SO_SET, XCB_SHAPE_SK_BOUNDING, XCB_CLIP_ORDERING_UNSORTED,
+                         window, 0, 0, 1, &rect);
+}
+
+void TestManageFetch::testTextProperty()
+{
+    for (int i = 0; i < m_windows.count(); ++i) {
+        const xcb_window_t w = m_windows.at(i);
+        Xcb::TextProperty name(w, XCB_ATOM_WM_NAME);
+        Xcb::TextProperty iconName(w, XCB_ATOM_WM_ICON_NAME);
+        // flushes the batch, like the WinInfo in Client::manage
+        NETWinInfo info(connection(), w, rootWindow(), s_properties, s_properties2);
+        QVERIFY(!info.name());
+
+        const QString expected = QStringLiteral("window %1").arg(i);
+        QCOMPARE(name.toString(*m_utf8String), expected);
+        QCOMPARE(iconName.toString(*m_utf8String), expected);
+    }
+    testPrintlog();
+}
+
+void TestManageFetch::testShape()
+{
+    if (!Xcb::Extensions::self()->isShapeAvailable()) {
+        QSKIP("The X server does not support the shape extension");
+    }
+    const QRect geometry(0, 0, 10, 10);
+    const uint32_t values[] = { true };
+    Xcb::Window unshaped(geometry, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_CW_OVERRIDE_REDIRECT, values);
+    Xcb::Window shaped(geometry, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_CW_OVERRIDE_REDIRECT, values);
+    setBoundingShape(shaped);
+
+    Xcb::ShapeExtents unshapedExtents = Xcb::Extensions::self()->fetchShape(unshaped);
+    Xcb::ShapeExtents shapedExtents = Xcb::Extensions::self()->fetchShape(shaped);
+    QVERIFY(!Xcb::Extensions::self()->hasShape(unshapedExtents));
+    QVERIFY(Xcb::Extensions::self()->hasShape(shapedExtents));
+
+    // the synchronous overload gives the same answer
+    QVERIFY(!Xcb::Extensions::self()->hasShape(unshaped));
+    QVERIFY(Xcb::Extensions::self()->hasShape(shaped));
+    testPrintlog();
+}
+
+void TestManageFetch::testShapeChangedAfterFetch()
+{
+    if (!Xcb::Extensions::self()->isShapeAvailable()) {
+        QSKIP("The X server does not support the shape extension");
+    }
+    // the reply reflects the shape at the time of the query, Client::manage selects the
+    // shape input before so a later change arrives as an event
+    const QRect geometry(0, 0, 10, 10);
+    const uint32_t values[] = { true };
+    Xcb::Window window(geometry, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_CW_OVERRIDE_REDIRECT, values);
+    Xcb::ShapeExtents extents = Xcb::Extensions::self()->fetchShape(window);
+    setBoundingShape(window);
+    QVERIFY(!Xcb::Extensions::self()->hasShape(extents));
+    QVERIFY(Xcb::Extensions::self()->hasShape(window));
+    testPrintlog();
+}
+
+void TestManageFetch::benchmarkSerialized()
+{
+    // every reply is waited for before the next request goes out
+    QBENCHMARK {
+        for (xcb_window_t w : qAsConst(m_windows)) {
+            NETWinInfo info(connection(), w, rootWindow(), s_properties, s_properties2);
+            Xcb::TextProperty(w, XCB_ATOM_WM_NAME).toString(*m_utf8String);
+            Xcb::ShapeExtents extents = Xcb::Extensions::self()->fetchShape(w);
+            Xcb::Extensions::self()->hasShape(extents);
+            Xcb::TextProperty(w, XCB_ATOM_WM_ICON_NAME).toString(*m_utf8String);
+        }
+    }
+    testPrintlog();
+}
+
+void TestManageFetch::benchmarkBatched()
+{
+    QBENCHMARK {
+        for (xcb_window_t w : qAsConst(m_windows)) {
+            Xcb::TextProperty name(w, XCB_ATOM_WM_NAME);
+            Xcb::TextProperty iconName(w, XCB_ATOM_WM_ICON_NAME);
+            Xcb::ShapeExtents extents = Xcb::Extensions::self()->fetchShape(w);
+            NETWinInfo info(connection(), w, rootWindow(), s_properties, s_properties2);
+            name.toString(*m_utf8String);
+            Xcb::Extensions::self()->hasShape(extents);
+            iconName.toString(*m_utf8String);
+        }
+    }
+    testPrintlog();
+}
+
+Q_CONSTRUCTOR_FUNCTION(forceXcb)
+QTEST_MAIN(TestManageFetch)
+#include "test_manage_fetch.moc"
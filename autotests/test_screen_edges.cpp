@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Frameworks
 #include <KConfigGroup>
 // Qt
+#include <QMouseEvent>
 #include <QtTest>
 #include <QX11Info>
 // xcb
@@ -133,6 +134,8 @@ private Q_SLOTS:
     void testTouchEdge();
     void testTouchCallback_data();
     void testTouchCallback();
+    void benchmarkIsEntered_data();
+    void benchmarkIsEntered();
 };
 
 void TestScreenEdges::initTestCase()
@@ -1085,6 +1088,48 @@ void TestScreenEdges::testTouchCallback()
     testPrintlog();
 }
 
+void TestScreenEdges::benchmarkIsEntered_data()
+{
+    QTest::addColumn<QPoint>("pos");
+
+    QTest::newRow("center") << QPoint(1536, 384);
+    QTest::newRow("output border") << QPoint(1024, 384);
+    QTest::newRow("approaching left") << QPoint(5, 384);
+    QTest::newRow("approaching corner") << QPoint(3067, 763);
+}
+
+void TestScreenEdges::benchmarkIsEntered()
+{
+    using namespace KWin;
+    MockWorkspace ws;
+    static_cast<MockScreens*>(screens())->setGeometries(QList<QRect>{QRect{0, 0, 1024, 768}, QRect{1024, 0, 1024, 768}, QRect{2048, 0, 1024, 768}});
+    QSignalSpy changedSpy(screens(), SIGNAL(changed()));
+    QVERIFY(changedSpy.isValid());
+    // first is before it's updated
+    QVERIFY(changedSpy.wait());
+    // second is after it's updated
+    QVERIFY(changedSpy.wait());
+    auto s = ScreenEdges::self();
+    s->init();
+    TestObject callback;
+    s->reserve(ElectricLeft, &callback, "callback");
+    s->reserve(ElectricTopLeft, &callback, "callback");
+    s->reserve(ElectricTop, &callback, "callback");
+    s->reserve(ElectricTopRight, &callback, "callback");
+    s->reserve(ElectricRight, &callback, "callback");
+    s->reserve(ElectricBottomRight, &callback, "callback");
+    s->reserve(ElectricBottom, &callback, "callback");
+    s->reserve(ElectricBottomLeft, &callback, "callback");
+
+    // cost of a pointer motion event which does not trigger an edge
+    QFETCH(QPoint, pos);
+    QMouseEvent event(QEvent::MouseMove, pos, pos, Qt::NoButton, Qt::NoButton, Qt::NoModifier);
+    QBENCHMARK {
+        s->isEntered(&event);
+    }
+    testPrintlog();
+}
+
 Q_CONSTRUCTOR_FUNCTION(forceXcb)
 QTEST_MAIN(TestScreenEdges)
 #include "test_screen_edges.moc"
@@ -0,0 +1,307 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../sessioninfostore.h"
+#include "../sm.h"
+// Qt
+#include <QtTest>
+#include "testprintasanbase.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace KWin;
+
+namespace
+{
+
+// the properties of a window looking for its session entry
+struct Window {
+    QByteArray sessionId;
+    QByteArray windowRole;
+    QByteArray wmCommand;
+    QByteArray resourceName;
+    QByteArray resourceClass;
+    NET::WindowType windowType;
+};
+
+SessionInfo *createInfo(int id, const Window &window)
+{
+    SessionInfo *info = new SessionInfo;
+    info->sessionId = window.sessionId;
+    info->windowRole = window.windowRole;
+    info->wmCommand = window.wmCommand;
+    info->resourceName = window.resourceName;
+    info->resourceClass = window.resourceClass;
+    info->windowType = window.windowType;
+    info->stackingOrder = id;
+    info->tabGroup = 0;
+    info->tabGroupClient = nullptr;
+    return info;
+}
+
+// the linear scan Workspace::takeSessionInfo used to do
+SessionInfo *takeLinear(QList<SessionInfo *> &session, const Window &window)
+{
+    for (SessionInfo *info : qAsConst(session)) {
+        if (info->windowType != window.windowType) {
+            continue;
+        }
+        bool match;
+        if (!window.sessionId.isEmpty()) {
+            match = info->sessionId == window.sessionId
+                && (window.windowRole.isEmpty()
+                    ? info->windowRole.isEmpty()
+                        && info->resourceName == window.resourceName
+                        && info->resourceClass == window.resourceClass
+                    : info->windowRole == window.windowRole);
+        } else {
+            match = info->resourceName == window.resourceName
+                && info->resourceClass == window.resourceClass
+                && (window.wmCommand.isEmpty() || info->wmCommand == window.wmCommand);
+        }
+        if (match) {
+            session.removeOne(info);
+            return info;
+        }
+    }
+    return nullptr;
+}
+
+SessionInfo *take(SessionInfoStore &store, const Window &window)
+{
+    auto typeMatch = [&window] (const SessionInfo *info) {
+        return info->windowType == window.windowType;
+    };
+    if (!window.sessionId.isEmpty()) {
+        return store.takeSessionManaged(window.sessionId, window.windowRole,
+                                        window.resourceName, window.resourceClass, typeMatch);
+    }
+    return store.takeByResource(window.resourceName, window.resourceClass, window.wmCommand, typeMatch);
+}
+
+}
+
+class TestSessionInfoStore : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFirstMatchWins();
+    void testSessionManaged();
+    void testWmCommand();
+    void testTabGroup();
+    void testRestoreLargeSession();
+    void benchmarkRestoreLinear();
+    void benchmarkRestore();
+};
+
+void TestSessionInfoStore::testFirstMatchWins()
+{
+    SessionInfoStore store;
+    const Window window{QByteArray(), QByteArray(), QByteArrayLiteral("konsole"),
+                        QByteArrayLiteral("konsole"), QByteArrayLiteral("konsole"), NET::Normal};
+    Window dialog = window;
+    dialog.windowType = NET::Dialog;
+    store.add(createInfo(1, dialog));
+    store.add(createInfo(2, window));
+    store.add(createInfo(3, window));
+    QCOMPARE(store.count(), 3);
+
+    // the dialog entry does not match the window type
+    QScopedPointer<SessionInfo> info(take(store, window));
+    QVERIFY(info);
+    QCOMPARE(info->stackingOrder, 2);
+    info.reset(take(store, window));
+    QVERIFY(info);
+    QCOMPARE(info->stackingOrder, 3);
+    QVERIFY(!take(store, window));
+    info.reset(take(store, dialog));
+    QVERIFY(info);
+    QCOMPARE(info->stackingOrder, 1);
+    QVERIFY(store.isEmpty());
+    testPrintlog();
+}
+
+void TestSessionInfoStore::testSessionManaged()
+{
+    SessionInfoStore store;
+    const Window withRole{QByteArrayLiteral("session"), QByteArrayLiteral("main"), QByteArray(),
+                          QByteArrayLiteral("dolphin"), QByteArrayLiteral("dolphin"), NET::Normal};
+    Window withoutRole = withRole;
+    withoutRole.windowRole = QByteArray();
+    Window otherClass = withoutRole;
+    otherClass.resourceClass = QByteArrayLiteral("other");
+    store.add(createInfo(1, otherClass));
+    store.add(createInfo(2, withRole));
+    store.add(createInfo(3, withoutRole));
+
+    // without window role the resource has to match
+    QScopedPointer<SessionInfo> info(take(store, withoutRole));
+    QVERIFY(info);
+    QCOMPARE(info->stackingOrder, 3);
+    QVERIFY(!take(store, withoutRole));
+    info.reset(take(store, withRole));
+    QVERIFY(info);
+    QCOMPARE(info->stackingOrder, 2);
+
+    // a window without session id can take a session managed entry
+    Window unmanaged = otherClass;
+    unmanaged.sessionId = QByteArray();
+    info.reset(take(store, unmanaged));
+    QVERIFY(info);
+    QCOMPARE(info->stackingOrder, 1);
+    QVERIFY(store.isEmpty());
+    testPrintlog();
+}
+
+void TestSessionInfoStore::testWmCommand()
+{
+    SessionInfoStore store;
+    const Window first{QByteArray(), QByteArray(), QByteArrayLiteral("xterm -e top"),
+                       QByteArrayLiteral("xterm"), QByteArrayLiteral("xterm"), NET::Normal};
+    Window second = first;
+    second.wmCommand = QByteArrayLiteral("xterm -e htop");
+    store.add(createInfo(1, first));
+    store.add(createInfo(2, second));
+
+    QScopedPointer<SessionInfo> info(take(store, second));
+    QVERIFY(info);
+    QCOMPARE(info->stackingOrder, 2);
+    QVERIFY(!take(store, second));
+
+    // without WM_COMMAND any entry of the resource matches
+    Window any = first;
+    any.wmCommand = QByteArray();
+    info.reset(take(store, any));
+    QVERIFY(info);
+    QCOMPARE(info->stackingOrder, 1);
+    QVERIFY(store.isEmpty());
+    testPrintlog();
+}
+
+void TestSessionInfoStore::testTabGroup()
+{
+    SessionInfoStore store;
+    Window window{QByteArrayLiteral("session"), QByteArray(), QByteArray(),
+                  QByteArrayLiteral("app"), QByteArrayLiteral("app"), NET::Normal};
+    QVector<SessionInfo *> infos;
+    for (int i = 0; i < 3; ++i) {
+        window.windowRole = QByteArray::number(i);
+        SessionInfo *info = createInfo(i, window);
+        info->tabGroup = i < 2 ? 42 : 7;
+        infos << info;
+        store.add(info);
+    }
+    Client *client = reinterpret_cast<Client *>(quintptr(0x1000));
+    window.windowRole = QByteArrayLiteral("0");
+    QScopedPointer<SessionInfo> info(take(store, window));
+    QVERIFY(info);
+    store.setTabGroupClient(info->tabGroup, client);
+    QCOMPARE(infos[1]->tabGroupClient, client);
+    QVERIFY(!infos[2]->tabGroupClient);
+
+    // the first client of the group stays
+    window.windowRole = QByteArrayLiteral("1");
+    info.reset(take(store, window));
+    QVERIFY(info);
+    store.setTabGroupClient(info->tabGroup, reinterpret_cast<Client *>(quintptr(0x2000)));
+    QCOMPARE(info->tabGroupClient, client);
+    testPrintlog();
+}
+
+// a synthetic session of 1000 windows, half of them session managed, the others only
+// identified by resource and WM_COMMAND, with plenty of duplicates
+static QVector<Window> largeSession()
+{
+    const int count = 1000;
+    QVector<Window> windows;
+    windows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Window window;
+        const QByteArray app = QByteArrayLiteral("app") + QByteArray::number(i % 37);
+        window.resourceName = app;
+        window.resourceClass = app;
+        window.windowType = i % 11 ? NET::Normal : NET::Dialog;
+        if (i % 2) {
+            window.sessionId = QByteArrayLiteral("session") + QByteArray::number(i % 97);
+            if (i % 3) {
+                window.windowRole = QByteArrayLiteral("role") + QByteArray::number(i % 5);
+            }
+        } else if (i % 4) {
+            window.wmCommand = app + QByteArrayLiteral(" --instance ") + QByteArray::number(i % 13);
+        }
+        windows << window;
+    }
+    return windows;
+}
+
+// windows get mapped in a different order than they got saved
+static QVector<Window> mappingOrder(QVector<Window> windows)
+{
+    std::mt19937 random(windows.count());
+    std::shuffle(windows.begin(), windows.end(), random);
+    return windows;
+}
+
+void TestSessionInfoStore::testRestoreLargeSession()
+{
+    const QVector<Window> windows = largeSession();
+    SessionInfoStore store;
+    QList<SessionInfo *> reference;
+    for (int i = 0; i < windows.count(); ++i) {
+        store.add(createInfo(i, windows[i]));
+        reference << createInfo(i, windows[i]);
+    }
+    QCOMPARE(store.count(), windows.count());
+
+    for (const Window &window : mappingOrder(windows)) {
+        QScopedPointer<SessionInfo> expected(takeLinear(reference, window));
+        QScopedPointer<SessionInfo> info(take(store, window));
+        // windows without WM_COMMAND can take the entry another window was saved with
+        QCOMPARE(bool(info), bool(expected));
+        if (info) {
+            QCOMPARE(info->stackingOrder, expected->stackingOrder);
+        }
+    }
+    QCOMPARE(store.count(), reference.count());
+    qDeleteAll(reference);
+    testPrintlog();
+}
+
+void TestSessionInfoStore::benchmarkRestoreLinear()
+{
+    const QVector<Window> windows = largeSession();
+    const QVector<Window> mapped = mappingOrder(windows);
+    QBENCHMARK {
+        QList<SessionInfo *> session;
+        for (int i = 0; i < windows.count(); ++i) {
+            session << createInfo(i, windows[i]);
+        }
+        for (const Window &window : mapped) {
+            delete takeLinear(session, window);
+        }
+        qDeleteAll(session);
+    }
+    testPrintlog();
+}
+
+void TestSessionInfoStore::benchmarkRestore()
+{
+    const QVector<Window> windows = largeSession();
+    const QVector<Window> mapped = mappingOrder(windows);
+    QBENCHMARK {
+        SessionInfoStore store;
+        for (int i = 0; i < windows.count(); ++i) {
+            store.add(createInfo(i, windows[i]));
+        }
+        for (const Window &window : mapped) {
+            delete take(store, window);
+        }
+    }
+    testPrintlog();
+}
+
+QTEST_GUILESS_MAIN(TestSessionInfoStore)
+#include "test_session_info_store.moc"
@@ -0,0 +1,236 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../smartplacement.h"
+// Qt
+#include <QRandomGenerator>
+#include <QtTest>
+#include "testprintasanbase.h"
+
+using namespace KWin;
+
+Q_DECLARE_METATYPE(QVector<SmartPlacement::Window>)
+
+/**
+ * The smart placement as Placement::placeSmart implemented it before, going over all windows
+ * for every candidate position.
+ **/
+static QPoint referencePlacement(const QRect &maxRect, const QSize &size, const QVector<SmartPlacement::Window> &windows)
+{
+    const int none = 0, h_wrong = -1, w_wrong = -2; // overlap types
+    long int overlap, min_overlap = 0;
+    int x_optimal, y_optimal;
+    int possible;
+
+    int cxl, cxr, cyt, cyb;     //temp coords
+    int  xl, xr, yt, yb;     //temp coords
+    int basket;                 //temp holder
+
+    int x = maxRect.left(), y = maxRect.top();
+    x_optimal = x; y_optimal = y;
+
+    int ch = size.height() - 1;
+    int cw = size.width()  - 1;
+
+    bool first_pass = true;
+
+    do {
+        if (y + ch > maxRect.bottom() && ch < maxRect.height())
+            overlap = h_wrong;
+        else if (x + cw > maxRect.right())
+            overlap = w_wrong;
+        else {
+            overlap = none;
+
+            cxl = x; cxr = x + cw;
+            cyt = y; cyb = y + ch;
+            for (const SmartPlacement::Window &window : windows) {
+                xl = window.left;  yt = window.top;
+                xr = window.right; yb = window.bottom;
+
+                if ((cxl < xr) && (cxr > xl) &&
+                        (cyt < yb) && (cyb > yt)) {
+                    xl = qMax(cxl, xl); xr = qMin(cxr, xr);
+                    yt = qMax(cyt, yt); yb = qMin(cyb, yb);
+                    overlap += window.weight * (xr - xl) * (yb - yt);
+                }
+            }
+        }
+
+        if (overlap == none) {
+            x_optimal = x;
+            y_optimal = y;
+            break;
+        }
+
+        if (first_pass) {
+            first_pass = false;
+            min_overlap = overlap;
+        }
+        else if (overlap >= none && overlap < min_overlap) {
+            min_overlap = overlap;
+            x_optimal = x;
+            y_optimal = y;
+        }
+
+        if (overlap > none) {
+            possible = maxRect.right();
+            if (possible - cw > x) possible -= cw;
+
+            for (const SmartPlacement::Window &window : windows) {
+                xl = window.left;  yt = window.top;
+                xr = window.right; yb = window.bottom;
+
+                if ((y < yb) && (yt < ch + y)) {
+                    if ((xr > x) && (possible > xr)) possible = xr;
+
+                    basket = xl - cw;
+                    if ((basket > x) && (possible > basket)) possible = basket;
+                }
+            }
+            x = possible;
+        }
+        else if (overlap == w_wrong) {
+            x = maxRect.left();
+            possible = maxRect.bottom();
+
+            if (possible - ch > y) possible -= ch;
+
+            for (const SmartPlacement::Window &window : windows) {
+                yt = window.top;
+                yb = window.bottom;
+
+                if ((yb > y) && (possible > yb)) possible = yb;
+
+                basket = yt - ch;
+                if ((basket > y) && (possible > basket)) possible = basket;
+            }
+            y = possible;
+        }
+    } while ((overlap != none) && (overlap != h_wrong) && (y < maxRect.bottom()));
+
+    if (ch >= maxRect.height())
+        y_optimal = maxRect.top();
+
+    return QPoint(x_optimal, y_optimal);
+}
+
+static SmartPlacement::Window window(const QRect &geometry, int weight = 1)
+{
+    return SmartPlacement::Window{geometry.x(), geometry.y(),
+                                  geometry.x() + geometry.width(), geometry.y() + geometry.height(),
+                                  weight};
+}
+
+static QVector<SmartPlacement::Window> randomLayout(QRandomGenerator *random, const QRect &area, int count)
+{
+    static const int weights[] = { 1, 1, 1, 1, 16, 0 };
+    QVector<SmartPlacement::Window> windows;
+    for (int i = 0; i < count; ++i) {
+        const QSize size(random->bounded(50, area.width()), random->bounded(50, area.height()));
+        // some windows stick out of the area
+        const QPoint pos(area.x() + random->bounded(-100, area.width()), area.y() + random->bounded(-100, area.height()));
+        windows << window(QRect(pos, size), weights[random->bounded(6)]);
+    }
+    return windows;
+}
+
+class TestSmartPlacement : public TestPrintAsanBase
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testPlacement_data();
+    void testPlacement();
+    void testRandomLayouts_data();
+    void testRandomLayouts();
+    void benchmarkReference();
+    void benchmarkSmartPlacement();
+};
+
+void TestSmartPlacement::testPlacement_data()
+{
+    QTest::addColumn<QVector<SmartPlacement::Window>>("windows");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<QPoint>("expected");
+
+    QTest::newRow("empty") << QVector<SmartPlacement::Window>() << QSize(400, 300) << QPoint(0, 0);
+    QTest::newRow("right of window")
+        << QVector<SmartPlacement::Window>{window(QRect(0, 0, 500, 400))} << QSize(400, 300) << QPoint(500, 0);
+    QTest::newRow("below window")
+        << QVector<SmartPlacement::Window>{window(QRect(0, 0, 1500, 400))} << QSize(400, 300) << QPoint(0, 400);
+    // with no free space the position covering the least wins, the first one on a tie
+    QTest::newRow("least overlap")
+        << QVector<SmartPlacement::Window>{window(QRect(0, 0, 1024, 768)), window(QRect(600, 0, 424, 768))}
+        << QSize(400, 300) << QPoint(0, 0);
+    QTest::newRow("avoid keep above")
+        << QVector<SmartPlacement::Window>{window(QRect(0, 0, 1024, 768)), window(QRect(0, 0, 400, 768), 16)}
+        << QSize(400, 300) << QPoint(400, 0);
+    QTest::newRow("ignore keep below")
+        << QVector<SmartPlacement::Window>{window(QRect(0, 0, 1024, 768), 0)} << QSize(400, 300) << QPoint(0, 0);
+    QTest::newRow("too high") << QVector<SmartPlacement::Window>() << QSize(400, 1000) << QPoint(0, 0);
+}
+
+void TestSmartPlacement::testPlacement()
+{
+    QFETCH(QVector<SmartPlacement::Window>, windows);
+    QFETCH(QSize, size);
+    const QRect area(0, 0, 1024, 768);
+    QTEST(SmartPlacement(windows).place(area, size), "expected");
+    QCOMPARE(referencePlacement(area, size, windows), SmartPlacement(windows).place(area, size));
+    testPrintlog();
+}
+
+void TestSmartPlacement::testRandomLayouts_data()
+{
+    QTest::addColumn<QRect>("area");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("few") << QRect(0, 0, 1920, 1080) << 5;
+    QTest::newRow("some") << QRect(0, 0, 1920, 1080) << 20;
+    QTest::newRow("many") << QRect(0, 0, 1920, 1080) << 100;
+    QTest::newRow("second screen") << QRect(1920, 32, 2560, 1408) << 40;
+    QTest::newRow("wide") << QRect(0, 0, 5120, 1440) << 150;
+}
+
+void TestSmartPlacement::testRandomLayouts()
+{
+    QFETCH(QRect, area);
+    QFETCH(int, count);
+    QRandomGenerator random(count);
+    for (int i = 0; i < 50; ++i) {
+        const QVector<SmartPlacement::Window> windows = randomLayout(&random, area, count);
+        const SmartPlacement placement(windows);
+        for (int j = 0; j < 5; ++j) {
+            const QSize size(random.bounded(50, area.width() + 100), random.bounded(50, area.height() + 100));
+            QCOMPARE(placement.place(area, size), referencePlacement(area, size, windows));
+        }
+    }
+    testPrintlog();
+}
+
+void TestSmartPlacement::benchmarkReference()
+{
+    const QRect area(0, 0, 5120, 1440);
+    QRandomGenerator random(150);
+    const QVector<SmartPlacement::Window> windows = randomLayout(&random, area, 150);
+    QBENCHMARK {
+        referencePlacement(area, QSize(800, 600), windows);
+    }
+    testPrintlog();
+}
+
+void TestSmartPlacement::benchmarkSmartPlacement()
+{
+    const QRect area(0, 0, 5120, 1440);
+    QRandomGenerator random(150);
+    const QVector<SmartPlacement::Window> windows = randomLayout(&random, area, 150);
+    QBENCHMARK {
+        SmartPlacement(windows).place(area, QSize(800, 600));
+    }
+    testPrintlog();
+}
+
+QTEST_GUILESS_MAIN(TestSmartPlacement)
+#include "test_smart_placement.moc"
@@ -52,6 +52,7 @@ private Q_SLOTS:
     void testTransientFor();
     void testPropertyByteArray();
     void testPropertyBool();
+    void testTextProperty();
     void testAtom();
     void testMotifEmpty();
     void testMotif_data();
@@ -379,6 +380,33 @@ void TestXcbWrapper::testPropertyByteArray()
     QCOMPARE(QByteArray(StringProperty(testWindow, XCB_ATOM_WM_NAME)), QByteArray());
 }
 
+void TestXcbWrapper::testTextProperty()
+{
+    Window testWindow(createWindow());
+    Atom utf8String(QByteArrayLiteral("UTF8_STRING"));
+    QVERIFY(utf8String.isValid());
+    // not set
+    QVERIFY(TextProperty(testWindow, XCB_ATOM_WM_NAME).toString(utf8String).isNull());
+
+    const QByteArray utf8 = QStringLiteral("  f\u00f6\u00f6   bar ").toUtf8();
+    testWindow.changeProperty(XCB_ATOM_WM_NAME, utf8String, 8, utf8.length(), utf8.constData());
+    QCOMPARE(TextProperty(testWindow, XCB_ATOM_WM_NAME).toString(utf8String), QStringLiteral("f\u00f6\u00f6 bar"));
+
+    testWindow.changeProperty(XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, 3, "foo");
+    QCOMPARE(TextProperty(testWindow, XCB_ATOM_WM_NAME).toString(utf8String), QStringLiteral("foo"));
+
+    // the property got requested before it changed, the reply carries the old value
+    TextProperty pending(testWindow, XCB_ATOM_WM_NAME);
+    testWindow.changeProperty(XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, 3, "bar");
+    QCOMPARE(pending.toString(utf8String), QStringLiteral("foo"));
+
+    // other encodings are not supported
+    Atom compoundText(QByteArrayLiteral("COMPOUND_TEXT"));
+    testWindow.changeProperty(XCB_ATOM_WM_NAME, compoundText, 8, 3, "foo");
+    QVERIFY(TextProperty(testWindow, XCB_ATOM_WM_NAME).toString(utf8String).isNull());
+    testPrintlog();
+}
+
 void TestXcbWrapper::testPropertyBool()
 {
     Window testWindow(createWindow());
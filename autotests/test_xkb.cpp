@@ -19,9 +19,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "../xkb.h"
 
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QtConcurrent>
 #include <QtTest>
+#include <xkbcommon/xkbcommon.h>
 #include <xkbcommon/xkbcommon-keysyms.h>
 #include "testprintasanbase.h"
+#include <fcntl.h>
+#include <sys/mman.h>
 using namespace KWin;
 
 class XkbTest : public TestPrintAsanBase
@@ -32,6 +39,12 @@ private Q_SLOTS:
     void testToQtKey();
     void testFromQtKey_data();
     void testFromQtKey();
+    void testKeymapNames();
+    void testCompiledKeymap();
+    void testKeymapStaysActiveWhileCompiling();
+    void testConfigChangeDuringCompilation();
+    void testCachedKeymapAppliesSynchronously();
+    void testCacheKeepsActiveKeymap();
 };
 
 // from kwindowsystem/src/platforms/xcb/kkeyserver.cpp
@@ -510,5 +523,243 @@ void XkbTest::testFromQtKey()
     testPrintlog();
 }
 
+void XkbTest::testKeymapNames()
+{
+    const CompiledKeymap::Names defaults{QByteArray(), QByteArray(), QByteArray(), QByteArray(), QByteArray()};
+    CompiledKeymap::Names names = defaults;
+    QCOMPARE(names, defaults);
+    // an empty name does not select the default like a null one does
+    names.options = QByteArray("");
+    QVERIFY(names != defaults);
+    QVERIFY(qHash(names) != qHash(defaults));
+    names.options = QByteArray();
+    names.layout = QByteArrayLiteral("us");
+    QVERIFY(names != defaults);
+    QCOMPARE(qHash(names), qHash(CompiledKeymap::Names{QByteArray(), QByteArray(), QByteArrayLiteral("us"), QByteArray(), QByteArray()}));
+    testPrintlog();
+}
+
+void XkbTest::testCompiledKeymap()
+{
+    const QSharedPointer<CompiledKeymap> keymap = CompiledKeymap::compile(
+        CompiledKeymap::Names{QByteArray(), QByteArrayLiteral("pc104"), QByteArrayLiteral("us"), QByteArray(), QByteArray()});
+    if (!keymap) {
+        QSKIP("No xkb data to compile a keymap from");
+    }
+    QVERIFY(keymap->keymap());
+    QVERIFY(keymap->fd() >= 0);
+
+    // the file holds the keymap as text including the terminating null
+    QScopedPointer<char, QScopedPointerPodDeleter> expected(xkb_keymap_get_as_string(keymap->keymap(), XKB_KEYMAP_FORMAT_TEXT_V1));
+    QCOMPARE(keymap->size(), quint32(qstrlen(expected.data()) + 1));
+    char *map = reinterpret_cast<char*>(mmap(nullptr, keymap->size(), PROT_READ, MAP_PRIVATE, keymap->fd(), 0));
+    QVERIFY(map != MAP_FAILED);
+    QCOMPARE(QByteArray(map, keymap->size()), QByteArray(expected.data(), keymap->size()));
+    munmap(map, keymap->size());
+
+#ifdef F_SEAL_SEAL
+    // clients share the file, none of them may modify it
+    const int seals = fcntl(keymap->fd(), F_GET_SEALS);
+    if (seals >= 0) {
+        QVERIFY(seals & F_SEAL_WRITE);
+        QVERIFY(seals & F_SEAL_SHRINK);
+        QVERIFY(seals & F_SEAL_SEAL);
+    }
+#endif
+    testPrintlog();
+}
+
+static bool canCompileKeymaps()
+{
+    return !CompiledKeymap::compile(
+        CompiledKeymap::Names{QByteArray(), QByteArrayLiteral("pc104"), QByteArrayLiteral("us"), QByteArray(), QByteArray()}).isNull();
+}
+
+static void setLayoutList(const KSharedConfigPtr &config, const QString &layouts)
+{
+    KConfigGroup layoutGroup = config->group("Layout");
+    layoutGroup.writeEntry("Model", "pc104");
+    layoutGroup.writeEntry("LayoutList", layouts);
+    layoutGroup.writeEntry("Options", QString());
+}
+
+void XkbTest::testKeymapStaysActiveWhileCompiling()
+{
+    if (!canCompileKeymaps()) {
+        QSKIP("No xkb data to compile a keymap from");
+    }
+    KSharedConfigPtr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    setLayoutList(config, QStringLiteral("us"));
+    Xkb xkb;
+    xkb.setConfig(config);
+    QSignalSpy keymapChangedSpy(&xkb, &Xkb::keymapChanged);
+    QVERIFY(keymapChangedSpy.isValid());
+
+    xkb.reconfigure();
+    QVERIFY(xkb.isCompilingKeymap());
+    QVERIFY(keymapChangedSpy.wait());
+    QVERIFY(xkb.keymap());
+    QCOMPARE(xkb.numberOfLayouts(), 1u);
+    xkb_keymap *previous = xkb.keymap();
+
+    // the new layout compiles in a thread, keys keep using the old keymap meanwhile
+    setLayoutList(config, QStringLiteral("us,de"));
+    xkb.reconfigure();
+    QVERIFY(xkb.isCompilingKeymap());
+    QCOMPARE(xkb.keymap(), previous);
+    QCOMPARE(xkb.numberOfLayouts(), 1u);
+    QCOMPARE(keymapChangedSpy.count(), 1);
+
+    QVERIFY(keymapChangedSpy.wait());
+    QVERIFY(!xkb.isCompilingKeymap());
+    QVERIFY(xkb.keymap() != previous);
+    QCOMPARE(xkb.numberOfLayouts(), 2u);
+    testPrintlog();
+}
+
+void XkbTest::testConfigChangeDuringCompilation()
+{
+    if (!canCompileKeymaps()) {
+        QSKIP("No xkb data to compile a keymap from");
+    }
+    KSharedConfigPtr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    setLayoutList(config, QStringLiteral("us"));
+    Xkb xkb;
+    xkb.setConfig(config);
+    QSignalSpy keymapChangedSpy(&xkb, &Xkb::keymapChanged);
+    QVERIFY(keymapChangedSpy.isValid());
+
+    xkb.reconfigure();
+    QVERIFY(xkb.isCompilingKeymap());
+    // changed before the first compilation finished, which is then outdated
+    setLayoutList(config, QStringLiteral("us,de,fr"));
+    xkb.reconfigure();
+    QVERIFY(xkb.isCompilingKeymap());
+
+    // only the keymap of the last configuration becomes active
+    QTRY_VERIFY(!xkb.isCompilingKeymap());
+    QCOMPARE(keymapChangedSpy.count(), 1);
+    QCOMPARE(xkb.numberOfLayouts(), 3u);
+    testPrintlog();
+}
+
+void XkbTest::testCachedKeymapAppliesSynchronously()
+{
+    if (!canCompileKeymaps()) {
+        QSKIP("No xkb data to compile a keymap from");
+    }
+    KSharedConfigPtr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    setLayoutList(config, QStringLiteral("us"));
+    Xkb xkb;
+    xkb.setConfig(config);
+    QSignalSpy keymapChangedSpy(&xkb, &Xkb::keymapChanged);
+    QVERIFY(keymapChangedSpy.isValid());
+
+    xkb.reconfigure();
+    QVERIFY(keymapChangedSpy.wait());
+    xkb_keymap *us = xkb.keymap();
+    setLayoutList(config, QStringLiteral("us,de"));
+    xkb.reconfigure();
+    QVERIFY(keymapChangedSpy.wait());
+    QCOMPARE(xkb.numberOfLayouts(), 2u);
+
+    // switching back finds the keymap compiled before and applies it right away
+    setLayoutList(config, QStringLiteral("us"));
+    xkb.reconfigure();
+    QVERIFY(!xkb.isCompilingKeymap());
+    QCOMPARE(keymapChangedSpy.count(), 3);
+    QCOMPARE(xkb.keymap(), us);
+    QCOMPARE(xkb.numberOfLayouts(), 1u);
+    testPrintlog();
+}
+
+/**
+ * Occupies the only thread of the global pool, so queued compilations wait until it goes away.
+ * Constructing it waits for the compilation running before.
+ **/
+class PoolBlocker
+{
+public:
+    PoolBlocker() {
+        m_future = QtConcurrent::run([this] {
+            m_started.release();
+            m_released.acquire();
+        });
+        m_started.acquire();
+    }
+    ~PoolBlocker() {
+        m_released.release();
+        m_future.waitForFinished();
+    }
+
+private:
+    QSemaphore m_started;
+    QSemaphore m_released;
+    QFuture<void> m_future;
+};
+
+void XkbTest::testCacheKeepsActiveKeymap()
+{
+    if (!canCompileKeymaps()) {
+        QSKIP("No xkb data to compile a keymap from");
+    }
+    KSharedConfigPtr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    setLayoutList(config, QStringLiteral("us"));
+    Xkb xkb;
+    xkb.setConfig(config);
+    QSignalSpy keymapChangedSpy(&xkb, &Xkb::keymapChanged);
+    QVERIFY(keymapChangedSpy.isValid());
+
+    xkb.reconfigure();
+    QVERIFY(keymapChangedSpy.wait());
+    xkb_keymap *us = xkb.keymap();
+
+    // each compilation finishes after the configuration changed again, so it gets cached but
+    // not applied and the active keymap becomes the least recently used one of the cache
+    const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(1);
+    setLayoutList(config, QStringLiteral("de"));
+    xkb.reconfigure();
+    setLayoutList(config, QStringLiteral("fr"));
+    xkb.reconfigure();
+    const QStringList layouts = {
+        QStringLiteral("us,de"),
+        QStringLiteral("us,fr"),
+        QStringLiteral("de,fr")
+    };
+    for (const QString &layout : layouts) {
+        PoolBlocker blocker;
+        // delivers the finished compilation, which starts the next one behind the blocker
+        QCoreApplication::processEvents();
+        QVERIFY(xkb.isCompilingKeymap());
+        QCOMPARE(xkb.keymap(), us);
+        setLayoutList(config, layout);
+        xkb.reconfigure();
+    }
+    QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+    // the cache overflowed while "us" was still active, only the last layout gets applied
+    QVERIFY(keymapChangedSpy.wait());
+    QVERIFY(!xkb.isCompilingKeymap());
+    QCOMPARE(keymapChangedSpy.count(), 2);
+    QCOMPARE(xkb.numberOfLayouts(), 2u);
+
+    // the keymap active during the eviction is still cached
+    setLayoutList(config, QStringLiteral("us"));
+    xkb.reconfigure();
+    QVERIFY(!xkb.isCompilingKeymap());
+    QCOMPARE(keymapChangedSpy.count(), 3);
+    QCOMPARE(xkb.keymap(), us);
+
+    // while the oldest of the others got evicted
+    setLayoutList(config, QStringLiteral("de"));
+    xkb.reconfigure();
+    QVERIFY(xkb.isCompilingKeymap());
+    QCOMPARE(keymapChangedSpy.count(), 3);
+    QVERIFY(keymapChangedSpy.wait());
+    QCOMPARE(xkb.numberOfLayouts(), 1u);
+    QVERIFY(xkb.keymap() != us);
+    testPrintlog();
+}
+
 QTEST_MAIN(XkbTest)
 #include "test_xkb.moc"
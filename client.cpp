@@ -19,6 +19,7 @@
 #include "focuschain.h"
 #include "group.h"
 #include "shadow.h"
+#include "windowidentity.h"
 #include "workspace.h"
 #include "screenedge.h"
 #include "decorations/decorationbridge.h"
@@ -42,7 +43,6 @@
 // XLib
 #include <X11/Xutil.h>
 #include <fixx11h.h>
-#include <xcb/xcb_icccm.h>
 // system
 #include <unistd.h>
 #include <signal.h>
@@ -1503,29 +1503,24 @@ void Client::fetchName()
     setCaption(readName());
 }
 
-static inline QString readNameProperty(xcb_window_t w, xcb_atom_t atom)
+Xcb::TextProperty Client::fetchWmName() const
 {
-    const auto cookie = xcb_icccm_get_text_property_unchecked(connection(), w, atom);
-    xcb_icccm_get_text_property_reply_t reply;
-    if (xcb_icccm_get_wm_name_reply(connection(), cookie, &reply, nullptr)) {
-        QString retVal;
-        if (reply.encoding == atoms->utf8_string) {
-            retVal = QString::fromUtf8(QByteArray(reply.name, reply.name_len));
-        } else if (reply.encoding == XCB_ATOM_STRING) {
-            retVal = QString::fromLocal8Bit(QByteArray(reply.name, reply.name_len));
-        }
-        xcb_icccm_get_text_property_reply_wipe(&reply);
-        return retVal.simplified();
-    }
-    return QString();
+    return Xcb::TextProperty(window(), XCB_ATOM_WM_NAME);
 }
 
 QString Client::readName() const
 {
+    Xcb::TextProperty wmName = fetchWmName();
+    return readName(wmName);
+}
+
+QString Client::readName(Xcb::TextProperty &wmName) const
+{
+    // WM_NAME is only waited for if _NET_WM_NAME is not set, otherwise its reply gets discarded
     if (info->name() && info->name()[0] != '\0')
         return QString::fromUtf8(info->name()).simplified();
     else {
-        return readNameProperty(window(), XCB_ATOM_WM_NAME);
+        return wmName.toString(atoms->utf8_string);
     }
 }
 
@@ -1596,13 +1591,24 @@ void Client::updateCaption()
     setCaption(cap_normal, true);
 }
 
+Xcb::TextProperty Client::fetchWmIconName() const
+{
+    return Xcb::TextProperty(window(), XCB_ATOM_WM_ICON_NAME);
+}
+
 void Client::fetchIconicName()
+{
+    Xcb::TextProperty wmIconName = fetchWmIconName();
+    readIconicName(wmIconName);
+}
+
+void Client::readIconicName(Xcb::TextProperty &wmIconName)
 {
     QString s;
     if (info->iconName() && info->iconName()[0] != '\0')
         s = QString::fromUtf8(info->iconName());
     else
-        s = readNameProperty(window(), XCB_ATOM_WM_ICON_NAME);
+        s = wmIconName.toString(atoms->utf8_string);
     if (s != cap_iconic) {
         bool was_set = !cap_iconic.isEmpty();
         cap_iconic = s;
@@ -1667,31 +1673,84 @@ void Client::getMotifHints()
 
 void Client::getIcons()
 {
-    // First read icons from the window itself
-    const QString themedIconName = iconFromDesktopFile();
-    if (!themedIconName.isEmpty()) {
-        setIcon(QIcon::fromTheme(themedIconName));
-        return;
-    }
-    // Second read icons from the environment GIO_LAUNCHED_DESKTOP_FILE
-    const QString gioIconName = iconFromGioDesktopFile();
-    if (!gioIconName.isEmpty()) {
-        setIcon(QIcon::fromTheme(gioIconName));
+    // Desktop files are resolved in a worker thread, a newer request supersedes
+    // the callbacks of the older ones
+    const quint32 serial = ++m_iconSerial;
+    const QByteArray gioDesktopFileName = m_gioDesktopFileName;
+    // First read icons from the desktop file
+    resolveDesktopFileIcon(desktopFileName(), serial,
+        [this, serial, gioDesktopFileName] {
+            // Second read icons from the environment GIO_LAUNCHED_DESKTOP_FILE
+            resolveDesktopFileIcon(gioDesktopFileName, serial,
+                [this] {
+                    getIconsFromWindow();
+                }
+            );
+        }
+    );
+}
+
+void Client::resolveDesktopFileIcon(const QByteArray &desktopFileName, quint32 serial, std::function<void ()> fallback)
+{
+    if (desktopFileName.isEmpty() || !WindowIdentity::self()) {
+        fallback();
         return;
     }
+    WindowIdentity::self()->resolveIconName(desktopFileName, this,
+        [this, serial, fallback] (const QString &iconName) {
+            if (serial != m_iconSerial) {
+                return;
+            }
+            if (iconName.isEmpty()) {
+                fallback();
+            } else {
+                setIcon(QIcon::fromTheme(iconName));
+            }
+        }
+    );
+}
 
+void Client::getIconsFromWindow()
+{
     QIcon icon;
-    auto readIcon = [this, &icon](int size, bool scale = true) {
-        const QPixmap pix = KWindowSystem::icon(window(), size, size, scale, KWindowSystem::NETWM | KWindowSystem::WMHints, info);
-        if (!pix.isNull()) {
-            icon.addPixmap(pix);
+    // _NET_WM_ICON got fetched along with the other properties, pick the best match for each size
+    // and convert every distinct image only once instead of going through KWindowSystem::icon
+    // for every size
+    struct {
+        int size;
+        bool scale;
+    } const sizes[] = { {16, true}, {32, true}, {48, false}, {64, false}, {128, false} };
+    QHash<const unsigned char*, QImage> images;
+    for (const auto &s : sizes) {
+        const NETIcon netIcon = info->icon(s.size, s.size);
+        if (!netIcon.data) {
+            continue;
         }
-    };
-    readIcon(16);
-    readIcon(32);
-    readIcon(48, false);
-    readIcon(64, false);
-    readIcon(128, false);
+        auto it = images.find(netIcon.data);
+        if (it == images.end()) {
+            // every distinct image is part of the icon at its own size, no matter which
+            // requested size found it first
+            it = images.insert(netIcon.data, QImage(netIcon.data, netIcon.size.width, netIcon.size.height, QImage::Format_ARGB32).copy());
+            icon.addPixmap(QPixmap::fromImage(*it));
+        }
+        if (s.scale && it->size() != QSize(s.size, s.size)) {
+            icon.addPixmap(QPixmap::fromImage(it->scaled(s.size, s.size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)));
+        }
+    }
+    if (icon.isNull()) {
+        // the window might still provide an icon through WM_HINTS
+        auto readIcon = [this, &icon](int size, bool scale = true) {
+            const QPixmap pix = KWindowSystem::icon(window(), size, size, scale, KWindowSystem::WMHints, info);
+            if (!pix.isNull()) {
+                icon.addPixmap(pix);
+            }
+        };
+        readIcon(16);
+        readIcon(32);
+        readIcon(48, false);
+        readIcon(64, false);
+        readIcon(128, false);
+    }
     if (icon.isNull()) {
         // Then try window group
         icon = group()->icon();
@@ -1718,14 +1777,23 @@ void Client::getIcons()
     setIcon(icon);
 }
 
-void Client::getSyncCounter()
+Xcb::Property Client::fetchSyncCounter() const
 {
     // TODO: make sync working on XWayland
     static const bool isX11 = kwinApp()->operationMode() == Application::OperationModeX11;
     if (!Xcb::Extensions::self()->isSyncAvailable() || !isX11)
-        return;
+        return Xcb::Property();
+    return Xcb::Property(false, window(), atoms->net_wm_sync_request_counter, XCB_ATOM_CARDINAL, 0, 1);
+}
 
-    Xcb::Property syncProp(false, window(), atoms->net_wm_sync_request_counter, XCB_ATOM_CARDINAL, 0, 1);
+void Client::getSyncCounter()
+{
+    Xcb::Property syncProp = fetchSyncCounter();
+    readSyncCounter(syncProp);
+}
+
+void Client::readSyncCounter(Xcb::Property &syncProp)
+{
     const xcb_sync_counter_t counter = syncProp.value<xcb_sync_counter_t>(XCB_NONE);
     if (counter != XCB_NONE) {
         syncRequest.counter = counter;
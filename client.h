@@ -20,6 +20,8 @@
 #include <QPointer>
 #include <QPixmap>
 #include <QWindow>
+
+#include <functional>
 // X
 #include <xcb/sync.h>
 
@@ -408,9 +410,15 @@ private:
     void getWmNormalHints();
     void getMotifHints();
     void getIcons();
+    void resolveDesktopFileIcon(const QByteArray &desktopFileName, quint32 serial, std::function<void ()> fallback);
+    void getIconsFromWindow();
     void fetchName();
     void fetchIconicName();
+    Xcb::TextProperty fetchWmIconName() const;
+    void readIconicName(Xcb::TextProperty &wmIconName);
     QString readName() const;
+    Xcb::TextProperty fetchWmName() const;
+    QString readName(Xcb::TextProperty &wmName) const;
     void setCaption(const QString& s, bool force = false);
     bool hasTransientInternal(const Client* c, bool indirect, ConstClientList& set) const;
     void setShortcutInternal() override;
@@ -419,6 +427,8 @@ private:
     NETExtendedStrut strut() const;
     int checkShadeGeometry(int w, int h);
     void getSyncCounter();
+    Xcb::Property fetchSyncCounter() const;
+    void readSyncCounter(Xcb::Property &syncProp);
     void sendSyncRequest();
     void leaveMoveResize() override;
     void positionGeometryTip() override;
@@ -558,6 +568,8 @@ private:
 
     QMetaObject::Connection m_edgeRemoveConnection;
     QMetaObject::Connection m_edgeGeometryTrackingConnection;
+    // increased with every getIcons, outdated desktop file lookups are ignored
+    quint32 m_iconSerial = 0;
 };
 
 inline xcb_window_t Client::wrapperId() const
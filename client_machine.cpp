@@ -167,7 +167,16 @@ void ClientMachine::resolve(xcb_window_t window, xcb_window_t clientLeader)
     if (m_resolved) {
         return;
     }
-    QByteArray name = NETWinInfo(connection(), window, rootWindow(), NET::Properties(), NET::WM2ClientMachine).clientMachine();
+    resolve(NETWinInfo(connection(), window, rootWindow(), NET::Properties(), NET::WM2ClientMachine).clientMachine(),
+            window, clientLeader);
+}
+
+void ClientMachine::resolve(const QByteArray &windowMachine, xcb_window_t window, xcb_window_t clientLeader)
+{
+    if (m_resolved) {
+        return;
+    }
+    QByteArray name = windowMachine;
     if (name.isEmpty() && clientLeader && clientLeader != window) {
         name = NETWinInfo(connection(), clientLeader, rootWindow(), NET::Properties(), NET::WM2ClientMachine).clientMachine();
     }
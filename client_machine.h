@@ -55,6 +55,11 @@ public:
     virtual ~ClientMachine();
 
     void resolve(xcb_window_t window, xcb_window_t clientLeader);
+    /**
+     * Resolves with the already fetched WM_CLIENT_MACHINE @p windowMachine of @p window.
+     * The property of @p clientLeader is only fetched if @p windowMachine is empty.
+     **/
+    void resolve(const QByteArray &windowMachine, xcb_window_t window, xcb_window_t clientLeader);
     const QByteArray &hostName() const;
     bool isLocal() const;
     static QByteArray localhost();
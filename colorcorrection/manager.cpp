@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <main.h>
 #include <platform.h>
 #include <abstract_output.h>
+#include <composite.h>
 #include <screens.h>
 #include <workspace.h>
 #include <logind.h>
@@ -35,6 +36,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTimer>
 #include <QDBusConnection>
 #include <QSocketNotifier>
+#include <QVector>
 
 #ifdef Q_OS_LINUX
 #include <sys/timerfd.h>
@@ -47,6 +49,8 @@ namespace ColorCorrect {
 
 static const int QUICK_ADJUST_DURATION = 2000;
 static const int TEMPERATURE_STEP = 50;
+// lower bound for the steps of outputs which block on each gamma ramp commit
+static const int LEGACY_QUICK_ADJUST_INTERVAL = 100;
 
 static bool checkLocation(double lat, double lng)
 {
@@ -249,38 +253,78 @@ void Manager::resetQuickAdjustTimer()
     // allow tolerance of one TEMPERATURE_STEP to compensate if a slow update is coincidental
     if (tempDiff > TEMPERATURE_STEP) {
         cancelAllTimers();
+        // outputs which commit their ramp with the next frame step on each of their own
+        // presentations, the timer steps the others, where each step is a blocking ioctl
         m_quickAdjustTimer = new QTimer(this);
-        m_quickAdjustTimer->setSingleShot(false);
-        connect(m_quickAdjustTimer, &QTimer::timeout, this, &Manager::quickAdjust);
-
-        int interval = QUICK_ADJUST_DURATION / (tempDiff / TEMPERATURE_STEP);
-        if (interval == 0) {
-            interval = 1;
+        m_quickAdjustTimer->setInterval(qMax(LEGACY_QUICK_ADJUST_INTERVAL, QUICK_ADJUST_DURATION / (tempDiff / TEMPERATURE_STEP)));
+        connect(m_quickAdjustTimer, &QTimer::timeout, this, [this] { quickAdjust(nullptr); });
+        if (Compositor::self()) {
+            // bound to the timer, so the connection goes away with the quick adjust
+            connect(Compositor::self(), &Compositor::outputPresented, m_quickAdjustTimer,
+                [this] (AbstractOutput *output) {
+                    if (output->presentsGammaRampWithFrame()) {
+                        quickAdjust(output);
+                    }
+                }
+            );
         }
-        m_quickAdjustTimer->start(interval);
+
+        // the temperature follows the elapsed time, so the transition takes the same time
+        // and is equally smooth independent of the distance
+        m_quickAdjustStartTemp = m_currentTemp;
+        m_outputTemps.clear();
+        m_quickAdjustElapsed.start();
+        m_quickAdjustTimer->start();
+        quickAdjust(nullptr);
     } else {
         resetSlowUpdateStartTimer();
     }
 }
 
-void Manager::quickAdjust()
+void Manager::quickAdjust(AbstractOutput *presented)
 {
     if (!m_quickAdjustTimer) {
         return;
     }
 
-    int nextTemp;
-    int targetTemp = currentTargetTemp();
+    const int targetTemp = currentTargetTemp();
+    const qreal progress = qMin(qreal(1.0), m_quickAdjustElapsed.elapsed() / qreal(QUICK_ADJUST_DURATION));
+    const int nextTemp = progress < 1.0
+            ? qRound(m_quickAdjustStartTemp + (targetTemp - m_quickAdjustStartTemp) * progress) : targetTemp;
 
-    if (m_currentTemp < targetTemp) {
-        nextTemp = qMin(m_currentTemp + TEMPERATURE_STEP, targetTemp);
-    } else {
-        nextTemp = qMax(m_currentTemp - TEMPERATURE_STEP, targetTemp);
+    // on a presentation only that output steps, on the timer every output which lags behind,
+    // this also restarts outputs whose presentations stopped because no step was due
+    bool reached = true;
+    const auto outs = kwinApp()->platform()->outputs();
+    for (auto *o : outs) {
+        const int rampsize = o->getGammaRampSize();
+        if (rampsize <= 0) {
+            continue;
+        }
+        const int temp = m_outputTemps.value(o, m_quickAdjustStartTemp);
+        if ((!presented || o == presented) && temp != nextTemp) {
+            GammaRamp ramp(rampsize);
+            fillGammaRamp(&ramp, nextTemp);
+            if (!commitGammaRamp(o, ramp)) {
+                if (!m_quickAdjustTimer) {
+                    // committing failed too often
+                    return;
+                }
+                reached = false;
+                continue;
+            }
+            m_outputTemps[o] = nextTemp;
+            m_currentTemp = nextTemp;
+        }
+        if (m_outputTemps.value(o, m_quickAdjustStartTemp) != targetTemp) {
+            reached = false;
+        }
     }
-    commitGammaRamps(nextTemp);
 
-    if (nextTemp == targetTemp) {
-        // stop timer, we reached the target temp
+    if (reached) {
+        // stop timer, we reached the target temp on all outputs
+        m_currentTemp = targetTemp;
+        m_outputTemps.clear();
         delete m_quickAdjustTimer;
         m_quickAdjustTimer = nullptr;
         resetSlowUpdateStartTimer();
@@ -508,58 +552,92 @@ int Manager::currentTargetTemp() const
     }
 }
 
+void Manager::fillGammaRamp(GammaRamp *ramp, int temperature)
+{
+    /*
+     * The gamma calculation below is based on the Redshift app:
+     * https://github.com/jonls/redshift
+     */
+
+    // approximate white point
+    float whitePoint[3];
+    float alpha = (temperature % 100) / 100.;
+    int bbCIndex = ((temperature - 1000) / 100) * 3;
+    whitePoint[0] = (1. - alpha) * blackbodyColor[bbCIndex] + alpha * blackbodyColor[bbCIndex + 3];
+    whitePoint[1] = (1. - alpha) * blackbodyColor[bbCIndex + 1] + alpha * blackbodyColor[bbCIndex + 4];
+    whitePoint[2] = (1. - alpha) * blackbodyColor[bbCIndex + 2] + alpha * blackbodyColor[bbCIndex + 5];
+
+    // scale the linear default state by the white point
+    const int rampsize = ramp->size;
+    const float step = float(UINT16_MAX + 1) / rampsize;
+    for (int i = 0; i < rampsize; i++) {
+        const float value = i * step;
+        ramp->red[i] = value * whitePoint[0];
+        ramp->green[i] = value * whitePoint[1];
+        ramp->blue[i] = value * whitePoint[2];
+    }
+}
+
+bool Manager::commitGammaRamp(AbstractOutput *output, const GammaRamp &ramp)
+{
+    if (output->setGammaRamp(ramp)) {
+        m_failedCommitAttempts = 0;
+        return true;
+    }
+    m_failedCommitAttempts++;
+    if (m_failedCommitAttempts < 10) {
+        qCWarning(KWIN_COLORCORRECTION).nospace() << "Committing Gamma Ramp failed for output " << output->name() <<
+                 ". Trying " << (10 - m_failedCommitAttempts) << " times more.";
+    } else {
+        // TODO: On multi monitor setups we could try to rollback earlier changes for already commited outputs
+        qCWarning(KWIN_COLORCORRECTION) << "Gamma Ramp commit failed too often. Deactivating color correction for now.";
+        m_failedCommitAttempts = 0; // reset so we can try again later (i.e. after suspend phase or config change)
+        m_running = false;
+        cancelAllTimers();
+    }
+    return false;
+}
+
 void Manager::commitGammaRamps(int temperature)
 {
     const auto outs = kwinApp()->platform()->outputs();
 
-    for (auto *o : outs) {
-        int rampsize = o->getGammaRampSize();
-        GammaRamp ramp(rampsize);
-
-        /*
-         * The gamma calculation below is based on the Redshift app:
-         * https://github.com/jonls/redshift
-         */
-
-        // linear default state
-        for (int i = 0; i < rampsize; i++) {
-                uint16_t value = (double)i / rampsize * (UINT16_MAX + 1);
-                ramp.red[i] = value;
-                ramp.green[i] = value;
-                ramp.blue[i] = value;
+    // outputs usually share the ramp size, compute each ramp only once
+    QVector<GammaRamp*> ramps;
+    auto rampForSize = [&ramps, temperature] (int rampsize) {
+        for (GammaRamp *ramp : qAsConst(ramps)) {
+            if (int(ramp->size) == rampsize) {
+                return ramp;
+            }
         }
+        GammaRamp *ramp = new GammaRamp(rampsize);
+        fillGammaRamp(ramp, temperature);
+        ramps << ramp;
+        return ramp;
+    };
 
-        // approximate white point
-        float whitePoint[3];
-        float alpha = (temperature % 100) / 100.;
-        int bbCIndex = ((temperature - 1000) / 100) * 3;
-        whitePoint[0] = (1. - alpha) * blackbodyColor[bbCIndex] + alpha * blackbodyColor[bbCIndex + 3];
-        whitePoint[1] = (1. - alpha) * blackbodyColor[bbCIndex + 1] + alpha * blackbodyColor[bbCIndex + 4];
-        whitePoint[2] = (1. - alpha) * blackbodyColor[bbCIndex + 2] + alpha * blackbodyColor[bbCIndex + 5];
-
-        for (int i = 0; i < rampsize; i++) {
-            ramp.red[i] = (double)ramp.red[i] / (UINT16_MAX+1) * whitePoint[0] * (UINT16_MAX+1);
-            ramp.green[i] = (double)ramp.green[i] / (UINT16_MAX+1) * whitePoint[1] * (UINT16_MAX+1);
-            ramp.blue[i] = (double)ramp.blue[i] / (UINT16_MAX+1) * whitePoint[2] * (UINT16_MAX+1);
+    bool applied = false;
+    bool failed = false;
+    for (auto *o : outs) {
+        int rampsize = o->getGammaRampSize();
+        if (rampsize <= 0) {
+            // the output has no gamma control, which is not a failure of the commit
+            continue;
         }
-
-        if (o->setGammaRamp(ramp)) {
-            m_currentTemp = temperature;
-            m_failedCommitAttempts = 0;
+        if (commitGammaRamp(o, *rampForSize(rampsize))) {
+            applied = true;
         } else {
-            m_failedCommitAttempts++;
-            if (m_failedCommitAttempts < 10) {
-                qCWarning(KWIN_COLORCORRECTION).nospace() << "Committing Gamma Ramp failed for output " << o->name() <<
-                         ". Trying " << (10 - m_failedCommitAttempts) << " times more.";
-            } else {
-                // TODO: On multi monitor setups we could try to rollback earlier changes for already commited outputs
-                qCWarning(KWIN_COLORCORRECTION) << "Gamma Ramp commit failed too often. Deactivating color correction for now.";
-                m_failedCommitAttempts = 0; // reset so we can try again later (i.e. after suspend phase or config change)
-                m_running = false;
-                cancelAllTimers();
+            failed = true;
+            if (!m_running) {
+                break;
             }
         }
     }
+    qDeleteAll(ramps);
+    // also when no output has gamma control, otherwise a transition would never reach its target
+    if (applied || !failed) {
+        m_currentTemp = temperature;
+    }
 }
 
 QHash<QString, QVariant> Manager::info() const
@@ -24,14 +24,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kwin_export.h>
 
 #include <QObject>
+#include <QHash>
 #include <QPair>
 #include <QDateTime>
+#include <QElapsedTimer>
 
 class QTimer;
 
 namespace KWin
 {
 
+class AbstractOutput;
 class Platform;
 
 namespace ColorCorrect
@@ -41,6 +44,7 @@ typedef QPair<QDateTime,QDateTime> DateTimes;
 typedef QPair<QTime,QTime> Times;
 
 class ColorCorrectDBusInterface;
+struct GammaRamp;
 
 
 enum NightColorMode {
@@ -79,7 +83,10 @@ public:
 
 public Q_SLOTS:
     void resetSlowUpdateStartTimer();
-    void quickAdjust();
+    /**
+     * Steps the quick adjust on @p presented, or on all outputs lagging behind if it's @c null.
+     **/
+    void quickAdjust(AbstractOutput *presented);
 
 Q_SIGNALS:
     void configChange(QHash<QString, QVariant> data);
@@ -104,7 +111,8 @@ private:
     DateTimes getSunTimings(QDate date, double latitude, double longitude, bool morning) const;
     bool checkAutomaticSunTimings() const;
     bool daylight() const;
-
+    static void fillGammaRamp(GammaRamp *ramp, int temperature);
+    bool commitGammaRamp(AbstractOutput *output, const GammaRamp &ramp);
     void commitGammaRamps(int temperature);
 
     ColorCorrectDBusInterface *m_iface;
@@ -133,6 +141,10 @@ private:
     QTimer *m_slowUpdateStartTimer = nullptr;
     QTimer *m_slowUpdateTimer = nullptr;
     QTimer *m_quickAdjustTimer = nullptr;
+    QElapsedTimer m_quickAdjustElapsed;
+    int m_quickAdjustStartTemp = NEUTRAL_TEMPERATURE;
+    // temperature of each output during a quick adjust, outputs step independently
+    QHash<AbstractOutput*, int> m_outputTemps;
 
     int m_currentTemp = NEUTRAL_TEMPERATURE;
     int m_dayTargetTemp = NEUTRAL_TEMPERATURE;
@@ -21,6 +21,7 @@
 #include "useractions.h"
 #include "xcbutils.h"
 #include "platform.h"
+#include "abstract_output.h"
 #include "shell_client.h"
 #include "wayland_server.h"
 #include "decorations/decoratedclient.h"
@@ -103,6 +104,9 @@ void CompositorSelectionOwner::looseOwnership()
 
 KWIN_SINGLETON_FACTORY_VARIABLE(Compositor, s_compositor)
 
+// interval in milliseconds at which surfaces which are not visible get their frame callbacks
+static const int s_throttledFrameCallbackInterval = 1000;
+
 static inline qint64 milliToNano(int milli) { return qint64(milli) * 1000 * 1000; }
 static inline qint64 nanoToMilli(int nano) { return nano / (1000*1000); }
 
@@ -138,6 +142,10 @@ Compositor::Compositor(QObject* workspace)
     m_unusedSupportPropertyTimer.setSingleShot(true);
     connect(&m_unusedSupportPropertyTimer, SIGNAL(timeout()), SLOT(deleteUnusedSupportProperties()));
 
+    m_throttledFrameCallbackTimer.setInterval(s_throttledFrameCallbackInterval);
+    m_throttledFrameCallbackTimer.setSingleShot(true);
+    connect(&m_throttledFrameCallbackTimer, &QTimer::timeout, this, &Compositor::sendThrottledFrameCallbacks);
+
     // delay the call to setup by one event cycle
     // The ctor of this class is invoked from the Workspace ctor, that means before
     // Workspace is completely constructed, so calling Workspace::self() would result
@@ -710,6 +718,7 @@ void Compositor::bufferSwapComplete()
 {
     //assert(m_bufferSwapPending);
     m_bufferSwapPending = false;
+    sendFrameCallbacks();
 
     if (m_composeAtSwapCompletion) {
         m_composeAtSwapCompletion = false;
@@ -871,11 +880,35 @@ void Compositor::composite()
     m_timeSinceStart += m_timeSinceLastVBlank;
 
     if (waylandServer()) {
+        // throttled surfaces which got visible again, e.g. unminimized, don't wait for the timer
+        for (auto it = m_throttledFrameCallbacks.begin(); it != m_throttledFrameCallbacks.end();) {
+            if (it->window && m_scene->isVisibleInLastFrame(it->window)) {
+                m_pendingFrameCallbacks << FrameCallback{it->surface, it->window, it->window->visibleRect()};
+                it = m_throttledFrameCallbacks.erase(it);
+            } else {
+                ++it;
+            }
+        }
         for (Toplevel *win : qAsConst(damaged)) {
-            if (auto surface = win->surface()) {
-                surface->frameRendered(m_timeSinceStart);
+            auto surface = win->surface();
+            if (!surface) {
+                continue;
+            }
+            if (m_scene->isVisibleInLastFrame(win)) {
+                m_pendingFrameCallbacks << FrameCallback{surface, win, win->visibleRect()};
+            } else if (std::none_of(m_throttledFrameCallbacks.constBegin(), m_throttledFrameCallbacks.constEnd(),
+                                    [surface] (const FrameCallback &callback) { return callback.surface == surface; })) {
+                // minimized, on another desktop or covered, rendering at full rate is wasted
+                m_throttledFrameCallbacks << FrameCallback{surface, win, QRect()};
             }
         }
+        // the frame is presented once the swap completed, unless the backend does not tell
+        if (!m_bufferSwapPending) {
+            sendFrameCallbacks();
+        }
+        if (!m_throttledFrameCallbacks.isEmpty() && !m_throttledFrameCallbackTimer.isActive()) {
+            m_throttledFrameCallbackTimer.start();
+        }
     }
 
     compositeTimer.stop(); // stop here to ensure *we* cause the next repaint schedule - not some effect through m_scene->paint()
@@ -900,6 +933,42 @@ void Compositor::composite()
     }
 }
 
+void Compositor::outputPresented(AbstractOutput *output)
+{
+    const QRect outputGeometry = output->geometry();
+    for (auto it = m_pendingFrameCallbacks.begin(); it != m_pendingFrameCallbacks.end();) {
+        // a window spanning several outputs gets its callbacks from the first one presenting it
+        if (it->geometry.intersects(outputGeometry)) {
+            if (it->surface) {
+                it->surface->frameRendered(m_timeSinceStart);
+            }
+            it = m_pendingFrameCallbacks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void Compositor::sendFrameCallbacks()
+{
+    for (const auto &callback : qAsConst(m_pendingFrameCallbacks)) {
+        if (callback.surface) {
+            callback.surface->frameRendered(m_timeSinceStart);
+        }
+    }
+    m_pendingFrameCallbacks.clear();
+}
+
+void Compositor::sendThrottledFrameCallbacks()
+{
+    for (const auto &callback : qAsConst(m_throttledFrameCallbacks)) {
+        if (callback.surface) {
+            callback.surface->frameRendered(m_timeSinceStart);
+        }
+    }
+    m_throttledFrameCallbacks.clear();
+}
+
 template <class T>
 static bool repaintsPending(const QList<T*> &windows)
 {
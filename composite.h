@@ -16,12 +16,24 @@
 #include <QElapsedTimer>
 #include <QTimer>
 #include <QBasicTimer>
+#include <QPointer>
 #include <QRegion>
+#include <QVector>
+
+namespace KWayland
+{
+namespace Server
+{
+class SurfaceInterface;
+}
+}
 
 namespace KWin {
 
+class AbstractOutput;
 class Client;
 class Scene;
+class Toplevel;
 
 class CompositorSelectionOwner : public KSelectionOwner
 {
@@ -156,8 +168,15 @@ public Q_SLOTS:
 
     /**
      * Notifies the compositor that a pending buffer swap has completed.
+     * The surfaces painted in the swapped frame are told to render their next frame.
      */
     void bufferSwapComplete();
+    /**
+     * Notifies the compositor that @p output presented the last painted frame. The surfaces
+     * shown on @p output are told to render their next frame without waiting for the other
+     * outputs. Backends which can't tell per output only call bufferSwapComplete.
+     */
+    void outputPresented(AbstractOutput *output);
 
 Q_SIGNALS:
     void compositingSetup();
@@ -197,6 +216,8 @@ private:
     void startupWithWorkspace();
     void setupX11Support();
     void composite();
+    void sendFrameCallbacks();
+    void sendThrottledFrameCallbacks();
 
     /**
      * Whether the Compositor is currently suspended, 8 bits encoding the reason
@@ -222,6 +243,17 @@ private:
     bool m_bufferSwapPending;
     bool m_composeAtSwapCompletion;
     int m_framesToTestForSafety = 3;
+    struct FrameCallback {
+        QPointer<KWayland::Server::SurfaceInterface> surface;
+        QPointer<Toplevel> window;
+        // where the window got painted, the outputs showing it present it
+        QRect geometry;
+    };
+    // surfaces painted in the last frame, their frame callbacks are sent once it got presented
+    QVector<FrameCallback> m_pendingFrameCallbacks;
+    // damaged surfaces which were not visible in the last frame get their frame callbacks at a low rate
+    QVector<FrameCallback> m_throttledFrameCallbacks;
+    QTimer m_throttledFrameCallbackTimer;
 
     uint32_t frames = 0;
     uint32_t fps_time = 0;
@@ -0,0 +1,119 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "configcommitter.h"
+
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+KWIN_SINGLETON_FACTORY(ConfigCommitter)
+
+// delay between the first scheduled change and writing the configs
+static const int s_syncInterval = 500;
+
+ConfigCommitter::ConfigCommitter(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(s_syncInterval);
+    connect(m_timer, &QTimer::timeout, this, &ConfigCommitter::flush);
+}
+
+ConfigCommitter::~ConfigCommitter()
+{
+    flush();
+    s_self = nullptr;
+}
+
+int ConfigCommitter::interval() const
+{
+    return m_timer->interval();
+}
+
+void ConfigCommitter::setInterval(int interval)
+{
+    m_timer->setInterval(interval);
+}
+
+void ConfigCommitter::scheduleSync(const KConfigGroup &group)
+{
+    if (!group.config()) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        // the group keeps its shared config alive until it got written
+        auto it = std::find_if(m_pending.constBegin(), m_pending.constEnd(),
+            [&group] (const KConfigGroup &pending) {
+                return pending.config() == group.config();
+            }
+        );
+        if (it == m_pending.constEnd()) {
+            m_pending.append(group);
+        }
+    }
+    // the timer is not restarted, so continuous changes still get written after the interval
+    if (QThread::currentThread() == thread()) {
+        if (!m_timer->isActive()) {
+            m_timer->start();
+        }
+    } else {
+        QMetaObject::invokeMethod(this,
+            [this] {
+                if (!m_timer->isActive()) {
+                    m_timer->start();
+                }
+            }, Qt::QueuedConnection
+        );
+    }
+}
+
+void ConfigCommitter::scheduleSync(const KSharedConfigPtr &config)
+{
+    if (config) {
+        scheduleSync(config->group(QString()));
+    }
+}
+
+void ConfigCommitter::flush()
+{
+    m_timer->stop();
+    QVector<KConfigGroup> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending.swap(m_pending);
+    }
+    // stays in the main thread, see the class documentation
+    for (KConfigGroup &group : pending) {
+        group.sync();
+        m_syncCount.fetchAndAddRelaxed(1);
+    }
+}
+
+void ConfigCommitter::sync(const KConfigGroup &group)
+{
+    if (s_self) {
+        s_self->scheduleSync(group);
+    } else {
+        KConfigGroup(group).sync();
+    }
+}
+
+void ConfigCommitter::sync(const KSharedConfigPtr &config)
+{
+    if (s_self) {
+        s_self->scheduleSync(config);
+    } else if (config) {
+        config->sync();
+    }
+}
+
+}
@@ -0,0 +1,81 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_CONFIGCOMMITTER_H
+#define KWIN_CONFIGCOMMITTER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <kwinglobals.h>
+
+class QTimer;
+
+namespace KWin
+{
+
+/**
+ * @brief Coalesces writing runtime configuration changes to disk.
+ *
+ * KConfig::sync rewrites and fsyncs the whole file. Some state like the current virtual desktop
+ * or input device settings changes in quick succession, syncing after every change stalls the
+ * compositor for nothing. Instead the changed configs are scheduled and written once after a
+ * short delay. Pending changes are written on flush, which happens on session save and when the
+ * committer gets destroyed on shutdown.
+ *
+ * Changes can be scheduled from any thread, but the configs are always written in the thread the
+ * committer lives in, which is the main thread. KConfig is not thread-safe and the shared configs
+ * get read and modified there all the time, a sync in a worker thread would race with that.
+ **/
+class KWIN_EXPORT ConfigCommitter : public QObject
+{
+    Q_OBJECT
+public:
+    virtual ~ConfigCommitter();
+
+    /**
+     * Schedules writing the config @p group belongs to. Can be called from any thread.
+     **/
+    void scheduleSync(const KConfigGroup &group);
+    void scheduleSync(const KSharedConfigPtr &config);
+    /**
+     * Writes all pending configs right away.
+     **/
+    void flush();
+
+    /**
+     * Delay in milliseconds between the first scheduled change and writing the configs.
+     **/
+    int interval() const;
+    void setInterval(int interval);
+
+    /**
+     * @returns how often a config got written to disk, meant for tests.
+     **/
+    int syncCount() const {
+        return m_syncCount.load();
+    }
+
+    /**
+     * Writes the config of @p group through the committer if it exists, right away otherwise.
+     **/
+    static void sync(const KConfigGroup &group);
+    static void sync(const KSharedConfigPtr &config);
+
+private:
+    QMutex m_mutex;
+    QVector<KConfigGroup> m_pending;
+    QTimer *m_timer;
+    QAtomicInt m_syncCount;
+    KWIN_SINGLETON(ConfigCommitter)
+};
+
+}
+
+#endif
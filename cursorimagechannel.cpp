@@ -0,0 +1,171 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "cursorimagechannel.h"
+#include "composite.h"
+#include "cursor.h"
+#include "main.h"
+#include "platform.h"
+#include "scene.h"
+#include "utils.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace KWin
+{
+
+// fallback interval for coalescing position updates if there is no scene
+static const int s_positionUpdateInterval = 16;
+
+CursorImageChannel::CursorImageChannel(QObject *parent)
+    : QObject(parent)
+{
+    m_positionTimer.setSingleShot(true);
+    m_positionTimer.setInterval(s_positionUpdateInterval);
+    connect(&m_positionTimer, &QTimer::timeout, this, &CursorImageChannel::flushPosition);
+
+    Cursor::self()->startCursorTracking();
+    connect(Cursor::self(), &Cursor::cursorChanged, this, &CursorImageChannel::updateShape);
+    connect(Cursor::self(), &Cursor::posChanged, this, &CursorImageChannel::schedulePositionUpdate);
+    if (Compositor::self()) {
+        connect(Compositor::self(), &Compositor::compositingToggled, this, &CursorImageChannel::updateScene);
+        updateScene();
+    }
+    updateShape();
+}
+
+CursorImageChannel::~CursorImageChannel()
+{
+    if (Cursor::self()) {
+        Cursor::self()->stopCursorTracking();
+    }
+    release();
+}
+
+void CursorImageChannel::release()
+{
+    if (m_data) {
+        munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+    if (m_readOnlyFd != -1) {
+        close(m_readOnlyFd);
+        m_readOnlyFd = -1;
+    }
+    if (m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+}
+
+bool CursorImageChannel::ensureSize(quint32 size)
+{
+    if (m_data && size <= m_size) {
+        return true;
+    }
+    release();
+#ifdef F_SEAL_SEAL
+    m_fd = memfd_create("kwin-cursor", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#endif
+    if (m_fd == -1) {
+        qCWarning(KWIN_CORE) << "Failed to create memfd for the cursor image channel";
+        return false;
+    }
+    // round up to whole pages, the next cursors will very likely fit as well
+    const quint32 pageSize = sysconf(_SC_PAGESIZE);
+    size = (size + pageSize - 1) / pageSize * pageSize;
+    if (ftruncate(m_fd, size) < 0) {
+        qCWarning(KWIN_CORE) << "Failed to resize cursor image memfd to" << size;
+        release();
+        return false;
+    }
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        qCWarning(KWIN_CORE) << "Failed to mmap cursor image memfd";
+        release();
+        return false;
+    }
+#ifdef F_SEAL_SEAL
+    const int seals = F_SEAL_GROW | F_SEAL_SHRINK | F_SEAL_SEAL;
+    bool sealed = false;
+#ifdef F_SEAL_FUTURE_WRITE
+    // keeps our own mapping writable, but nobody can write through a reopened descriptor,
+    // older kernels reject the seal
+    sealed = fcntl(m_fd, F_ADD_SEALS, seals | F_SEAL_FUTURE_WRITE) == 0;
+#endif
+    if (!sealed && fcntl(m_fd, F_ADD_SEALS, seals) == -1) {
+        qCWarning(KWIN_CORE) << "Failed to seal cursor image memfd";
+    }
+#endif
+    m_data = static_cast<uchar*>(data);
+    m_size = size;
+    // subscribers must not be able to write into the channel, a descriptor opened
+    // read-only cannot be mapped writable
+    m_readOnlyFd = open(QByteArrayLiteral("/proc/self/fd/").append(QByteArray::number(m_fd)).constData(), O_RDONLY | O_CLOEXEC);
+    if (m_readOnlyFd == -1) {
+        qCWarning(KWIN_CORE) << "Failed to open the cursor image memfd read-only";
+        release();
+        return false;
+    }
+    header()->magic = s_magic;
+    header()->version = s_version;
+    header()->dataOffset = sizeof(Header);
+    emit fdChanged();
+    return true;
+}
+
+void CursorImageChannel::updateShape()
+{
+    const PlatformCursorImage cursor = kwinApp()->platform()->cursorImage();
+    const QImage image = cursor.image().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const quint32 dataSize = image.isNull() ? 0 : image.bytesPerLine() * image.height();
+    if (!ensureSize(sizeof(Header) + dataSize)) {
+        return;
+    }
+    // the serial continues in a replaced memfd, subscribers compare it to the one they saw
+    writeShape(header(), m_shapeSerial, image, cursor.hotSpot());
+    m_shapeSerial += 2;
+    emit shapeChanged(m_shapeSerial, cursor.hotSpot());
+    schedulePositionUpdate();
+}
+
+void CursorImageChannel::updateScene()
+{
+    disconnect(m_frameConnection);
+    m_scene = Compositor::self() ? Compositor::self()->scene() : nullptr;
+    if (m_scene) {
+        m_frameConnection = connect(m_scene, &Scene::frameRendered, this,
+            [this] {
+                if (m_positionDirty) {
+                    flushPosition();
+                }
+            }
+        );
+    }
+}
+
+void CursorImageChannel::schedulePositionUpdate()
+{
+    m_positionDirty = true;
+    // the timer only matters if no frame gets rendered, e.g. with a hardware cursor
+    if (!m_positionTimer.isActive()) {
+        m_positionTimer.start();
+    }
+}
+
+void CursorImageChannel::flushPosition()
+{
+    m_positionDirty = false;
+    m_positionTimer.stop();
+    if (!m_data) {
+        return;
+    }
+    writePosition(header(), Cursor::pos());
+}
+
+}
@@ -0,0 +1,204 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_CURSORIMAGECHANNEL_H
+#define KWIN_CURSORIMAGECHANNEL_H
+
+#include <QImage>
+#include <QObject>
+#include <QPoint>
+#include <QPointer>
+#include <QTimer>
+
+#include <cstring>
+
+namespace KWin
+{
+
+class Scene;
+
+/**
+ * @brief Publishes the current cursor image into a shared memory file.
+ *
+ * Instead of encoding the cursor into a PNG for every D-Bus request, the cursor
+ * image is written once per shape change into a memfd which can be mapped by
+ * any number of subscribers. The file starts with a Header followed by the
+ * ARGB32 premultiplied pixel data.
+ *
+ * Subscribers get a read-only file descriptor and compare the shape serial to the
+ * one they saw last, the shapeChanged signal tells them when it moved. The pointer
+ * position in the header is updated at most once per rendered frame.
+ *
+ * Both serials work like a seqlock: they are odd while the data they guard gets
+ * written. A reader takes the serial, copies the data and accepts the copy only if
+ * the serial was even and did not change in the meantime, see readShape and readPosition.
+ *
+ * The memfd gets replaced if a new cursor does not fit into the current mapping,
+ * in that case the fdChanged signal is emitted and subscribers need to fetch the
+ * new file descriptor.
+ **/
+class CursorImageChannel : public QObject
+{
+    Q_OBJECT
+public:
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 shapeSerial;
+        quint32 positionSerial;
+        qint32 width;
+        qint32 height;
+        qint32 stride;
+        qint32 hotSpotX;
+        qint32 hotSpotY;
+        qint32 x;
+        qint32 y;
+        quint32 dataOffset;
+    };
+    static const quint32 s_magic = 0x4b435552; // "KCUR"
+    static const quint32 s_version = 2;
+
+    explicit CursorImageChannel(QObject *parent = nullptr);
+    virtual ~CursorImageChannel();
+
+    /**
+     * @returns a read-only file descriptor of the shared memory, @c -1 if it could not be
+     * created. The descriptor stays owned by the channel.
+     **/
+    int fd() const {
+        return m_readOnlyFd;
+    }
+    /**
+     * @returns the size of the shared memory in bytes.
+     **/
+    quint32 size() const {
+        return m_size;
+    }
+    quint32 shapeSerial() const {
+        return m_shapeSerial;
+    }
+
+    /**
+     * Writes @p image with @p hotSpot into @p header and the pixel data following it, the
+     * shape serial goes from @p serial over an odd value to @p serial + 2. The image has to be
+     * ARGB32 premultiplied and fit behind the header.
+     **/
+    static void writeShape(Header *header, quint32 serial, const QImage &image, const QPoint &hotSpot) {
+        const quint32 stride = image.isNull() ? 0 : image.bytesPerLine();
+        __atomic_store_n(&header->shapeSerial, serial + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&header->width, image.width(), __ATOMIC_RELAXED);
+        __atomic_store_n(&header->height, image.height(), __ATOMIC_RELAXED);
+        __atomic_store_n(&header->stride, qint32(stride), __ATOMIC_RELAXED);
+        __atomic_store_n(&header->hotSpotX, hotSpot.x(), __ATOMIC_RELAXED);
+        __atomic_store_n(&header->hotSpotY, hotSpot.y(), __ATOMIC_RELAXED);
+        if (stride) {
+            memcpy(reinterpret_cast<uchar*>(header) + header->dataOffset, image.constBits(), stride * image.height());
+        }
+        __atomic_store_n(&header->shapeSerial, serial + 2, __ATOMIC_RELEASE);
+    }
+    /**
+     * Copies the cursor image and its hot spot out of the @p size bytes starting at @p header
+     * like a subscriber does.
+     * @returns @c false if a write was in progress or the header describes an image which
+     * does not fit into @p size, the read is supposed to be retried.
+     **/
+    static bool readShape(const Header *header, quint32 size, QImage *image, QPoint *hotSpot, quint32 *serial = nullptr) {
+        const quint32 before = __atomic_load_n(&header->shapeSerial, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            return false;
+        }
+        const qint32 width = __atomic_load_n(&header->width, __ATOMIC_RELAXED);
+        const qint32 height = __atomic_load_n(&header->height, __ATOMIC_RELAXED);
+        const qint32 stride = __atomic_load_n(&header->stride, __ATOMIC_RELAXED);
+        const qint32 hotSpotX = __atomic_load_n(&header->hotSpotX, __ATOMIC_RELAXED);
+        const qint32 hotSpotY = __atomic_load_n(&header->hotSpotY, __ATOMIC_RELAXED);
+        const quint32 dataOffset = __atomic_load_n(&header->dataOffset, __ATOMIC_RELAXED);
+        // a torn header may describe anything, never read outside of the mapping
+        if (width < 0 || height < 0 || stride < 0 || qint64(stride) < qint64(width) * 4
+                || dataOffset < sizeof(Header) || dataOffset + quint64(stride) * height > size) {
+            return false;
+        }
+        QImage copy;
+        if (width > 0 && height > 0) {
+            copy = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+            const uchar *data = reinterpret_cast<const uchar*>(header) + dataOffset;
+            for (int y = 0; y < height; ++y) {
+                memcpy(copy.scanLine(y), data + y * stride, width * 4);
+            }
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&header->shapeSerial, __ATOMIC_RELAXED) != before) {
+            return false;
+        }
+        *image = copy;
+        *hotSpot = QPoint(hotSpotX, hotSpotY);
+        if (serial) {
+            *serial = before;
+        }
+        return true;
+    }
+    /**
+     * Writes @p pos into @p header, readers never see a half written position.
+     **/
+    static void writePosition(Header *header, const QPoint &pos) {
+        const quint32 serial = __atomic_load_n(&header->positionSerial, __ATOMIC_RELAXED);
+        __atomic_store_n(&header->positionSerial, serial + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&header->x, pos.x(), __ATOMIC_RELAXED);
+        __atomic_store_n(&header->y, pos.y(), __ATOMIC_RELAXED);
+        __atomic_store_n(&header->positionSerial, serial + 2, __ATOMIC_RELEASE);
+    }
+    /**
+     * Reads the position from @p header like a subscriber does.
+     * @returns @c false if a write was in progress, the read is supposed to be retried.
+     **/
+    static bool readPosition(const Header *header, QPoint *pos, quint32 *serial = nullptr) {
+        const quint32 before = __atomic_load_n(&header->positionSerial, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            return false;
+        }
+        const qint32 x = __atomic_load_n(&header->x, __ATOMIC_RELAXED);
+        const qint32 y = __atomic_load_n(&header->y, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&header->positionSerial, __ATOMIC_RELAXED) != before) {
+            return false;
+        }
+        *pos = QPoint(x, y);
+        if (serial) {
+            *serial = before;
+        }
+        return true;
+    }
+
+Q_SIGNALS:
+    void shapeChanged(quint32 serial, const QPoint &hotSpot);
+    void fdChanged();
+
+private:
+    void updateShape();
+    void schedulePositionUpdate();
+    void flushPosition();
+    void updateScene();
+    bool ensureSize(quint32 size);
+    void release();
+    Header *header() const {
+        return reinterpret_cast<Header*>(m_data);
+    }
+
+    int m_fd = -1;
+    int m_readOnlyFd = -1;
+    quint32 m_size = 0;
+    uchar *m_data = nullptr;
+    quint32 m_shapeSerial = 0;
+    bool m_positionDirty = false;
+    QPointer<Scene> m_scene;
+    QMetaObject::Connection m_frameConnection;
+    QTimer m_positionTimer;
+};
+
+}
+
+#endif
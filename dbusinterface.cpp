@@ -14,6 +14,7 @@
 #include <pointer_input.h>
 #include "atoms.h"
 #include "composite.h"
+#include "cursorimagechannel.h"
 #include "debug_console.h"
 #include "main.h"
 #include "placement.h"
@@ -186,6 +187,36 @@ QByteArray DBusInterface::cursorImage()
     return ba;
 }
 
+CursorImageChannel *DBusInterface::cursorImageChannel()
+{
+    if (!m_cursorImageChannel) {
+        m_cursorImageChannel = new CursorImageChannel(this);
+        connect(m_cursorImageChannel, &CursorImageChannel::shapeChanged, this,
+            [this] (quint32 serial, const QPoint &hotSpot) {
+                emit cursorShapeChanged(serial, hotSpot.x(), hotSpot.y());
+            }
+        );
+        connect(m_cursorImageChannel, &CursorImageChannel::fdChanged, this, &DBusInterface::cursorImageFdChanged);
+    }
+    return m_cursorImageChannel;
+}
+
+QDBusUnixFileDescriptor DBusInterface::cursorImageFd()
+{
+    const int fd = cursorImageChannel()->fd();
+    if (fd == -1) {
+        sendErrorReply(QDBusError::Failed, QStringLiteral("The cursor image channel is not available"));
+        return QDBusUnixFileDescriptor();
+    }
+    // QDBusUnixFileDescriptor duplicates the descriptor, the channel keeps its own
+    return QDBusUnixFileDescriptor(fd);
+}
+
+uint DBusInterface::cursorImageSerial()
+{
+    return cursorImageChannel()->shapeSerial();
+}
+
 bool DBusInterface::xwaylandGrabed()
 {
     return waylandServer()->zwpXwaylandKeyboardGrabClientV1() != nullptr;
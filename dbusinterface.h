@@ -16,6 +16,7 @@ namespace KWin
 {
 
 class Compositor;
+class CursorImageChannel;
 class VirtualDesktopManager;
 
 /**
@@ -57,6 +58,14 @@ public Q_SLOTS: // METHODS
     Q_NOREPLY void showDebugConsole();
     bool xwaylandGrabed();
     QByteArray cursorImage();
+    /**
+     * @brief Shared memory file holding the current cursor image, see CursorImageChannel.
+     *
+     * The channel gets created on first use, afterwards cursorShapeChanged is emitted
+     * whenever a new image got written into the file.
+     **/
+    QDBusUnixFileDescriptor cursorImageFd();
+    uint cursorImageSerial();
 
     void setTouchDeviceToScreenId(const QString &touchDeviceSysName, int screenId);
     QString getTouchDeviceToScreenInfo();
@@ -76,13 +85,19 @@ public Q_SLOTS: // METHODS
     void printKwinFps(bool isFps);
     void dumpOutputBuffer();
 
+Q_SIGNALS:
+    void cursorShapeChanged(uint serial, int hotSpotX, int hotSpotY);
+    void cursorImageFdChanged();
+
 private Q_SLOTS:
     void becomeKWinService(const QString &service);
 
 private:
     void announceService();
+    CursorImageChannel *cursorImageChannel();
     QString m_serviceName;
     QDBusMessage m_replyQueryWindowInfo;
+    CursorImageChannel *m_cursorImageChannel = nullptr;
 };
 
 class CompositorDBusInterface : public QObject
@@ -30,8 +30,10 @@
 #include <KPluginLoader>
 
 // Qt
+#include <QFuture>
 #include <QMetaProperty>
 #include <QPainter>
+#include <QtConcurrentRun>
 
 namespace KWin
 {
@@ -40,6 +42,8 @@ namespace Decoration
 
 static const QString s_aurorae = QStringLiteral("org.kde.kwin.aurorae");
 static const QString s_pluginName = QStringLiteral("org.kde.kdecoration2");
+// a default constructed future counts as canceled
+static QFuture<QVector<KPluginMetaData>> s_prefetchedPlugins;
 #if HAVE_BREEZE_DECO
 static const QString s_defaultPlugin = QStringLiteral(BREEZE_KDECORATION_PLUGIN_ID);
 #else
@@ -88,6 +92,18 @@ QString DecorationBridge::readTheme() const
     return kwinApp()->config()->group(s_pluginName).readEntry("theme", cg.readEntry("theme", m_defaultTheme));
 }
 
+void DecorationBridge::prefetchPlugins()
+{
+    if (!s_prefetchedPlugins.isCanceled()) {
+        return;
+    }
+    s_prefetchedPlugins = QtConcurrent::run(
+        [] {
+            return KPluginLoader::findPlugins(s_pluginName);
+        }
+    );
+}
+
 void DecorationBridge::init()
 {
     using namespace KWayland::Server;
@@ -96,6 +112,7 @@ void DecorationBridge::init()
         if (waylandServer()) {
             waylandServer()->decorationManager()->setDefaultMode(ServerSideDecorationManagerInterface::Mode::None);
         }
+        s_prefetchedPlugins = QFuture<QVector<KPluginMetaData>>();
         return;
     }
     m_plugin = readPlugin();
@@ -116,11 +133,23 @@ void DecorationBridge::init()
     if (waylandServer()) {
         waylandServer()->decorationManager()->setDefaultMode(m_factory ? ServerSideDecorationManagerInterface::Mode::Server : ServerSideDecorationManagerInterface::Mode::None);
     }
+    // plugins installed later get found by a new search on reconfigure
+    s_prefetchedPlugins = QFuture<QVector<KPluginMetaData>>();
 }
 
 void DecorationBridge::initPlugin()
 {
-    const auto offers = KPluginLoader::findPluginsById(s_pluginName, m_plugin);
+    QVector<KPluginMetaData> offers;
+    if (!s_prefetchedPlugins.isCanceled()) {
+        const auto plugins = s_prefetchedPlugins.result();
+        for (const KPluginMetaData &plugin : plugins) {
+            if (plugin.pluginId() == m_plugin) {
+                offers << plugin;
+            }
+        }
+    } else {
+        offers = KPluginLoader::findPluginsById(s_pluginName, m_plugin);
+    }
     if (offers.isEmpty()) {
         qCWarning(KWIN_DECORATIONS) << "Could not locate decoration plugin";
         return;
@@ -37,6 +37,12 @@ class DecorationBridge : public KDecoration2::DecorationBridge
 public:
     virtual ~DecorationBridge();
 
+    /**
+     * Starts looking up the installed decoration plugins in a thread, init() uses the result
+     * instead of searching the plugin directories itself.
+     **/
+    static void prefetchPlugins();
+
     void init();
     KDecoration2::Decoration *createDecoration(AbstractClient *client);
 
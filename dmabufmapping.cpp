@@ -0,0 +1,214 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "dmabufmapping.h"
+#include "platformsupport/scenes/opengl/drm_fourcc.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KWin
+{
+
+static int bytesPerPixel(uint32_t drmFormat)
+{
+    switch (drmFormat) {
+    case DRM_FORMAT_ARGB8888:
+    case DRM_FORMAT_XRGB8888:
+    case DRM_FORMAT_ABGR8888:
+    case DRM_FORMAT_XBGR8888:
+        return 4;
+    case DRM_FORMAT_RGB565:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+// bytes from the start of the file up to the last pixel of the plane
+static uint64_t planeEnd(uint32_t offset, uint32_t stride, int bpp, const QSize &size)
+{
+    return uint64_t(offset) + uint64_t(stride) * (size.height() - 1) + uint64_t(size.width()) * bpp;
+}
+
+/**
+ * Only dmabufs list the name of their exporter in their fdinfo.
+ **/
+static bool hasExporterName(int fd)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fdinfo/%d", fd);
+    const int infoFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (infoFd == -1) {
+        return false;
+    }
+    char info[1024];
+    const ssize_t length = read(infoFd, info, sizeof(info) - 1);
+    close(infoFd);
+    if (length <= 0) {
+        return false;
+    }
+    info[length] = '\0';
+    return strstr(info, "\nexp_name:") != nullptr;
+}
+
+/**
+ * The fdinfo lists the exporter name since Linux 5.3 only. Before, dmabufs are anonymous inodes
+ * named after the dmabuf class, since then they live on their own dmabuf filesystem.
+ **/
+static bool hasDmabufLink(int fd)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    char link[256];
+    const ssize_t length = readlink(path, link, sizeof(link) - 1);
+    if (length <= 0) {
+        return false;
+    }
+    link[length] = '\0';
+    return strcmp(link, "anon_inode:dmabuf") == 0 || strncmp(link, "/dmabuf:", 8) == 0;
+}
+
+/**
+ * Probes with flags the kernel refuses, a dmabuf fails with exactly EINVAL. Other drivers may
+ * implement an ioctl with the same number, so the exporter name or the link has to confirm it.
+ **/
+static bool isDmabuf(int fd)
+{
+    dma_buf_sync args;
+    args.flags = 0;
+    if (ioctl(fd, DMA_BUF_IOCTL_SYNC, &args) == 0 || errno != EINVAL) {
+        return false;
+    }
+    return hasExporterName(fd) || hasDmabufLink(fd);
+}
+
+/**
+ * Anything but a dmabuf can be truncated by the client while it is mapped, which turns reading
+ * the mapping into a SIGBUS. Such files are only accepted if they are sealed against shrinking.
+ **/
+static bool cannotShrink(int fd)
+{
+#ifdef F_SEAL_SHRINK
+    const int seals = fcntl(fd, F_GET_SEALS);
+    return seals != -1 && (seals & F_SEAL_SHRINK);
+#else
+    Q_UNUSED(fd)
+    return false;
+#endif
+}
+
+static int64_t fileSize(int fd, bool dmabuf)
+{
+    if (dmabuf) {
+        // seeking a dmabuf only reports its size, the file offset shared with the client stays
+        return lseek(fd, 0, SEEK_END);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -1;
+    }
+    return st.st_size;
+}
+
+DmabufMapping::DmabufMapping(int fd, uint32_t offset, uint32_t stride, uint32_t format, const QSize &size)
+    : m_fd(fd)
+    , m_offset(offset)
+    , m_stride(stride)
+    , m_format(imageFormat(format))
+    , m_size(size)
+{
+    if (!isValidLayout(fd, offset, stride, format, size)) {
+        return;
+    }
+    // the offset does not need to be page aligned, so the mapping starts at the beginning of the file
+    m_length = planeEnd(offset, stride, bytesPerPixel(format), size);
+    void *data = mmap(nullptr, m_length, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        m_length = 0;
+        return;
+    }
+    m_data = static_cast<uchar*>(data);
+}
+
+DmabufMapping::~DmabufMapping()
+{
+    if (m_data) {
+        munmap(m_data, m_length);
+    }
+}
+
+void DmabufMapping::sync(uint64_t flags)
+{
+    dma_buf_sync args;
+    args.flags = flags;
+    // fails with ENOTTY for file descriptors which are no dmabuf, e.g. a memfd, those need no sync
+    while (ioctl(m_fd, DMA_BUF_IOCTL_SYNC, &args) == -1 && (errno == EINTR || errno == EAGAIN)) {
+    }
+}
+
+QImage DmabufMapping::beginCpuAccess()
+{
+    if (!m_data) {
+        return QImage();
+    }
+    sync(DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+    const uchar *data = m_data + m_offset;
+    return QImage(data, m_size.width(), m_size.height(), m_stride, m_format);
+}
+
+void DmabufMapping::endCpuAccess()
+{
+    if (m_data) {
+        sync(DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+    }
+}
+
+QImage::Format DmabufMapping::imageFormat(uint32_t drmFormat)
+{
+    switch (drmFormat) {
+    case DRM_FORMAT_ARGB8888:
+        return QImage::Format_ARGB32_Premultiplied;
+    case DRM_FORMAT_XRGB8888:
+        return QImage::Format_RGB32;
+    case DRM_FORMAT_ABGR8888:
+        return QImage::Format_RGBA8888_Premultiplied;
+    case DRM_FORMAT_XBGR8888:
+        return QImage::Format_RGBX8888;
+    case DRM_FORMAT_RGB565:
+        return QImage::Format_RGB16;
+    default:
+        return QImage::Format_Invalid;
+    }
+}
+
+bool DmabufMapping::isValidLayout(int fd, uint32_t offset, uint32_t stride, uint32_t format, const QSize &size)
+{
+    const int bpp = bytesPerPixel(format);
+    if (fd < 0 || bpp == 0 || size.isEmpty()) {
+        return false;
+    }
+    if (uint64_t(stride) < uint64_t(size.width()) * bpp) {
+        return false;
+    }
+    const bool dmabuf = isDmabuf(fd);
+    if (!dmabuf && !cannotShrink(fd)) {
+        return false;
+    }
+    const int64_t length = fileSize(fd, dmabuf);
+    if (length < 0) {
+        return false;
+    }
+    return planeEnd(offset, stride, bpp, size) <= uint64_t(length);
+}
+
+}
@@ -0,0 +1,69 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_DMABUFMAPPING_H
+#define KWIN_DMABUFMAPPING_H
+
+#include <QImage>
+#include <QSize>
+
+#include <kwinglobals.h>
+
+#include <cstdint>
+
+namespace KWin
+{
+
+/**
+ * @brief CPU mapping of a single plane, linear dmabuf.
+ *
+ * Used where a dmabuf cannot be imported by the GPU, e.g. by the QPainter scene or if the EGL
+ * import failed. The plane is mapped once and read through a QImage without copying, every
+ * access gets bracketed with DMA_BUF_IOCTL_SYNC so the caches are coherent with the device.
+ * The file descriptor is not owned by the mapping.
+ **/
+class KWIN_EXPORT DmabufMapping
+{
+public:
+    DmabufMapping(int fd, uint32_t offset, uint32_t stride, uint32_t format, const QSize &size);
+    ~DmabufMapping();
+
+    bool isValid() const {
+        return m_data != nullptr;
+    }
+
+    /**
+     * Starts reading the buffer. The returned image references the mapping and must not be
+     * used after endCpuAccess. The image is null if the buffer could not be mapped.
+     **/
+    QImage beginCpuAccess();
+    void endCpuAccess();
+
+    /**
+     * @returns the QImage format matching the DRM fourcc @p drmFormat or
+     * QImage::Format_Invalid if it cannot be mapped.
+     **/
+    static QImage::Format imageFormat(uint32_t drmFormat);
+    /**
+     * Checks that a plane with @p offset and @p stride describes a @p format image of
+     * @p size which fits into the file @p fd refers to. The file has to be a dmabuf or sealed
+     * with F_SEAL_SHRINK, so the client cannot truncate it under the mapping.
+     **/
+    static bool isValidLayout(int fd, uint32_t offset, uint32_t stride, uint32_t format, const QSize &size);
+
+private:
+    void sync(uint64_t flags);
+    int m_fd;
+    uint32_t m_offset;
+    uint32_t m_stride;
+    QImage::Format m_format;
+    QSize m_size;
+    uchar *m_data = nullptr;
+    size_t m_length = 0;
+};
+
+}
+
+#endif
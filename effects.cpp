@@ -14,6 +14,7 @@
 #endif
 #include "deleted.h"
 #include "client.h"
+#include "configcommitter.h"
 #include "cursor.h"
 #include "group.h"
 #include "osd.h"
@@ -1508,7 +1509,7 @@ void EffectsHandlerImpl::enableEffect(const QString &name, bool enable)
     QString minimizeall = "minimizeallEnabled";
     kwinConfig.writeEntry(minimizeall, !enable);
     kwinConfig.writeEntry(key, enable);
-    kwinConfig.sync();
+    ConfigCommitter::sync(kwinConfig);
 }
 
 bool EffectsHandlerImpl::loadEffect(const QString& name)
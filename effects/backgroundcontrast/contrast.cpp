@@ -447,11 +447,16 @@ void ContrastEffect::doContrast(EffectWindow *w, const QRegion& shape, const QRe
     GLTexture scratch(GL_RGBA8, r.width() * scale, r.height() * scale);
     scratch.setFilter(GL_LINEAR);
     scratch.setWrapMode(GL_CLAMP_TO_EDGE);
-    scratch.bind();
-
-    const QRect sg = GLRenderTarget::virtualScreenGeometry();
-    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (r.x() - sg.x()) * scale, (sg.height() - (r.y() - sg.y() + r.height())) * scale,
-                        scratch.width(), scratch.height());
+    if (GLRenderTarget::virtualScreenRotation() != 0 && GLRenderTarget::blitSupported()) {
+        // the framebuffer is rotated in software, the blit turns the content upright
+        GLRenderTarget scratchTarget(scratch);
+        scratchTarget.blitFromFramebuffer(r);
+        scratch.bind();
+    } else {
+        scratch.bind();
+        const QRect f = GLRenderTarget::mapToFramebuffer(r);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, f.x(), f.y(), scratch.width(), scratch.height());
+    }
 
     // Draw the texture on the offscreen framebuffer object, while blurring it horizontally
 
@@ -73,9 +73,8 @@ void ColorPickerEffect::postPaintScreen()
 
     if (m_scheduledPosition != QPoint(-1, -1) && (m_cachedOutputGeometry.isEmpty() || m_cachedOutputGeometry.contains(m_scheduledPosition))) {
         uint8_t data[3];
-        const QRect geo = GLRenderTarget::virtualScreenGeometry();
-        const QPoint screenPosition(m_scheduledPosition.x() - geo.x(), m_scheduledPosition.y() - geo.y());
-        const QPoint texturePosition(screenPosition.x() * GLRenderTarget::virtualScreenScale(), (geo.height() - screenPosition.y()) * GLRenderTarget::virtualScreenScale());
+        // the framebuffer might be rotated in software
+        const QRect texturePosition = GLRenderTarget::mapToFramebuffer(QRect(m_scheduledPosition, QSize(1, 1)));
 
         glReadnPixels(texturePosition.x(), texturePosition.y(), 1, 1, GL_RGB, GL_UNSIGNED_BYTE, 3, data);
         QDBusConnection::sessionBus().send(m_replyMessage.createReply(QColor(data[0], data[1], data[2])));
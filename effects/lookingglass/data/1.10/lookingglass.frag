@@ -3,6 +3,7 @@ uniform vec2 u_cursor;
 uniform float u_zoom;
 uniform float u_radius;
 uniform vec2 u_textureSize;
+uniform vec2 u_textureOffset;
 
 varying vec2 texcoord0;
 
@@ -18,7 +19,7 @@ void main()
         texcoord += d / dist * disp;
     }
 
-    texcoord = texcoord/u_textureSize;
+    texcoord = (texcoord - u_textureOffset)/u_textureSize;
     texcoord.t = 1.0 - texcoord.t;
     gl_FragColor = texture2D(sampler, texcoord);
 }
@@ -41,6 +41,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace KWin
 {
 
+// pixels read around the lens for the linear filter
+static const int s_lensMargin = 2;
+
 LookingGlassEffect::LookingGlassEffect()
     : zoom(1.0f)
     , target_zoom(1.0f)
@@ -51,6 +54,7 @@ LookingGlassEffect::LookingGlassEffect()
     , m_shader(NULL)
     , m_enabled(false)
     , m_valid(false)
+    , m_regionLimited(false)
 {
     initConfig<LookingGlassConfig>();
     QAction* a;
@@ -98,13 +102,29 @@ void LookingGlassEffect::reconfigure(ReconfigureFlags)
 
 bool LookingGlassEffect::loadData()
 {
+    delete m_texture;
+    delete m_fbo;
+    delete m_shader;
+    delete m_vbo;
+    m_texture = nullptr;
+    m_fbo = nullptr;
+    m_shader = nullptr;
+    m_vbo = nullptr;
+
+    // With blit support only the area under the lens gets copied out of the rendered screen,
+    // otherwise the whole screen has to be redirected into a texture of its size.
+    m_regionLimited = GLRenderTarget::blitSupported();
     const QSize screenSize = effects->virtualScreenSize();
-    int texw = screenSize.width();
-    int texh = screenSize.height();
+    QSize textureSize = screenSize;
+    if (m_regionLimited) {
+        // large enough for the biggest radius the zoom animation reaches
+        const int side = 2 * (int(std::ceil(3.5 * initialradius)) + s_lensMargin);
+        textureSize = QSize(side, side);
+    }
 
     // Create texture and render target
-    const int levels = std::log2(qMin(texw, texh)) + 1;
-    m_texture = new GLTexture(GL_RGBA8, texw, texh, levels);
+    const int levels = std::log2(qMin(textureSize.width(), textureSize.height())) + 1;
+    m_texture = new GLTexture(GL_RGBA8, textureSize, levels);
     m_texture->setFilter(GL_LINEAR_MIPMAP_LINEAR);
     m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
 
@@ -116,12 +136,17 @@ bool LookingGlassEffect::loadData()
     m_shader = ShaderManager::instance()->generateShaderFromResources(ShaderTrait::MapTexture, QString(), QStringLiteral("lookingglass.frag"));
     if (m_shader->isValid()) {
         ShaderBinder binder(m_shader);
-        m_shader->setUniform("u_textureSize", QVector2D(screenSize.width(), screenSize.height()));
+        m_shader->setUniform("u_textureSize", QVector2D(textureSize.width(), textureSize.height()));
+        m_shader->setUniform("u_textureOffset", QVector2D(0, 0));
     } else {
         qCCritical(KWINEFFECTS) << "The shader failed to load!";
         return false;
     }
 
+    if (m_regionLimited) {
+        // the lens quad moves with the cursor and goes through the streaming buffer
+        return true;
+    }
     m_vbo = new GLVertexBuffer(GLVertexBuffer::Static);
     QVector<float> verts;
     QVector<float> texcoords;
@@ -141,6 +166,20 @@ bool LookingGlassEffect::loadData()
     return true;
 }
 
+QRect LookingGlassEffect::lensArea() const
+{
+    const QPoint cursor = cursorPos();
+    const int extent = radius + s_lensMargin;
+    return QRect(cursor.x() - extent, cursor.y() - extent, 2 * extent, 2 * extent);
+}
+
+bool LookingGlassEffect::needsMipmaps() const
+{
+    // The displacement squeezes the ring at the rim of the lens by up to 1 + 20 * pi * (zoom - 1) / radius,
+    // mipmaps only pay off once that reaches a factor of two.
+    return 20.0 * M_PI * (zoom - 1.0) >= radius;
+}
+
 void LookingGlassEffect::toggle()
 {
     if (target_zoom == 1.0f) {
@@ -207,13 +246,17 @@ void LookingGlassEffect::prePaintScreen(ScreenPrePaintData& data, int time)
 
         effects->addRepaint(cursorPos().x() - radius, cursorPos().y() - radius, 2 * radius, 2 * radius);
     }
-    if (m_valid && m_enabled) {
+    if (m_valid && m_enabled && !m_regionLimited) {
         data.mask |= PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS;
         // Start rendering to texture
         GLRenderTarget::pushRenderTarget(m_fbo);
     }
 
     effects->prePaintScreen(data, time);
+    if (m_valid && m_enabled && m_regionLimited) {
+        // the lens reads what got painted underneath it in this frame
+        data.paint |= lensArea();
+    }
 }
 
 void LookingGlassEffect::slotMouseChanged(const QPoint& pos, const QPoint& old, Qt::MouseButtons,
@@ -229,23 +272,90 @@ void LookingGlassEffect::paintScreen(int mask, QRegion region, ScreenPaintData &
 {
     // Call the next effect.
     effects->paintScreen(mask, region, data);
-    if (m_valid && m_enabled) {
-        // Disable render texture
-        GLRenderTarget* target = GLRenderTarget::popRenderTarget();
-        assert(target == m_fbo);
-        Q_UNUSED(target);
-        m_texture->bind();
-        m_texture->generateMipmaps();
+    if (!m_valid || !m_enabled) {
+        return;
+    }
+    if (m_regionLimited) {
+        paintLens(data);
+        return;
+    }
+    // Disable render texture
+    GLRenderTarget* target = GLRenderTarget::popRenderTarget();
+    assert(target == m_fbo);
+    Q_UNUSED(target);
+    m_texture->bind();
+    m_texture->generateMipmaps();
+
+    // Use the shader
+    ShaderBinder binder(m_shader);
+    m_shader->setUniform("u_zoom", (float)zoom);
+    m_shader->setUniform("u_radius", (float)radius);
+    m_shader->setUniform("u_cursor", QVector2D(cursorPos().x(), cursorPos().y()));
+    m_shader->setUniform(GLShader::ModelViewProjectionMatrix, data.projectionMatrix());
+    m_vbo->render(GL_TRIANGLES);
+    m_texture->unbind();
+}
 
-        // Use the shader
-        ShaderBinder binder(m_shader);
-        m_shader->setUniform("u_zoom", (float)zoom);
-        m_shader->setUniform("u_radius", (float)radius);
-        m_shader->setUniform("u_cursor", QVector2D(cursorPos().x(), cursorPos().y()));
-        m_shader->setUniform(GLShader::ModelViewProjectionMatrix, data.projectionMatrix());
-        m_vbo->render(GL_TRIANGLES);
-        m_texture->unbind();
+void LookingGlassEffect::paintLens(ScreenPaintData &data)
+{
+    // copy the area under the lens out of the rendered screen, the rest of the screen stays as painted
+    const QRect area = lensArea();
+    // only the part on the output being rendered can be read from its framebuffer
+    const QRect visible = area & GLRenderTarget::virtualScreenGeometry();
+    if (visible.isEmpty()) {
+        return;
+    }
+    const bool mipmaps = needsMipmaps();
+    if (visible != area || mipmaps) {
+        // the texture still holds earlier lens areas, which would show at the screen edge
+        // and bleed into the mipmap levels
+        const bool scissor = glIsEnabled(GL_SCISSOR_TEST);
+        glDisable(GL_SCISSOR_TEST);
+        GLRenderTarget::pushRenderTarget(m_fbo);
+        glClearColor(0.0, 0.0, 0.0, 0.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        GLRenderTarget::popRenderTarget();
+        if (scissor) {
+            glEnable(GL_SCISSOR_TEST);
+        }
     }
+    m_fbo->blitFromFramebuffer(visible, visible.translated(-area.topLeft()));
+
+    m_texture->bind();
+    if (mipmaps) {
+        m_texture->setFilter(GL_LINEAR_MIPMAP_LINEAR);
+        m_texture->generateMipmaps();
+    } else {
+        m_texture->setFilter(GL_LINEAR);
+    }
+
+    QVector<float> verts;
+    QVector<float> texcoords;
+    const QRectF lens = area.adjusted(s_lensMargin, s_lensMargin, -s_lensMargin, -s_lensMargin);
+    texcoords << lens.right() << lens.top();
+    verts << lens.right() << lens.top();
+    texcoords << lens.left() << lens.top();
+    verts << lens.left() << lens.top();
+    texcoords << lens.left() << lens.bottom();
+    verts << lens.left() << lens.bottom();
+    texcoords << lens.left() << lens.bottom();
+    verts << lens.left() << lens.bottom();
+    texcoords << lens.right() << lens.bottom();
+    verts << lens.right() << lens.bottom();
+    texcoords << lens.right() << lens.top();
+    verts << lens.right() << lens.top();
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setData(6, 2, verts.constData(), texcoords.constData());
+
+    ShaderBinder binder(m_shader);
+    m_shader->setUniform("u_zoom", (float)zoom);
+    m_shader->setUniform("u_radius", (float)radius);
+    m_shader->setUniform("u_cursor", QVector2D(cursorPos().x(), cursorPos().y()));
+    m_shader->setUniform("u_textureOffset", QVector2D(area.x(), area.y()));
+    m_shader->setUniform(GLShader::ModelViewProjectionMatrix, data.projectionMatrix());
+    vbo->render(GL_TRIANGLES);
+    m_texture->unbind();
 }
 
 bool LookingGlassEffect::isActive() const
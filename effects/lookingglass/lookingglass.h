@@ -65,6 +65,9 @@ public Q_SLOTS:
 
 private:
     bool loadData();
+    void paintLens(ScreenPaintData &data);
+    QRect lensArea() const;
+    bool needsMipmaps() const;
     double zoom;
     double target_zoom;
     bool polling; // Mouse polling
@@ -76,6 +79,7 @@ private:
     GLShader *m_shader;
     bool m_enabled;
     bool m_valid;
+    bool m_regionLimited;
 };
 
 } // namespace
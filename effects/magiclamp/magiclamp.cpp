@@ -24,9 +24,61 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // KConfigSkeleton
 #include "magiclampconfig.h"
 
+#include <kwinglutils.h>
+
+#include <QVector4D>
+
 namespace KWin
 {
 
+// Evaluates the vertex movement of the CPU path in paintWindow on the GPU.
+// iconPosition uses the values of MagicLampEffect::IconPosition, the name position is
+// taken by the vertex attribute of the generated shader.
+static const char s_deformation[] =
+    "uniform vec4 windowGeometry;\n"
+    "uniform vec4 iconGeometry;\n"
+    "uniform float progress;\n"
+    "uniform int iconPosition;\n"
+    "\n"
+    "vec2 deform(vec2 p)\n"
+    "{\n"
+    "    vec2 geoPos = windowGeometry.xy;\n"
+    "    vec2 geoSize = windowGeometry.zw;\n"
+    "    vec2 iconPos = iconGeometry.xy;\n"
+    "    vec2 iconSize = iconGeometry.zw;\n"
+    "    float quadFactor;\n"
+    "    float offset;\n"
+    "    float factor;\n"
+    "    if (iconPosition == 0 || iconPosition == 1) {\n"
+    "        if (iconPosition == 1) {\n"
+    "            quadFactor = (p.y + (geoSize.y - p.y) * progress) / geoSize.y;\n"
+    "            offset = (iconPos.y + p.y - geoPos.y) * progress * quadFactor * quadFactor * quadFactor;\n"
+    "            factor = min(offset / (iconPos.y + iconSize.y - geoPos.y - p.y), 1.0);\n"
+    "        } else {\n"
+    "            quadFactor = (geoSize.y - p.y + p.y * progress) / geoSize.y;\n"
+    "            offset = (geoPos.y - iconSize.y + geoSize.y + p.y - iconPos.y) * progress * quadFactor * quadFactor * quadFactor;\n"
+    "            factor = min(offset / (geoPos.y - iconSize.y + geoSize.y - iconPos.y - (geoSize.y - p.y)), 1.0);\n"
+    "            offset = -offset;\n"
+    "        }\n"
+    "        factor = abs(factor);\n"
+    "        // x values are moved towards the center of the icon\n"
+    "        return vec2((iconPos.x + iconSize.x * (p.x / geoSize.x) - (p.x + geoPos.x)) * factor + p.x, p.y + offset);\n"
+    "    }\n"
+    "    if (iconPosition == 3) {\n"
+    "        quadFactor = (p.x + (geoSize.x - p.x) * progress) / geoSize.x;\n"
+    "        offset = (iconPos.x + p.x - geoPos.x) * progress * quadFactor * quadFactor * quadFactor;\n"
+    "        factor = min(offset / (iconPos.x + iconSize.x - geoPos.x - p.x), 1.0);\n"
+    "    } else {\n"
+    "        quadFactor = (geoSize.x - p.x + p.x * progress) / geoSize.x;\n"
+    "        offset = (geoPos.x - iconSize.x + geoSize.x + p.x - iconPos.x) * progress * quadFactor * quadFactor * quadFactor;\n"
+    "        factor = min(offset / (geoPos.x - iconSize.x + geoSize.x - iconPos.x - (geoSize.x - p.x)), 1.0);\n"
+    "        offset = -offset;\n"
+    "    }\n"
+    "    factor = abs(factor);\n"
+    "    // y values are moved towards the center of the icon\n"
+    "    return vec2(p.x + offset, (iconPos.y + iconSize.y * (p.y / geoSize.y) - (p.y + geoPos.y)) * factor + p.y);\n"
+    "}\n";
+
 MagicLampEffect::MagicLampEffect()
 {
     initConfig<MagicLampConfig>();
@@ -36,6 +88,10 @@ MagicLampEffect::MagicLampEffect()
     connect(effects, SIGNAL(windowUnminimized(KWin::EffectWindow*)), this, SLOT(slotWindowUnminimized(KWin::EffectWindow*)));
 }
 
+MagicLampEffect::~MagicLampEffect()
+{
+}
+
 bool MagicLampEffect::supported()
 {
     return effects->isOpenGLCompositing() && effects->animationsSupported();
@@ -77,7 +133,7 @@ void MagicLampEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data,
     if (m_animations.contains(w)) {
         // We'll transform this window
         data.setTransformed();
-        data.quads = data.quads.makeGrid(40);
+        data.quads = m_gridCache.grid(w, data.quads, 40);
         w->enablePainting(EffectWindow::PAINT_DISABLED_BY_MINIMIZE);
     }
 
@@ -183,6 +239,23 @@ void MagicLampEffect::paintWindow(EffectWindow* w, int mask, QRegion region, Win
             }
         }
 
+        // another effect providing its own shader wins, deform on the CPU then
+        GLShader *shader = data.shader ? nullptr : deformationShader();
+        if (shader) {
+            ShaderManager::instance()->pushShader(shader);
+            shader->setUniform("windowGeometry", QVector4D(geo.x(), geo.y(), geo.width(), geo.height()));
+            shader->setUniform("iconGeometry", QVector4D(icon.x(), icon.y(), icon.width(), icon.height()));
+            shader->setUniform("progress", float(progress));
+            shader->setUniform("iconPosition", int(position));
+            data.shader = shader;
+
+            effects->paintWindow(w, mask, region, data);
+
+            ShaderManager::instance()->popShader();
+            data.shader = nullptr;
+            return;
+        }
+
 #define SANITIZE_PROGRESS   if (p_progress[0] < 0)\
                                 p_progress[0] = -p_progress[0];\
                             if (p_progress[1] < 0)\
@@ -308,11 +381,31 @@ void MagicLampEffect::paintWindow(EffectWindow* w, int mask, QRegion region, Win
     effects->paintWindow(w, mask, region, data);
 }
 
+bool MagicLampEffect::deformsOnGpu()
+{
+    return deformationShader() != nullptr;
+}
+
+GLShader *MagicLampEffect::deformationShader()
+{
+    if (!m_deformationShaderLoaded) {
+        m_deformationShaderLoaded = true;
+        m_deformationShader.reset(ShaderManager::instance()->generateDeformationShader(
+            ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation, s_deformation));
+        if (!m_deformationShader->isValid()) {
+            qCWarning(KWINEFFECTS) << "Failed to compile the magic lamp deformation shader, falling back to CPU deformation";
+            m_deformationShader.reset();
+        }
+    }
+    return m_deformationShader.data();
+}
+
 void MagicLampEffect::postPaintScreen()
 {
     auto animationIt = m_animations.begin();
     while (animationIt != m_animations.end()) {
         if ((*animationIt).done()) {
+            m_gridCache.remove(animationIt.key());
             animationIt = m_animations.erase(animationIt);
         } else {
             ++animationIt;
@@ -328,6 +421,7 @@ void MagicLampEffect::postPaintScreen()
 void MagicLampEffect::slotWindowDeleted(EffectWindow* w)
 {
     m_animations.remove(w);
+    m_gridCache.remove(w);
 }
 
 void MagicLampEffect::slotWindowMinimized(EffectWindow* w)
@@ -33,6 +33,7 @@ class MagicLampEffect
 
 public:
     MagicLampEffect();
+    ~MagicLampEffect() override;
 
     virtual void reconfigure(ReconfigureFlags);
     virtual void prePaintScreen(ScreenPrePaintData& data, int time);
@@ -47,14 +48,24 @@ public:
 
     static bool supported();
 
+    /**
+     * Whether windows get deformed in the vertex shader, requires a current context.
+     **/
+    Q_INVOKABLE bool deformsOnGpu();
+
 public Q_SLOTS:
     void slotWindowDeleted(KWin::EffectWindow *w);
     void slotWindowMinimized(KWin::EffectWindow *w);
     void slotWindowUnminimized(KWin::EffectWindow *w);
 
 private:
+    GLShader *deformationShader();
+
     std::chrono::milliseconds m_duration;
     QHash<const EffectWindow*, TimeLine> m_animations;
+    WindowQuadGridCache m_gridCache;
+    QScopedPointer<GLShader> m_deformationShader;
+    bool m_deformationShaderLoaded = false;
 
     enum IconPosition {
         Top,
@@ -144,13 +144,36 @@ void MagnifierEffect::paintScreen(int mask, QRegion region, ScreenPaintData& dat
     if (zoom != 1.0) {
         // get the right area from the current rendered screen
         const QRect area = magnifierArea();
+        m_paintedArea = area.adjusted(-FRAME_WIDTH, -FRAME_WIDTH, FRAME_WIDTH, FRAME_WIDTH);
         const QPoint cursor = cursorPos();
 
         QRect srcArea(cursor.x() - (double)area.width() / (zoom*2),
                       cursor.y() - (double)area.height() / (zoom*2),
                       (double)area.width() / zoom, (double)area.height() / zoom);
         if (effects->isOpenGLCompositing()) {
-            m_fbo->blitFromFramebuffer(srcArea);
+            // only the part on the output being rendered can be read from its framebuffer,
+            // the rest of the magnifier shows black instead of what an earlier frame left
+            const QRect visible = srcArea & GLRenderTarget::virtualScreenGeometry();
+            if (visible != srcArea) {
+                const bool scissor = glIsEnabled(GL_SCISSOR_TEST);
+                glDisable(GL_SCISSOR_TEST);
+                GLRenderTarget::pushRenderTarget(m_fbo);
+                glClearColor(0.0, 0.0, 0.0, 1.0);
+                glClear(GL_COLOR_BUFFER_BIT);
+                GLRenderTarget::popRenderTarget();
+                if (scissor) {
+                    glEnable(GL_SCISSOR_TEST);
+                }
+            }
+            if (!visible.isEmpty()) {
+                const qreal scaleX = qreal(m_texture->width()) / srcArea.width();
+                const qreal scaleY = qreal(m_texture->height()) / srcArea.height();
+                const QRect destination(qRound((visible.x() - srcArea.x()) * scaleX),
+                                        qRound((visible.y() - srcArea.y()) * scaleY),
+                                        qRound(visible.width() * scaleX),
+                                        qRound(visible.height() * scaleY));
+                m_fbo->blitFromFramebuffer(visible, destination);
+            }
             // paint magnifier
             m_texture->bind();
             auto s = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
@@ -327,10 +350,12 @@ void MagnifierEffect::toggle()
 void MagnifierEffect::slotMouseChanged(const QPoint& pos, const QPoint& old,
                                    Qt::MouseButtons, Qt::MouseButtons, Qt::KeyboardModifiers, Qt::KeyboardModifiers)
 {
-    if (pos != old && zoom != 1)
-        // need full repaint as we might lose some change events on fast mouse movements
-        // see Bug 187658
-        effects->addRepaintFull();
+    if (pos != old && zoom != 1) {
+        // Repaint where the magnifier got painted last rather than around the old position, we
+        // might lose some change events on fast mouse movements, see Bug 187658
+        effects->addRepaint(m_paintedArea);
+        effects->addRepaint(magnifierArea(pos).adjusted(-FRAME_WIDTH, -FRAME_WIDTH, FRAME_WIDTH, FRAME_WIDTH));
+    }
 }
 
 bool MagnifierEffect::isActive() const
@@ -68,6 +68,7 @@ private:
     double target_zoom;
     bool polling; // Mouse polling
     QSize magnifier_size;
+    QRect m_paintedArea;
     GLTexture *m_texture;
     GLRenderTarget *m_fbo;
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
@@ -621,14 +621,21 @@ QImage ScreenShotEffect::blitScreenshot(const QRect &geometry)
     if (effects->isOpenGLCompositing())
     {
         img = QImage(geometry.size(), QImage::Format_ARGB32);
-        if (GLRenderTarget::blitSupported() && !GLPlatform::instance()->isGLES()) {
+        if (GLRenderTarget::blitSupported()) {
+            // the blit takes outputs rotated by the projection into account
             GLTexture tex(GL_RGBA8, geometry.width(), geometry.height());
             GLRenderTarget target(tex);
             target.blitFromFramebuffer(geometry);
             // copy content from framebuffer into image
-            tex.bind();
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)img.bits());
-            tex.unbind();
+            if (GLPlatform::instance()->isGLES()) {
+                GLRenderTarget::pushRenderTarget(&target);
+                glReadPixels(0, 0, img.width(), img.height(), GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)img.bits());
+                GLRenderTarget::popRenderTarget();
+            } else {
+                tex.bind();
+                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)img.bits());
+                tex.unbind();
+            }
         } else {
             glReadPixels(0, 0, img.width(), img.height(), GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)img.bits());
         }
@@ -12,6 +12,11 @@ License. See the file "COPYING" for the exact licensing terms.
 #include "wobblywindows.h"
 #include "wobblywindowsconfig.h"
 
+#include <kwinglutils.h>
+
+#include <QVector2D>
+#include <QVector4D>
+
 #include <math.h>
 
 //#define COMPUTE_STATS
@@ -137,6 +142,24 @@ static const ParameterSet set_4 = {
 
 static const ParameterSet pset[5] = { set_0, set_1, set_2, set_3, set_4 };
 
+// Evaluates the bicubic bezier surface of computeBezierPoint on the GPU.
+// The control points are window local, bezierRect is the undeformed control grid.
+static const char s_deformation[] =
+    "uniform vec2 controlPoints[16];\n"
+    "uniform vec4 bezierRect;\n"
+    "\n"
+    "vec2 deform(vec2 position)\n"
+    "{\n"
+    "    vec2 t = (position - bezierRect.xy) / bezierRect.zw;\n"
+    "    vec2 s = vec2(1.0) - t;\n"
+    "    vec4 px = vec4(s.x * s.x * s.x, 3.0 * s.x * s.x * t.x, 3.0 * s.x * t.x * t.x, t.x * t.x * t.x);\n"
+    "    vec4 py = vec4(s.y * s.y * s.y, 3.0 * s.y * s.y * t.y, 3.0 * s.y * t.y * t.y, t.y * t.y * t.y);\n"
+    "    return py.x * (px.x * controlPoints[0]  + px.y * controlPoints[1]  + px.z * controlPoints[2]  + px.w * controlPoints[3])\n"
+    "         + py.y * (px.x * controlPoints[4]  + px.y * controlPoints[5]  + px.z * controlPoints[6]  + px.w * controlPoints[7])\n"
+    "         + py.z * (px.x * controlPoints[8]  + px.y * controlPoints[9]  + px.z * controlPoints[10] + px.w * controlPoints[11])\n"
+    "         + py.w * (px.x * controlPoints[12] + px.y * controlPoints[13] + px.z * controlPoints[14] + px.w * controlPoints[15]);\n"
+    "}\n";
+
 WobblyWindowsEffect::WobblyWindowsEffect()
 {
     initConfig<WobblyWindowsConfig>();
@@ -149,6 +172,7 @@ WobblyWindowsEffect::WobblyWindowsEffect()
     connect(effects, SIGNAL(windowMaximizedStateChanged(KWin::EffectWindow*,bool,bool)), this, SLOT(slotWindowMaximizeStateChanged(KWin::EffectWindow*,bool,bool)));
 
     connect(effects, &EffectsHandler::windowDataChanged, this, &WobblyWindowsEffect::cancelWindowGrab);
+    connect(effects, &EffectsHandler::windowDeleted, this, [this] (EffectWindow *w) { m_gridCache.remove(w); });
 }
 
 WobblyWindowsEffect::~WobblyWindowsEffect()
@@ -278,7 +302,7 @@ void WobblyWindowsEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& da
 {
     if (windows.contains(w)) {
         data.setTransformed();
-        data.quads = data.quads.makeRegularGrid(m_xTesselation, m_yTesselation);
+        data.quads = m_gridCache.regularGrid(w, data.quads, m_xTesselation, m_yTesselation);
         bool stop = false;
         qreal updateTime = time;
 
@@ -299,6 +323,7 @@ void WobblyWindowsEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& da
 
 void WobblyWindowsEffect::paintWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data)
 {
+    GLShader *shader = nullptr;
     if (!(mask & PAINT_SCREEN_TRANSFORMED) && windows.contains(w)) {
         WindowWobblyInfos& wwi = windows[w];
         int tx = w->geometry().x();
@@ -307,17 +332,46 @@ void WobblyWindowsEffect::paintWindow(EffectWindow* w, int mask, QRegion region,
         double top = 0.0;
         double right = w->width();
         double bottom = w->height();
-        for (int i = 0; i < data.quads.count(); ++i) {
-            for (int j = 0; j < 4; ++j) {
-                WindowVertex& v = data.quads[i][j];
-                Pair oldPos = {tx + v.x(), ty + v.y()};
-                Pair newPos = computeBezierPoint(wwi, oldPos);
-                v.move(newPos.x - tx, newPos.y - ty);
+        // another effect providing its own shader wins, deform on the CPU then
+        shader = data.shader ? nullptr : deformationShader();
+        if (shader) {
+            // the bezier surface lies within the convex hull of its control points
+            QVector<QVector2D> controlPoints(wwi.count);
+            for (unsigned int i = 0; i < wwi.count; ++i) {
+                const Pair &p = wwi.position[i];
+                controlPoints[i] = QVector2D(p.x - tx, p.y - ty);
+                left   = qMin(left,   p.x - tx);
+                top    = qMin(top,    p.y - ty);
+                right  = qMax(right,  p.x - tx);
+                bottom = qMax(bottom, p.y - ty);
+            }
+            // shadows extend beyond the control grid
+            const QRect expanded = w->expandedGeometry();
+            left   += expanded.left() - w->x();
+            top    += expanded.top() - w->y();
+            right  += expanded.right() - w->geometry().right();
+            bottom += expanded.bottom() - w->geometry().bottom();
+
+            const Pair &topLeft = wwi.origin[0];
+            const Pair &bottomRight = wwi.origin[wwi.count - 1];
+            ShaderManager::instance()->pushShader(shader);
+            shader->setUniform("controlPoints", controlPoints);
+            shader->setUniform("bezierRect", QVector4D(topLeft.x - tx, topLeft.y - ty,
+                                                       bottomRight.x - topLeft.x, bottomRight.y - topLeft.y));
+            data.shader = shader;
+        } else {
+            for (int i = 0; i < data.quads.count(); ++i) {
+                for (int j = 0; j < 4; ++j) {
+                    WindowVertex& v = data.quads[i][j];
+                    Pair oldPos = {tx + v.x(), ty + v.y()};
+                    Pair newPos = computeBezierPoint(wwi, oldPos);
+                    v.move(newPos.x - tx, newPos.y - ty);
+                }
+                left   = qMin(left,   data.quads[i].left());
+                top    = qMin(top,    data.quads[i].top());
+                right  = qMax(right,  data.quads[i].right());
+                bottom = qMax(bottom, data.quads[i].bottom());
             }
-            left   = qMin(left,   data.quads[i].left());
-            top    = qMin(top,    data.quads[i].top());
-            right  = qMax(right,  data.quads[i].right());
-            bottom = qMax(bottom, data.quads[i].bottom());
         }
         QRectF dirtyRect(
             left * data.xScale() + w->x() + data.xTranslation(),
@@ -331,6 +385,25 @@ void WobblyWindowsEffect::paintWindow(EffectWindow* w, int mask, QRegion region,
 
     // Call the next effect.
     effects->paintWindow(w, mask, region, data);
+
+    if (shader) {
+        ShaderManager::instance()->popShader();
+        data.shader = nullptr;
+    }
+}
+
+GLShader *WobblyWindowsEffect::deformationShader()
+{
+    if (!m_deformationShaderLoaded) {
+        m_deformationShaderLoaded = true;
+        m_deformationShader.reset(ShaderManager::instance()->generateDeformationShader(
+            ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation, s_deformation));
+        if (!m_deformationShader->isValid()) {
+            qCWarning(KWINEFFECTS) << "Failed to compile the wobbly deformation shader, falling back to CPU deformation";
+            m_deformationShader.reset();
+        }
+    }
+    return m_deformationShader.data();
 }
 
 void WobblyWindowsEffect::postPaintScreen()
@@ -498,6 +571,7 @@ void WobblyWindowsEffect::slotWindowClosed(EffectWindow* w)
         } else {
             freeWobblyInfo(wwi);
             windows.remove(w);
+            m_gridCache.remove(w);
             if (windows.isEmpty())
                 effects->addRepaintFull();
         }
@@ -1043,6 +1117,7 @@ bool WobblyWindowsEffect::updateWindowWobblyDatas(EffectWindow* w, qreal time)
         }
         freeWobblyInfo(wwi);
         windows.remove(w);
+        m_gridCache.remove(w);
         if (windows.isEmpty())
             effects->addRepaintFull();
         return false;
@@ -1203,6 +1278,7 @@ void WobblyWindowsEffect::cancelWindowGrab(KWin::EffectWindow *w, int grabRole)
             if (it != windows.end()) {
                 freeWobblyInfo(it.value());
                 windows.erase(it);
+                m_gridCache.remove(w);
             }
          }
     } else if (grabRole == WindowClosedGrabRole) {
@@ -1214,6 +1290,7 @@ void WobblyWindowsEffect::cancelWindowGrab(KWin::EffectWindow *w, int grabRole)
                 }
                 freeWobblyInfo(it.value());
                 windows.erase(it);
+                m_gridCache.remove(w);
             }
          }
     }
@@ -143,6 +143,7 @@ private:
     void startMovedResized(EffectWindow* w);
     void stepMovedResized(EffectWindow* w);
     bool updateWindowWobblyDatas(EffectWindow* w, qreal time);
+    GLShader *deformationShader();
 
     struct WindowWobblyInfos {
         Pair* origin;
@@ -178,6 +179,10 @@ private:
 
     QRegion m_updateRegion;
 
+    WindowQuadGridCache m_gridCache;
+    QScopedPointer<GLShader> m_deformationShader;
+    bool m_deformationShaderLoaded = false;
+
     qreal m_stiffness;
     qreal m_drag;
     qreal m_move_factor;
@@ -34,6 +34,7 @@ void FocusChain::remove(AbstractClient *client)
         it.value().removeAll(client);
     }
     m_mostRecentlyUsed.removeAll(client);
+    emit changed();
 }
 
 void FocusChain::resize(uint previousSize, uint newSize)
@@ -111,6 +112,7 @@ void FocusChain::update(AbstractClient *client, FocusChain::Change change)
 
     // add for most recently used chain
     updateClientInChain(client, change, m_mostRecentlyUsed);
+    emit changed();
 }
 
 void FocusChain::updateClientInChain(AbstractClient *client, FocusChain::Change change, Chain &chain)
@@ -154,6 +156,7 @@ void FocusChain::moveAfterClient(AbstractClient *client, AbstractClient *referen
         moveAfterClientInChain(client, reference, it.value());
     }
     moveAfterClientInChain(client, reference, m_mostRecentlyUsed);
+    emit changed();
 }
 
 void FocusChain::moveAfterClientInChain(AbstractClient *client, AbstractClient *reference, Chain &chain)
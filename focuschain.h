@@ -175,6 +175,15 @@ public Q_SLOTS:
     void setCurrentDesktop(uint previous, uint newDesktop);
     bool isUsableFocusCandidate(AbstractClient *c, AbstractClient *prev) const;
 
+Q_SIGNALS:
+    /**
+     * @brief Emitted after a Client got added to, moved inside or removed from the focus chains.
+     *
+     * Users keeping a copy of the chain, like the TabBox client list, can update it from here
+     * instead of walking the chain each time they need it.
+     **/
+    void changed();
+
 private:
     using Chain = QList<AbstractClient*>;
     /**
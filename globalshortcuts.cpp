@@ -13,17 +13,13 @@
 #include "utils.h"
 // KDE
 #include <KGlobalAccel/private/kglobalacceld.h>
-#include <KGlobalAccel/private/kglobalaccel_interface.h>
 // Qt
 #include <QAction>
 
 namespace KWin
 {
 
-uint qHash(SwipeDirection direction)
-{
-    return uint(direction);
-}
+GlobalAccelKeyHandler::~GlobalAccelKeyHandler() = default;
 
 GlobalShortcut::GlobalShortcut(const QKeySequence &shortcut)
     : m_shortcut(shortcut)
@@ -126,9 +122,8 @@ GlobalShortcutsManager::GlobalShortcutsManager(QObject *parent)
 template <typename T>
 void clearShortcuts(T &shortcuts)
 {
-    for (auto it = shortcuts.begin(); it != shortcuts.end(); ++it) {
-        qDeleteAll((*it));
-    }
+    qDeleteAll(shortcuts);
+    shortcuts.clear();
 }
 
 GlobalShortcutsManager::~GlobalShortcutsManager()
@@ -156,19 +151,16 @@ void GlobalShortcutsManager::init()
 template <typename T>
 void handleDestroyedAction(QObject *object, T &shortcuts)
 {
-    for (auto it = shortcuts.begin(); it != shortcuts.end(); ++it) {
-        auto &list = it.value();
-        auto it2 = list.begin();
-        while (it2 != list.end()) {
-            if (InternalGlobalShortcut *shortcut = dynamic_cast<InternalGlobalShortcut*>(it2.value())) {
-                if (shortcut->action() == object) {
-                    it2 = list.erase(it2);
-                    delete shortcut;
-                    continue;
-                }
+    auto it = shortcuts.begin();
+    while (it != shortcuts.end()) {
+        if (InternalGlobalShortcut *shortcut = dynamic_cast<InternalGlobalShortcut*>(it.value())) {
+            if (shortcut->action() == object) {
+                it = shortcuts.erase(it);
+                delete shortcut;
+                continue;
             }
-            ++it2;
         }
+        ++it;
     }
 }
 
@@ -183,15 +175,8 @@ template <typename T, typename R>
 GlobalShortcut *addShortcut(T &shortcuts, QAction *action, Qt::KeyboardModifiers modifiers, R value)
 {
     GlobalShortcut *cut = new InternalGlobalShortcut(modifiers, value, action);
-    auto it = shortcuts.find(modifiers);
-    if (it != shortcuts.end()) {
-        // TODO: check if shortcut already exists
-        (*it).insert(value, cut);
-    } else {
-        QHash<R, GlobalShortcut*> s;
-        s.insert(value, cut);
-        shortcuts.insert(modifiers, s);
-    }
+    // a shortcut registered again replaces the previous one
+    delete shortcuts.insert(T::key(modifiers, quint32(value)), cut);
     return cut;
 }
 
@@ -217,32 +202,22 @@ void GlobalShortcutsManager::registerTouchpadSwipe(QAction *action, SwipeDirecti
 template <typename T, typename U>
 bool processShortcut(Qt::KeyboardModifiers mods, T key, U &shortcuts)
 {
-    auto it = shortcuts.find(mods);
-    if (it == shortcuts.end()) {
-        return false;
-    }
-    auto it2 = (*it).find(key);
-    if (it2 == (*it).end()) {
+    GlobalShortcut *shortcut = shortcuts.value(U::key(mods, quint32(key)));
+    if (!shortcut) {
         return false;
     }
-    it2.value()->invoke();
+    shortcut->invoke();
     return true;
 }
 
 bool GlobalShortcutsManager::processKey(Qt::KeyboardModifiers mods, int keyQt)
 {
-    if (m_kglobalAccelInterface) {
+    if (m_keyHandler) {
         if (!keyQt && !mods) {
             return false;
         }
         auto check = [this] (Qt::KeyboardModifiers mods, int keyQt) {
-            bool retVal = false;
-            QMetaObject::invokeMethod(m_kglobalAccelInterface,
-                                        "checkKeyPressed",
-                                        Qt::DirectConnection,
-                                        Q_RETURN_ARG(bool, retVal),
-                                        Q_ARG(int, int(mods) | keyQt));
-            return retVal;
+            return m_keyHandler->checkKeyPressed(int(mods) | keyQt);
         };
         if (check(mods, keyQt)) {
             return true;
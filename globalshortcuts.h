@@ -8,12 +8,12 @@
 #define KWIN_GLOBALSHORTCUTS_H
 // KWin
 #include <kwinglobals.h>
+#include "globalshortcuttable.h"
 // Qt
 #include <QKeySequence>
 
 class QAction;
 class KGlobalAccelD;
-class KGlobalAccelInterface;
 
 namespace KWin
 {
@@ -22,6 +22,21 @@ class GlobalShortcut;
 class SwipeGesture;
 class GestureRecognizer;
 
+/**
+ * @brief Key handling of the kglobalaccel platform plugin.
+ *
+ * Called directly for every key press which could be a global shortcut.
+ **/
+class KWIN_EXPORT GlobalAccelKeyHandler
+{
+public:
+    virtual ~GlobalAccelKeyHandler();
+    /**
+     * @returns @c true if @p keyQt, the key or'ed with the modifiers, triggered a shortcut.
+     **/
+    virtual bool checkKeyPressed(int keyQt) = 0;
+};
+
 /**
  * @brief Manager for the global shortcut system inside KWin.
  *
@@ -89,17 +104,17 @@ public:
     void processSwipeCancel();
     void processSwipeEnd();
 
-    void setKGlobalAccelInterface(KGlobalAccelInterface *interface) {
-        m_kglobalAccelInterface = interface;
+    void setGlobalAccelKeyHandler(GlobalAccelKeyHandler *handler) {
+        m_keyHandler = handler;
     }
 
 private:
     void objectDeleted(QObject *object);
-    QHash<Qt::KeyboardModifiers, QHash<Qt::MouseButtons, GlobalShortcut*> > m_pointerShortcuts;
-    QHash<Qt::KeyboardModifiers, QHash<PointerAxisDirection, GlobalShortcut*> > m_axisShortcuts;
-    QHash<Qt::KeyboardModifiers, QHash<SwipeDirection, GlobalShortcut*> > m_swipeShortcuts;
+    GlobalShortcutTable<GlobalShortcut*> m_pointerShortcuts;
+    GlobalShortcutTable<GlobalShortcut*> m_axisShortcuts;
+    GlobalShortcutTable<GlobalShortcut*> m_swipeShortcuts;
     KGlobalAccelD *m_kglobalAccel = nullptr;
-    KGlobalAccelInterface *m_kglobalAccelInterface = nullptr;
+    GlobalAccelKeyHandler *m_keyHandler = nullptr;
     GestureRecognizer *m_gestureRecognizer;
 };
 
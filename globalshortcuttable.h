@@ -0,0 +1,89 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_GLOBALSHORTCUTTABLE_H
+#define KWIN_GLOBALSHORTCUTTABLE_H
+
+#include <QHash>
+
+namespace KWin
+{
+
+/**
+ * @brief Lookup table for global shortcuts keyed by the modifiers and the key, button or axis.
+ *
+ * Every key press, pointer press and scroll step is checked against the shortcuts, so the check
+ * is a single hash lookup on one integer. The table gets updated whenever a shortcut gets
+ * registered or removed instead of being searched on the input path.
+ **/
+template <typename T>
+class GlobalShortcutTable
+{
+public:
+    typedef typename QHash<quint64, T>::iterator iterator;
+    typedef typename QHash<quint64, T>::const_iterator const_iterator;
+
+    /**
+     * @returns the key under which the combination of @p modifiers and @p value is stored.
+     **/
+    static quint64 key(Qt::KeyboardModifiers modifiers, quint32 value) {
+        return (quint64(quint32(modifiers)) << 32) | value;
+    }
+    /**
+     * @returns the key for a key combination as Qt encodes it, that is modifiers or'ed to the key.
+     **/
+    static quint64 key(int keyQt) {
+        return key(Qt::KeyboardModifiers(keyQt & Qt::KeyboardModifierMask), keyQt & ~Qt::KeyboardModifierMask);
+    }
+
+    T value(quint64 key) const {
+        return m_table.value(key);
+    }
+    bool contains(quint64 key) const {
+        return m_table.contains(key);
+    }
+    /**
+     * Stores @p value for @p key.
+     * @returns the value previously stored for @p key or a default constructed value.
+     **/
+    T insert(quint64 key, const T &value) {
+        T &entry = m_table[key];
+        const T previous = entry;
+        entry = value;
+        return previous;
+    }
+    T take(quint64 key) {
+        return m_table.take(key);
+    }
+    void clear() {
+        m_table.clear();
+    }
+    int count() const {
+        return m_table.count();
+    }
+
+    iterator begin() {
+        return m_table.begin();
+    }
+    iterator end() {
+        return m_table.end();
+    }
+    const_iterator begin() const {
+        return m_table.constBegin();
+    }
+    const_iterator end() const {
+        return m_table.constEnd();
+    }
+    iterator erase(iterator it) {
+        return m_table.erase(it);
+    }
+
+private:
+    QHash<quint64, T> m_table;
+};
+
+}
+
+#endif
@@ -2793,9 +2793,9 @@ void InputRedirection::registerTouchpadSwipeShortcut(SwipeDirection direction, Q
     m_shortcuts->registerTouchpadSwipe(action, direction);
 }
 
-void InputRedirection::registerGlobalAccel(KGlobalAccelInterface *interface)
+void InputRedirection::registerGlobalAccel(GlobalAccelKeyHandler *handler)
 {
-    m_shortcuts->setKGlobalAccelInterface(interface);
+    m_shortcuts->setGlobalAccelKeyHandler(handler);
 }
 
 void InputRedirection::warpPointer(const QPointF &pos)
@@ -20,7 +20,6 @@
 
 #include <functional>
 
-class KGlobalAccelInterface;
 class QKeySequence;
 class QMouseEvent;
 class QKeyEvent;
@@ -29,6 +28,7 @@ class RecordEventMonitor;
 
 namespace KWin
 {
+class GlobalAccelKeyHandler;
 class GlobalShortcutsManager;
 class Toplevel;
 class InputEventFilter;
@@ -108,7 +108,7 @@ public:
     void registerPointerShortcut(Qt::KeyboardModifiers modifiers, Qt::MouseButton pointerButtons, QAction *action);
     void registerAxisShortcut(Qt::KeyboardModifiers modifiers, PointerAxisDirection axis, QAction *action);
     void registerTouchpadSwipeShortcut(SwipeDirection direction, QAction *action);
-    void registerGlobalAccel(KGlobalAccelInterface *interface);
+    void registerGlobalAccel(GlobalAccelKeyHandler *handler);
 
     /**
      * @internal
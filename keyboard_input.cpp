@@ -279,8 +279,8 @@ void KeyboardInputRedirection::processKeymapChange(int fd, uint32_t size)
         return;
     }
     // TODO: should we pass the keymap to our Clients? Or only to the currently active one and update
+    // the layout gets reset through Xkb::keymapChanged
     m_xkb->installKeymap(fd, size);
-    m_keyboardLayout->resetLayout();
 }
 
 }
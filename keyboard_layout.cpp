@@ -53,6 +53,8 @@ void KeyboardLayout::init()
                                           QStringLiteral("reloadConfig"),
                                           this,
                                           SLOT(reconfigure()));
+    // the keymap of a new configuration may only be ready after reconfigure returned
+    connect(m_xkb, &Xkb::keymapChanged, this, &KeyboardLayout::resetLayout);
 
     reconfigure();
 }
@@ -154,7 +156,6 @@ void KeyboardLayout::reconfigure()
         }
     }
     m_xkb->reconfigure();
-    resetLayout();
 }
 
 void KeyboardLayout::resetLayout()
@@ -5,8 +5,11 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "device.h"
+#include "../configcommitter.h"
 
+#include <QCoreApplication>
 #include <QDBusConnection>
+#include <QThread>
 
 #include <linux/input.h>
 
@@ -265,8 +268,16 @@ void Device::writeEntry(const ConfigKey &key, const T &value)
     }
     auto it = s_configData.find(key);
     Q_ASSERT(it != s_configData.end());
-    m_config.writeEntry(it.value().key.constData(), value);
-    m_config.sync();
+    auto write = [config = m_config, entry = it.value().key, value] () mutable {
+        config.writeEntry(entry.constData(), value);
+        ConfigCommitter::sync(config);
+    };
+    // the device lives in the libinput thread, the config is written and synced in the main thread
+    if (QThread::currentThread() == qApp->thread()) {
+        write();
+    } else {
+        QMetaObject::invokeMethod(qApp, write, Qt::QueuedConnection);
+    }
 }
 
 template <typename T, typename Setter>
@@ -42,6 +42,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kconfiggroup.h>
 
 #include <assert.h>
+#include <cstddef>
 
 #include <KWayland/Server/surface_interface.h>
 
@@ -63,6 +64,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #ifdef HAVE_SSE2
 #  include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#  define HAVE_NEON
+#  include <arm_neon.h>
 #endif
 
 
@@ -857,6 +861,73 @@ EffectWindowGroup::~EffectWindowGroup()
  WindowQuad
 ***************************************************************/
 
+namespace {
+
+/**
+ * Subdivides one quad into sub-quads.
+ *
+ * The bounds and the texture mapping of the parent quad are computed only once, so
+ * cutting a quad into a grid does not walk its vertices again for every cell.
+ **/
+class SubQuadBuilder
+{
+public:
+    explicit SubQuadBuilder(const WindowQuad &quad)
+        : m_quad(quad)
+        , m_left(quad.left())
+        , m_top(quad.top())
+        , m_width(quad.right() - m_left)
+        , m_height(quad.bottom() - m_top)
+        , m_u0(quad[0].textureX())
+        , m_v0(quad[0].textureY())
+        , m_texWidth(quad[2].textureX() - m_u0)
+        , m_texHeight(quad[2].textureY() - m_v0)
+    {
+    }
+
+    WindowQuad make(double x1, double y1, double x2, double y2) const
+    {
+        WindowQuad ret(m_quad);
+        // vertices are clockwise starting from topleft, original x/y are supposed
+        // to be the same, no transforming is done here
+        if (!m_quad.uvAxisSwapped()) {
+            const double u0 = (x1 - m_left) / m_width  * m_texWidth  + m_u0;
+            const double u1 = (x2 - m_left) / m_width  * m_texWidth  + m_u0;
+            const double v0 = (y1 - m_top)  / m_height * m_texHeight + m_v0;
+            const double v1 = (y2 - m_top)  / m_height * m_texHeight + m_v0;
+
+            ret[0] = WindowVertex(x1, y1, u0, v0);
+            ret[1] = WindowVertex(x2, y1, u1, v0);
+            ret[2] = WindowVertex(x2, y2, u1, v1);
+            ret[3] = WindowVertex(x1, y2, u0, v1);
+        } else {
+            const double u0 = (y1 - m_top)  / m_height * m_texWidth  + m_u0;
+            const double u1 = (y2 - m_top)  / m_height * m_texWidth  + m_u0;
+            const double v0 = (x1 - m_left) / m_width  * m_texHeight + m_v0;
+            const double v1 = (x2 - m_left) / m_width  * m_texHeight + m_v0;
+
+            ret[0] = WindowVertex(x1, y1, u0, v0);
+            ret[1] = WindowVertex(x2, y1, u0, v1);
+            ret[2] = WindowVertex(x2, y2, u1, v1);
+            ret[3] = WindowVertex(x1, y2, u1, v0);
+        }
+        return ret;
+    }
+
+private:
+    const WindowQuad &m_quad;
+    const double m_left;
+    const double m_top;
+    const double m_width;
+    const double m_height;
+    const double m_u0;
+    const double m_v0;
+    const double m_texWidth;
+    const double m_texHeight;
+};
+
+}
+
 WindowQuad WindowQuad::makeSubQuad(double x1, double y1, double x2, double y2) const
 {
     assert(x1 < x2 && y1 < y2 && x1 >= left() && x2 <= right() && y1 >= top() && y2 <= bottom());
@@ -864,70 +935,7 @@ WindowQuad WindowQuad::makeSubQuad(double x1, double y1, double x2, double y2) c
     if (isTransformed())
         qFatal("Splitting quads is allowed only in pre-paint calls!");
 #endif
-    WindowQuad ret(*this);
-    // vertices are clockwise starting from topleft
-    ret.verts[ 0 ].px = x1;
-    ret.verts[ 3 ].px = x1;
-    ret.verts[ 1 ].px = x2;
-    ret.verts[ 2 ].px = x2;
-    ret.verts[ 0 ].py = y1;
-    ret.verts[ 1 ].py = y1;
-    ret.verts[ 2 ].py = y2;
-    ret.verts[ 3 ].py = y2;
-    // original x/y are supposed to be the same, no transforming is done here
-    ret.verts[ 0 ].ox = x1;
-    ret.verts[ 3 ].ox = x1;
-    ret.verts[ 1 ].ox = x2;
-    ret.verts[ 2 ].ox = x2;
-    ret.verts[ 0 ].oy = y1;
-    ret.verts[ 1 ].oy = y1;
-    ret.verts[ 2 ].oy = y2;
-    ret.verts[ 3 ].oy = y2;
-
-    const double my_u0 = verts[0].tx;
-    const double my_u1 = verts[2].tx;
-    const double my_v0 = verts[0].ty;
-    const double my_v1 = verts[2].ty;
-
-    const double width  = right() - left();
-    const double height = bottom() - top();
-
-    const double texWidth  = my_u1 - my_u0;
-    const double texHeight = my_v1 - my_v0;
-
-    if (!uvAxisSwapped()) {
-        const double u0 = (x1 - left()) / width  * texWidth  + my_u0;
-        const double u1 = (x2 - left()) / width  * texWidth  + my_u0;
-        const double v0 = (y1 - top())  / height * texHeight + my_v0;
-        const double v1 = (y2 - top())  / height * texHeight + my_v0;
-
-        ret.verts[0].tx = u0;
-        ret.verts[3].tx = u0;
-        ret.verts[1].tx = u1;
-        ret.verts[2].tx = u1;
-        ret.verts[0].ty = v0;
-        ret.verts[1].ty = v0;
-        ret.verts[2].ty = v1;
-        ret.verts[3].ty = v1;
-    } else {
-        const double u0 = (y1 - top())  / height * texWidth  + my_u0;
-        const double u1 = (y2 - top())  / height * texWidth  + my_u0;
-        const double v0 = (x1 - left()) / width  * texHeight + my_v0;
-        const double v1 = (x2 - left()) / width  * texHeight + my_v0;
-
-        ret.verts[0].tx = u0;
-        ret.verts[1].tx = u0;
-        ret.verts[2].tx = u1;
-        ret.verts[3].tx = u1;
-        ret.verts[0].ty = v0;
-        ret.verts[3].ty = v0;
-        ret.verts[1].ty = v1;
-        ret.verts[2].ty = v1;
-    }
-
-    ret.setUVAxisSwapped(uvAxisSwapped());
-
-    return ret;
+    return SubQuadBuilder(*this).make(x1, y1, x2, y2);
 }
 
 bool WindowQuad::smoothNeeded() const
@@ -1030,6 +1038,8 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
     }
 
     WindowQuadList ret;
+    // usually every cell of the bounding rectangle ends up with one sub-quad
+    ret.reserve(count() + qCeil((right - left) / maxQuadSize) * qCeil((bottom - top) / maxQuadSize));
 
     foreach (const WindowQuad &quad, *this) {
         const double quadLeft   = quad.left();
@@ -1043,6 +1053,8 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
             continue;
         }
 
+        const SubQuadBuilder builder(quad);
+
         // Compute the top-left corner of the first intersecting grid cell
         const double xBegin = left + qFloor((quadLeft - left) / maxQuadSize) * maxQuadSize;
         const double yBegin = top  + qFloor((quadTop  - top)  / maxQuadSize) * maxQuadSize;
@@ -1056,7 +1068,7 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
                 const double x0 = qMax(x, quadLeft);
                 const double x1 = qMin(quadRight, x + maxQuadSize);
 
-                ret.append(quad.makeSubQuad(x0, y0, x1, y1));
+                ret.append(builder.make(x0, y0, x1, y1));
             }
         }
     }
@@ -1090,6 +1102,7 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
     double yIncrement = (bottom - top) / ySubdivisions;
 
     WindowQuadList ret;
+    ret.reserve(count() + xSubdivisions * ySubdivisions);
 
     foreach (const WindowQuad &quad, *this) {
         const double quadLeft   = quad.left();
@@ -1103,6 +1116,8 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
             continue;
         }
 
+        const SubQuadBuilder builder(quad);
+
         // Compute the top-left corner of the first intersecting grid cell
         const double xBegin = left + qFloor((quadLeft - left) / xIncrement) * xIncrement;
         const double yBegin = top  + qFloor((quadTop  - top)  / yIncrement) * yIncrement;
@@ -1116,7 +1131,7 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
                 const double x0 = qMax(x, quadLeft);
                 const double x1 = qMin(quadRight, x + xIncrement);
 
-                ret.append(quad.makeSubQuad(x0, y0, x1, y1));
+                ret.append(builder.make(x0, y0, x1, y1));
             }
         }
     }
@@ -1124,6 +1139,79 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
     return ret;
 }
 
+/***************************************************************
+ WindowQuadGridCache
+***************************************************************/
+
+static bool isSameVertex(const WindowVertex &a, const WindowVertex &b)
+{
+    return a.x() == b.x() && a.y() == b.y() && a.textureX() == b.textureX() && a.textureY() == b.textureY();
+}
+
+static bool isSameQuadList(const WindowQuadList &a, const WindowQuadList &b)
+{
+    if (a.count() != b.count()) {
+        return false;
+    }
+    for (int i = 0; i < a.count(); ++i) {
+        const WindowQuad &qa = a.at(i);
+        const WindowQuad &qb = b.at(i);
+        if (qa.type() != qb.type() || qa.id() != qb.id() || qa.uvAxisSwapped() != qb.uvAxisSwapped()) {
+            return false;
+        }
+        for (int j = 0; j < 4; ++j) {
+            if (!isSameVertex(qa[j], qb[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+WindowQuadGridCache::Entry &WindowQuadGridCache::lookup(const EffectWindow *w, const WindowQuadList &quads, int xSubdivisions, int ySubdivisions, bool *valid)
+{
+    Entry &entry = m_entries[w];
+    *valid = entry.xSubdivisions == xSubdivisions && entry.ySubdivisions == ySubdivisions
+            && isSameQuadList(entry.source, quads);
+    if (!*valid) {
+        entry.source = quads;
+        entry.xSubdivisions = xSubdivisions;
+        entry.ySubdivisions = ySubdivisions;
+    }
+    return entry;
+}
+
+WindowQuadList WindowQuadGridCache::regularGrid(const EffectWindow *w, const WindowQuadList &quads, int xSubdivisions, int ySubdivisions)
+{
+    bool valid;
+    Entry &entry = lookup(w, quads, xSubdivisions, ySubdivisions, &valid);
+    if (!valid) {
+        entry.grid = quads.makeRegularGrid(xSubdivisions, ySubdivisions);
+    }
+    return entry.grid;
+}
+
+WindowQuadList WindowQuadGridCache::grid(const EffectWindow *w, const WindowQuadList &quads, int maxQuadSize)
+{
+    bool valid;
+    // a negative subdivision marks the irregular grid, so the two kinds never match
+    Entry &entry = lookup(w, quads, -maxQuadSize, -maxQuadSize, &valid);
+    if (!valid) {
+        entry.grid = quads.makeGrid(maxQuadSize);
+    }
+    return entry.grid;
+}
+
+void WindowQuadGridCache::remove(const EffectWindow *w)
+{
+    m_entries.remove(w);
+}
+
+void WindowQuadGridCache::clear()
+{
+    m_entries.clear();
+}
+
 #ifndef GL_TRIANGLES
 #  define GL_TRIANGLES      0x0004
 #endif
@@ -1143,115 +1231,71 @@ void WindowQuadList::makeInterleavedArrays(unsigned int type, GLVertex2D *vertic
 
     assert(type == GL_QUADS || type == GL_TRIANGLES);
 
-    switch (type)
-    {
-    case GL_QUADS:
-#ifdef HAVE_SSE2
-        if (!(intptr_t(vertex) & 0xf)) {
-            for (int i = 0; i < count(); i++) {
-                const WindowQuad &quad = at(i);
-                KWIN_ALIGN(16) GLVertex2D v[4];
+    // Note: The positions in a WindowQuad are stored in clockwise order
+    static const int quadIndex[] = { 0, 1, 2, 3 };
+    static const int triangleIndex[] = { 1, 0, 3, 3, 2, 1 };
+    const int *index = type == GL_QUADS ? quadIndex : triangleIndex;
+    const int verticesPerQuad = type == GL_QUADS ? 4 : 6;
+
+#if defined(HAVE_SSE2) || defined(HAVE_NEON)
+    // A WindowVertex starts with the position followed by the texture coordinate, which
+    // is the layout of GLVertex2D. So each vertex is one load, multiply-add and store.
+    static_assert(sizeof(GLVertex2D) == 4 * sizeof(float), "GLVertex2D has to be four packed floats");
+    static_assert(offsetof(WindowVertex, ty) == 3 * sizeof(float), "WindowVertex has to start with x, y, u, v");
+#endif
 
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
+#if defined(HAVE_SSE2)
+    if (!(intptr_t(vertex) & 0xf)) {
+        const __m128 scale = _mm_set_ps(coeff.y(), coeff.x(), 1.0f, 1.0f);
+        const __m128 translate = _mm_set_ps(offset.y(), offset.x(), 0.0f, 0.0f);
 
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-                }
+        for (int i = 0; i < count(); i++) {
+            const WindowQuad &quad = at(i);
+            __m128 v[4];
 
-                const __m128i *srcP = (const __m128i *) &v;
-                __m128i *dstP = (__m128i *) vertex;
+            for (int j = 0; j < 4; j++) {
+                v[j] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&quad.verts[j].px), scale), translate);
+            }
+            for (int j = 0; j < verticesPerQuad; j++) {
+                _mm_stream_ps(reinterpret_cast<float *>(vertex++), v[index[j]]);
+            }
+        }
+        return;
+    }
+#elif defined(HAVE_NEON)
+    {
+        const float32x4_t scale = { 1.0f, 1.0f, coeff.x(), coeff.y() };
+        const float32x4_t translate = { 0.0f, 0.0f, offset.x(), offset.y() };
 
-                _mm_stream_si128(&dstP[0], _mm_load_si128(&srcP[0])); // Top-left
-                _mm_stream_si128(&dstP[1], _mm_load_si128(&srcP[1])); // Top-right
-                _mm_stream_si128(&dstP[2], _mm_load_si128(&srcP[2])); // Bottom-right
-                _mm_stream_si128(&dstP[3], _mm_load_si128(&srcP[3])); // Bottom-left
+        for (int i = 0; i < count(); i++) {
+            const WindowQuad &quad = at(i);
+            float32x4_t v[4];
 
-                vertex += 4;
+            for (int j = 0; j < 4; j++) {
+                v[j] = vmlaq_f32(translate, vld1q_f32(&quad.verts[j].px), scale);
+            }
+            for (int j = 0; j < verticesPerQuad; j++) {
+                vst1q_f32(reinterpret_cast<float *>(vertex++), v[index[j]]);
             }
-        } else
-#endif // HAVE_SSE2
-        {
-            for (int i = 0; i < count(); i++) {
-                const WindowQuad &quad = at(i);
+        }
+        return;
+    }
+#endif
 
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
+    for (int i = 0; i < count(); i++) {
+        const WindowQuad &quad = at(i);
+        GLVertex2D v[4]; // Four unique vertices / quad
 
-                    GLVertex2D v;
-                    v.position = QVector2D(wv.x(), wv.y());
-                    v.texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
+        for (int j = 0; j < 4; j++) {
+            const WindowVertex &wv = quad[j];
 
-                    *(vertex++) = v;
-                }
-            }
+            v[j].position = QVector2D(wv.x(), wv.y());
+            v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
         }
-        break;
 
-    case GL_TRIANGLES:
-#ifdef HAVE_SSE2
-        if (!(intptr_t(vertex) & 0xf)) {
-            for (int i = 0; i < count(); i++) {
-                const WindowQuad &quad = at(i);
-                KWIN_ALIGN(16) GLVertex2D v[4];
-
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
-
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-                }
-
-                const __m128i *srcP = (const __m128i *) &v;
-                __m128i *dstP = (__m128i *) vertex;
-
-                __m128i src[4];
-                src[0] = _mm_load_si128(&srcP[0]); // Top-left
-                src[1] = _mm_load_si128(&srcP[1]); // Top-right
-                src[2] = _mm_load_si128(&srcP[2]); // Bottom-right
-                src[3] = _mm_load_si128(&srcP[3]); // Bottom-left
-
-                // First triangle
-                _mm_stream_si128(&dstP[0], src[1]); // Top-right
-                _mm_stream_si128(&dstP[1], src[0]); // Top-left
-                _mm_stream_si128(&dstP[2], src[3]); // Bottom-left
-
-                // Second triangle
-                _mm_stream_si128(&dstP[3], src[3]); // Bottom-left
-                _mm_stream_si128(&dstP[4], src[2]); // Bottom-right
-                _mm_stream_si128(&dstP[5], src[1]); // Top-right
-
-                vertex += 6;
-            }
-        } else
-#endif // HAVE_SSE2
-        {
-            for (int i = 0; i < count(); i++) {
-                const WindowQuad &quad = at(i);
-                GLVertex2D v[4]; // Four unique vertices / quad
-
-                for (int j = 0; j < 4; j++) {
-                    const WindowVertex &wv = quad[j];
-
-                    v[j].position = QVector2D(wv.x(), wv.y());
-                    v[j].texcoord = QVector2D(wv.u(), wv.v()) * coeff + offset;
-                }
-
-                // First triangle
-                *(vertex++) = v[1]; // Top-right
-                *(vertex++) = v[0]; // Top-left
-                *(vertex++) = v[3]; // Bottom-left
-
-                // Second triangle
-                *(vertex++) = v[3]; // Bottom-left
-                *(vertex++) = v[2]; // Bottom-right
-                *(vertex++) = v[1]; // Top-right
-            }
+        for (int j = 0; j < verticesPerQuad; j++) {
+            *(vertex++) = v[index[j]];
         }
-        break;
-
-    default:
-        break;
     }
 }
 
@@ -188,7 +188,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 227
+#define KWIN_EFFECT_API_VERSION_MINOR 228
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -2397,6 +2397,10 @@ struct GLVertex3D
  *
  * A vertex is one position in a window. WindowQuad consists of four WindowVertex objects
  * and represents one part of a window.
+ *
+ * The coordinates are stored as floats, which is what ends up in the vertex buffer anyway.
+ * The position is followed by the texture coordinate, so both can be loaded with a single
+ * vector load when building the interleaved vertex arrays.
  **/
 class KWINEFFECTS_EXPORT WindowVertex
 {
@@ -2420,9 +2424,9 @@ public:
 private:
     friend class WindowQuad;
     friend class WindowQuadList;
-    double px, py; // position
-    double ox, oy; // origional position
-    double tx, ty; // texture coords
+    float px, py; // position
+    float tx, ty; // texture coords
+    float ox, oy; // origional position
 };
 
 /**
@@ -2462,8 +2466,22 @@ private:
     int quadID;
 };
 
+} // namespace
+
+Q_DECLARE_TYPEINFO(KWin::WindowVertex, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(KWin::WindowQuad, Q_MOVABLE_TYPE);
+
+namespace KWin
+{
+
+/**
+ * @short List of WindowQuads.
+ *
+ * The quads are stored contiguously, so building a grid or the vertex arrays does not need
+ * a heap allocation per quad.
+ **/
 class KWINEFFECTS_EXPORT WindowQuadList
-    : public QList< WindowQuad >
+    : public QVector< WindowQuad >
 {
 public:
     WindowQuadList splitAtX(double x) const;
@@ -2478,6 +2496,47 @@ public:
     bool isTransformed() const;
 };
 
+/**
+ * @short Cache for subdivided window quads.
+ *
+ * Effects which deform windows in the vertex shader need a finely subdivided mesh,
+ * but the mesh itself does not change between frames as long as the window keeps
+ * its geometry. This class keeps the subdivided quads per window and only subdivides
+ * again if the undeformed quads passed in changed.
+ *
+ * The returned WindowQuadList is implicitly shared with the cache, so assigning it to
+ * WindowPrePaintData::quads does not copy any vertices.
+ *
+ * @since 5.15.5
+ **/
+class KWINEFFECTS_EXPORT WindowQuadGridCache
+{
+public:
+    /**
+     * @returns @p quads split with WindowQuadList::makeRegularGrid for the window @p w.
+     **/
+    WindowQuadList regularGrid(const EffectWindow *w, const WindowQuadList &quads, int xSubdivisions, int ySubdivisions);
+    /**
+     * @returns @p quads split with WindowQuadList::makeGrid for the window @p w.
+     **/
+    WindowQuadList grid(const EffectWindow *w, const WindowQuadList &quads, int maxQuadSize);
+    /**
+     * Drops the cached grid of @p w, has to be called when the window gets deleted.
+     **/
+    void remove(const EffectWindow *w);
+    void clear();
+
+private:
+    struct Entry {
+        WindowQuadList source;
+        WindowQuadList grid;
+        int xSubdivisions = 0;
+        int ySubdivisions = 0;
+    };
+    Entry &lookup(const EffectWindow *w, const WindowQuadList &quads, int xSubdivisions, int ySubdivisions, bool *valid);
+    QHash<const EffectWindow*, Entry> m_entries;
+};
+
 class KWINEFFECTS_EXPORT WindowPrePaintData
 {
 public:
@@ -3693,20 +3752,20 @@ extern KWINEFFECTS_EXPORT EffectsHandler* effects;
 
 inline
 WindowVertex::WindowVertex()
-    : px(0), py(0), ox(0), oy(0), tx(0), ty(0)
+    : px(0), py(0), tx(0), ty(0), ox(0), oy(0)
 {
 }
 
 inline
 WindowVertex::WindowVertex(double _x, double _y, double _tx, double _ty)
-    : px(_x), py(_y), ox(_x), oy(_y), tx(_tx), ty(_ty)
+    : px(_x), py(_y), tx(_tx), ty(_ty), ox(_x), oy(_y)
 {
 }
 
 
 inline
 WindowVertex::WindowVertex(const QPointF &position, const QPointF &texturePosition)
-    : px(position.x()), py(position.y()), ox(position.x()), oy(position.y()), tx(texturePosition.x()), ty(texturePosition.y())
+    : px(position.x()), py(position.y()), tx(texturePosition.x()), ty(texturePosition.y()), ox(position.x()), oy(position.y())
 {
 }
 
@@ -418,6 +418,12 @@ bool GLShader::setUniform(const char *name, const QVector2D& value)
     return setUniform(location, value);
 }
 
+bool GLShader::setUniform(const char *name, const QVector<QVector2D> &values)
+{
+    const int location = uniformLocation(name);
+    return setUniform(location, values);
+}
+
 bool GLShader::setUniform(const char *name, const QVector3D& value)
 {
     const int location = uniformLocation(name);
@@ -466,6 +472,14 @@ bool GLShader::setUniform(int location, const QVector2D &value)
     return (location >= 0);
 }
 
+bool GLShader::setUniform(int location, const QVector<QVector2D> &values)
+{
+    if (location >= 0) {
+        glUniform2fv(location, values.count(), (const GLfloat*)values.constData());
+    }
+    return (location >= 0);
+}
+
 bool GLShader::setUniform(int location, const QVector3D &value)
 {
     if (location >= 0) {
@@ -797,7 +811,7 @@ bool ShaderManager::selfTest()
     return pass;
 }
 
-QByteArray ShaderManager::generateVertexSource(ShaderTraits traits) const
+QByteArray ShaderManager::generateVertexSource(ShaderTraits traits, const QByteArray &deformation) const
 {
     QByteArray source;
     QTextStream stream(&source);
@@ -832,11 +846,17 @@ QByteArray ShaderManager::generateVertexSource(ShaderTraits traits) const
 
     stream << "uniform mat4 modelViewProjectionMatrix;\n\n";
 
+    if (!deformation.isEmpty())
+        stream << deformation << "\n\n";
+
     stream << "void main()\n{\n";
     if (traits & ShaderTrait::MapTexture)
         stream << "    texcoord0 = texcoord.st;\n";
 
-    stream << "    gl_Position = modelViewProjectionMatrix * position;\n";
+    if (deformation.isEmpty())
+        stream << "    gl_Position = modelViewProjectionMatrix * position;\n";
+    else
+        stream << "    gl_Position = modelViewProjectionMatrix * vec4(deform(position.xy), position.zw);\n";
     stream << "}\n";
 
     stream.flush();
@@ -943,6 +963,11 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
     return shader;
 }
 
+GLShader *ShaderManager::generateDeformationShader(ShaderTraits traits, const QByteArray &deformation)
+{
+    return generateCustomShader(traits, generateVertexSource(traits, deformation));
+}
+
 GLShader *ShaderManager::generateShaderFromResources(ShaderTraits traits, const QString &vertexFile, const QString &fragmentFile)
 {
     auto loadShaderFile = [this] (const QString &fileName) {
@@ -1063,6 +1088,9 @@ QRect GLRenderTarget::s_virtualScreenGeometry;
 qreal GLRenderTarget::s_virtualScreenScale = 1.0;
 GLint GLRenderTarget::s_virtualScreenViewport[4];
 GLuint GLRenderTarget::s_kwinFramebuffer = 0;
+int GLRenderTarget::s_virtualScreenRotation = 0;
+GLTexture *GLRenderTarget::s_transposeScratch = nullptr;
+GLRenderTarget *GLRenderTarget::s_transposeScratchTarget = nullptr;
 
 void GLRenderTarget::initStatic()
 {
@@ -1083,6 +1111,10 @@ void GLRenderTarget::initStatic()
 void GLRenderTarget::cleanup()
 {
     Q_ASSERT(s_renderTargets.isEmpty());
+    delete s_transposeScratchTarget;
+    s_transposeScratchTarget = nullptr;
+    delete s_transposeScratch;
+    s_transposeScratch = nullptr;
     sSupported = false;
     s_blitSupported = false;
 }
@@ -1193,6 +1225,75 @@ bool GLRenderTarget::disable()
     return true;
 }
 
+QRect GLRenderTarget::mapToFramebuffer(const QRect &rect, const QRect &geometry, qreal scale, int rotation)
+{
+    const int w = geometry.width() * scale;
+    const int h = geometry.height() * scale;
+    const int x = (rect.x() - geometry.x()) * scale;
+    const int y = (geometry.height() + geometry.y() - rect.y() - rect.height()) * scale;
+    const int rw = rect.width() * scale;
+    const int rh = rect.height() * scale;
+
+    switch (rotation) {
+    case 90:
+        return QRect(h - y - rh, x, rh, rw);
+    case 180:
+        return QRect(w - x - rw, h - y - rh, rw, rh);
+    case 270:
+        return QRect(y, w - x - rw, rh, rw);
+    default:
+        return QRect(x, y, rw, rh);
+    }
+}
+
+/**
+ * Saves the arrays of the vertex attributes the shaders use and restores them when
+ * going out of scope, so drawing in between does not break a bound GLVertexBuffer.
+ **/
+class VertexAttributeState
+{
+public:
+    VertexAttributeState() {
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &m_arrayBuffer);
+        for (int i = 0; i < VertexAttributeCount; ++i) {
+            Attribute &a = m_attributes[i];
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &a.enabled);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &a.buffer);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &a.size);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &a.type);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &a.normalized);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &a.stride);
+            glGetVertexAttribPointerv(i, GL_VERTEX_ATTRIB_ARRAY_POINTER, &a.pointer);
+        }
+    }
+    ~VertexAttributeState() {
+        for (int i = 0; i < VertexAttributeCount; ++i) {
+            const Attribute &a = m_attributes[i];
+            glBindBuffer(GL_ARRAY_BUFFER, a.buffer);
+            glVertexAttribPointer(i, a.size, a.type, a.normalized, a.stride, a.pointer);
+            if (a.enabled) {
+                glEnableVertexAttribArray(i);
+            } else {
+                glDisableVertexAttribArray(i);
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, m_arrayBuffer);
+    }
+
+private:
+    struct Attribute {
+        GLint enabled;
+        GLint buffer;
+        GLint size;
+        GLint type;
+        GLint normalized;
+        GLint stride;
+        GLvoid *pointer;
+    };
+    Attribute m_attributes[VertexAttributeCount];
+    GLint m_arrayBuffer;
+};
+
 static QString formatFramebufferStatus(GLenum status)
 {
     switch(status) {
@@ -1291,19 +1392,114 @@ void GLRenderTarget::blitFromFramebuffer(const QRect &source, const QRect &desti
         initFBO();
     }
 
+    const QRect s = source.isNull() ? s_virtualScreenGeometry : source;
+    const QRect d = destination.isNull() ? QRect(0, 0, mTexture.width(), mTexture.height()) : destination;
+    const QRect f = mapToFramebuffer(s);
+    const int dx0 = d.x();
+    const int dy0 = mTexture.height() - d.y() - d.height();
+    const int dx1 = d.x() + d.width();
+    const int dy1 = mTexture.height() - d.y();
+
+    if (s_virtualScreenRotation == 90 || s_virtualScreenRotation == 270) {
+        blitTransposedFromFramebuffer(f, QRect(dx0, dy0, d.width(), d.height()), filter);
+        return;
+    }
+
     GLRenderTarget::pushRenderTarget(this);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFramebuffer);
     glBindFramebuffer(GL_READ_FRAMEBUFFER, s_kwinFramebuffer);
-    const QRect s = source.isNull() ? s_virtualScreenGeometry : source;
-    const QRect d = destination.isNull() ? QRect(0, 0, mTexture.width(), mTexture.height()) : destination;
+    if (s_virtualScreenRotation == 180) {
+        // swapped source corners mirror the blit in both directions
+        glBlitFramebuffer(f.x() + f.width(), f.y() + f.height(), f.x(), f.y(),
+                          dx0, dy0, dx1, dy1, GL_COLOR_BUFFER_BIT, filter);
+    } else {
+        glBlitFramebuffer(f.x(), f.y(), f.x() + f.width(), f.y() + f.height(),
+                          dx0, dy0, dx1, dy1, GL_COLOR_BUFFER_BIT, filter);
+    }
+    GLRenderTarget::popRenderTarget();
+}
+
+void GLRenderTarget::blitTransposedFromFramebuffer(const QRect &source, const QRect &destination, GLenum filter)
+{
+    // glBlitFramebuffer can only mirror, so the framebuffer content gets copied as it is
+    // and drawn into the texture with rotated texture coordinates
+    if (source.isEmpty()) {
+        return;
+    }
+    if (!s_transposeScratch || s_transposeScratch->width() < source.width() || s_transposeScratch->height() < source.height()) {
+        // blur, the magnifier and the looking glass blit every frame, the scratch is kept
+        const QSize size = s_transposeScratch ? source.size().expandedTo(s_transposeScratch->size()) : source.size();
+        delete s_transposeScratchTarget;
+        delete s_transposeScratch;
+        s_transposeScratch = new GLTexture(GL_RGBA8, size);
+        s_transposeScratch->setWrapMode(GL_CLAMP_TO_EDGE);
+        s_transposeScratchTarget = new GLRenderTarget(*s_transposeScratch);
+    }
+    if (!s_transposeScratchTarget->valid()) {
+        return;
+    }
+    GLTexture &scratch = *s_transposeScratch;
+    scratch.setFilter(filter);
+
+    const GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    const GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    GLint texture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
 
-    glBlitFramebuffer((s.x() - s_virtualScreenGeometry.x()) * s_virtualScreenScale,
-                      (s_virtualScreenGeometry.height() - (s.y() - s_virtualScreenGeometry.y() + s.height())) * s_virtualScreenScale,
-                      (s.x() - s_virtualScreenGeometry.x() + s.width()) * s_virtualScreenScale,
-                      (s_virtualScreenGeometry.height() - (s.y() - s_virtualScreenGeometry.y())) * s_virtualScreenScale,
-                      d.x(), mTexture.height() - d.y() - d.height(), d.x() + d.width(), mTexture.height() - d.y(),
-                      GL_COLOR_BUFFER_BIT, filter);
+    GLRenderTarget::pushRenderTarget(this);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, s_transposeScratchTarget->mFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, s_kwinFramebuffer);
+    glBlitFramebuffer(source.x(), source.y(), source.x() + source.width(), source.y() + source.height(),
+                      0, 0, source.width(), source.height(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+
+    // destination corners in the texture's OpenGL coordinates, counter-clockwise from the bottom left
+    const float x0 = destination.x();
+    const float y0 = destination.y();
+    const float x1 = destination.x() + destination.width();
+    const float y1 = destination.y() + destination.height();
+    const float vertices[] = {
+        x0, y0, x1, y0, x1, y1,
+        x1, y1, x0, y1, x0, y0
+    };
+    // the screen content at (s, t) of the destination is at (1 - t, s) of a framebuffer rotated
+    // by 90 degrees and at (t, 1 - s) of one rotated by 270 degrees
+    // the source only covers the bottom left part of the scratch texture
+    const float s1 = float(source.width()) / scratch.width();
+    const float t1 = float(source.height()) / scratch.height();
+    const float rotated90[] = {
+        s1, 0, s1, t1, 0, t1,
+        0, t1, 0, 0, s1, 0
+    };
+    const float rotated270[] = {
+        0, t1, 0, 0, s1, 0,
+        s1, 0, s1, t1, 0, t1
+    };
+
+    {
+        VertexAttributeState attributeState;
+        GLVertexBuffer vbo(GLVertexBuffer::Stream);
+        vbo.setData(6, 2, vertices, s_virtualScreenRotation == 90 ? rotated90 : rotated270);
+
+        ShaderBinder binder(ShaderTrait::MapTexture);
+        QMatrix4x4 mvp;
+        mvp.ortho(0, mTexture.width(), 0, mTexture.height(), 0, 65535);
+        binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+        scratch.bind();
+        vbo.render(GL_TRIANGLES);
+        scratch.unbind();
+    }
     GLRenderTarget::popRenderTarget();
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (scissor) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+    if (blend) {
+        glEnable(GL_BLEND);
+    }
 }
 
 void GLRenderTarget::attachTexture(const GLTexture& target)
@@ -2011,6 +2207,8 @@ GLvoid *GLVertexBufferPrivate::mapNextFreeRange(size_t size)
 //*********************************
 QRect GLVertexBuffer::s_virtualScreenGeometry;
 qreal GLVertexBuffer::s_virtualScreenScale;
+int GLVertexBuffer::s_virtualScreenRotation = 0;
+quint64 GLVertexBuffer::s_drawCallCount = 0;
 
 GLVertexBuffer::GLVertexBuffer(UsageHint hint)
     : d(new GLVertexBufferPrivate(hint))
@@ -2181,33 +2379,38 @@ void GLVertexBuffer::draw(const QRegion &region, GLenum primitiveMode, int first
 
         if (!hardwareClipping) {
             glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, nullptr, first);
+            s_drawCallCount++;
         } else {
             // Clip using scissoring
             for (const QRect &r : region) {
-                glScissor((r.x() - s_virtualScreenGeometry.x()) * s_virtualScreenScale,
-                (s_virtualScreenGeometry.height() + s_virtualScreenGeometry.y() - r.y() - r.height()) * s_virtualScreenScale,
-                r.width() * s_virtualScreenScale,
-                r.height() * s_virtualScreenScale);
+                const QRect scissor = scissorRect(r);
+                glScissor(scissor.x(), scissor.y(), scissor.width(), scissor.height());
                 glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, nullptr, first);
             }
+            s_drawCallCount += region.rectCount();
         }
         return;
     }
 
     if (!hardwareClipping) {
         glDrawArrays(primitiveMode, first, count);
+        s_drawCallCount++;
     } else {
         // Clip using scissoring
         for (const QRect &r : region) {
-            glScissor((r.x() - s_virtualScreenGeometry.x()) * s_virtualScreenScale,
-                      (s_virtualScreenGeometry.height()  + s_virtualScreenGeometry.y() - r.y() - r.height()) * s_virtualScreenScale,
-                      r.width() * s_virtualScreenScale,
-                      r.height() * s_virtualScreenScale);
+            const QRect scissor = scissorRect(r);
+            glScissor(scissor.x(), scissor.y(), scissor.width(), scissor.height());
             glDrawArrays(primitiveMode, first, count);
         }
+        s_drawCallCount += region.rectCount();
     }
 }
 
+QRect GLVertexBuffer::scissorRect(const QRect &rect)
+{
+    return GLRenderTarget::mapToFramebuffer(rect, s_virtualScreenGeometry, s_virtualScreenScale, s_virtualScreenRotation);
+}
+
 bool GLVertexBuffer::supportsIndexedQuads()
 {
     return GLVertexBufferPrivate::supportsIndexedQuads;
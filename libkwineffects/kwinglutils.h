@@ -30,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Qt
 #include <QSize>
 #include <QStack>
+#include <QVector>
 
 /** @addtogroup kwineffects */
 /** @{ */
@@ -91,6 +92,11 @@ public:
     bool setUniform(const char* name, float value);
     bool setUniform(const char* name, int value);
     bool setUniform(const char* name, const QVector2D& value);
+    /**
+     * Sets the uniform array @p name of type vec2 to @p values.
+     * @since 5.15.5
+     **/
+    bool setUniform(const char* name, const QVector<QVector2D> &values);
     bool setUniform(const char* name, const QVector3D& value);
     bool setUniform(const char* name, const QVector4D& value);
     bool setUniform(const char* name, const QMatrix4x4& value);
@@ -99,6 +105,7 @@ public:
     bool setUniform(int location, float value);
     bool setUniform(int location, int value);
     bool setUniform(int location, const QVector2D &value);
+    bool setUniform(int location, const QVector<QVector2D> &values);
     bool setUniform(int location, const QVector3D &value);
     bool setUniform(int location, const QVector4D &value);
     bool setUniform(int location, const QMatrix4x4 &value);
@@ -301,6 +308,26 @@ public:
      **/
     GLShader *generateShaderFromResources(ShaderTraits traits, const QString &vertexFile = QString(), const QString &fragmentFile = QString());
 
+    /**
+     * Creates a shader with the given @p traits whose vertex shader displaces every vertex
+     * through the GLSL function @p deformation before projecting it.
+     *
+     * The @p deformation source has to define the function
+     * @code
+     * vec2 deform(vec2 position);
+     * @endcode
+     * which gets the window local position of the vertex and returns the deformed position.
+     * It may declare additional uniforms which the effect sets before painting. Together with
+     * WindowQuadGridCache this allows effects to deform windows without touching the vertices
+     * on the CPU.
+     *
+     * @param traits The shader traits for generating the shader
+     * @param deformation GLSL source defining the deform function
+     * @return new generated shader
+     * @since 5.15.5
+     **/
+    GLShader *generateDeformationShader(ShaderTraits traits, const QByteArray &deformation);
+
     /**
      * Compiles and tests the dynamically generated shaders.
      * Returns true if successful and false otherwise.
@@ -324,7 +351,7 @@ private:
     void bindFragDataLocations(GLShader *shader);
     void bindAttributeLocations(GLShader *shader) const;
 
-    QByteArray generateVertexSource(ShaderTraits traits) const;
+    QByteArray generateVertexSource(ShaderTraits traits, const QByteArray &deformation = QByteArray()) const;
     QByteArray generateFragmentSource(ShaderTraits traits) const;
     GLShader *generateShader(ShaderTraits traits);
 
@@ -548,6 +575,38 @@ public:
         return s_virtualScreenScale;
     }
 
+    /**
+     * The counter-clockwise rotation in degrees with which the OpenGL window
+     * currently being rendered to is presented, if it is rotated by the projection
+     * matrix instead of the display hardware. blitFromFramebuffer takes it into
+     * account, so the blitted content is always upright.
+     * @see GLVertexBuffer::setVirtualScreenRotation
+     * @since 5.15.5
+     */
+    static void setVirtualScreenRotation(int rotation) {
+        s_virtualScreenRotation = rotation;
+    }
+
+    static int virtualScreenRotation() {
+        return s_virtualScreenRotation;
+    }
+
+    /**
+     * Maps @p rect in the virtual geometry space into the framebuffer of the screen with
+     * @p geometry, in OpenGL window coordinates. The framebuffer shows the screen rotated
+     * counter-clockwise by @p rotation degrees.
+     * @since 5.15.5
+     **/
+    static QRect mapToFramebuffer(const QRect &rect, const QRect &geometry, qreal scale, int rotation);
+    /**
+     * Maps @p rect in the virtual geometry space into the framebuffer currently being
+     * rendered to, taking the virtual screen geometry, scale and rotation into account.
+     * @since 5.15.5
+     **/
+    static QRect mapToFramebuffer(const QRect &rect) {
+        return mapToFramebuffer(rect, s_virtualScreenGeometry, s_virtualScreenScale, s_virtualScreenRotation);
+    }
+
     /**
      * The framebuffer of KWin's OpenGL window or other object currently being rendered to
      *
@@ -565,6 +624,7 @@ protected:
 private:
     friend void KWin::cleanupGL();
     static void cleanup();
+    void blitTransposedFromFramebuffer(const QRect &source, const QRect &destination, GLenum filter);
     static bool sSupported;
     static bool s_blitSupported;
     static QStack<GLRenderTarget*> s_renderTargets;
@@ -573,6 +633,10 @@ private:
     static qreal s_virtualScreenScale;
     static GLint s_virtualScreenViewport[4];
     static GLuint s_kwinFramebuffer;
+    static int s_virtualScreenRotation;
+    // holds the unrotated framebuffer content for blitTransposedFromFramebuffer, only grows
+    static GLTexture *s_transposeScratch;
+    static GLRenderTarget *s_transposeScratchTarget;
 
     GLTexture mTexture;
     bool mValid;
@@ -824,10 +888,34 @@ public:
         s_virtualScreenScale = s;
     }
 
+    /**
+     * The counter-clockwise rotation in degrees with which the OpenGL window
+     * currently being rendered to is presented, if it is rotated by the projection
+     * matrix instead of the display hardware. Used to rotate the scissor rects
+     * for hardware clipping.
+     * @since 5.15.5
+     */
+    static void setVirtualScreenRotation(int rotation) {
+        s_virtualScreenRotation = rotation;
+    }
+
+    /**
+     * The number of draw calls issued through any vertex buffer so far. A draw clipped
+     * by scissoring counts once per clip rect. Compare two values to get the draw calls
+     * in between.
+     * @since 5.15.5
+     **/
+    static quint64 drawCallCount() {
+        return s_drawCallCount;
+    }
+
 private:
+    static QRect scissorRect(const QRect &rect);
     GLVertexBufferPrivate* const d;
     static QRect s_virtualScreenGeometry;
     static qreal s_virtualScreenScale;
+    static int s_virtualScreenRotation;
+    static quint64 s_drawCallCount;
 };
 
 } // namespace
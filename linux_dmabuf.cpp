@@ -0,0 +1,104 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "linux_dmabuf.h"
+#include "dmabufmapping.h"
+#include "wayland_server.h"
+#include "platformsupport/scenes/opengl/drm_fourcc.h"
+
+#include <unistd.h>
+
+namespace KWin
+{
+
+DmabufBuffer::DmabufBuffer(const QVector<Plane> &planes, uint32_t format, const QSize &size, Flags flags)
+    : KWayland::Server::LinuxDmabufUnstableV1Buffer(format, size)
+    , m_planes(planes)
+    , m_flags(flags)
+{
+    waylandServer()->addLinuxDmabufBuffer(this);
+}
+
+DmabufBuffer::~DmabufBuffer()
+{
+    m_mapping.reset();
+    // the buffer owns the file descriptors
+    for (const Plane &plane : m_planes) {
+        if (plane.fd != -1) {
+            ::close(plane.fd);
+        }
+    }
+    if (waylandServer()) {
+        waylandServer()->removeLinuxDmabufBuffer(this);
+    }
+}
+
+QImage DmabufBuffer::beginCpuAccess()
+{
+    if (m_planes.count() != 1 || m_planes.first().modifier != DRM_FORMAT_MOD_LINEAR) {
+        return QImage();
+    }
+    if (m_mapping.isNull()) {
+        const Plane &plane = m_planes.first();
+        m_mapping.reset(new DmabufMapping(plane.fd, plane.offset, plane.stride, format(), size()));
+    }
+    return m_mapping->beginCpuAccess();
+}
+
+void DmabufBuffer::endCpuAccess()
+{
+    if (!m_mapping.isNull()) {
+        m_mapping->endCpuAccess();
+    }
+}
+
+LinuxDmabuf::LinuxDmabuf()
+    : KWayland::Server::LinuxDmabufUnstableV1Interface::Impl()
+{
+    Q_ASSERT(waylandServer());
+    waylandServer()->linuxDmabuf()->setImpl(this);
+
+    const QSet<uint64_t> linear = { DRM_FORMAT_MOD_LINEAR };
+    setSupportedFormatsAndModifiers({
+        { DRM_FORMAT_ARGB8888, linear },
+        { DRM_FORMAT_XRGB8888, linear },
+        { DRM_FORMAT_ABGR8888, linear },
+        { DRM_FORMAT_XBGR8888, linear },
+        { DRM_FORMAT_RGB565, linear }
+    });
+}
+
+LinuxDmabuf::~LinuxDmabuf()
+{
+    if (waylandServer()) {
+        waylandServer()->linuxDmabuf()->setImpl(nullptr);
+    }
+}
+
+KWayland::Server::LinuxDmabufUnstableV1Buffer *LinuxDmabuf::importBuffer(const QVector<Plane> &planes,
+                                                                         uint32_t format,
+                                                                         const QSize &size,
+                                                                         Flags flags)
+{
+    // only what can be mapped: a single linear plane, the fds are closed by the caller on failure
+    if (planes.count() != 1) {
+        return nullptr;
+    }
+    const Plane &plane = planes.first();
+    if (plane.modifier != DRM_FORMAT_MOD_LINEAR) {
+        return nullptr;
+    }
+    if (!DmabufMapping::isValidLayout(plane.fd, plane.offset, plane.stride, format, size)) {
+        return nullptr;
+    }
+    return new DmabufBuffer(planes, format, size, flags);
+}
+
+void LinuxDmabuf::setSupportedFormatsAndModifiers(const QHash<uint32_t, QSet<uint64_t>> &set)
+{
+    waylandServer()->linuxDmabuf()->setSupportedFormatsWithModifiers(set);
+}
+
+}
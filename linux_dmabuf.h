@@ -0,0 +1,91 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_LINUX_DMABUF_H
+#define KWIN_LINUX_DMABUF_H
+
+#include <kwinglobals.h>
+
+#include <KWayland/Server/linuxdmabuf_v1_interface.h>
+
+#include <QHash>
+#include <QImage>
+#include <QScopedPointer>
+#include <QSet>
+#include <QVector>
+
+namespace KWin
+{
+
+class DmabufMapping;
+
+/**
+ * @brief A client buffer imported through zwp_linux_dmabuf_v1.
+ *
+ * The buffer owns the file descriptors of its planes. Scenes which can import it into the GPU
+ * subclass it, everything else reads it through a CPU mapping of the first plane.
+ **/
+class KWIN_EXPORT DmabufBuffer : public KWayland::Server::LinuxDmabufUnstableV1Buffer
+{
+public:
+    using Plane = KWayland::Server::LinuxDmabufUnstableV1Interface::Plane;
+    using Flags = KWayland::Server::LinuxDmabufUnstableV1Interface::Flags;
+
+    DmabufBuffer(const QVector<Plane> &planes, uint32_t format, const QSize &size, Flags flags);
+    ~DmabufBuffer() override;
+
+    const QVector<Plane> &planes() const {
+        return m_planes;
+    }
+    Flags flags() const {
+        return m_flags;
+    }
+
+    /**
+     * Maps the buffer for reading, only possible for single plane linear buffers in one of the
+     * formats supported by DmabufMapping. The image is valid until endCpuAccess.
+     **/
+    QImage beginCpuAccess();
+    void endCpuAccess();
+
+private:
+    QVector<Plane> m_planes;
+    Flags m_flags;
+    QScopedPointer<DmabufMapping> m_mapping;
+};
+
+/**
+ * @brief Implementation of the zwp_linux_dmabuf_v1 buffer import.
+ *
+ * The base implementation accepts single plane linear buffers which can be read through a CPU
+ * mapping, which is all the QPainter scene can use. Only real dmabufs and files sealed against
+ * shrinking get mapped. Scenes which can import dmabufs into the GPU
+ * override importBuffer and advertise the formats and modifiers the driver supports.
+ **/
+class KWIN_EXPORT LinuxDmabuf : public KWayland::Server::LinuxDmabufUnstableV1Interface::Impl
+{
+public:
+    using Plane = KWayland::Server::LinuxDmabufUnstableV1Interface::Plane;
+    using Flags = KWayland::Server::LinuxDmabufUnstableV1Interface::Flags;
+
+    explicit LinuxDmabuf();
+    ~LinuxDmabuf() override;
+
+    /**
+     * On success the returned buffer owns the file descriptors of @p planes, on failure they
+     * stay with the caller.
+     **/
+    KWayland::Server::LinuxDmabufUnstableV1Buffer *importBuffer(const QVector<Plane> &planes,
+                                                                uint32_t format,
+                                                                const QSize &size,
+                                                                Flags flags) override;
+
+protected:
+    void setSupportedFormatsAndModifiers(const QHash<uint32_t, QSet<uint64_t>> &set);
+};
+
+}
+
+#endif
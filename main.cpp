@@ -11,6 +11,7 @@
 #include "platform.h"
 #include "atoms.h"
 #include "composite.h"
+#include "configcommitter.h"
 #include "cursor.h"
 #include "input.h"
 #include "logind.h"
@@ -20,6 +21,7 @@
 #include "sm.h"
 #include "workspace.h"
 #include "xcbutils.h"
+#include "decorations/decorationbridge.h"
 #include "libinput/connection.h"
 
 #include <kwineffects.h>
@@ -99,6 +101,7 @@ Application::Application(Application::OperationMode mode, int &argc, char **argv
     qRegisterMetaType<KWin::EffectWindow*>();
     qRegisterMetaType<KWayland::Server::SurfaceInterface *>("KWayland::Server::SurfaceInterface *");
     qRegisterMetaType<KSharedConfigPtr>();
+    m_startupTimer.start();
 }
 
 void Application::setConfigLock(bool lock)
@@ -139,12 +142,14 @@ void Application::start()
     if (!m_inputConfig) {
         m_inputConfig = KSharedConfig::openConfig(QStringLiteral("kcminputrc"), KConfig::NoGlobals);
     }
+    ConfigCommitter::create(this);
 
     performStartup();
 }
 
 Application::~Application()
 {
+    delete ConfigCommitter::self();
     delete options;
     destroyAtoms();
 }
@@ -255,6 +260,18 @@ void Application::notifyKSplash()
     QDBusConnection::sessionBus().asyncCall(ksplashProgressMessage);
 }
 
+void Application::markStartupStep(const QByteArray &step)
+{
+    for (const auto &done : qAsConst(m_startupSteps)) {
+        if (done.first == step) {
+            return;
+        }
+    }
+    const qint64 elapsed = m_startupTimer.elapsed();
+    m_startupSteps << qMakePair(step, elapsed);
+    qCDebug(KWIN_CORE) << "Startup step" << step << "done after" << elapsed << "ms";
+}
+
 void Application::createWorkspace()
 {
     // we want all QQuickWindows with an alpha buffer, do here as Workspace might create QQuickWindows
@@ -266,6 +283,7 @@ void Application::createWorkspace()
 
     // create workspace.
     (void) new Workspace(m_originalSessionKey);
+    markStartupStep(QByteArrayLiteral("workspace"));
     qDebug()<<"emit workspaceCreated";
     emit workspaceCreated();
 }
@@ -277,6 +295,12 @@ void Application::createInput()
     auto input = InputRedirection::create(this);
     input->init();
     m_platform->createPlatformCursor(this);
+    markStartupStep(QByteArrayLiteral("input"));
+}
+
+void Application::prepareWorkspace()
+{
+    Decoration::DecorationBridge::prefetchPlugins();
 }
 
 void Application::createScreens()
@@ -286,6 +310,7 @@ void Application::createScreens()
     }
     qDebug()<<"Screens::create emit screensCreated";
     Screens::create(this);
+    markStartupStep(QByteArrayLiteral("screens"));
     emit screensCreated();
 }
 
@@ -301,7 +326,12 @@ void Application::createOptions()
 
 void Application::createCompositor()
 {
-    Compositor::create(this);
+    Compositor *compositor = Compositor::create(this);
+    connect(compositor, &Compositor::sceneCreated, this,
+        [this] {
+            markStartupStep(QByteArrayLiteral("scene"));
+        }
+    );
 }
 
 void Application::setupEventFilters()
@@ -17,7 +17,9 @@
 // Qt
 #include <QApplication>
 #include <QAbstractNativeEventFilter>
+#include <QElapsedTimer>
 #include <QProcessEnvironment>
+#include <QVector>
 
 class KPluginMetaData;
 class QCommandLineParser;
@@ -187,6 +189,19 @@ public:
     static void setUseXRecord(bool use);
     static bool useXRecord();
 
+    /**
+     * Records that the startup step @p step is done, only the first time a step gets marked
+     * counts. The time since the application got created is logged to the kwin_core category.
+     **/
+    void markStartupStep(const QByteArray &step);
+    /**
+     * @returns the startup steps done so far with the milliseconds passed since the application
+     * got created, in the order they got done.
+     **/
+    QVector<QPair<QByteArray, qint64>> startupSteps() const {
+        return m_startupSteps;
+    }
+
 Q_SIGNALS:
     void x11ConnectionChanged();
     void x11ConnectionAboutToBeDestroyed();
@@ -200,6 +215,12 @@ protected:
 
     void notifyKSplash();
     void createInput();
+    /**
+     * Starts work the workspace needs in threads, so it overlaps with bringing up the platform
+     * and the scene: looking up the decoration plugins. The keymap already compiles in a
+     * thread since createInput.
+     **/
+    void prepareWorkspace();
     void createWorkspace();
     void createAtoms();
     void createOptions();
@@ -216,11 +237,14 @@ protected:
     }
     /**
      * Inheriting classes should use this method to set the xcb connection
-     * before accessing any X11 specific code pathes.
+     * before accessing any X11 specific code pathes. Without @p notify the caller
+     * emits x11ConnectionChanged itself once the atoms exist.
      **/
-    void setX11Connection(xcb_connection_t *c) {
+    void setX11Connection(xcb_connection_t *c, bool notify = true) {
         m_connection = c;
-        emit x11ConnectionChanged();
+        if (notify) {
+            emit x11ConnectionChanged();
+        }
     }
     void destroyAtoms();
 
@@ -250,6 +274,8 @@ private:
 #endif
     Platform *m_platform = nullptr;
     bool m_terminating = false;
+    QElapsedTimer m_startupTimer;
+    QVector<QPair<QByteArray, qint64>> m_startupSteps;
 };
 
 inline static Application *kwinApp()
@@ -167,6 +167,7 @@ void ApplicationWayland::performStartup()
     createInput();
     // now libinput thread has been created, adjust scheduler to not leak into other processes
     gainRealTime(RealTimeFlags::ResetOnFork);
+    prepareWorkspace();
 
     VirtualKeyboard::create(this);
     createBackend();
@@ -198,13 +199,8 @@ void ApplicationWayland::continueStartupWithScreens()
     disconnect(kwinApp()->platform(), &Platform::startWithoutScreen, this, &ApplicationWayland::continueStartupWithoutScreens);
     createScreens();
 
-    if (operationMode() == OperationModeWaylandOnly) {
-        createCompositor();
-        connect(Compositor::self(), &Compositor::sceneCreated, this, &ApplicationWayland::continueStartupWithScene);
-        return;
-    }
     createCompositor();
-    connect(Compositor::self(), &Compositor::sceneCreated, this, &ApplicationWayland::continueStartupWithXwayland);
+    connect(Compositor::self(), &Compositor::sceneCreated, this, &ApplicationWayland::continueStartupWithScene);
 }
 
 void ApplicationWayland::continueStartupWithoutScreens()
@@ -232,15 +228,16 @@ void ApplicationWayland::continueStartupWithScene()
 {
     qDebug() << QDateTime::currentDateTime().toString("yyyy-mm-dd hh:mm:ss") << Q_FUNC_INFO << " ut-gfx-start";
     disconnect(Compositor::self(), &Compositor::sceneCreated, this, &ApplicationWayland::continueStartupWithScene);
-    startSession();
-    createWorkspace();
-    notifyKSplash();
-}
-
-void ApplicationWayland::continueStartupWithXwayland()
-{
-    disconnect(Compositor::self(), &Compositor::sceneCreated, this, &ApplicationWayland::continueStartupWithXwayland);
+    if (operationMode() == OperationModeWaylandOnly) {
+        startSession();
+        createWorkspace();
+        notifyKSplash();
+        return;
+    }
 
+    // Xwayland needs the scene for its buffers, from there on it comes up in its own process
+    // while the workspace gets created. The X11 part of the workspace and the session, which
+    // needs DISPLAY, follow once Xwayland is ready.
     m_xwayland = new Xwl::Xwayland(this);
     connect(m_xwayland, &Xwl::Xwayland::criticalError, this, [](int code) {
         // we currently exit on Xwayland errors always directly
@@ -248,7 +245,22 @@ void ApplicationWayland::continueStartupWithXwayland()
         std::cerr << "Xwayland had a critical error. Going to exit now." << std::endl;
         exit(code);
     });
+    if (m_lazyXwayland && m_xwayland->listen()) {
+        // DISPLAY is known already, Xwayland only starts for the first X11 client
+        createWorkspace();
+        finishStartup();
+        return;
+    }
+    connect(m_xwayland, &Xwl::Xwayland::started, this, &ApplicationWayland::finishStartup);
     m_xwayland->init();
+    createWorkspace();
+}
+
+void ApplicationWayland::finishStartup()
+{
+    disconnect(m_xwayland, &Xwl::Xwayland::started, this, &ApplicationWayland::finishStartup);
+    startSession();
+    notifyKSplash();
 }
 
 void ApplicationWayland::startSession()
@@ -305,6 +317,7 @@ void ApplicationWayland::startSession()
             p->start(application);
         }
     }
+    markStartupStep(QByteArrayLiteral("session"));
 }
 
 static const QString s_waylandPlugin = QStringLiteral("KWinWaylandWaylandBackend");
@@ -533,6 +546,8 @@ int main(int argc, char * argv[])
 
     QCommandLineOption xwaylandOption(QStringLiteral("xwayland"),
                                       i18n("Start a rootless Xwayland server."));
+    QCommandLineOption lazyXwaylandOption(QStringLiteral("lazy-xwayland"),
+                                          i18n("Start the rootless Xwayland server only when the first X11 client connects."));
     QCommandLineOption waylandSocketOption(QStringList{QStringLiteral("s"), QStringLiteral("socket")},
                                            i18n("Name of the Wayland socket to listen on. If not set \"wayland-0\" is used."),
                                            QStringLiteral("socket"));
@@ -576,6 +591,7 @@ int main(int argc, char * argv[])
     QCommandLineParser parser;
     a.setupCommandLine(&parser);
     parser.addOption(xwaylandOption);
+    parser.addOption(lazyXwaylandOption);
     parser.addOption(withoutscreenOption);
     parser.addOption(disableMultiScreens);
     parser.addOption(waylandSocketOption);
@@ -778,7 +794,8 @@ int main(int argc, char * argv[])
     QObject::connect(&a, &KWin::Application::workspaceCreated, server, &KWin::WaylandServer::initWorkspace);
     environment.insert(QStringLiteral("WAYLAND_DISPLAY"), server->display()->socketName());
     a.setProcessStartupEnvironment(environment);
-    a.setStartXwayland(parser.isSet(xwaylandOption));
+    a.setStartXwayland(parser.isSet(xwaylandOption) || parser.isSet(lazyXwaylandOption));
+    a.setLazyXwayland(parser.isSet(lazyXwaylandOption));
     a.setWithoutScreen(parser.isSet(withoutscreenOption));
     a.setDisableMultiScreens(parser.isSet(disableMultiScreens));
     a.setApplicationsToStart(parser.positionalArguments());
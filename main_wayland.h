@@ -29,6 +29,12 @@ public:
     void setStartXwayland(bool start) {
         m_startXWayland = start;
     }
+    /**
+     * Only start Xwayland once the first X11 client connects to its display.
+     **/
+    void setLazyXwayland(bool lazy) {
+        m_lazyXwayland = lazy;
+    }
     void setApplicationsToStart(const QStringList &applications) {
         m_applicationsToStart = applications;
     }
@@ -62,10 +68,11 @@ private:
     void continueStartupWithScreens();
     void continueStartupWithoutScreens();
     void continueStartupWithScene();
-    void continueStartupWithXwayland();
+    void finishStartup();
     void startSession() override;
 
     bool m_startXWayland = false;
+    bool m_lazyXwayland = false;
     QStringList m_applicationsToStart;
     QString m_inputMethodServerToStart;
     QProcessEnvironment m_environment;
@@ -67,6 +67,7 @@ bool Client::manage(xcb_window_t w, bool isMapped)
         NET::WM2BlockCompositing |
         NET::WM2WindowClass |
         NET::WM2WindowRole |
+        NET::WM2ClientMachine |
         NET::WM2UserTime |
         NET::WM2StartupId |
         NET::WM2ExtendedStrut |
@@ -92,9 +93,18 @@ bool Client::manage(xcb_window_t w, bool isMapped)
     auto activitiesCookie = fetchActivities();
     auto applicationMenuServiceNameCookie = fetchApplicationMenuServiceName();
     auto applicationMenuObjectPathCookie = fetchApplicationMenuObjectPath();
+    auto syncCounterCookie = fetchSyncCounter();
+    auto wmNameCookie = fetchWmName();
+    auto wmIconNameCookie = fetchWmIconName();
+    // select the input before querying the shape, so that no change gets lost in between
+    if (Xcb::Extensions::self()->isShapeAvailable())
+        xcb_shape_select_input(connection(), window(), true);
+    auto shapeCookie = Xcb::Extensions::self()->fetchShape(window());
 
     m_geometryHints.init(window());
     m_motif.init(window());
+    // waiting for the NET properties flushes all requests above, from here on their replies
+    // are read without further round trips to the X server
     info = new WinInfo(this, m_client, rootWindow(), properties, properties2);
 
     if (isDesktop() && bit_depth == 32) {
@@ -110,22 +120,20 @@ bool Client::manage(xcb_window_t w, bool isMapped)
     getResourceClass();
     readWmClientLeader(wmClientLeaderCookie);
     getWmClientMachine();
-    getSyncCounter();
+    readSyncCounter(syncCounterCookie);
     // First only read the caption text, so that setupWindowRules() can use it for matching,
     // and only then really set the caption using setCaption(), which checks for duplicates etc.
     // and also relies on rules already existing
-    cap_normal = readName();
+    cap_normal = readName(wmNameCookie);
     setupWindowRules(false);
     setCaption(cap_normal, true);
 
     connect(this, &Client::windowClassChanged, this, &Client::evaluateWindowRules);
 
-    if (Xcb::Extensions::self()->isShapeAvailable())
-        xcb_shape_select_input(connection(), window(), true);
-    detectShape(window());
+    detectShape(shapeCookie);
     readGtkFrameExtents(gtkFrameExtentsCookie);
     detectNoBorder();
-    fetchIconicName();
+    readIconicName(wmIconNameCookie);
 
     // Needs to be done before readTransient() because of reading the group
     checkGroup();
@@ -20,6 +20,7 @@
 #include "options.h"
 #include "rules.h"
 #include "screens.h"
+#include "smartplacement.h"
 #endif
 #include "report.h"
 
@@ -192,146 +193,30 @@ void Placement::placeSmart(AbstractClient* c, const QRect& area, Policy /*next*/
      * with ideas from xfce.
      */
 
-    const int none = 0, h_wrong = -1, w_wrong = -2; // overlap types
-    long int overlap, min_overlap = 0;
-    int x_optimal, y_optimal;
-    int possible;
     int desktop = c->desktop() == 0 || c->isOnAllDesktops() ? VirtualDesktopManager::self()->current() : c->desktop();
 
-    int cxl, cxr, cyt, cyb;     //temp coords
-    int  xl, xr, yt, yb;     //temp coords
-    int basket;                 //temp holder
+    // collect the windows to avoid once, the placement searches them for every candidate position
+    QVector<SmartPlacement::Window> windows;
+    for (Toplevel *toplevel : workspace()->stackingOrder()) {
+        AbstractClient *client = qobject_cast<AbstractClient*>(toplevel);
+        if (isIrrelevant(client, c, desktop)) {
+            continue;
+        }
+        int weight = 1;
+        if (client->keepAbove())
+            weight = 16;
+        else if (client->keepBelow() && !client->isDock()) // ignore KeepBelow windows
+            weight = 0; // for placement (see Client::belongsToLayer() for Dock)
+        windows << SmartPlacement::Window{client->x(), client->y(),
+                                          client->x() + client->width(), client->y() + client->height(),
+                                          weight};
+    }
 
     // get the maximum allowed windows space
     const QRect maxRect = checkArea(c, area);
-    int x = maxRect.left(), y = maxRect.top();
-    x_optimal = x; y_optimal = y;
-
-    //client gabarit
-    int ch = c->height() - 1;
-    int cw = c->width()  - 1;
-
-    bool first_pass = true; //CT lame flag. Don't like it. What else would do?
-
-    //loop over possible positions
-    do {
-        //test if enough room in x and y directions
-        if (y + ch > maxRect.bottom() && ch < maxRect.height())
-            overlap = h_wrong; // this throws the algorithm to an exit
-        else if (x + cw > maxRect.right())
-            overlap = w_wrong;
-        else {
-            overlap = none; //initialize
-
-            cxl = x; cxr = x + cw;
-            cyt = y; cyb = y + ch;
-            ToplevelList::ConstIterator l;
-            for (l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd() ; ++l) {
-                AbstractClient *client = qobject_cast<AbstractClient*>(*l);
-                if (isIrrelevant(client, c, desktop)) {
-                    continue;
-                }
-                xl = client->x();          yt = client->y();
-                xr = xl + client->width(); yb = yt + client->height();
-
-                //if windows overlap, calc the overall overlapping
-                if ((cxl < xr) && (cxr > xl) &&
-                        (cyt < yb) && (cyb > yt)) {
-                    xl = qMax(cxl, xl); xr = qMin(cxr, xr);
-                    yt = qMax(cyt, yt); yb = qMin(cyb, yb);
-                    if (client->keepAbove())
-                        overlap += 16 * (xr - xl) * (yb - yt);
-                    else if (client->keepBelow() && !client->isDock()) // ignore KeepBelow windows
-                        overlap += 0; // for placement (see Client::belongsToLayer() for Dock)
-                    else
-                        overlap += (xr - xl) * (yb - yt);
-                }
-            }
-        }
-
-        //CT first time we get no overlap we stop.
-        if (overlap == none) {
-            x_optimal = x;
-            y_optimal = y;
-            break;
-        }
-
-        if (first_pass) {
-            first_pass = false;
-            min_overlap = overlap;
-        }
-        //CT save the best position and the minimum overlap up to now
-        else if (overlap >= none && overlap < min_overlap) {
-            min_overlap = overlap;
-            x_optimal = x;
-            y_optimal = y;
-        }
-
-        // really need to loop? test if there's any overlap
-        if (overlap > none) {
-
-            possible = maxRect.right();
-            if (possible - cw > x) possible -= cw;
-
-            // compare to the position of each client on the same desk
-            ToplevelList::ConstIterator l;
-            for (l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd() ; ++l) {
-                AbstractClient *client = qobject_cast<AbstractClient*>(*l);
-                if (isIrrelevant(client, c, desktop)) {
-                    continue;
-                }
-
-                xl = client->x();          yt = client->y();
-                xr = xl + client->width(); yb = yt + client->height();
-
-                // if not enough room above or under the current tested client
-                // determine the first non-overlapped x position
-                if ((y < yb) && (yt < ch + y)) {
-
-                    if ((xr > x) && (possible > xr)) possible = xr;
-
-                    basket = xl - cw;
-                    if ((basket > x) && (possible > basket)) possible = basket;
-                }
-            }
-            x = possible;
-        }
-
-        // ... else ==> not enough x dimension (overlap was wrong on horizontal)
-        else if (overlap == w_wrong) {
-            x = maxRect.left();
-            possible = maxRect.bottom();
-
-            if (possible - ch > y) possible -= ch;
-
-            //test the position of each window on the desk
-            ToplevelList::ConstIterator l;
-            for (l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd() ; ++l) {
-                AbstractClient *client = qobject_cast<AbstractClient*>(*l);
-                if (isIrrelevant(client, c, desktop)) {
-                    continue;
-                }
-
-                xl = client->x();          yt = client->y();
-                xr = xl + client->width(); yb = yt + client->height();
-
-                // if not enough room to the left or right of the current tested client
-                // determine the first non-overlapped y position
-                if ((yb > y) && (possible > yb)) possible = yb;
-
-                basket = yt - ch;
-                if ((basket > y) && (possible > basket)) possible = basket;
-            }
-            y = possible;
-        }
-    } while ((overlap != none) && (overlap != h_wrong) && (y < maxRect.bottom()));
-
-    if (ch >= maxRect.height())
-        y_optimal = maxRect.top();
 
     // place the window
-    c->move(x_optimal, y_optimal);
-
+    c->move(SmartPlacement(windows).place(maxRect, c->size()));
 }
 
 void Placement::reinitCascading(int desktop)
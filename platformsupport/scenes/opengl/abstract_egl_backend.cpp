@@ -5,6 +5,9 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "abstract_egl_backend.h"
+#if HAVE_LINUX_DMABUF
+#include "egl_dmabuf.h"
+#endif
 #include "texture.h"
 #include "composite.h"
 #include "egl_context_attribute_builder.h"
@@ -23,6 +26,7 @@
 // Qt
 #include <QOpenGLContext>
 #include <QOpenGLFramebufferObject>
+#include <QTimer>
 
 #include <memory>
 
@@ -64,6 +68,12 @@ void AbstractEglBackend::unbindWaylandDisplay()
 
 void AbstractEglBackend::cleanup()
 {
+    m_bufferTextures.clear();
+    releaseBufferTextures();
+#if HAVE_LINUX_DMABUF
+    delete m_dmaBuf;
+    m_dmaBuf = nullptr;
+#endif
     cleanupGL();
     doneCurrent();
     eglDestroyContext(m_display, m_context);
@@ -164,6 +174,9 @@ void AbstractEglBackend::initWayland()
             }
         }
     }
+#if HAVE_LINUX_DMABUF
+    m_dmaBuf = EglDmabuf::factory(this);
+#endif
 }
 
 void AbstractEglBackend::initClientExtensions()
@@ -331,21 +344,128 @@ QSharedPointer<GLTexture> AbstractEglBackend::textureForOutput(AbstractOutput *r
     return texture;
 }
 
+QSharedPointer<AbstractEglBackend::BufferTexture> AbstractEglBackend::bufferTexture(KWayland::Server::BufferInterface *buffer)
+{
+    QSharedPointer<BufferTexture> texture = m_bufferTextures.value(buffer);
+    if (texture.isNull()) {
+        texture = importBuffer(buffer);
+        if (!texture.isNull()) {
+            m_bufferTextures.insert(buffer, texture);
+        }
+    }
+    return texture;
+}
+
+QSharedPointer<AbstractEglBackend::BufferTexture> AbstractEglBackend::importBuffer(KWayland::Server::BufferInterface *buffer)
+{
+    BufferTexture imported;
+#if HAVE_LINUX_DMABUF
+    if (buffer->linuxDmabufBuffer()) {
+        auto dmabuf = dynamic_cast<EglDmabufBuffer*>(buffer->linuxDmabufBuffer());
+        // buffers the driver could not import get mapped by the window texture,
+        // the image got destroyed if the buffer was created before the scene got restarted
+        if (!dmabuf || !m_dmaBuf || !m_dmaBuf->restoreImage(dmabuf)) {
+            return QSharedPointer<BufferTexture>();
+        }
+        imported.image = dmabuf->image();
+        imported.ownsImage = false;
+        imported.yInverted = !(dmabuf->flags() & KWayland::Server::LinuxDmabufUnstableV1Interface::YInverted);
+    } else
+#endif
+    if (eglQueryWaylandBufferWL && buffer->resource()) {
+        EGLint format = 0, yInverted = EGL_TRUE;
+        if (!eglQueryWaylandBufferWL(m_display, buffer->resource(), EGL_TEXTURE_FORMAT, &format)) {
+            // not a wl_drm buffer
+            return QSharedPointer<BufferTexture>();
+        }
+        if (format != EGL_TEXTURE_RGB && format != EGL_TEXTURE_RGBA) {
+            qCDebug(KWIN_OPENGL) << "Unsupported texture format: " << format;
+            return QSharedPointer<BufferTexture>();
+        }
+        if (!eglQueryWaylandBufferWL(m_display, buffer->resource(), EGL_WAYLAND_Y_INVERTED_WL, &yInverted)) {
+            // if EGL_WAYLAND_Y_INVERTED_WL is not supported wl_buffer should be treated as if value were EGL_TRUE
+            yInverted = EGL_TRUE;
+        }
+        const EGLint attribs[] = {
+            EGL_WAYLAND_PLANE_WL, 0,
+            EGL_NONE
+        };
+        imported.image = eglCreateImageKHR(m_display, EGL_NO_CONTEXT, EGL_WAYLAND_BUFFER_WL,
+                                           (EGLClientBuffer)buffer->resource(), attribs);
+        imported.yInverted = yInverted;
+    }
+    if (imported.image == EGL_NO_IMAGE_KHR) {
+        return QSharedPointer<BufferTexture>();
+    }
+    imported.size = buffer->size();
+
+    glGenTextures(1, &imported.texture);
+    glBindTexture(GL_TEXTURE_2D, imported.texture);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)imported.image);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // the texture is shared by the window textures and released once the last one let go of it
+    QPointer<AbstractEglBackend> backend(this);
+    return QSharedPointer<BufferTexture>(new BufferTexture(imported),
+        [backend] (BufferTexture *texture) {
+            if (backend) {
+                backend->m_releasedBufferTextures << *texture;
+                backend->scheduleReleaseBufferTextures();
+            }
+            delete texture;
+        }
+    );
+}
+
+void AbstractEglBackend::scheduleReleaseBufferTextures()
+{
+    // buffers get destroyed outside of painting and without a current context,
+    // all textures released until the event loop returns are deleted in one go
+    if (m_releasedBufferTextures.count() != 1) {
+        return;
+    }
+    QTimer::singleShot(0, this, [this] {
+        if (m_releasedBufferTextures.isEmpty() || !makeCurrent()) {
+            return;
+        }
+        releaseBufferTextures();
+    });
+}
+
+void AbstractEglBackend::releaseBufferTextures()
+{
+    for (const BufferTexture &texture : qAsConst(m_releasedBufferTextures)) {
+        glDeleteTextures(1, &texture.texture);
+        if (texture.ownsImage) {
+            eglDestroyImageKHR(m_display, texture.image);
+        }
+    }
+    m_releasedBufferTextures.clear();
+}
 
 AbstractEglTexture::AbstractEglTexture(SceneOpenGLTexture *texture, AbstractEglBackend *backend)
     : SceneOpenGLTexturePrivate()
     , q(texture)
     , m_backend(backend)
-    , m_image(EGL_NO_IMAGE_KHR)
 {
     m_target = GL_TEXTURE_2D;
 }
 
 AbstractEglTexture::~AbstractEglTexture()
 {
-    if (m_image != EGL_NO_IMAGE_KHR) {
-        eglDestroyImageKHR(m_backend->eglDisplay(), m_image);
-    }
+    dropBufferTexture();
+}
+
+void AbstractEglTexture::onDamage()
+{
+    // the texture object is shared by all windows showing the buffer, take its filter
+    // and wrap mode back if another window texture set its own on it since
+    if (m_bufferTexture && m_bufferTexture->parametersOwner != this) {
+        m_bufferTexture->parametersOwner = this;
+        m_filterChanged = true;
+        m_wrapModeChanged = true;
+    }
+    SceneOpenGLTexturePrivate::onDamage();
 }
 
 OpenGLBackend *AbstractEglTexture::backend()
@@ -366,8 +486,13 @@ bool AbstractEglTexture::loadTexture(WindowPixmap *pixmap)
     if (auto s = pixmap->surface()) {
         s->resetTrackedDamage();
     }
+#if HAVE_LINUX_DMABUF
+    if (buffer->linuxDmabufBuffer()) {
+        return loadDmabufTexture(buffer);
+    }
+#endif
     if (buffer->shmBuffer()) {
-        return loadShmTexture(buffer);
+        return loadShmTexture(buffer->data());
     } else {
         return loadEglTexture(buffer);
     }
@@ -387,24 +512,30 @@ void AbstractEglTexture::updateTexture(WindowPixmap *pixmap)
         return;
     }
     auto s = pixmap->surface();
+#if HAVE_LINUX_DMABUF
+    if (buffer->linuxDmabufBuffer()) {
+        updateDmabufTexture(buffer, s);
+        return;
+    }
+#endif
     if (!buffer->shmBuffer()) {
-        q->bind();
-        EGLImageKHR image = attach(buffer);
-        q->unbind();
-        if (image != EGL_NO_IMAGE_KHR) {
-            eglDestroyImageKHR(m_backend->eglDisplay(), m_image);
-            m_image = image;
-        }
+        // a buffer the client used before is just a swap of the texture
+        attachBufferTexture(buffer);
         if (s) {
             s->resetTrackedDamage();
         }
         return;
     }
     // shm fallback
-    const QImage &image = buffer->data();
+    updateShmTexture(buffer->data(), s);
+}
+
+void AbstractEglTexture::updateShmTexture(const QImage &image, KWayland::Server::SurfaceInterface *s)
+{
     if (image.isNull() || !s) {
         return;
     }
+    detachBufferTexture();
 
     q->bind();
     if (image.size() == m_size) {
@@ -475,9 +606,8 @@ void AbstractEglTexture::updateTexture(WindowPixmap *pixmap)
     q->unbind();
 }
 
-bool AbstractEglTexture::loadShmTexture(const QPointer< KWayland::Server::BufferInterface > &buffer)
+bool AbstractEglTexture::loadShmTexture(const QImage &image)
 {
-    const QImage &image = buffer->data();
     if (image.isNull()) {
         return false;
     }
@@ -532,48 +662,111 @@ bool AbstractEglTexture::loadEglTexture(const QPointer< KWayland::Server::Buffer
         return false;
     }
 
-    glGenTextures(1, &m_texture);
     q->setWrapMode(GL_CLAMP_TO_EDGE);
     q->setFilter(GL_LINEAR);
-    q->bind();
-    m_image = attach(buffer);
-    q->unbind();
-
-    if (EGL_NO_IMAGE_KHR == m_image) {
+    if (!attachBufferTexture(buffer)) {
         qCDebug(KWIN_OPENGL) << "failed to create egl image";
-        q->discard();
         return false;
     }
-
     return true;
 }
 
-EGLImageKHR AbstractEglTexture::attach(const QPointer< KWayland::Server::BufferInterface > &buffer)
+#if HAVE_LINUX_DMABUF
+static DmabufBuffer *dmabufBuffer(const QPointer<KWayland::Server::BufferInterface> &buffer)
 {
-    EGLint format, yInverted;
-    eglQueryWaylandBufferWL(m_backend->eglDisplay(), buffer->resource(), EGL_TEXTURE_FORMAT, &format);
-    if (format != EGL_TEXTURE_RGB && format != EGL_TEXTURE_RGBA) {
-        qCDebug(KWIN_OPENGL) << "Unsupported texture format: " << format;
-        return EGL_NO_IMAGE_KHR;
+    // all buffers of the linux-dmabuf global are created by LinuxDmabuf
+    return static_cast<DmabufBuffer*>(buffer->linuxDmabufBuffer());
+}
+
+// maps a buffer the driver could not import, needs to be followed by endCpuAccess
+static QImage mapDmabuf(DmabufBuffer *buffer)
+{
+    QImage image = buffer->beginCpuAccess();
+    if (image.format() != QImage::Format_ARGB32_Premultiplied && image.format() != QImage::Format_RGB32) {
+        image = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
     }
-    if (!eglQueryWaylandBufferWL(m_backend->eglDisplay(), buffer->resource(), EGL_WAYLAND_Y_INVERTED_WL, &yInverted)) {
-        // if EGL_WAYLAND_Y_INVERTED_WL is not supported wl_buffer should be treated as if value were EGL_TRUE
-        yInverted = EGL_TRUE;
+    if (buffer->flags() & KWayland::Server::LinuxDmabufUnstableV1Interface::YInverted) {
+        image = image.mirrored();
     }
+    return image;
+}
 
-    const EGLint attribs[] = {
-        EGL_WAYLAND_PLANE_WL, 0,
-        EGL_NONE
-    };
-    EGLImageKHR image = eglCreateImageKHR(m_backend->eglDisplay(), EGL_NO_CONTEXT, EGL_WAYLAND_BUFFER_WL,
-                                      (EGLClientBuffer)buffer->resource(), attribs);
-    if (image != EGL_NO_IMAGE_KHR) {
-        glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)image);
-        m_size = buffer->size();
-        updateMatrix();
-        q->setYInverted(yInverted);
+bool AbstractEglTexture::loadDmabufTexture(const QPointer< KWayland::Server::BufferInterface > &buffer)
+{
+    q->setWrapMode(GL_CLAMP_TO_EDGE);
+    q->setFilter(GL_LINEAR);
+    if (attachBufferTexture(buffer)) {
+        return true;
     }
-    return image;
+    DmabufBuffer *dmabuf = dmabufBuffer(buffer);
+    const bool loaded = loadShmTexture(mapDmabuf(dmabuf));
+    dmabuf->endCpuAccess();
+    return loaded;
+}
+
+void AbstractEglTexture::updateDmabufTexture(const QPointer< KWayland::Server::BufferInterface > &buffer, KWayland::Server::SurfaceInterface *s)
+{
+    if (!attachBufferTexture(buffer)) {
+        DmabufBuffer *dmabuf = dmabufBuffer(buffer);
+        updateShmTexture(mapDmabuf(dmabuf), s);
+        dmabuf->endCpuAccess();
+        return;
+    }
+    if (s) {
+        s->resetTrackedDamage();
+    }
+}
+#endif
+
+bool AbstractEglTexture::attachBufferTexture(const QPointer< KWayland::Server::BufferInterface > &buffer)
+{
+    const auto bufferTexture = m_backend->bufferTexture(buffer.data());
+    if (bufferTexture.isNull()) {
+        return false;
+    }
+    if (bufferTexture == m_bufferTexture) {
+        return true;
+    }
+    if (m_bufferTexture.isNull() && m_texture != 0 && !m_foreign) {
+        // the content got uploaded from a shm buffer before
+        glDeleteTextures(1, &m_texture);
+    }
+    dropBufferTexture();
+    m_bufferTexture = bufferTexture;
+    m_texture = bufferTexture->texture;
+    // the texture belongs to the backend
+    m_foreign = true;
+    // filter and wrap mode are state of the texture object
+    m_filterChanged = true;
+    m_wrapModeChanged = true;
+    m_size = bufferTexture->size;
+    updateMatrix();
+    q->setYInverted(bufferTexture->yInverted);
+    // binding goes through onDamage, which restores the parameters of this window texture
+    q->setDirty();
+    return true;
+}
+
+void AbstractEglTexture::dropBufferTexture()
+{
+    if (m_bufferTexture && m_bufferTexture->parametersOwner == this) {
+        m_bufferTexture->parametersOwner = nullptr;
+    }
+    m_bufferTexture.reset();
+}
+
+void AbstractEglTexture::detachBufferTexture()
+{
+    if (m_bufferTexture.isNull()) {
+        return;
+    }
+    dropBufferTexture();
+    glGenTextures(1, &m_texture);
+    m_foreign = false;
+    m_filterChanged = true;
+    m_wrapModeChanged = true;
+    // the next upload has to specify the whole texture
+    m_size = QSize();
 }
 
 bool AbstractEglTexture::updateFromFBO(const QSharedPointer<QOpenGLFramebufferObject> &fbo)
@@ -581,6 +774,7 @@ bool AbstractEglTexture::updateFromFBO(const QSharedPointer<QOpenGLFramebufferOb
     if (fbo.isNull()) {
         return false;
     }
+    dropBufferTexture();
     m_foreign = true;
     m_texture = fbo->texture();
     m_size = fbo->size();
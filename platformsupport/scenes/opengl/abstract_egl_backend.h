@@ -7,9 +7,13 @@
 #ifndef KWIN_ABSTRACT_EGL_BACKEND_H
 #define KWIN_ABSTRACT_EGL_BACKEND_H
 #include "backend.h"
+#include "client_buffer_cache.h"
 #include "texture.h"
 
+#include <config-kwin.h>
+
 #include <QObject>
+#include <QVector>
 #include <epoxy/egl.h>
 #include <fixx11h.h>
 
@@ -20,12 +24,15 @@ namespace KWayland
 namespace Server
 {
 class BufferInterface;
+class SurfaceInterface;
 }
 }
 
 namespace KWin
 {
+class AbstractEglTexture;
 class AbstractOutput;
+class EglDmabuf;
 
 class KWIN_EXPORT AbstractEglBackend : public QObject, public OpenGLBackend
 {
@@ -49,6 +56,34 @@ public:
     }
     QSharedPointer<GLTexture> textureForOutput(AbstractOutput *output) const override;
 
+    /**
+     * A texture bound to the EGLImage of a hardware client buffer.
+     **/
+    struct BufferTexture {
+        GLuint texture = 0;
+        EGLImageKHR image = EGL_NO_IMAGE_KHR;
+        // the image of a dmabuf belongs to the EglDmabufBuffer
+        bool ownsImage = true;
+        QSize size;
+        bool yInverted = true;
+        // the window texture whose filter and wrap mode the texture object has
+        AbstractEglTexture *parametersOwner = nullptr;
+    };
+    /**
+     * @returns the texture of the wl_drm or dmabuf @p buffer. The buffer is imported on first
+     * use and kept until it gets destroyed, so clients cycling through their buffers cause no
+     * further imports. Null if the buffer cannot be imported.
+     *
+     * Must be called with the context current.
+     **/
+    QSharedPointer<BufferTexture> bufferTexture(KWayland::Server::BufferInterface *buffer);
+    /**
+     * @returns how often a client buffer got imported, meant for tests.
+     **/
+    quint64 bufferImportCount() const {
+        return m_bufferTextures.insertCount();
+    }
+
 protected:
     AbstractEglBackend();
     void setEglDisplay(const EGLDisplay &display);
@@ -68,12 +103,19 @@ protected:
 
 private:
     void unbindWaylandDisplay();
+    QSharedPointer<BufferTexture> importBuffer(KWayland::Server::BufferInterface *buffer);
+    void scheduleReleaseBufferTextures();
+    void releaseBufferTextures();
 
     EGLDisplay m_display = EGL_NO_DISPLAY;
     EGLSurface m_surface = EGL_NO_SURFACE;
     EGLContext m_context = EGL_NO_CONTEXT;
     EGLConfig m_config = nullptr;
     QList<QByteArray> m_clientExtensions;
+    EglDmabuf *m_dmaBuf = nullptr;
+    // textures of destroyed buffers, released once the context is current
+    QVector<BufferTexture> m_releasedBufferTextures;
+    ClientBufferCache<QSharedPointer<BufferTexture>> m_bufferTextures;
 };
 
 class KWIN_EXPORT AbstractEglTexture : public SceneOpenGLTexturePrivate
@@ -86,24 +128,27 @@ public:
 
 protected:
     AbstractEglTexture(SceneOpenGLTexture *texture, AbstractEglBackend *backend);
-    EGLImageKHR image() const {
-        return m_image;
-    }
-    void setImage(const EGLImageKHR &img) {
-        m_image = img;
-    }
+    void onDamage() override;
     SceneOpenGLTexture *texture() const {
         return q;
     }
 
 private:
-    bool loadShmTexture(const QPointer<KWayland::Server::BufferInterface> &buffer);
+    bool loadShmTexture(const QImage &image);
+    void updateShmTexture(const QImage &image, KWayland::Server::SurfaceInterface *surface);
     bool loadEglTexture(const QPointer<KWayland::Server::BufferInterface> &buffer);
-    EGLImageKHR attach(const QPointer<KWayland::Server::BufferInterface> &buffer);
+#if HAVE_LINUX_DMABUF
+    bool loadDmabufTexture(const QPointer<KWayland::Server::BufferInterface> &buffer);
+    void updateDmabufTexture(const QPointer<KWayland::Server::BufferInterface> &buffer, KWayland::Server::SurfaceInterface *surface);
+#endif
+    bool attachBufferTexture(const QPointer<KWayland::Server::BufferInterface> &buffer);
+    void detachBufferTexture();
+    void dropBufferTexture();
     bool updateFromFBO(const QSharedPointer<QOpenGLFramebufferObject> &fbo);
     SceneOpenGLTexture *q;
     AbstractEglBackend *m_backend;
-    EGLImageKHR m_image;
+    // the shared texture of the attached hardware buffer, if any
+    QSharedPointer<AbstractEglBackend::BufferTexture> m_bufferTexture;
 };
 
 }
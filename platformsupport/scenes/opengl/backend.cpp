@@ -108,6 +108,12 @@ bool OpenGLBackend::perScreenRendering() const
     return false;
 }
 
+int OpenGLBackend::screenRotation(int screenId) const
+{
+    Q_UNUSED(screenId)
+    return 0;
+}
+
 void OpenGLBackend::copyPixels(const QRegion &region)
 {
     const int height = screens()->size().height();
@@ -102,6 +102,15 @@ public:
      **/
     virtual bool perScreenRendering() const;
     virtual QRegion prepareRenderingForScreen(int screenId);
+    /**
+     * Rotation in degrees (counter-clockwise, 0, 90, 180 or 270) which the scene has to
+     * apply when rendering the screen @p screenId, because the output cannot rotate
+     * in hardware. The rotation is folded into the projection matrix, so a backend
+     * returning a non-zero value must set the viewport to its whole framebuffer in
+     * prepareRenderingForScreen.
+     * Default implementation returns @c 0.
+     **/
+    virtual int screenRotation(int screenId) const;
     /**
      * @brief Compositor is going into idle mode, flushes any pending paints.
      **/
@@ -0,0 +1,95 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_CLIENT_BUFFER_CACHE_H
+#define KWIN_CLIENT_BUFFER_CACHE_H
+
+#include <QHash>
+#include <QObject>
+
+namespace KWin
+{
+
+/**
+ * @brief Keeps what got imported from a client buffer until the buffer gets destroyed.
+ *
+ * Clients cycle through a small set of buffers, importing a buffer on every commit repeats the
+ * same work over and over. The cache holds one value per buffer, which is dropped once the
+ * buffer object gets destroyed or the cache gets cleared.
+ **/
+template <typename T>
+class ClientBufferCache
+{
+public:
+    ClientBufferCache() = default;
+    ~ClientBufferCache() {
+        clear();
+    }
+
+    /**
+     * @returns the value cached for @p buffer or a default constructed value.
+     **/
+    T value(QObject *buffer) const {
+        return m_entries.value(buffer).value;
+    }
+    bool contains(QObject *buffer) const {
+        return m_entries.contains(buffer);
+    }
+
+    void insert(QObject *buffer, const T &value) {
+        auto it = m_entries.find(buffer);
+        if (it == m_entries.end()) {
+            it = m_entries.insert(buffer, Entry());
+            it->connection = QObject::connect(buffer, &QObject::destroyed,
+                [this, buffer] {
+                    remove(buffer);
+                }
+            );
+        }
+        it->value = value;
+        m_insertCount++;
+    }
+
+    void remove(QObject *buffer) {
+        auto it = m_entries.find(buffer);
+        if (it == m_entries.end()) {
+            return;
+        }
+        QObject::disconnect(it->connection);
+        m_entries.erase(it);
+    }
+
+    void clear() {
+        for (const Entry &entry : qAsConst(m_entries)) {
+            QObject::disconnect(entry.connection);
+        }
+        m_entries.clear();
+    }
+
+    int count() const {
+        return m_entries.count();
+    }
+
+    /**
+     * @returns how many values got inserted over the lifetime of the cache, that is how often
+     * a buffer got imported. Meant for tests.
+     **/
+    quint64 insertCount() const {
+        return m_insertCount;
+    }
+
+private:
+    Q_DISABLE_COPY(ClientBufferCache)
+    struct Entry {
+        T value = T();
+        QMetaObject::Connection connection;
+    };
+    QHash<QObject*, Entry> m_entries;
+    quint64 m_insertCount = 0;
+};
+
+}
+
+#endif
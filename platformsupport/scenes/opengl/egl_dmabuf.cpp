@@ -0,0 +1,270 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "egl_dmabuf.h"
+#include "abstract_egl_backend.h"
+#include "drm_fourcc.h"
+#include "wayland_server.h"
+// kwin libs
+#include <logging.h>
+
+namespace KWin
+{
+
+typedef EGLBoolean (*eglQueryDmaBufFormatsEXT_func)(EGLDisplay dpy, EGLint max_formats, EGLint *formats, EGLint *num_formats);
+typedef EGLBoolean (*eglQueryDmaBufModifiersEXT_func)(EGLDisplay dpy, EGLint format, EGLint max_modifiers, EGLuint64KHR *modifiers, EGLBoolean *external_only, EGLint *num_modifiers);
+static eglQueryDmaBufFormatsEXT_func eglQueryDmaBufFormatsEXT = nullptr;
+static eglQueryDmaBufModifiersEXT_func eglQueryDmaBufModifiersEXT = nullptr;
+
+#ifndef EGL_LINUX_DMA_BUF_EXT
+#define EGL_LINUX_DMA_BUF_EXT                     0x3270
+#define EGL_LINUX_DRM_FOURCC_EXT                  0x3271
+#define EGL_DMA_BUF_PLANE0_FD_EXT                 0x3272
+#define EGL_DMA_BUF_PLANE0_OFFSET_EXT             0x3273
+#define EGL_DMA_BUF_PLANE0_PITCH_EXT              0x3274
+#define EGL_DMA_BUF_PLANE1_FD_EXT                 0x3275
+#define EGL_DMA_BUF_PLANE1_OFFSET_EXT             0x3276
+#define EGL_DMA_BUF_PLANE1_PITCH_EXT              0x3277
+#define EGL_DMA_BUF_PLANE2_FD_EXT                 0x3278
+#define EGL_DMA_BUF_PLANE2_OFFSET_EXT             0x3279
+#define EGL_DMA_BUF_PLANE2_PITCH_EXT              0x327A
+#endif
+#ifndef EGL_DMA_BUF_PLANE3_FD_EXT
+#define EGL_DMA_BUF_PLANE3_FD_EXT                 0x3440
+#define EGL_DMA_BUF_PLANE3_OFFSET_EXT             0x3441
+#define EGL_DMA_BUF_PLANE3_PITCH_EXT              0x3442
+#define EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT        0x3443
+#define EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT        0x3444
+#define EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT        0x3445
+#define EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT        0x3446
+#define EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT        0x3447
+#define EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT        0x3448
+#define EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT        0x3449
+#define EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT        0x344A
+#endif
+
+struct PlaneAttributes {
+    EGLint fd;
+    EGLint offset;
+    EGLint pitch;
+    EGLint modifierLo;
+    EGLint modifierHi;
+};
+
+static const PlaneAttributes s_planeAttributes[] = {
+    { EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT,
+      EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT,
+      EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT,
+      EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT, EGL_DMA_BUF_PLANE3_PITCH_EXT,
+      EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT }
+};
+
+EglDmabufBuffer::EglDmabufBuffer(EGLImageKHR image, const QVector<Plane> &planes, uint32_t format,
+                                 const QSize &size, Flags flags, EGLDisplay display)
+    : DmabufBuffer(planes, format, size, flags)
+    , m_image(image)
+    , m_display(display)
+{
+}
+
+EglDmabufBuffer::~EglDmabufBuffer()
+{
+    destroyImage();
+}
+
+void EglDmabufBuffer::destroyImage()
+{
+    if (m_image != EGL_NO_IMAGE_KHR) {
+        eglDestroyImageKHR(m_display, m_image);
+        m_image = EGL_NO_IMAGE_KHR;
+    }
+}
+
+void EglDmabufBuffer::setImage(EGLImageKHR image, EGLDisplay display)
+{
+    destroyImage();
+    m_image = image;
+    m_display = display;
+}
+
+EglDmabuf *EglDmabuf::factory(AbstractEglBackend *backend)
+{
+    if (!backend->hasExtension(QByteArrayLiteral("EGL_EXT_image_dma_buf_import"))) {
+        return nullptr;
+    }
+    if (backend->hasExtension(QByteArrayLiteral("EGL_EXT_image_dma_buf_import_modifiers"))) {
+        eglQueryDmaBufFormatsEXT = (eglQueryDmaBufFormatsEXT_func)eglGetProcAddress("eglQueryDmaBufFormatsEXT");
+        eglQueryDmaBufModifiersEXT = (eglQueryDmaBufModifiersEXT_func)eglGetProcAddress("eglQueryDmaBufModifiersEXT");
+    } else {
+        eglQueryDmaBufFormatsEXT = nullptr;
+        eglQueryDmaBufModifiersEXT = nullptr;
+    }
+    return new EglDmabuf(backend);
+}
+
+EglDmabuf::EglDmabuf(AbstractEglBackend *backend)
+    : LinuxDmabuf()
+    , m_backend(backend)
+{
+    setSupportedFormatsAndModifiers();
+}
+
+EglDmabuf::~EglDmabuf()
+{
+    // the buffers outlive the EGL display, the next scene imports them again in restoreImage
+    for (DmabufBuffer *buffer : waylandServer()->linuxDmabufBuffers()) {
+        if (auto eglBuffer = dynamic_cast<EglDmabufBuffer*>(buffer)) {
+            eglBuffer->destroyImage();
+        }
+    }
+}
+
+EGLImageKHR EglDmabuf::createImage(const QVector<Plane> &planes, uint32_t format, const QSize &size)
+{
+    const bool haveModifiers = eglQueryDmaBufModifiersEXT != nullptr;
+    QVector<EGLint> attribs;
+    attribs << EGL_WIDTH << size.width()
+            << EGL_HEIGHT << size.height()
+            << EGL_LINUX_DRM_FOURCC_EXT << EGLint(format);
+    for (int i = 0; i < planes.count(); ++i) {
+        const Plane &plane = planes.at(i);
+        attribs << s_planeAttributes[i].fd << plane.fd
+                << s_planeAttributes[i].offset << EGLint(plane.offset)
+                << s_planeAttributes[i].pitch << EGLint(plane.stride);
+        // an invalid modifier means the layout is implied by the driver
+        if (plane.modifier != DRM_FORMAT_MOD_INVALID) {
+            if (!haveModifiers) {
+                if (plane.modifier != DRM_FORMAT_MOD_LINEAR) {
+                    return EGL_NO_IMAGE_KHR;
+                }
+                continue;
+            }
+            attribs << s_planeAttributes[i].modifierLo << EGLint(plane.modifier & 0xffffffff)
+                    << s_planeAttributes[i].modifierHi << EGLint(plane.modifier >> 32);
+        }
+    }
+    attribs << EGL_NONE;
+    return eglCreateImageKHR(m_backend->eglDisplay(), EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT,
+                             (EGLClientBuffer)nullptr, attribs.data());
+}
+
+KWayland::Server::LinuxDmabufUnstableV1Buffer *EglDmabuf::importBuffer(const QVector<Plane> &planes,
+                                                                       uint32_t format,
+                                                                       const QSize &size,
+                                                                       Flags flags)
+{
+    if (planes.isEmpty() || planes.count() > 4) {
+        return nullptr;
+    }
+    const EGLImageKHR image = createImage(planes, format, size);
+    if (image != EGL_NO_IMAGE_KHR) {
+        return new EglDmabufBuffer(image, planes, format, size, flags, m_backend->eglDisplay());
+    }
+    qCDebug(KWIN_OPENGL) << "Failed to import dmabuf of format" << format << ", trying to map it";
+    return LinuxDmabuf::importBuffer(planes, format, size, flags);
+}
+
+bool EglDmabuf::restoreImage(EglDmabufBuffer *buffer)
+{
+    if (buffer->image() != EGL_NO_IMAGE_KHR) {
+        return true;
+    }
+    const EGLImageKHR image = createImage(buffer->planes(), buffer->format(), buffer->size());
+    if (image == EGL_NO_IMAGE_KHR) {
+        qCDebug(KWIN_OPENGL) << "Failed to import dmabuf again after a scene restart";
+        return false;
+    }
+    buffer->setImage(image, m_backend->eglDisplay());
+    return true;
+}
+
+/**
+ * YUV formats are sampled through GL_TEXTURE_EXTERNAL_OES. Without a modifier list the
+ * driver does not tell whether it could bind them as GL_TEXTURE_2D, so they are left out.
+ **/
+static bool isExternalOnlyFormat(uint32_t format)
+{
+    switch (format) {
+    case DRM_FORMAT_YUYV:
+    case DRM_FORMAT_YVYU:
+    case DRM_FORMAT_UYVY:
+    case DRM_FORMAT_VYUY:
+    case DRM_FORMAT_AYUV:
+    case DRM_FORMAT_NV12:
+    case DRM_FORMAT_NV21:
+    case DRM_FORMAT_NV16:
+    case DRM_FORMAT_NV61:
+    case DRM_FORMAT_NV24:
+    case DRM_FORMAT_NV42:
+    case DRM_FORMAT_YUV410:
+    case DRM_FORMAT_YVU410:
+    case DRM_FORMAT_YUV411:
+    case DRM_FORMAT_YVU411:
+    case DRM_FORMAT_YUV420:
+    case DRM_FORMAT_YVU420:
+    case DRM_FORMAT_YUV422:
+    case DRM_FORMAT_YVU422:
+    case DRM_FORMAT_YUV444:
+    case DRM_FORMAT_YVU444:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void EglDmabuf::setSupportedFormatsAndModifiers()
+{
+    if (!eglQueryDmaBufFormatsEXT) {
+        // without the query only the formats which can be mapped are known to work
+        return;
+    }
+    const EGLDisplay display = m_backend->eglDisplay();
+    EGLint count = 0;
+    if (!eglQueryDmaBufFormatsEXT(display, 0, nullptr, &count) || count <= 0) {
+        return;
+    }
+    QVector<EGLint> formats(count);
+    if (!eglQueryDmaBufFormatsEXT(display, count, formats.data(), &count)) {
+        return;
+    }
+    formats.resize(count);
+
+    QHash<uint32_t, QSet<uint64_t>> set;
+    for (EGLint format : formats) {
+        count = 0;
+        if (!eglQueryDmaBufModifiersEXT(display, format, 0, nullptr, nullptr, &count) || count <= 0) {
+            // no modifier list, the driver only supports the implicit layout
+            if (!isExternalOnlyFormat(format)) {
+                set.insert(format, QSet<uint64_t>());
+            }
+            continue;
+        }
+        QVector<EGLuint64KHR> modifiers(count);
+        QVector<EGLBoolean> externalOnly(count);
+        if (!eglQueryDmaBufModifiersEXT(display, format, count, modifiers.data(), externalOnly.data(), &count)) {
+            continue;
+        }
+        // textures are bound as GL_TEXTURE_2D, external only layouts cannot be sampled
+        QSet<uint64_t> usable;
+        for (int i = 0; i < count; ++i) {
+            if (!externalOnly.at(i)) {
+                usable.insert(modifiers.at(i));
+            }
+        }
+        if (!usable.isEmpty()) {
+            set.insert(format, usable);
+        }
+    }
+    if (set.isEmpty()) {
+        return;
+    }
+    qCDebug(KWIN_OPENGL) << "Advertising" << set.count() << "dmabuf formats";
+    LinuxDmabuf::setSupportedFormatsAndModifiers(set);
+}
+
+}
@@ -0,0 +1,84 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_EGL_DMABUF_H
+#define KWIN_EGL_DMABUF_H
+
+#include "linux_dmabuf.h"
+
+#include <epoxy/egl.h>
+
+namespace KWin
+{
+
+class AbstractEglBackend;
+
+/**
+ * @brief A dmabuf which got imported into an EGLImage.
+ *
+ * The image is created once when the client creates the wl_buffer and bound by every texture
+ * the buffer gets attached to, so committing the same buffer again costs no import.
+ **/
+class EglDmabufBuffer : public DmabufBuffer
+{
+public:
+    EglDmabufBuffer(EGLImageKHR image, const QVector<Plane> &planes, uint32_t format,
+                    const QSize &size, Flags flags, EGLDisplay display);
+    ~EglDmabufBuffer() override;
+
+    EGLImageKHR image() const {
+        return m_image;
+    }
+    /**
+     * Destroys the image, used when the EGL display goes away before the buffer.
+     **/
+    void destroyImage();
+    /**
+     * Takes over @p image of @p display, the buffer got imported again by a new scene.
+     **/
+    void setImage(EGLImageKHR image, EGLDisplay display);
+
+private:
+    EGLImageKHR m_image;
+    EGLDisplay m_display;
+};
+
+/**
+ * @brief Imports dmabufs with EGL_EXT_image_dma_buf_import.
+ *
+ * Advertises the formats and modifiers the driver can sample as GL_TEXTURE_2D. Buffers which
+ * the driver rejects are still accepted through the CPU mapping of LinuxDmabuf if possible.
+ **/
+class EglDmabuf : public LinuxDmabuf
+{
+public:
+    /**
+     * @returns a new EglDmabuf or @c nullptr if the EGL display cannot import dmabufs.
+     **/
+    static EglDmabuf *factory(AbstractEglBackend *backend);
+
+    explicit EglDmabuf(AbstractEglBackend *backend);
+    ~EglDmabuf() override;
+
+    KWayland::Server::LinuxDmabufUnstableV1Buffer *importBuffer(const QVector<Plane> &planes,
+                                                                uint32_t format,
+                                                                const QSize &size,
+                                                                Flags flags) override;
+    /**
+     * Imports @p buffer again if its image got destroyed with the scene it was created by.
+     * @returns whether the buffer has an image of this backend's display afterwards.
+     **/
+    bool restoreImage(EglDmabufBuffer *buffer);
+
+private:
+    EGLImageKHR createImage(const QVector<Plane> &planes, uint32_t format, const QSize &size);
+    void setSupportedFormatsAndModifiers();
+
+    AbstractEglBackend *m_backend;
+};
+
+}
+
+#endif
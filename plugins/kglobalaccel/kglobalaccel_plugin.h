@@ -7,11 +7,13 @@
 #ifndef KGLOBALACCEL_PLUGIN_H
 #define KGLOBALACCEL_PLUGIN_H
 
+#include "../../globalshortcuts.h"
+
 #include <KGlobalAccel/private/kglobalaccel_interface.h>
 
 #include <QObject>
 
-class KGlobalAccelImpl : public KGlobalAccelInterface
+class KGlobalAccelImpl : public KGlobalAccelInterface, public KWin::GlobalAccelKeyHandler
 {
     Q_OBJECT
     Q_PLUGIN_METADATA(IID "org.kde.kglobalaccel5.KGlobalAccelInterface" FILE "kwin.json")
@@ -24,8 +26,7 @@ public:
     bool grabKey(int key, bool grab) override;
     void setEnabled(bool) override;
 
-public Q_SLOTS:
-    bool checkKeyPressed(int keyQt);
+    bool checkKeyPressed(int keyQt) override;
 
 private:
     bool m_shuttingDown = false;
@@ -226,7 +226,33 @@ void DrmBackend::pageFlipHandler(int fd, unsigned int frame, unsigned int sec, u
     Q_UNUSED(sec)
     Q_UNUSED(usec)
     auto output = reinterpret_cast<DrmOutput*>(data);
-    output->pageFlipped();
+    if (output->m_stateOnlyFlip) {
+        // only cursor plane or gamma LUT got updated, the compositor does not wait for such flips, but it
+        // might have presented a frame meanwhile which waits for this one
+        output->pageFlipped();
+        DrmBuffer *buffer = output->m_deferredPresent;
+        output->m_deferredPresent = nullptr;
+        if (!buffer) {
+            if (output->m_dpmsAtomicOffPending) {
+                output->m_modesetRequested = true;
+                output->dpmsAtomicOff();
+            }
+            return;
+        }
+        if (output->present(buffer)) {
+            // the flip of the frame completes the swap
+            return;
+        }
+        if (output->m_backend->m_deleteBufferAfterPageFlip) {
+            delete buffer;
+        }
+    } else {
+        output->pageFlipped();
+    }
+    if (Compositor::self()) {
+        // the surfaces on this output don't wait for the other outputs to flip
+        Compositor::self()->outputPresented(output);
+    }
     output->m_backend->m_pageFlipsPending--;
     if (output->m_backend->m_pageFlipsPending == 0) {
         // TODO: improve, this currently means we wait for all page flips or all outputs.
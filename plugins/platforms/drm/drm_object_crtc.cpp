@@ -47,6 +47,12 @@ DrmCrtc::~DrmCrtc()
     if (m_gammaRamp) {
         delete m_gammaRamp;
     }
+    if (m_pendingGammaBlobId) {
+        drmModeDestroyPropertyBlob(m_backend->fd(), m_pendingGammaBlobId);
+    }
+    if (m_gammaBlobId) {
+        drmModeDestroyPropertyBlob(m_backend->fd(), m_gammaBlobId);
+    }
 }
 
 bool DrmCrtc::atomicInit()
@@ -64,6 +70,8 @@ bool DrmCrtc::initProps()
     setPropertyNames({
         QByteArrayLiteral("MODE_ID"),
         QByteArrayLiteral("ACTIVE"),
+        QByteArrayLiteral("GAMMA_LUT"),
+        QByteArrayLiteral("GAMMA_LUT_SIZE"),
     });
 
     drmModeObjectProperties *properties = drmModeObjectGetProperties(fd(), m_id, DRM_MODE_OBJECT_CRTC);
@@ -77,6 +85,36 @@ bool DrmCrtc::initProps()
         initProp(j, properties);
     }
     drmModeFreeObjectProperties(properties);
+
+    // the color management LUT can be larger than the legacy gamma ramp, which stays the
+    // published ramp size, ramps get resampled to the LUT size when the blob is created
+    const auto lutSize = m_props.at(int(PropertyIndex::GammaLutSize));
+    if (m_props.at(int(PropertyIndex::GammaLut)) && lutSize && lutSize->value() > 0) {
+        m_gammaLutSize = lutSize->value();
+    }
+    return true;
+}
+
+bool DrmCrtc::atomicPopulate(drmModeAtomicReq *req)
+{
+    bool ret = true;
+    for (int i = 0; i < m_props.size(); i++) {
+        auto property = m_props.at(i);
+        if (!property) {
+            continue;
+        }
+        // GAMMA_LUT_SIZE is immutable, and the LUT is only carried once a ramp got set,
+        // the blob found at startup might be gone already
+        if (i == int(PropertyIndex::GammaLutSize)
+                || (i == int(PropertyIndex::GammaLut) && !m_gammaBlobId && !m_pendingGammaBlobId)) {
+            continue;
+        }
+        ret &= atomicAddProperty(req, property);
+    }
+    if (!ret) {
+        qCWarning(KWIN_DRM) << "Failed to populate atomic crtc" << m_id;
+        return false;
+    }
     return true;
 }
 
@@ -123,6 +161,39 @@ bool DrmCrtc::blank()
 }
 
 bool DrmCrtc::setGammaRamp(const ColorCorrect::GammaRamp &gamma) {
+    if (hasGammaLut()) {
+        const uint32_t lutSize = m_gammaLutSize ? m_gammaLutSize : gamma.size;
+        if (lutSize == 0 || gamma.size == 0) {
+            return false;
+        }
+        QVector<drm_color_lut> lut(lutSize);
+        // linear interpolation between the ramp entries, the end points map onto each other
+        const double scale = lutSize > 1 ? double(gamma.size - 1) / (lutSize - 1) : 0.0;
+        for (uint32_t i = 0; i < lutSize; i++) {
+            const double position = i * scale;
+            const uint32_t index = qMin(uint32_t(position), gamma.size - 1);
+            const uint32_t next = qMin(index + 1, gamma.size - 1);
+            const double t = position - index;
+            lut[i].red = qRound((1.0 - t) * gamma.red[index] + t * gamma.red[next]);
+            lut[i].green = qRound((1.0 - t) * gamma.green[index] + t * gamma.green[next]);
+            lut[i].blue = qRound((1.0 - t) * gamma.blue[index] + t * gamma.blue[next]);
+            lut[i].reserved = 0;
+        }
+        uint32_t blobId = 0;
+        if (drmModeCreatePropertyBlob(m_backend->fd(), lut.constData(), lut.size() * sizeof(drm_color_lut), &blobId) != 0) {
+            qCWarning(KWIN_DRM) << "Failed to create gamma blob for crtc" << m_id;
+            return false;
+        }
+        // a ramp set while the previous one still waits replaces it
+        if (m_pendingGammaBlobId) {
+            drmModeDestroyPropertyBlob(m_backend->fd(), m_pendingGammaBlobId);
+        }
+        m_pendingGammaBlobId = blobId;
+        setValue(int(PropertyIndex::GammaLut), blobId);
+        *m_gammaRamp = gamma;
+        return true;
+    }
+
     bool isError = drmModeCrtcSetGamma(m_backend->fd(), m_id, gamma.size,
                                 gamma.red, gamma.green, gamma.blue);
 
@@ -138,4 +209,31 @@ const ColorCorrect::GammaRamp* DrmCrtc::getGammaRamp() const
     return m_gammaRamp;
 }
 
+bool DrmCrtc::hasGammaLut() const
+{
+    return m_backend->atomicModeSetting() && m_props.at(int(PropertyIndex::GammaLut));
+}
+
+bool DrmCrtc::atomicPopulateGammaLut(drmModeAtomicReq *req)
+{
+    auto property = m_props.at(int(PropertyIndex::GammaLut));
+    if (!property) {
+        return false;
+    }
+    return atomicAddProperty(req, property);
+}
+
+void DrmCrtc::gammaLutCommitted()
+{
+    if (!m_pendingGammaBlobId) {
+        return;
+    }
+    // the kernel holds its own reference on the blob in use
+    if (m_gammaBlobId) {
+        drmModeDestroyPropertyBlob(m_backend->fd(), m_gammaBlobId);
+    }
+    m_gammaBlobId = m_pendingGammaBlobId;
+    m_pendingGammaBlobId = 0;
+}
+
 }
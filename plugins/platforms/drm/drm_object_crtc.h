@@ -45,10 +45,13 @@ public:
     enum class PropertyIndex {
         ModeId = 0,
         Active,
+        GammaLut,
+        GammaLutSize,
         Count
     };
     
     bool initProps();
+    bool atomicPopulate(drmModeAtomicReq *req) override;
 
     int resIndex() const {
         return m_resIndex;
@@ -70,12 +73,34 @@ public:
     int getGammaRampSize() const {
         return m_gammaRampSize;
     }
+    /**
+     * Sets the gamma ramp. With atomic mode setting and a GAMMA_LUT property the ramp is
+     * only stored in a blob, which goes out with the next atomic commit of the output.
+     * The ramp has the size of getGammaRampSize() and gets resampled to the LUT size.
+     **/
     bool setGammaRamp(const ColorCorrect::GammaRamp &gamma);
     const ColorCorrect::GammaRamp* getGammaRamp() const;
+    /**
+     * @returns whether gamma ramps get committed through the GAMMA_LUT property.
+     **/
+    bool hasGammaLut() const;
+    /**
+     * @returns whether a gamma blob waits for the next atomic commit.
+     **/
+    bool hasPendingGammaLut() const {
+        return m_pendingGammaBlobId != 0;
+    }
+    bool atomicPopulateGammaLut(drmModeAtomicReq *req);
+    /**
+     * To be called once an atomic commit carrying the pending gamma blob succeeded.
+     **/
+    void gammaLutCommitted();
 
 private:
     int m_resIndex;
     uint32_t m_gammaRampSize = 0;
+    // size of the GAMMA_LUT, 0 without color management support
+    uint32_t m_gammaLutSize = 0;
 
     DrmBuffer *m_currentBuffer = nullptr;
     DrmBuffer *m_nextBuffer = nullptr;
@@ -83,6 +108,8 @@ private:
     DrmBackend *m_backend;
 
     ColorCorrect::GammaRamp *m_gammaRamp = nullptr;
+    uint32_t m_gammaBlobId = 0;
+    uint32_t m_pendingGammaBlobId = 0;
 };
 
 }
@@ -34,6 +34,7 @@
 // Qt
 #include <QMatrix4x4>
 #include <QCryptographicHash>
+#include <QHash>
 #include <QPainter>
 // drm
 #include <xf86drm.h>
@@ -44,10 +45,19 @@
 
 namespace KWin
 {
+// upper limit for the memory used by pre-rendered cursor buffers per output
+static const int s_cursorCacheBytes = 4 * 1024 * 1024;
+// delay in ms before a cursor or gamma commit rejected with EBUSY is tried again
+static const int s_busyRetryInterval = 1;
+
 DrmOutput::DrmOutput(DrmBackend *backend)
     : AbstractOutput(backend)
     , m_backend(backend)
 {
+    // coalesces all cursor and gamma changes of one event loop pass into one update
+    m_pendingCommitTimer.setSingleShot(true);
+    m_pendingCommitTimer.setInterval(0);
+    connect(&m_pendingCommitTimer, &QTimer::timeout, this, &DrmOutput::commitPendingState);
 }
 
 DrmOutput::~DrmOutput()
@@ -79,11 +89,20 @@ void DrmOutput::teardown()
             m_primaryPlane->setCurrent(nullptr);
         }
 
+        if (m_cursorPlane) {
+            m_cursorPlane->setOutput(nullptr);
+            m_cursorPlane = nullptr;
+        }
+        m_pendingCommitTimer.stop();
+
         m_crtc->setOutput(nullptr);
         m_conn->setOutput(nullptr);
 
-        m_cursor[0].reset(nullptr);
-        m_cursor[1].reset(nullptr);
+        m_cursorCache.clear();
+        m_cursor.reset();
+        m_cursorPlaneBuffer.reset();
+        m_cursorPendingBuffer.reset();
+        m_cursorScanoutBuffer.reset();
     } else {
         if (!m_pageFlipPending) {
             qDebug() << "-------" << __func__ << waylandOutput();
@@ -113,6 +132,12 @@ bool DrmOutput::hideCursor()
     if (m_isVirtual) {
         return false;
     }
+    m_cursorVisible = false;
+    if (m_cursorPlane) {
+        setCursorPlaneState(nullptr);
+        schedulePendingCommit();
+        return true;
+    }
     int ret = drmModeSetCursor(m_backend->fd(), m_crtc->id(), 0, 0, 0) == 0;
     if (false == ret) {
         qDebug() << "drmModeSetCursor to 0/0 failed";
@@ -120,12 +145,23 @@ bool DrmOutput::hideCursor()
     return ret;
 }
 
-bool DrmOutput::showCursor(DrmDumbBuffer *c)
+bool DrmOutput::showCursor(const QSharedPointer<DrmDumbBuffer> &c)
 {
     if (!c) {
         qDebug() << "dumb buffer is null";
         return false;
     }
+    if (m_cursorPlane) {
+        setCursorPlaneState(c);
+        if (!testCursorPlane()) {
+            qCWarning(KWIN_DRM) << "Cursor plane" << m_cursorPlane->id() << "rejected the cursor buffer of output" << uuid();
+            setCursorPlaneState(nullptr);
+            return false;
+        }
+        m_cursorVisible = true;
+        schedulePendingCommit();
+        return true;
+    }
     const QSize &s = c->size();
     bool ret = drmModeSetCursor(m_backend->fd(), m_crtc->id(), c->handle(), s.width(), s.height()) == 0;
     if (false == ret) {
@@ -137,50 +173,68 @@ bool DrmOutput::showCursor(DrmDumbBuffer *c)
 
 bool DrmOutput::showCursor()
 {
-    const bool ret = showCursor(m_cursor[m_cursorIndex].data());
-    if (!ret) {
-        return ret;
-    }
-
-    if (m_hasNewCursor) {
-        m_cursorIndex = (m_cursorIndex + 1) % 2;
-        m_hasNewCursor = false;
-    }
-
-    return ret;
+    return showCursor(m_cursor);
 }
 
-void DrmOutput::updateCursor()
+QSharedPointer<DrmDumbBuffer> DrmOutput::renderCursor(const QImage &cursorImage)
 {
-    QImage cursorImage = m_backend->softwareCursor();
-    if (cursorImage.isNull()) {
-        return;
+    QSharedPointer<DrmDumbBuffer> buffer(m_backend->createBuffer(m_cursorSize));
+    if (!buffer->map(QImage::Format_ARGB32_Premultiplied)) {
+        return QSharedPointer<DrmDumbBuffer>();
     }
-    m_hasNewCursor = true;
-    QImage *c = m_cursor[m_cursorIndex]->image();
-    if (!c) return;
+    QImage *c = buffer->image();
 
     c->fill(Qt::transparent);
     c->setDevicePixelRatio(scale());
 
     QPainter p;
     p.begin(c);
-    /* if (orientation() == Qt::InvertedLandscapeOrientation) {
-        QMatrix4x4 matrix;
-        matrix.translate(cursorImage.width() / 2.0, cursorImage.height() / 2.0);
-        matrix.rotate(180.0f, 0.0f, 0.0f, 1.0f);
-        matrix.translate(-cursorImage.width() / 2.0, -cursorImage.height() / 2.0);
-        p.setWorldTransform(matrix.toTransform());
-    } */
-
     QRect cursorRect = QRect(QPoint(0, 0), cursorImage.size() / cursorImage.devicePixelRatio());
     p.setWorldTransform(logicalToNativeMatrix(cursorRect, 1, transformWayland()).toTransform());
 
     p.drawImage(QPoint(0, 0), cursorImage);
     p.end();
     if (workspace() && workspace()->isKwinDebug()) {
-        qDebug() << "output" << uuid() << geometry() << globalPos()<<"draw cursorImag" << cursorImage.size() << c->size() << "scale" << cursorImage.devicePixelRatio();        
+        qDebug() << "output" << uuid() << geometry() << globalPos()<<"draw cursorImag" << cursorImage.size() << c->size() << "scale" << cursorImage.devicePixelRatio();
+    }
+    return buffer;
+}
+
+void DrmOutput::updateCursor()
+{
+    QImage cursorImage = m_backend->softwareCursor();
+    if (cursorImage.isNull() || m_cursorSize.isEmpty()) {
+        return;
     }
+    if (m_cursorCacheScale != scale() || m_cursorCacheTransform != transformWayland()) {
+        // the cached buffers are rendered for the previous scale or rotation
+        m_cursorCache.clear();
+        m_cursorCacheScale = scale();
+        m_cursorCacheTransform = transformWayland();
+    }
+    // Client cursors are a fresh copy of the buffer on every change, so the cache goes by
+    // content. That way themed, animated and client cursors only get rasterized once.
+    const uint hash = qHashBits(cursorImage.constBits(), cursorImage.sizeInBytes());
+    for (int i = 0; i < m_cursorCache.count(); ++i) {
+        const CursorCacheEntry &entry = m_cursorCache.at(i);
+        if (entry.hash == hash && entry.image.devicePixelRatio() == cursorImage.devicePixelRatio()
+                && entry.image == cursorImage) {
+            m_cursor = entry.buffer;
+            m_cursorCache.move(i, 0);
+            return;
+        }
+    }
+    QSharedPointer<DrmDumbBuffer> buffer = renderCursor(cursorImage);
+    if (!buffer) {
+        return;
+    }
+    const int maxCount = qMax(8, s_cursorCacheBytes / (m_cursorSize.width() * m_cursorSize.height() * 4));
+    while (m_cursorCache.count() >= maxCount) {
+        // the plane keeps its buffers alive on its own until they got replaced
+        m_cursorCache.removeLast();
+    }
+    m_cursorCache.prepend({cursorImage, hash, buffer});
+    m_cursor = buffer;
 }
 
 void DrmOutput::moveCursor(const QPoint &globalPos)
@@ -191,20 +245,6 @@ void DrmOutput::moveCursor(const QPoint &globalPos)
     m_oldPos = globalPos;
     QMatrix4x4 matrix;
     QMatrix4x4 hotspotMatrix;
-    /* if (orientation() == Qt::InvertedLandscapeOrientation) {
-        matrix.translate(pixelSize().width() /2.0, pixelSize().height() / 2.0);
-        matrix.rotate(180.0f, 0.0f, 0.0f, 1.0f);
-        matrix.translate(-pixelSize().width() /2.0, -pixelSize().height() / 2.0);
-        const auto cursorSize = m_backend->softwareCursor().size();
-        hotspotMatrix.translate(cursorSize.width()/2.0, cursorSize.height()/2.0);
-        hotspotMatrix.rotate(180.0f, 0.0f, 0.0f, 1.0f);
-        hotspotMatrix.translate(-cursorSize.width()/2.0, -cursorSize.height()/2.0);
-    }
-    hotspotMatrix.scale(scale());
-    matrix.scale(scale());
-    const auto outputGlobalPos = AbstractOutput::globalPos();
-    matrix.translate(-outputGlobalPos.x(), -outputGlobalPos.y());
-    const QPoint p = matrix.map(globalPos) - hotspotMatrix.map(m_backend->softwareCursorHotspot());*/
 
     const auto cursor = m_backend->softwareCursor();
     QRect cursorRect = QRect(QPoint(0, 0), cursor.size() / cursor.devicePixelRatio());
@@ -217,9 +257,120 @@ void DrmOutput::moveCursor(const QPoint &globalPos)
     if (workspace() && workspace()->isKwinDebug()) {
         qDebug() << "drmModeMoveCursor output" << uuid() << geometry() << globalPos << pos;    
     }
+    if (m_cursorPlane) {
+        if (m_cursorPos == pos) {
+            return;
+        }
+        m_cursorPos = pos;
+        if (m_cursorVisible) {
+            setCursorPlaneState(m_cursor);
+            schedulePendingCommit();
+        }
+        return;
+    }
     drmModeMoveCursor(m_backend->fd(), m_crtc->id(), pos.x(), pos.y());
 }
 
+void DrmOutput::setCursorPlaneState(const QSharedPointer<DrmDumbBuffer> &buffer)
+{
+    m_cursorPlaneBuffer = buffer;
+    if (!buffer) {
+        m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::FbId), 0);
+        m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::CrtcId), 0);
+        m_cursorPlaneDirty = true;
+        return;
+    }
+    const QSize size = buffer->size();
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::SrcX), 0);
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::SrcY), 0);
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::SrcW), size.width() << 16);
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::SrcH), size.height() << 16);
+    // CRTC_X and CRTC_Y are signed, the cursor may be partially off screen
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::CrtcX), uint64_t(int64_t(m_cursorPos.x())));
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::CrtcY), uint64_t(int64_t(m_cursorPos.y())));
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::CrtcW), size.width());
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::CrtcH), size.height());
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::FbId), buffer->bufferId());
+    m_cursorPlane->setValue(int(DrmPlane::PropertyIndex::CrtcId), m_crtc->id());
+    m_cursorPlaneDirty = true;
+}
+
+void DrmOutput::cursorPlaneCommitted()
+{
+    // the previous buffer might still be scanned out until the next vblank
+    if (m_cursorPendingBuffer != m_cursorPlaneBuffer) {
+        m_cursorScanoutBuffer = m_cursorPendingBuffer;
+        m_cursorPendingBuffer = m_cursorPlaneBuffer;
+    }
+}
+
+bool DrmOutput::testCursorPlane()
+{
+    drmModeAtomicReq *req = drmModeAtomicAlloc();
+    if (!req) {
+        return false;
+    }
+    const bool ok = m_cursorPlane->atomicPopulate(req)
+            && drmModeAtomicCommit(m_backend->fd(), req, DRM_MODE_ATOMIC_TEST_ONLY, this) == 0;
+    drmModeAtomicFree(req);
+    return ok;
+}
+
+void DrmOutput::schedulePendingCommit()
+{
+    if (!m_pendingCommitTimer.isActive()) {
+        m_pendingCommitTimer.start(0);
+    }
+}
+
+void DrmOutput::commitPendingState()
+{
+    const bool cursorPending = m_cursorPlane && m_cursorPlaneDirty;
+    const bool gammaPending = m_crtc && m_crtc->hasPendingGammaLut();
+    if (!cursorPending && !gammaPending) {
+        return;
+    }
+    // While a page flip is pending the kernel rejects further commits on this CRTC. Cursor
+    // plane and gamma LUT are part of every atomic present, so they either go out with the
+    // next frame or get committed on their own once the pending flip completed.
+    if (m_pageFlipPending || m_modesetRequested || m_dpmsModePending != DpmsMode::On
+            || !LogindIntegration::self()->isActiveSession()) {
+        return;
+    }
+    drmModeAtomicReq *req = drmModeAtomicAlloc();
+    if (!req) {
+        qCWarning(KWIN_DRM) << "DRM: couldn't allocate atomic request";
+        return;
+    }
+    bool ok = (!cursorPending || m_cursorPlane->atomicPopulate(req))
+            && (!gammaPending || m_crtc->atomicPopulateGammaLut(req));
+    if (ok && drmModeAtomicCommit(m_backend->fd(), req, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, this) != 0) {
+        if (errno == EBUSY) {
+            // the CRTC still works on a commit we did not get the event for, e.g. one from
+            // before a session switch
+            m_pendingCommitTimer.start(s_busyRetryInterval);
+        } else {
+            qCWarning(KWIN_DRM) << "Atomic state commit failed:" << strerror(errno);
+        }
+        ok = false;
+    }
+    drmModeAtomicFree(req);
+    if (!ok) {
+        return;
+    }
+    if (cursorPending) {
+        m_cursorPlaneDirty = false;
+        cursorPlaneCommitted();
+    }
+    if (gammaPending) {
+        m_crtc->gammaLutCommitted();
+    }
+    // the compositor does not wait for this flip, a frame presented meanwhile gets deferred
+    // until it completed
+    m_stateOnlyFlip = true;
+    m_pageFlipPending = true;
+}
+
 static QHash<int, QByteArray> s_connectorNames = {
     {DRM_MODE_CONNECTOR_Unknown, QByteArrayLiteral("Unknown")},
     {DRM_MODE_CONNECTOR_VGA, QByteArrayLiteral("VGA")},
@@ -269,6 +420,12 @@ bool DrmOutput::init(drmModeConnector *connector)
         if (!initPrimaryPlane()) {
             return false;
         }
+        if (initCursorPlane()) {
+            // don't inherit whatever the previous DRM master left on the plane
+            setCursorPlaneState(nullptr);
+        } else {
+            qCDebug(KWIN_DRM) << "No cursor plane for CRTC" << m_crtc->id() << ", using legacy cursor updates";
+        }
     } else if (!m_crtc->blank()) {
         return false;
     }
@@ -621,7 +778,7 @@ bool DrmOutput::initPrimaryPlane()
     return false;
 }
 
-bool DrmOutput::initCursorPlane()       // TODO: Add call in init (but needs layer support in general first)
+bool DrmOutput::initCursorPlane()
 {
     for (int i = 0; i < m_backend->planes().size(); ++i) {
         DrmPlane* p = m_backend->planes()[i];
@@ -650,16 +807,15 @@ bool DrmOutput::initCursorPlane()       // TODO: Add call in init (but needs lay
 
 bool DrmOutput::initCursor(const QSize &cursorSize)
 {
-    auto createCursor = [this, cursorSize] (int index) {
-        m_cursor[index].reset(m_backend->createBuffer(cursorSize));
-        if (!m_cursor[index]->map(QImage::Format_ARGB32_Premultiplied)) {
-            return false;
-        }
-        return true;
-    };
-    if (!createCursor(0) || !createCursor(1)) {
+    m_cursorSize = cursorSize;
+    m_cursorCache.clear();
+    // an empty cursor until the first updateCursor, also verifies that dumb buffers work
+    m_cursor.reset(m_backend->createBuffer(cursorSize));
+    if (!m_cursor->map(QImage::Format_ARGB32_Premultiplied)) {
+        m_cursor.reset();
         return false;
     }
+    m_cursor->image()->fill(Qt::transparent);
     return true;
 }
 
@@ -1116,9 +1272,17 @@ void DrmOutput::pageFlipped()
     if (!m_crtc) {
         return;
     }
+    m_cursorScanoutBuffer = m_cursorPendingBuffer;
+    if (m_cursorPlaneDirty || m_crtc->hasPendingGammaLut()) {
+        // a cursor or gamma change which came in while the flip was pending
+        schedulePendingCommit();
+    }
     // Egl based surface buffers get destroyed, QPainter based dumb buffers not
     // TODO: split up DrmOutput in two for dumb and egl/gbm surface buffer compatible subclasses completely?
-    if (m_backend->deleteBufferAfterPageFlip()) {
+    if (m_stateOnlyFlip) {
+        // only cursor plane or gamma LUT got updated, the buffers of the primary plane stay
+        m_stateOnlyFlip = false;
+    } else if (m_backend->deleteBufferAfterPageFlip()) {
         if (m_backend->atomicModeSetting()) {
             if (!m_primaryPlane->next()) {
                 // on manual vt switch
@@ -1186,6 +1350,10 @@ bool DrmOutput::dpmsAtomicOff()
     delete m_primaryPlane->next();
     m_primaryPlane->setNext(nullptr);
     m_nextPlanesFlipList << m_primaryPlane;
+    if (m_cursorPlane) {
+        // a plane must not stay enabled on the disabled CRTC
+        setCursorPlaneState(nullptr);
+    }
 
     if (!m_backend->usesSoftwareCursor()) {
         qDebug() << "setHideCursor output" << uuid() << geometry() << globalPos();
@@ -1218,6 +1386,11 @@ bool DrmOutput::presentAtomically(DrmBuffer *buffer)
     }
 
     if (m_pageFlipPending) {
+        if (m_stateOnlyFlip && !m_deferredPresent) {
+            // committed by the page flip handler once the gamma update got flipped
+            m_deferredPresent = buffer;
+            return true;
+        }
         qCWarning(KWIN_DRM) << "Page not yet flipped.";
         return false;
     }
@@ -1379,6 +1552,16 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
         DrmPlane *p = m_nextPlanesFlipList[i];
         ret &= p->atomicPopulate(req);
     }
+    // the cursor goes out together with the frame, so it never lags behind the content
+    if (m_cursorPlane) {
+        ret &= m_cursorPlane->atomicPopulate(req);
+    }
+    // so does the gamma LUT, a legacy gamma ioctl would stall on many drivers
+    const bool gammaPending = m_crtc->hasPendingGammaLut();
+    if (gammaPending && !(flags & DRM_MODE_ATOMIC_ALLOW_MODESET)) {
+        // a modeset already carries all crtc properties
+        ret &= m_crtc->atomicPopulateGammaLut(req);
+    }
 
     if (!ret) {
         qCWarning(KWIN_DRM) << "Failed to populate atomic planes. Abort atomic commit!";
@@ -1392,6 +1575,16 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
         return false;
     }
 
+    if (mode == AtomicCommitMode::Real) {
+        m_cursorPlaneDirty = false;
+        if (m_cursorPlane) {
+            cursorPlaneCommitted();
+        }
+        if (gammaPending) {
+            m_crtc->gammaLutCommitted();
+        }
+    }
+
     if (mode == AtomicCommitMode::Real && (flags & DRM_MODE_ATOMIC_ALLOW_MODESET)) {
         qCDebug(KWIN_DRM) << "Atomic Modeset successful.";
         m_modesetRequested = false;
@@ -1531,7 +1724,14 @@ int DrmOutput::getGammaRampSize() const
 
 bool DrmOutput::setGammaRamp(const ColorCorrect::GammaRamp &gamma)
 {
-    return m_crtc->setGammaRamp(gamma);
+    if (!m_crtc->setGammaRamp(gamma)) {
+        return false;
+    }
+    if (m_crtc->hasPendingGammaLut()) {
+        // goes out with the next frame, or on its own if no frame follows
+        schedulePendingCommit();
+    }
+    return true;
 }
 
 const ColorCorrect::GammaRamp* DrmOutput::getGammaRamp()
@@ -1539,4 +1739,9 @@ const ColorCorrect::GammaRamp* DrmOutput::getGammaRamp()
     return m_crtc->getGammaRamp();
 }
 
+bool DrmOutput::presentsGammaRampWithFrame() const
+{
+    return m_crtc->hasGammaLut();
+}
+
 }
@@ -12,9 +12,13 @@
 #include "drm_object.h"
 #include "drm_object_plane.h"
 
+#include <QImage>
+#include <QList>
 #include <QObject>
 #include <QPoint>
+#include <QSharedPointer>
 #include <QSize>
+#include <QTimer>
 #include <QVector>
 #include <xf86drmMode.h>
 
@@ -43,7 +47,7 @@ public:
     ///queues deleting the output after a page flip has completed.
     void teardown();
     void releaseGbm();
-    bool showCursor(DrmDumbBuffer *buffer);
+    bool showCursor(const QSharedPointer<DrmDumbBuffer> &buffer);
     bool showCursor();
     bool hideCursor();
     void updateCursor();
@@ -136,6 +140,12 @@ private:
     void initUuid();
     bool initPrimaryPlane();
     bool initCursorPlane();
+    QSharedPointer<DrmDumbBuffer> renderCursor(const QImage &image);
+    void setCursorPlaneState(const QSharedPointer<DrmDumbBuffer> &buffer);
+    void cursorPlaneCommitted();
+    bool testCursorPlane();
+    void schedulePendingCommit();
+    void commitPendingState();
 
     bool dpmsLegacyApply();
     void dpmsOnHandler();
@@ -153,6 +163,7 @@ private:
     int getGammaRampSize() const override;
     bool setGammaRamp(const ColorCorrect::GammaRamp &gamma) override;
     const ColorCorrect::GammaRamp* getGammaRamp() override;
+    bool presentsGammaRampWithFrame() const override;
 
     DrmBackend *m_backend;
     DrmConnector *m_conn = nullptr;
@@ -182,9 +193,33 @@ private:
         QPoint globalPos;
         bool valid = false;
     } m_lastWorkingState;
-    QScopedPointer<DrmDumbBuffer> m_cursor[2];
-    int m_cursorIndex = 0;
-    bool m_hasNewCursor = false;
+    QSize m_cursorSize;
+    // the buffer which is shown, or will be shown by the next showCursor
+    QSharedPointer<DrmDumbBuffer> m_cursor;
+    struct CursorCacheEntry {
+        QImage image;
+        uint hash;
+        QSharedPointer<DrmDumbBuffer> buffer;
+    };
+    // pre-rendered cursor buffers for the current scale and transform, most recently used first
+    QList<CursorCacheEntry> m_cursorCache;
+    // the buffer set on the cursor plane state, the one committed last and the one committed
+    // before, the kernel reads the latter two until they got replaced
+    QSharedPointer<DrmDumbBuffer> m_cursorPlaneBuffer;
+    QSharedPointer<DrmDumbBuffer> m_cursorPendingBuffer;
+    QSharedPointer<DrmDumbBuffer> m_cursorScanoutBuffer;
+    qreal m_cursorCacheScale = 1;
+    Transform m_cursorCacheTransform = Transform::Normal;
+    // cursor position in the output's native coordinates
+    QPoint m_cursorPos;
+    bool m_cursorVisible = false;
+    // the cursor plane state is not yet committed to the kernel
+    bool m_cursorPlaneDirty = false;
+    // the pending page flip only updates cursor plane or gamma LUT, the compositor does not wait for it
+    bool m_stateOnlyFlip = false;
+    // a frame presented while such a flip was pending, it gets committed once the flip completed
+    DrmBuffer *m_deferredPresent = nullptr;
+    QTimer m_pendingCommitTimer;
     bool m_showCursor = false;
     bool m_hideCursor = false;
     bool m_internal = false;
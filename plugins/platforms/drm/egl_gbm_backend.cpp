@@ -16,6 +16,7 @@
 #include "workspace.h"
 // kwin libs
 #include <kwinglplatform.h>
+#include <kwinglutils.h>
 // Qt
 #include <QOpenGLContext>
 // system
@@ -81,7 +82,6 @@ void EglGbmBackend::cleanupSurfaces()
 
 void EglGbmBackend::cleanupOutput(Output &o)
 {
-    cleanupPostprocess(o);
     o.output->releaseGbm();
 
     if (o.eglSurface != EGL_NO_SURFACE) {
@@ -258,177 +258,12 @@ void EglGbmBackend::initRemotePresent()
     });
 }
 
-void EglGbmBackend::cleanupPostprocess(Output& output)
-{
-    output.rotation.vbo.reset();
-    output.rotation.fbo.reset();
-    output.rotation.texture.reset();
-    qDebug() << "---------" << __func__;
-}
-
-void EglGbmBackend::resetPostprocess(Output& output)
-{
-    cleanupPostprocess(output);
-
-    if (output.output->hardwareTransformed()) {
-        return;
-    }
-
-    makeContextCurrent(output);
-
-    auto sz = output.output->pixelSize();
-    auto* back = new GLTexture(GL_RGB8, sz.width(), sz.height());
-    back->setFilter(GL_LINEAR);
-    back->setWrapMode(GL_CLAMP_TO_EDGE);
-
-    output.rotation.texture.reset(back);
-
-    GLRenderTarget *fbo = new GLRenderTarget(*back);
-    output.rotation.fbo.reset(fbo);
-}
-
-void EglGbmBackend::preparePostprocess(const Output& output) const
-{
-    if (output.rotation.fbo) {
-        GLRenderTarget::pushRenderTarget(output.rotation.fbo.get());
-        GLRenderTarget::setKWinFramebuffer(output.rotation.fbo->id());
-    }
-}
-
-void EglGbmBackend::renderPostprocess(Output& output)
-{
-    if (!output.rotation.fbo) return;
-
-    GLRenderTarget::popRenderTarget();
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    GLRenderTarget::setKWinFramebuffer(0);
-
-    const auto& sz = output.output->modeSize();
-    glViewport(0, 0, sz.width(), sz.height());
-
-    if (!output.rotation.vbo) {
-        const bool gles = GLPlatform::instance()->isGLES();
-        const bool glsl_140 = !gles && GLPlatform::instance()->glslVersion() >= kVersionNumber(1, 40);
-        const bool core = glsl_140 || (gles && GLPlatform::instance()->glslVersion() >= kVersionNumber(3, 0));
-
-        const QByteArray varying_in  = core ? (gles ? "in" : "noperspective in") : "varying";
-        const QByteArray varying_out = core ? (gles ? "out" : "noperspective out") : "varying";
-        const QByteArray attribute = core ? "in"        : "attribute";
-        const QByteArray texture2D = core ? "texture"   : "texture2D";
-        const QByteArray fragColor = core ? "fragColor" : "gl_FragColor";
-
-        QString glHeaderString;
-
-        if (gles) {
-            if (core) {
-                glHeaderString += "#version 300 es\n\n";
-            }
-
-            glHeaderString += "precision highp float;\n";
-        } else if (glsl_140) {
-            glHeaderString += "#version 140\n\n";
-        }
-
-        QByteArray vertexSource;
-        QByteArray fragSource;
-
-        QTextStream streamVert(&vertexSource);
-
-        streamVert << glHeaderString;
-
-        streamVert << "uniform mat4 rotateMatrix;\n";
-        streamVert << attribute << " vec4 vertex;\n\n";
-        streamVert << attribute << " vec4 texcoord;\n\n";
-        streamVert << varying_out << " vec2 texCoord;\n";
-        streamVert << "void main(void)\n";
-        streamVert << "{\n";
-        streamVert << "    gl_Position = vertex;\n";
-        streamVert << "    vec4 t = rotateMatrix * texcoord;\n";
-        streamVert << "    texCoord = t.xy;\n";
-        streamVert << "}\n";
-        streamVert.flush();
-
-        QTextStream streamFrag(&fragSource);
-        streamFrag << glHeaderString;
-
-        streamFrag << "uniform sampler2D texUnit;\n";
-        streamFrag << varying_in << " vec2 texCoord;\n\n";
-        if (core) {
-            streamFrag << "out vec4 fragColor;\n\n";
-        }
-        streamFrag << "void main(void)\n";
-        streamFrag << "{\n";
-        streamFrag << "    " << fragColor << " = " << texture2D << "(texUnit, texCoord);\n";
-        streamFrag << "}\n";
-        streamFrag.flush();
-
-        GLShader* shaderRotate = ShaderManager::instance()->loadShaderFromCode(vertexSource, fragSource);
-        if (!shaderRotate->isValid()) {
-            abort();
-        }
-        output.rotation.shader.reset(shaderRotate);
-
-        GLVertexBuffer *vbo = new GLVertexBuffer(KWin::GLVertexBuffer::Static);
-
-        QVector<float> verts;
-        verts 
-            << 1  << -1
-            << -1 << -1
-            << -1 << 1
-            << -1 << 1
-            << 1 << 1
-            << 1  << -1;
-        QVector<float> texcoords;
-        texcoords
-            << 1.0 << 0.0
-            << 0.0 << 0.0
-            << 0.0 << 1.0
-            << 0.0 << 1.0
-            << 1.0 << 1.0
-            << 1.0 << 0.0;
-        vbo->setData(verts.count()/2, 2, verts.data(), texcoords.data());
-        output.rotation.vbo.reset(vbo);
-        qDebug() << "--------- init vbo";
-    }
-
-#if 1
-    auto* shaderRotate = output.rotation.shader.get();
-    auto rotateLoc = shaderRotate->uniformLocation("rotateMatrix");
-
-    ShaderManager::instance()->pushShader(shaderRotate);
-    QMatrix4x4 m;
-    m.ortho(0, sz.width(), sz.height(), 0, 0, 65535);
-
-    QMatrix4x4 rm;
-    rm.translate(0.5, 0.5);
-    rm.rotate(-output.output->rotation(), 0, 0, 1);
-    rm.translate(-0.5, -0.5);
-
-    shaderRotate->setUniform(rotateLoc, rm);
-#else
-    // use builtin shader
-    auto shader = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
-    QMatrix4x4 rm;
-    rm.rotate(output.output->rotation(), 0, 0, 1);
-    shader->setUniform(GLShader::ModelViewProjectionMatrix, rm);
-#endif
-
-    glActiveTexture(GL_TEXTURE0);
-    output.rotation.texture->bind();
-
-    GLint ss[4];
-    glGetIntegerv(GL_VIEWPORT, ss);
-    output.rotation.vbo->render(GL_TRIANGLES);
-
-    output.rotation.texture->unbind();
-    ShaderManager::instance()->popShader();
-}
-
-
 bool EglGbmBackend::resetOutput(Output &o, DrmOutput *drmOutput)
 {
     o.output = drmOutput;
-    auto size = o.output->hardwareTransformed() ? drmOutput->pixelSize() : drmOutput->modeSize();
+    // without a hardware transform the scene renders rotated, see screenRotation
+    o.rotation = o.output->hardwareTransformed() ? 0 : o.output->rotation();
+    auto size = o.rotation == 0 ? drmOutput->pixelSize() : drmOutput->modeSize();
 
     qDebug() <<"output "<<drmOutput->uuid()<< "size" << size <<"drmOutput->geometry"<< drmOutput->geometry() \
              <<"pixelSize"<<drmOutput->pixelSize()<<"modeSize"<<drmOutput->modeSize();
@@ -474,7 +309,6 @@ bool EglGbmBackend::resetOutput(Output &o, DrmOutput *drmOutput)
         o.gbmSurface = gbmSurface;
     }
 
-    resetPostprocess(o);
     return true;
 }
 
@@ -533,6 +367,12 @@ void EglGbmBackend::createOutput(DrmOutput *drmOutput)
 
 void EglGbmBackend::setupViewport(const Output& output)
 {
+    if (output.rotation != 0) {
+        // the projection matrix maps the output into the whole framebuffer, see SceneOpenGL::paint
+        const QSize &mode = output.output->modeSize();
+        glViewport(0, 0, mode.width(), mode.height());
+        return;
+    }
     // TODO: ensure the viewport is set correctly each time
     const QSize &overall = screens()->size();
     const QRect &v = output.output->geometry();
@@ -626,20 +466,19 @@ void EglGbmBackend::present()
     // Not in use. This backend does per-screen rendering.
 }
 
-static QVector<EGLint> regionToRects(const QRegion &region, AbstractOutput *output)
+/**
+ * Maps @p region into the framebuffer of @p output, with the origin in the bottom left corner
+ * as expected by EGL and the rotation applied by the scene if the output is rotated in software.
+ **/
+static QVector<EGLint> regionToRects(const QRegion &region, DrmOutput *output, int rotation)
 {
-    const int height = output->modeSize().height();
-
-    auto drmOutput = reinterpret_cast<DrmOutput*>(output);
-    const QMatrix4x4 matrix = drmOutput->transformation();
-
     QVector<EGLint> rects;
     rects.reserve(region.rectCount() * 4);
     for (const QRect &_rect : region) {
-        const QRect rect = matrix.mapRect(_rect);
+        const QRect rect = GLRenderTarget::mapToFramebuffer(_rect, output->geometry(), output->scale(), rotation);
 
-        rects << rect.left();
-        rects << height - (rect.y() + rect.height());
+        rects << rect.x();
+        rects << rect.y();
         rects << rect.width();
         rects << rect.height();
     }
@@ -657,7 +496,7 @@ void EglGbmBackend::aboutToStartPainting(const QRegion &damagedRegion)
     if (output.bufferAge > 0 && !damagedRegion.isEmpty() && supportsPartialUpdate()) {
         const QRegion region = damagedRegion & output.output->geometry();
 
-        QVector<EGLint> rects = regionToRects(region, output.output);
+        QVector<EGLint> rects = regionToRects(region, output.output, output.rotation);
         const bool correct = eglSetDamageRegionKHR(eglDisplay(), output.eglSurface,
                                                    rects.data(), rects.count()/4);
         if (!correct) {
@@ -671,7 +510,7 @@ void EglGbmBackend::presentOnOutput(EglGbmBackend::Output &o, const QRegion &dam
     DTRACE_PROBE(EglGbmBackend, presentOnOutput);
 
     if (supportsSwapBuffersWithDamage() && !o.damageHistory.isEmpty()) {
-        QVector<EGLint> rects = regionToRects(o.damageHistory.constFirst(), o.output);
+        QVector<EGLint> rects = regionToRects(o.damageHistory.constFirst(), o.output, o.rotation);
         eglSwapBuffersWithDamageEXT(eglDisplay(), o.eglSurface,
                                     rects.data(), rects.count()/4);
     } else {
@@ -751,7 +590,6 @@ QRegion EglGbmBackend::prepareRenderingForScreen(int screenId)
     const Output &o = m_outputs.at(screenId);
     doneCurrent();
     makeContextCurrent(o);
-    preparePostprocess(o);
     setupViewport(o);
 
     if (supportsBufferAge()) {
@@ -782,7 +620,6 @@ void EglGbmBackend::endRenderingFrameForScreen(int screenId, const QRegion &rend
         return;
     }
     Output &o = m_outputs[screenId];
-    renderPostprocess(o);
 
     if (damagedRegion.intersected(o.output->geometry()).isEmpty() && screenId == 0) {
 
@@ -823,39 +660,32 @@ void EglGbmBackend::endRenderingFrameForScreen(int screenId, const QRegion &rend
 bool EglGbmBackend::setDamageRegion(const QRegion region) {
     int screenId = screens()->renderingIndex();
     const Output &o = m_outputs.at(screenId);
-    if (!supportsBufferAge() || o.rotation.fbo) {
+    if (!supportsBufferAge()) {
         return false;
     }
 
-    if (supportsBufferAge()) {
-        if (eglSetDamageRegionKHR == nullptr) {
-            qCWarning(KWIN_DRM) << "Failed to get eglSetDamageRegionHUAWEI address.";
-            return false;
-        }
-    }
-
-    EGLint *rects;
-    int num = region.rectCount();
-    QRect screenRect = screens()->geometry(screenId);
-    qreal scale = o.output->scale();
-    rects = (EGLint*)malloc(4 * num * sizeof(EGLint));
-    for (int i = 0; i < num; i++) {
-        QRect r = region.begin()[i];
-        rects[4 * i + 0] = (r.x() - screenRect.x()) * scale;
-        rects[4 * i + 1] = (-1 * (r.y() - (screenRect.y() + screenRect.height())) - r.height()) * scale;
-        rects[4 * i + 2] = r.width() * scale;
-        rects[4 * i + 3] = r.height() * scale;
+    if (eglSetDamageRegionKHR == nullptr) {
+        qCWarning(KWIN_DRM) << "Failed to get eglSetDamageRegionHUAWEI address.";
+        return false;
     }
 
-    EGLBoolean isSuccess = eglSetDamageRegionKHR(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), rects, num);
+    QVector<EGLint> rects = regionToRects(region, o.output, o.rotation);
+    EGLBoolean isSuccess = eglSetDamageRegionKHR(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), rects.data(), rects.count() / 4);
     if (!isSuccess) {
         qCWarning(KWIN_DRM) << "Failed to set damage region.";
         return false;
     }
-    free(rects);
     return true;
 }
 
+int EglGbmBackend::screenRotation(int screenId) const
+{
+    if (screenId < 0 || screenId >= m_outputs.size()) {
+        return 0;
+    }
+    return m_outputs.at(screenId).rotation;
+}
+
 bool EglGbmBackend::usesOverlayWindow() const
 {
     return false;
@@ -36,6 +36,7 @@ public:
     void endRenderingFrame(const QRegion &renderedRegion, const QRegion &damagedRegion) override;
     void endRenderingFrameForScreen(int screenId, const QRegion &damage, const QRegion &damagedRegion) override;
     bool setDamageRegion(const QRegion region) override;
+    int screenRotation(int screenId) const override;
     bool usesOverlayWindow() const override;
     bool perScreenRendering() const override;
     QRegion prepareRenderingForScreen(int screenId) override;
@@ -64,13 +65,10 @@ private:
         * @brief The damage history for the past 10 frames.
         */
         QList<QRegion> damageHistory;
-
-        struct {
-            std::shared_ptr<GLTexture> texture;
-            std::shared_ptr<GLVertexBuffer> vbo;
-            std::shared_ptr<GLRenderTarget> fbo;
-            std::shared_ptr<GLShader> shader;
-        } rotation;
+        /**
+        * @brief Rotation in degrees applied by the scene, 0 if the plane rotates in hardware.
+        */
+        int rotation = 0;
 
         /**
         * @brief  Hisilicon libmali platform.
@@ -90,11 +88,6 @@ private:
     void cleanupOutput(Output &output);
     void createOutput(DrmOutput *output);
 
-    void cleanupPostprocess(Output& output);
-    void resetPostprocess(Output& output);
-    void preparePostprocess(const Output& output) const;
-    void renderPostprocess(Output& output);
-
     DrmBackend *m_backend;
     QVector<Output> m_outputs;
     QScopedPointer<RemoteAccessManager> m_remoteaccessManager;
@@ -130,6 +130,8 @@ bool FramebufferBackend::handleScreenInfo()
     m_blue = {varinfo.blue.offset, varinfo.blue.length};
     m_alpha = {varinfo.transp.offset, varinfo.transp.length};
     m_bitsPerPixel = varinfo.bits_per_pixel;
+    m_virtualHeight = varinfo.yres_virtual;
+    m_xOffset = varinfo.xoffset;
     m_bufferLength = fixinfo.smem_len;
     m_bytesPerLine = fixinfo.line_length;
 
@@ -165,6 +167,32 @@ void FramebufferBackend::unmap()
     m_memory = nullptr;
 }
 
+int FramebufferBackend::pageCount() const
+{
+    if (m_resolution.height() <= 0 || m_bytesPerLine <= 0) {
+        return 1;
+    }
+    const quint32 pageLength = m_resolution.height() * m_bytesPerLine;
+    const int pages = qMin(m_virtualHeight / m_resolution.height(), m_bufferLength / pageLength);
+    return qMax(pages, 1);
+}
+
+bool FramebufferBackend::panToPage(int page)
+{
+    if (m_fd < 0 || page < 0 || page >= pageCount()) {
+        return false;
+    }
+    // the driver only looks at the offsets and the vmode
+    fb_var_screeninfo varinfo = {};
+    varinfo.xoffset = m_xOffset;
+    varinfo.yoffset = page * m_resolution.height();
+    if (ioctl(m_fd, FBIOPAN_DISPLAY, &varinfo) < 0) {
+        qCWarning(KWIN_FB) << "Failed to pan frame buffer to page" << page;
+        return false;
+    }
+    return true;
+}
+
 QImage::Format FramebufferBackend::imageFormat() const
 {
     return m_imageFormat;
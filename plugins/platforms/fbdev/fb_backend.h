@@ -64,6 +64,16 @@ public:
     bool isBGR() const {
         return m_bgr;
     }
+    /**
+     * @returns the number of screen sized pages in the mapped memory the display can be panned
+     * to, at least @c 1.
+     **/
+    int pageCount() const;
+    /**
+     * Pans the display to show @p page through FBIOPAN_DISPLAY.
+     * @returns whether the driver accepted the pan
+     **/
+    bool panToPage(int page);
 
     QVector<CompositingType> supportedCompositors() const override {
         return QVector<CompositingType>{QPainterCompositing};
@@ -85,6 +95,8 @@ private:
     Color m_blue;
     Color m_alpha;
     quint32 m_bitsPerPixel = 0;
+    quint32 m_virtualHeight = 0;
+    quint32 m_xOffset = 0;
     int m_fd = -1;
     quint32 m_bufferLength = 0;
     int m_bytesPerLine = 0;
@@ -0,0 +1,97 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "fb_blit.h"
+
+#include <QPainter>
+
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define KWIN_FB_BLIT_NEON
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define KWIN_FB_BLIT_SSSE3
+#endif
+
+namespace KWin
+{
+
+/**
+ * Packs @p count RGB32 pixels into 24 bit pixels with blue in the lowest byte, which on little
+ * endian is dropping every fourth byte. This is the frame buffer layout the BGR flag stands
+ * for, the channel swap of the RGB888 QImage format is never materialized.
+ **/
+static void packRgb32ToBgr24(const uchar *source, uchar *destination, int count)
+{
+    int i = 0;
+#if defined(KWIN_FB_BLIT_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x4_t pixels = vld4q_u8(source + i * 4);
+        uint8x16x3_t packed;
+        packed.val[0] = pixels.val[0];
+        packed.val[1] = pixels.val[1];
+        packed.val[2] = pixels.val[2];
+        vst3q_u8(destination + i * 3, packed);
+    }
+#elif defined(KWIN_FB_BLIT_SSSE3)
+    const __m128i mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    // every store writes 16 bytes for 12 bytes of pixels, the excess gets overwritten by the
+    // next iteration, so stop while at least two more pixels follow
+    for (; i + 6 <= count; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 3), _mm_shuffle_epi8(pixels, mask));
+    }
+#endif
+    for (; i < count; ++i) {
+        destination[i * 3] = source[i * 4];
+        destination[i * 3 + 1] = source[i * 4 + 1];
+        destination[i * 3 + 2] = source[i * 4 + 2];
+    }
+}
+
+void blitToFramebuffer(const QImage &source, QImage *target, const QRegion &region, bool bgr)
+{
+    const QRegion clipped = region & source.rect() & target->rect();
+    if (clipped.isEmpty()) {
+        return;
+    }
+    const bool rgb32Source = source.format() == QImage::Format_RGB32 || source.format() == QImage::Format_ARGB32_Premultiplied;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const bool packBgr = bgr && rgb32Source && target->format() == QImage::Format_RGB888;
+#else
+    const bool packBgr = false;
+#endif
+    const bool copyRgb32 = !bgr && rgb32Source && target->format() == QImage::Format_RGB32;
+
+    if (packBgr || copyRgb32) {
+        const uchar *sourceBits = source.constBits();
+        uchar *targetBits = target->bits();
+        for (const QRect &rect : clipped) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                const uchar *sourceLine = sourceBits + y * source.bytesPerLine() + rect.x() * 4;
+                if (packBgr) {
+                    packRgb32ToBgr24(sourceLine, targetBits + y * target->bytesPerLine() + rect.x() * 3, rect.width());
+                } else {
+                    std::memcpy(targetBits + y * target->bytesPerLine() + rect.x() * 4, sourceLine, rect.width() * 4);
+                }
+            }
+        }
+        return;
+    }
+
+    QPainter p(target);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    for (const QRect &rect : clipped) {
+        if (bgr) {
+            p.drawImage(rect.topLeft(), source.copy(rect).rgbSwapped());
+        } else {
+            p.drawImage(rect.topLeft(), source, rect);
+        }
+    }
+}
+
+}
@@ -0,0 +1,28 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_FB_BLIT_H
+#define KWIN_FB_BLIT_H
+
+#include <QImage>
+#include <QRegion>
+
+namespace KWin
+{
+
+/**
+ * Copies @p region of @p source into @p target, which usually wraps the mapped frame buffer.
+ *
+ * Only the rows and columns covered by @p region are touched. If @p bgr is @c true the red and
+ * blue channels are swapped while copying instead of converting a swapped copy of the whole
+ * image first. The common cases of a RGB32 source into a RGB32 target or into a BGR packed
+ * 24 bit target are copied directly, using SIMD where available; other formats go through
+ * QPainter for each rectangle of @p region.
+ **/
+void blitToFramebuffer(const QImage &source, QImage *target, const QRegion &region, bool bgr);
+
+}
+
+#endif
@@ -6,12 +6,12 @@
 
 #include "scene_qpainter_fb_backend.h"
 #include "fb_backend.h"
+#include "fb_blit.h"
 #include "composite.h"
 #include "logind.h"
 #include "cursor.h"
+#include "logging.h"
 #include "virtual_terminal.h"
-// Qt
-#include <QPainter>
 
 namespace KWin
 {
@@ -25,12 +25,20 @@ FramebufferQPainterBackend::FramebufferQPainterBackend(FramebufferBackend *backe
 
     m_backend->map();
 
-    m_backBuffer = QImage((uchar*)backend->mappedMemory(),
-                          backend->bytesPerLine() / (backend->bitsPerPixel() / 8),
-                          backend->bufferSize() / backend->bytesPerLine(),
-                          backend->bytesPerLine(), backend->imageFormat());
-
-    m_backBuffer.fill(Qt::black);
+    int pageCount = 1;
+    if (backend->pageCount() >= 2 && qgetenv("KWIN_FB_DOUBLE_BUFFER") != QByteArrayLiteral("0")
+            && backend->panToPage(0)) {
+        pageCount = 2;
+    }
+    const int pageLength = backend->size().height() * backend->bytesPerLine();
+    for (int i = 0; i < pageCount; ++i) {
+        QImage page((uchar*)backend->mappedMemory() + i * pageLength,
+                    backend->size().width(), backend->size().height(),
+                    backend->bytesPerLine(), backend->imageFormat());
+        page.fill(Qt::black);
+        m_pages << page;
+    }
+    qCDebug(KWIN_FB) << "Presenting with" << pageCount << "frame buffer pages";
     connect(VirtualTerminal::self(), &VirtualTerminal::activeChanged, this,
         [this] (bool active) {
             if (active) {
@@ -62,12 +70,26 @@ void FramebufferQPainterBackend::prepareRenderingFrame()
 void FramebufferQPainterBackend::present(int mask, const QRegion &damage)
 {
     Q_UNUSED(mask)
-    Q_UNUSED(damage)
     if (!LogindIntegration::self()->isActiveSession()) {
         return;
     }
-    QPainter p(&m_backBuffer);
-    p.drawImage(QPoint(0, 0), m_backend->isBGR() ? m_renderBuffer.rgbSwapped() : m_renderBuffer);
+    if (m_pages.count() == 1) {
+        blitToFramebuffer(m_renderBuffer, &m_pages[0], damage, m_backend->isBGR());
+        return;
+    }
+    // the back page last got updated two frames ago, so it misses the previous damage as well
+    const int backPage = (m_currentPage + 1) % m_pages.count();
+    blitToFramebuffer(m_renderBuffer, &m_pages[backPage], damage | m_previousDamage, m_backend->isBGR());
+    m_previousDamage = damage;
+    if (m_backend->panToPage(backPage)) {
+        m_currentPage = backPage;
+        return;
+    }
+    // the driver stopped panning, continue with the page which is still shown
+    m_pages.removeAt(backPage);
+    m_currentPage = 0;
+    m_previousDamage = QRegion();
+    blitToFramebuffer(m_renderBuffer, &m_pages[0], m_renderBuffer.rect(), m_backend->isBGR());
 }
 
 bool FramebufferQPainterBackend::usesOverlayWindow() const
@@ -10,6 +10,8 @@
 
 #include <QObject>
 #include <QImage>
+#include <QRegion>
+#include <QVector>
 
 namespace KWin
 {
@@ -30,7 +32,16 @@ public:
 
 private:
     QImage m_renderBuffer;
-    QImage m_backBuffer;
+    /**
+     * One image per page of the mapped frame buffer, with double buffering the display is
+     * panned between the two pages, otherwise there is only one page.
+     **/
+    QVector<QImage> m_pages;
+    int m_currentPage = 0;
+    /**
+     * Damage of the previous frame, which the back page has not seen yet.
+     **/
+    QRegion m_previousDamage;
     FramebufferBackend *m_backend;
 };
 
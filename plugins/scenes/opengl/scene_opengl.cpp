@@ -63,8 +63,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
 #include <QDBusInterface>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QGraphicsScale>
 #include <QStringList>
+#include <QVarLengthArray>
 #include <QVector2D>
 #include <QVector4D>
 #include <QMatrix4x4>
@@ -655,10 +658,30 @@ void SceneOpenGL::aboutToStartPainting(const QRegion &damage)
     m_backend->aboutToStartPainting(damage);
 }
 
+/**
+ * Creates the clip space transformation mapping the screen @p geometry out of the
+ * complete virtual screen of @p size into the whole framebuffer, rotated counter-clockwise
+ * by @p rotation degrees.
+ **/
+static QMatrix4x4 rotatedOutputTransformation(const QRect &geometry, const QSize &size, int rotation)
+{
+    const qreal sx = size.width() / qreal(geometry.width());
+    const qreal sy = size.height() / qreal(geometry.height());
+
+    QMatrix4x4 matrix;
+    matrix.rotate(rotation, 0, 0, 1);
+    matrix.translate(sx - 1 - 2.0 * geometry.x() / geometry.width(),
+                     1 - sy + 2.0 * geometry.y() / geometry.height());
+    matrix.scale(sx, sy);
+    return matrix;
+}
+
 qint64 SceneOpenGL::paint(QRegion damage, ToplevelList toplevels)
 {
     // actually paint the frame, flushed with the NEXT frame
     createStackingOrder(toplevels);
+    m_frameCounters = FrameCounters();
+    const quint64 drawCalls = GLVertexBuffer::drawCallCount();
     m_backend->doneCurrent();
 
     // After this call, updateRegion will contain the damaged region in the
@@ -691,6 +714,17 @@ qint64 SceneOpenGL::paint(QRegion damage, ToplevelList toplevels)
             GLVertexBuffer::setVirtualScreenScale(screens()->scale(i));
             GLRenderTarget::setVirtualScreenScale(screens()->scale(i));
 
+            // outputs which cannot rotate in hardware get the rotation through the
+            // projection, this keeps them single pass and partial repaints working
+            const int rotation = m_backend->screenRotation(i);
+            GLVertexBuffer::setVirtualScreenRotation(rotation);
+            GLRenderTarget::setVirtualScreenRotation(rotation);
+            if (rotation != 0) {
+                m_outputTransformation = rotatedOutputTransformation(geo, screens()->size(), rotation);
+            } else {
+                m_outputTransformation.setToIdentity();
+            }
+
             const GLenum status = glGetGraphicsResetStatus();
             if (status != GL_NO_ERROR) {
                 handleGraphicsReset(status);
@@ -721,6 +755,9 @@ qint64 SceneOpenGL::paint(QRegion damage, ToplevelList toplevels)
         GLRenderTarget::setVirtualScreenGeometry(screens()->geometry());
         GLVertexBuffer::setVirtualScreenScale(1);
         GLRenderTarget::setVirtualScreenScale(1);
+        GLVertexBuffer::setVirtualScreenRotation(0);
+        GLRenderTarget::setVirtualScreenRotation(0);
+        m_outputTransformation.setToIdentity();
 
         int mask = 0;
         updateProjectionMatrix();
@@ -758,6 +795,9 @@ qint64 SceneOpenGL::paint(QRegion damage, ToplevelList toplevels)
         m_currentFence = nullptr;
     }
 
+    m_frameCounters.drawCalls = int(GLVertexBuffer::drawCallCount() - drawCalls);
+    m_lastFrameCounters = m_frameCounters;
+
     // do cleanup
     clearStackingOrder();
     return m_backend->renderTime();
@@ -950,6 +990,182 @@ bool SceneOpenGL2::supported(OpenGLBackend *backend)
     return true;
 }
 
+/**
+ * Offscreen renderings of the desktops shown by desktop thumbnail items.
+ *
+ * Painting a desktop thumbnail means painting the whole desktop, for a pager showing all
+ * desktops that is one full scene per desktop and frame. Instead every desktop gets rendered
+ * into a texture of the size of the thumbnail, which is only rendered again after a window
+ * on that desktop changed.
+ **/
+class DesktopThumbnailCache
+{
+public:
+    struct Entry {
+        int desktop;
+        QScopedPointer<GLTexture> texture;
+        QScopedPointer<GLRenderTarget> renderTarget;
+        bool dirty = true;
+        QElapsedTimer lastUsed;
+    };
+
+    DesktopThumbnailCache(QObject *context);
+    ~DesktopThumbnailCache();
+
+    /**
+     * @returns the entry for @p desktop with a texture of at least @p size, or @c nullptr if the
+     * texture could not be created. There is one entry per desktop, its texture only gets
+     * created again if the size leaves its bucket, not on every step of a resize animation.
+     **/
+    Entry *entry(int desktop, const QSize &size);
+    /**
+     * @returns whether any entry was not used for a while.
+     **/
+    bool hasExpiredEntries() const;
+    /**
+     * Releases the entries which were not used for a while. Needs a current context.
+     **/
+    void purgeExpired();
+
+private:
+    void invalidate(EffectWindow *window);
+    void invalidateDesktop(int desktop);
+    void invalidateAll();
+    QHash<int, Entry*> m_entries;
+    QVector<QMetaObject::Connection> m_connections;
+};
+
+// milliseconds after which an unused thumbnail texture gets released
+static const qint64 s_desktopThumbnailExpiry = 5000;
+// thumbnail textures are sized in steps of this many pixels
+static const int s_desktopThumbnailBucket = 64;
+
+static QSize desktopThumbnailBucket(const QSize &size)
+{
+    auto roundUp = [] (int value) {
+        return (value + s_desktopThumbnailBucket - 1) / s_desktopThumbnailBucket * s_desktopThumbnailBucket;
+    };
+    return QSize(roundUp(size.width()), roundUp(size.height()));
+}
+
+DesktopThumbnailCache::DesktopThumbnailCache(QObject *context)
+{
+    auto windowChanged = [this] (EffectWindow *window) {
+        invalidate(window);
+    };
+    m_connections << QObject::connect(effects, &EffectsHandler::windowDamaged, context, windowChanged);
+    m_connections << QObject::connect(effects, &EffectsHandler::windowGeometryShapeChanged, context, windowChanged);
+    m_connections << QObject::connect(effects, &EffectsHandler::windowOpacityChanged, context, windowChanged);
+    m_connections << QObject::connect(effects, &EffectsHandler::windowAdded, context, windowChanged);
+    m_connections << QObject::connect(effects, &EffectsHandler::windowClosed, context, windowChanged);
+    m_connections << QObject::connect(effects, &EffectsHandler::windowDeleted, context, windowChanged);
+    m_connections << QObject::connect(effects, &EffectsHandler::windowMinimized, context, windowChanged);
+    m_connections << QObject::connect(effects, &EffectsHandler::windowUnminimized, context, windowChanged);
+    m_connections << QObject::connect(effects, &EffectsHandler::desktopPresenceChanged, context,
+        [this] (EffectWindow *window, int oldDesktop) {
+            invalidateDesktop(oldDesktop);
+            invalidate(window);
+        }
+    );
+    m_connections << QObject::connect(effects, &EffectsHandler::stackingOrderChanged, context,
+        [this] {
+            invalidateAll();
+        }
+    );
+    m_connections << QObject::connect(screens(), &Screens::changed, context,
+        [this] {
+            invalidateAll();
+        }
+    );
+}
+
+DesktopThumbnailCache::~DesktopThumbnailCache()
+{
+    for (const QMetaObject::Connection &connection : qAsConst(m_connections)) {
+        QObject::disconnect(connection);
+    }
+    qDeleteAll(m_entries);
+}
+
+DesktopThumbnailCache::Entry *DesktopThumbnailCache::entry(int desktop, const QSize &size)
+{
+    const QSize bucket = desktopThumbnailBucket(size);
+    Entry *entry = m_entries.value(desktop);
+    if (entry) {
+        const QSize current = entry->texture->size();
+        // grow into the next bucket, shrink only once the texture is far too large
+        const bool grows = bucket.width() > current.width() || bucket.height() > current.height();
+        const bool shrinks = bucket.width() * 2 <= current.width() && bucket.height() * 2 <= current.height();
+        if (grows || shrinks) {
+            delete m_entries.take(desktop);
+            entry = nullptr;
+        }
+    }
+    if (!entry) {
+        QScopedPointer<Entry> created(new Entry);
+        created->desktop = desktop;
+        created->texture.reset(new GLTexture(GL_RGBA8, bucket));
+        created->texture->setFilter(GL_LINEAR);
+        created->texture->setWrapMode(GL_CLAMP_TO_EDGE);
+        created->texture->setYInverted(false);
+        created->renderTarget.reset(new GLRenderTarget(*created->texture));
+        if (!created->renderTarget->valid()) {
+            return nullptr;
+        }
+        entry = created.take();
+        m_entries.insert(desktop, entry);
+    }
+    entry->lastUsed.start();
+    return entry;
+}
+
+bool DesktopThumbnailCache::hasExpiredEntries() const
+{
+    for (const Entry *entry : m_entries) {
+        if (entry->lastUsed.hasExpired(s_desktopThumbnailExpiry)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DesktopThumbnailCache::purgeExpired()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it.value()->lastUsed.hasExpired(s_desktopThumbnailExpiry)) {
+            delete it.value();
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DesktopThumbnailCache::invalidate(EffectWindow *window)
+{
+    for (Entry *entry : qAsConst(m_entries)) {
+        if (window->isOnDesktop(entry->desktop)) {
+            entry->dirty = true;
+        }
+    }
+}
+
+void DesktopThumbnailCache::invalidateDesktop(int desktop)
+{
+    for (Entry *entry : qAsConst(m_entries)) {
+        if (entry->desktop == desktop) {
+            entry->dirty = true;
+        }
+    }
+}
+
+void DesktopThumbnailCache::invalidateAll()
+{
+    for (Entry *entry : qAsConst(m_entries)) {
+        entry->dirty = true;
+    }
+}
+
 SceneOpenGL2::SceneOpenGL2(OpenGLBackend *backend, QObject *parent)
     : SceneOpenGL(backend, parent)
     , m_lanczosFilter(NULL)
@@ -994,6 +1210,84 @@ SceneOpenGL2::SceneOpenGL2(OpenGLBackend *backend, QObject *parent)
     init_ok = true;
 }
 
+void SceneOpenGL2::paintDesktopThumbnail(int desktop, const QRectF &rect, const QRegion &clip)
+{
+    const QRect target(qRound(rect.x()), qRound(rect.y()), qRound(rect.width()), qRound(rect.height()));
+    if (target.isEmpty() || !GLRenderTarget::supported()) {
+        Scene::paintDesktopThumbnail(desktop, rect, clip);
+        return;
+    }
+    if (!m_desktopThumbnails) {
+        m_desktopThumbnails.reset(new DesktopThumbnailCache(this));
+    }
+    DesktopThumbnailCache::Entry *entry = m_desktopThumbnails->entry(desktop, target.size());
+    if (!entry) {
+        Scene::paintDesktopThumbnail(desktop, rect, clip);
+        return;
+    }
+    if (entry->dirty) {
+        renderDesktopThumbnail(desktop, entry->renderTarget.data(), entry->texture->size());
+        entry->dirty = false;
+    }
+
+    GLTexture *texture = entry->texture.data();
+    texture->bind();
+    glEnable(GL_SCISSOR_TEST);
+    ShaderBinder binder(ShaderTrait::MapTexture);
+    QMatrix4x4 mvp = m_screenProjectionMatrix;
+    mvp.translate(target.x(), target.y());
+    binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+    texture->render(clip, target, true);
+    glDisable(GL_SCISSOR_TEST);
+    texture->unbind();
+}
+
+void SceneOpenGL2::renderDesktopThumbnail(int desktop, GLRenderTarget *target, const QSize &textureSize)
+{
+    // the render target spans the whole screen, so paint the desktop untransformed and without
+    // the transformation of the output currently being rendered
+    const QMatrix4x4 projectionMatrix = m_projectionMatrix;
+    const QMatrix4x4 screenProjectionMatrix = m_screenProjectionMatrix;
+    const bool scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    m_projectionMatrix = createProjectionMatrix();
+
+    // the texture is sized to a bucket, the desktop gets stretched to it and back when painted
+    const QRect screenGeometry(QPoint(0, 0), screens()->size());
+    const QRect virtualScreenGeometry = GLRenderTarget::virtualScreenGeometry();
+    const qreal virtualScreenScale = GLRenderTarget::virtualScreenScale();
+    const int virtualScreenRotation = GLRenderTarget::virtualScreenRotation();
+    // scissor rects get scaled by one factor, the larger one keeps them covering the texture
+    const qreal scale = qMax(qreal(textureSize.width()) / screenGeometry.width(),
+                             qreal(textureSize.height()) / screenGeometry.height());
+    GLVertexBuffer::setVirtualScreenGeometry(screenGeometry);
+    GLRenderTarget::setVirtualScreenGeometry(screenGeometry);
+    GLVertexBuffer::setVirtualScreenScale(scale);
+    GLRenderTarget::setVirtualScreenScale(scale);
+    GLVertexBuffer::setVirtualScreenRotation(0);
+    GLRenderTarget::setVirtualScreenRotation(0);
+
+    GLRenderTarget::pushRenderTarget(target);
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ScreenPaintData data;
+    const int desktopMask = PAINT_SCREEN_TRANSFORMED | PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_BACKGROUND_FIRST;
+    Scene::paintDesktop(desktop, desktopMask, QRegion(screenGeometry), data);
+    GLRenderTarget::popRenderTarget();
+
+    GLVertexBuffer::setVirtualScreenGeometry(virtualScreenGeometry);
+    GLRenderTarget::setVirtualScreenGeometry(virtualScreenGeometry);
+    GLVertexBuffer::setVirtualScreenScale(virtualScreenScale);
+    GLRenderTarget::setVirtualScreenScale(virtualScreenScale);
+    GLVertexBuffer::setVirtualScreenRotation(virtualScreenRotation);
+    GLRenderTarget::setVirtualScreenRotation(virtualScreenRotation);
+    m_projectionMatrix = projectionMatrix;
+    m_screenProjectionMatrix = screenProjectionMatrix;
+    if (scissor) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+}
+
 QMatrix4x4 SceneOpenGL2::createProjectionMatrix() const
 {
     // Create a perspective projection with a 60° field-of-view,
@@ -1028,7 +1322,7 @@ QMatrix4x4 SceneOpenGL2::createProjectionMatrix() const
 
 void SceneOpenGL2::updateProjectionMatrix()
 {
-    m_projectionMatrix = createProjectionMatrix();
+    m_projectionMatrix = m_outputTransformation * createProjectionMatrix();
 }
 
 void SceneOpenGL2::paintSimpleScreen(int mask, QRegion region)
@@ -1072,6 +1366,8 @@ void SceneOpenGL2::finalDrawWindow(EffectWindowImpl* w, int mask, QRegion region
     if (waylandServer() && waylandServer()->isScreenLocked() && !w->window()->isLockScreen() && !w->window()->isInputMethod()) {
         return;
     }
+    m_frameCounters.windows++;
+    setVisibleInFrame(w->window());
     performPaintWindow(w, mask, region, data);
 }
 
@@ -1151,6 +1447,34 @@ QMatrix4x4 SceneOpenGL::Window::transformation(int mask, const WindowPaintData &
     return matrix;
 }
 
+/**
+ * @returns @p quads cut down to @p region, given in window coordinates.
+ **/
+static WindowQuadList clipQuads(const WindowQuadList &quads, const QRegion &region)
+{
+    WindowQuadList clipped;
+    clipped.reserve(quads.count());
+
+    // split all quads in bounding rect with the actual rects in the region
+    foreach (const WindowQuad &quad, quads) {
+        for (const QRect &r : region) {
+            const QRectF rf(r);
+            const QRectF quadRect(QPointF(quad.left(), quad.top()), QPointF(quad.right(), quad.bottom()));
+            const QRectF &intersected = rf.intersected(quadRect);
+            if (intersected.isValid()) {
+                if (quadRect == intersected) {
+                    // case 1: completely contains, include and do not check other rects
+                    clipped << quad;
+                    break;
+                }
+                // case 2: intersection
+                clipped << quad.makeSubQuad(intersected.left(), intersected.top(), intersected.right(), intersected.bottom());
+            }
+        }
+    }
+    return clipped;
+}
+
 bool SceneOpenGL::Window::beginRenderWindow(int mask, const QRegion &region, WindowPaintData &data)
 {
     if (region.isEmpty())
@@ -1158,28 +1482,7 @@ bool SceneOpenGL::Window::beginRenderWindow(int mask, const QRegion &region, Win
 
     m_hardwareClipping = region != infiniteRegion() && (mask & PAINT_WINDOW_TRANSFORMED) && !(mask & PAINT_SCREEN_TRANSFORMED);
     if (region != infiniteRegion() && !m_hardwareClipping) {
-        WindowQuadList quads;
-        quads.reserve(data.quads.count());
-
-        const QRegion filterRegion = region.translated(-x(), -y());
-        // split all quads in bounding rect with the actual rects in the region
-        foreach (const WindowQuad &quad, data.quads) {
-            for (const QRect &r : filterRegion) {
-                const QRectF rf(r);
-                const QRectF quadRect(QPointF(quad.left(), quad.top()), QPointF(quad.right(), quad.bottom()));
-                const QRectF &intersected = rf.intersected(quadRect);
-                if (intersected.isValid()) {
-                    if (quadRect == intersected) {
-                        // case 1: completely contains, include and do not check other rects
-                        quads << quad;
-                        break;
-                    }
-                    // case 2: intersection
-                    quads << quad.makeSubQuad(intersected.left(), intersected.top(), intersected.right(), intersected.bottom());
-                }
-            }
-        }
-        data.quads = quads;
+        data.quads = clipQuads(data.quads, region.translated(-x(), -y()));
     }
 
     if (data.quads.isEmpty())
@@ -1344,32 +1647,35 @@ QMatrix4x4 SceneOpenGL2Window::modelViewProjectionMatrix(int mask, const WindowP
     return scene->projectionMatrix() * mvMatrix;
 }
 
-void SceneOpenGL2Window::renderSubSurface(GLShader *shader, const QMatrix4x4 &mvp, const QMatrix4x4 &windowMatrix, OpenGLWindowPixmap *pixmap, const QRegion &region, bool hardwareClipping)
+void SceneOpenGL2Window::addSubSurfaceQuads(const QVector<WindowPixmap*> &children, const QPoint &offset, QVector<OpenGLWindowPixmap*> &pixmaps, QVector<WindowQuadList> &quads) const
 {
-    QMatrix4x4 newWindowMatrix = windowMatrix;
-    newWindowMatrix.translate(pixmap->subSurface()->position().x(), pixmap->subSurface()->position().y());
-
-    qreal scale = 1.0;
-    if (pixmap->surface()) {
-        scale = pixmap->surface()->scale();
-    }
+    for (auto child : children) {
+        if (child->subSurface().isNull() || child->subSurface()->surface().isNull() || !child->subSurface()->surface()->isMapped()) {
+            continue;
+        }
+        auto pixmap = static_cast<OpenGLWindowPixmap*>(child);
+        const QPoint position = offset + pixmap->subSurface()->position();
 
-    if (!pixmap->texture()->isNull()) {
-        setBlendEnabled(pixmap->buffer() && pixmap->buffer()->hasAlphaChannel());
-        // render this texture
-        shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp * newWindowMatrix);
         auto texture = pixmap->texture();
-        texture->bind();
-        texture->render(region, QRect(0, 0, texture->width() / scale, texture->height() / scale), hardwareClipping);
-        texture->unbind();
-    }
-
-    const auto &children = pixmap->children();
-    for (auto pixmap : children) {
-        if (pixmap->subSurface().isNull() || pixmap->subSurface()->surface().isNull() || !pixmap->subSurface()->surface()->isMapped()) {
-            continue;
+        if (!texture->isNull()) {
+            qreal scale = 1.0;
+            if (pixmap->surface()) {
+                scale = pixmap->surface()->scale();
+            }
+            const QRectF rect(position, QSizeF(texture->width() / scale, texture->height() / scale));
+            WindowQuad quad(WindowQuadContents);
+            quad[0] = WindowVertex(rect.x(), rect.y(), 0, 0);
+            quad[1] = WindowVertex(rect.x() + rect.width(), rect.y(), texture->width(), 0);
+            quad[2] = WindowVertex(rect.x() + rect.width(), rect.y() + rect.height(), texture->width(), texture->height());
+            quad[3] = WindowVertex(rect.x(), rect.y() + rect.height(), 0, texture->height());
+
+            WindowQuadList list;
+            list.append(quad);
+            pixmaps.append(pixmap);
+            quads.append(list);
         }
-        renderSubSurface(shader, mvp, newWindowMatrix, static_cast<OpenGLWindowPixmap*>(pixmap), region, hardwareClipping);
+
+        addSubSurfaceQuads(pixmap->children(), position, pixmaps, quads);
     }
 }
 
@@ -1447,30 +1753,65 @@ void SceneOpenGL2Window::performPaint(int mask, QRegion region, WindowPaintData
         }
     }
 
+    // The sub-surfaces go into the same vertex upload as the window and share its shader and
+    // matrix, so each of them only costs the texture bind and its draw call.
+    // Batching stops at the window: effects paint between the windows and may read back what
+    // is below them, so the draws of several windows cannot be deferred into one upload.
+    QVector<OpenGLWindowPixmap*> subSurfaces;
+    QVector<WindowQuadList> subSurfaceQuads;
+    if (auto wp = windowPixmap<OpenGLWindowPixmap>()) {
+        addSubSurfaceQuads(wp->children(), toplevel->clientPos(), subSurfaces, subSurfaceQuads);
+        if (region != infiniteRegion() && !m_hardwareClipping) {
+            const QRegion filterRegion = region.translated(-x(), -y());
+            for (WindowQuadList &list : subSurfaceQuads) {
+                list = clipQuads(list, filterRegion);
+            }
+        }
+    }
+
+    const int nodeCount = LeafCount + subSurfaces.count();
+    QVarLengthArray<const WindowQuadList *, LeafCount + 4> nodeQuads(nodeCount);
+    QVarLengthArray<LeafNode, LeafCount + 4> nodes(nodeCount);
+    setupLeafNodes(nodes.data(), quads, data);
+
+    int quadCount = 0;
+    for (int i = 0; i < LeafCount; i++) {
+        nodeQuads[i] = &quads[i];
+    }
+    for (int i = 0; i < subSurfaces.count(); i++) {
+        OpenGLWindowPixmap *pixmap = subSurfaces.at(i);
+        LeafNode &node = nodes[LeafCount + i];
+        node.texture = pixmap->texture();
+        node.hasAlpha = pixmap->buffer() && pixmap->buffer()->hasAlphaChannel();
+        node.opacity = nodes[ContentLeaf].opacity;
+        node.coordinateType = UnnormalizedCoordinates;
+        nodeQuads[LeafCount + i] = &subSurfaceQuads.at(i);
+    }
+    for (int i = 0; i < nodeCount; i++) {
+        quadCount += nodeQuads[i]->count();
+    }
+
     const bool indexedQuads = GLVertexBuffer::supportsIndexedQuads();
     const GLenum primitiveType = indexedQuads ? GL_QUADS : GL_TRIANGLES;
     const int verticesPerQuad = indexedQuads ? 4 : 6;
 
-    const size_t size = verticesPerQuad *
-        (quads[0].count() + quads[1].count() + quads[2].count() + quads[3].count()) * sizeof(GLVertex2D);
+    const size_t size = verticesPerQuad * quadCount * sizeof(GLVertex2D);
 
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
     GLVertex2D *map = (GLVertex2D *) vbo->map(size);
 
-    LeafNode nodes[LeafCount];
-    setupLeafNodes(nodes, quads, data);
-
-    for (int i = 0, v = 0; i < LeafCount; i++) {
-        if (quads[i].isEmpty() || !nodes[i].texture)
+    for (int i = 0, v = 0; i < nodeCount; i++) {
+        const WindowQuadList &nodeList = *nodeQuads[i];
+        if (nodeList.isEmpty() || !nodes[i].texture)
             continue;
 
         nodes[i].firstVertex = v;
-        nodes[i].vertexCount = quads[i].count() * verticesPerQuad;
+        nodes[i].vertexCount = nodeList.count() * verticesPerQuad;
 
         const QMatrix4x4 matrix = nodes[i].texture->matrix(nodes[i].coordinateType);
 
-        quads[i].makeInterleavedArrays(primitiveType, &map[v], matrix);
-        v += quads[i].count() * verticesPerQuad;
+        nodeList.makeInterleavedArrays(primitiveType, &map[v], matrix);
+        v += nodeList.count() * verticesPerQuad;
     }
 
     vbo->unmap();
@@ -1481,7 +1822,7 @@ void SceneOpenGL2Window::performPaint(int mask, QRegion region, WindowPaintData
 
     float opacity = -1.0;
 
-    for (int i = 0; i < LeafCount; i++) {
+    for (int i = 0; i < nodeCount; i++) {
         if (nodes[i].vertexCount == 0)
             continue;
 
@@ -1502,17 +1843,6 @@ void SceneOpenGL2Window::performPaint(int mask, QRegion region, WindowPaintData
 
     vbo->unbindArrays();
 
-    // render sub-surfaces
-    auto wp = windowPixmap<OpenGLWindowPixmap>();
-    const auto &children = wp ? wp->children() : QVector<WindowPixmap*>();
-    windowMatrix.translate(toplevel->clientPos().x(), toplevel->clientPos().y());
-    for (auto pixmap : children) {
-        if (pixmap->subSurface().isNull() || pixmap->subSurface()->surface().isNull() || !pixmap->subSurface()->surface()->isMapped()) {
-            continue;
-        }
-        renderSubSurface(shader, modelViewProjection, windowMatrix, static_cast<OpenGLWindowPixmap*>(pixmap), region, m_hardwareClipping);
-    }
-
     setBlendEnabled(false);
 
     if (!data.shader)
@@ -1530,10 +1860,15 @@ QSharedPointer<GLTexture> SceneOpenGL2Window::windowTexture()
     } else {
         auto effectWindow = window()->effectWindow();
         QRect geo(pos(), window()->clientSize());
-        QSharedPointer<GLTexture> texture(new GLTexture(GL_RGBA8, geo.size()));
-
-        QScopedPointer<GLRenderTarget> framebuffer(new KWin::GLRenderTarget(*texture));
-        GLRenderTarget::pushRenderTarget(framebuffer.data());
+        if (!m_windowTexture || m_windowTexture->size() != geo.size()) {
+            m_windowRenderTarget.reset();
+            m_windowTexture.reset(new GLTexture(GL_RGBA8, geo.size()));
+            m_windowRenderTarget.reset(new GLRenderTarget(*m_windowTexture));
+        }
+        GLRenderTarget::pushRenderTarget(m_windowRenderTarget.data());
+        // the previous frame is still in the texture, translucent parts must not show it
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
 
         auto renderVSG = GLRenderTarget::virtualScreenGeometry();
         GLVertexBuffer::setVirtualScreenGeometry(geo);
@@ -1555,10 +1890,16 @@ QSharedPointer<GLTexture> SceneOpenGL2Window::windowTexture()
         GLRenderTarget::popRenderTarget();
         GLVertexBuffer::setVirtualScreenGeometry(renderVSG);
         GLRenderTarget::setVirtualScreenGeometry(renderVSG);
-        return texture;
+        return m_windowTexture;
     }
 }
 
+void SceneOpenGL2Window::releaseWindowTexture()
+{
+    m_windowRenderTarget.reset();
+    m_windowTexture.reset();
+}
+
 
 //****************************************
 // OpenGLWindowPixmap
@@ -2132,6 +2473,17 @@ void DecorationShadowTextureCache::clear()
     m_cache.clear();
 }
 
+qint64 SceneOpenGL2::paint(QRegion damage, ToplevelList toplevels)
+{
+    const qint64 renderTime = SceneOpenGL::paint(damage, toplevels);
+    if (m_desktopThumbnails && m_desktopThumbnails->hasExpiredEntries()) {
+        // thumbnails which were not painted for a while get released once the frame is done
+        makeOpenGLContextCurrent();
+        m_desktopThumbnails->purgeExpired();
+    }
+    return renderTime;
+}
+
 SceneOpenGL2::~SceneOpenGL2()
 {
     if (m_lanczosFilter) {
@@ -2139,6 +2491,10 @@ SceneOpenGL2::~SceneOpenGL2()
         delete m_lanczosFilter;
         m_lanczosFilter = nullptr;
     }
+    if (m_desktopThumbnails) {
+        makeOpenGLContextCurrent();
+        m_desktopThumbnails.reset();
+    }
     // SceneOpenGL2 被销毁时（可能发生在切换为2D模式）应该清理窗口阴影的材质缓存，否则在多次切换3D/2D后会导致窗口阴影绘制出现异常
     DecorationShadowTextureCache::instance().clear();
 }
@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace KWin
 {
+class DesktopThumbnailCache;
 class LanczosFilter;
 class OpenGLBackend;
 class SyncManager;
@@ -83,6 +84,9 @@ public:
     QVector<QByteArray> openGLPlatformInterfaceExtensions() const override;
     bool setDamageRegion(QRegion region) override;
     QSharedPointer<GLTexture> textureForOutput(AbstractOutput *output) const override;
+    FrameCounters frameCounters() const override {
+        return m_lastFrameCounters;
+    }
 
     static SceneOpenGL *createScene(QObject *parent);
 
@@ -101,6 +105,15 @@ protected:
 
 protected:
     bool init_ok;
+    /**
+     * Clip space transformation of the screen currently being rendered, applied on top
+     * of the projection matrix. Used for outputs which are rotated in software.
+     **/
+    QMatrix4x4 m_outputTransformation;
+    /**
+     * The counters of the frame being painted, published at its end.
+     **/
+    FrameCounters m_frameCounters;
 private:
     bool viewportLimitsMatched(const QSize &size) const;
 private:
@@ -108,6 +121,7 @@ private:
     OpenGLBackend *m_backend;
     SyncManager *m_syncManager;
     SyncObject *m_currentFence;
+    FrameCounters m_lastFrameCounters;
 };
 
 class SceneOpenGL2 : public SceneOpenGL
@@ -122,6 +136,7 @@ public:
 
     static bool supported(OpenGLBackend *backend);
 
+    qint64 paint(QRegion damage, ToplevelList windows) override;
     QMatrix4x4 projectionMatrix() const override { return m_projectionMatrix; }
     QMatrix4x4 screenProjectionMatrix() const override { return m_screenProjectionMatrix; }
 
@@ -133,13 +148,16 @@ protected:
     virtual void finalDrawWindow(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data);
     virtual void updateProjectionMatrix() override;
     void paintCursor() override;
+    void paintDesktopThumbnail(int desktop, const QRectF &rect, const QRegion &clip) override;
 
 private:
     void performPaintWindow(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data);
     QMatrix4x4 createProjectionMatrix() const;
+    void renderDesktopThumbnail(int desktop, GLRenderTarget *target, const QSize &textureSize);
 
 private:
     LanczosFilter *m_lanczosFilter;
+    QScopedPointer<DesktopThumbnailCache> m_desktopThumbnails;
     QScopedPointer<GLTexture> m_cursorTexture;
     QMatrix4x4 m_projectionMatrix;
     QMatrix4x4 m_screenProjectionMatrix;
@@ -214,13 +232,20 @@ protected:
     void setupLeafNodes(LeafNode *nodes, const WindowQuadList *quads, const WindowPaintData &data);
     virtual void performPaint(int mask, QRegion region, WindowPaintData data) override;
     QSharedPointer<GLTexture> windowTexture() override;
+    void releaseWindowTexture() override;
 
 private:
-    void renderSubSurface(GLShader *shader, const QMatrix4x4 &mvp, const QMatrix4x4 &windowMatrix, OpenGLWindowPixmap *pixmap, const QRegion &region, bool hardwareClipping);
+    void addSubSurfaceQuads(const QVector<WindowPixmap*> &children, const QPoint &offset, QVector<OpenGLWindowPixmap*> &pixmaps, QVector<WindowQuadList> &quads) const;
     /**
      * Whether prepareStates enabled blending and restore states should disable again.
      **/
     bool m_blendingEnabled;
+    /**
+     * The texture windowTexture renders a window with sub-surfaces into, kept for the next
+     * frame and only reallocated when the window changes its size.
+     **/
+    QSharedPointer<GLTexture> m_windowTexture;
+    QScopedPointer<GLRenderTarget> m_windowRenderTarget;
 };
 
 class OpenGLWindowPixmap : public WindowPixmap
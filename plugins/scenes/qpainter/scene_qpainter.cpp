@@ -24,6 +24,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "cursor.h"
 #include "deleted.h"
 #include "effects.h"
+#if HAVE_LINUX_DMABUF
+#include "linux_dmabuf.h"
+#endif
 #include "main.h"
 #include "screens.h"
 #include "toplevel.h"
@@ -38,6 +41,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QPainter>
 #include <KDecoration2/Decoration>
 
+#include <algorithm>
 #include <cmath>
 
 namespace KWin
@@ -63,12 +67,55 @@ SceneQPainter::SceneQPainter(QPainterBackend *backend, QObject *parent)
     , m_backend(backend)
     , m_painter(new QPainter())
 {
+#if HAVE_LINUX_DMABUF
+    // dmabufs get mapped, so only linear buffers are supported
+    if (waylandServer()) {
+        m_dmabuf.reset(new LinuxDmabuf);
+    }
+#endif
 }
 
 SceneQPainter::~SceneQPainter()
 {
 }
 
+// number of scratch images kept around for composing translucent windows
+static const int s_scratchImagePoolSize = 2;
+
+QImage SceneQPainter::acquireScratchImage(const QSize &size)
+{
+    QImage image;
+    for (auto it = m_scratchImages.begin(); it != m_scratchImages.end(); ++it) {
+        if (it->width() >= size.width() && it->height() >= size.height()) {
+            image = *it;
+            // the pool must not keep a reference, painting into the image would detach it
+            m_scratchImages.erase(it);
+            break;
+        }
+    }
+    if (image.isNull()) {
+        image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    }
+    QPainter p(&image);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    p.fillRect(QRect(QPoint(0, 0), size), Qt::transparent);
+    return image;
+}
+
+void SceneQPainter::releaseScratchImage(const QImage &image)
+{
+    m_scratchImages << image;
+    if (m_scratchImages.count() > s_scratchImagePoolSize) {
+        // drop the smallest image, the larger ones can serve any size it could
+        auto smallest = std::min_element(m_scratchImages.begin(), m_scratchImages.end(),
+            [] (const QImage &a, const QImage &b) {
+                return a.width() * a.height() < b.width() * b.height();
+            }
+        );
+        m_scratchImages.erase(smallest);
+    }
+}
+
 CompositingType SceneQPainter::compositingType() const
 {
     return QPainterCompositing;
@@ -217,7 +264,10 @@ static void paintSubSurface(QPainter *painter, const QPoint &pos, QPainterWindow
         p += pixmap->subSurface()->position();
     }
 
-    painter->drawImage(QRect(pos, pixmap->size()), pixmap->image());
+    {
+        const QImage image = pixmap->image();
+        painter->drawImage(QRect(pos, pixmap->size()), image);
+    }
     const auto &children = pixmap->children();
     for (auto it = children.begin(); it != children.end(); ++it) {
         auto pixmap = static_cast<QPainterWindowPixmap*>(*it);
@@ -261,8 +311,7 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
     QPainter tempPainter;
     if (!opaque) {
         // need a temp render target which we later on blit to the screen
-        tempImage = QImage(toplevel->visibleRect().size(), QImage::Format_ARGB32_Premultiplied);
-        tempImage.fill(Qt::transparent);
+        tempImage = m_scene->acquireScratchImage(toplevel->visibleRect().size());
         tempPainter.begin(&tempImage);
         tempPainter.save();
         tempPainter.translate(toplevel->geometry().topLeft() - toplevel->visibleRect().topLeft());
@@ -272,14 +321,18 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
     renderWindowDecorations(painter);
 
     // render content
-    const QRect target = QRect(toplevel->clientPos(), toplevel->clientSize());
-    QSize srcSize = pixmap->image().size();
-    if (pixmap->surface() && pixmap->surface()->scale() == 1 && srcSize != toplevel->clientSize()) {
-        // special case for XWayland windows
-        srcSize = toplevel->clientSize();
+    {
+        // the image maps the client buffer, release it before the subsurfaces get painted
+        const QImage image = pixmap->image();
+        const QRect target = QRect(toplevel->clientPos(), toplevel->clientSize());
+        QSize srcSize = image.size();
+        if (pixmap->surface() && pixmap->surface()->scale() == 1 && srcSize != toplevel->clientSize()) {
+            // special case for XWayland windows
+            srcSize = toplevel->clientSize();
+        }
+        const QRect src = QRect(toplevel->clientPos() + toplevel->clientContentPos(), srcSize);
+        painter->drawImage(target, image, src);
     }
-    const QRect src = QRect(toplevel->clientPos() + toplevel->clientContentPos(), srcSize);
-    painter->drawImage(target, pixmap->image(), src);
 
     // render subsurfaces
     const auto &children = pixmap->children();
@@ -298,7 +351,9 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
         tempPainter.fillRect(QRect(QPoint(0, 0), toplevel->visibleRect().size()), translucent);
         tempPainter.end();
         painter = scenePainter;
-        painter->drawImage(toplevel->visibleRect().topLeft() - toplevel->geometry().topLeft(), tempImage);
+        painter->drawImage(toplevel->visibleRect().topLeft() - toplevel->geometry().topLeft(), tempImage,
+                           QRect(QPoint(0, 0), toplevel->visibleRect().size()));
+        m_scene->releaseScratchImage(tempImage);
     }
 
     painter->restore();
@@ -388,6 +443,7 @@ QPainterWindowPixmap::QPainterWindowPixmap(const QPointer<KWayland::Server::SubS
 
 QPainterWindowPixmap::~QPainterWindowPixmap()
 {
+    QObject::disconnect(m_bufferDestroyedConnection);
 }
 
 void QPainterWindowPixmap::create()
@@ -395,15 +451,8 @@ void QPainterWindowPixmap::create()
     if (isValid()) {
         return;
     }
+    // takes the buffer through updateBuffer
     KWin::WindowPixmap::create();
-    if (!isValid()) {
-        return;
-    }
-    // performing deep copy, this could probably be improved
-    m_image = buffer()->data().copy();
-    if (auto s = surface()) {
-        s->resetTrackedDamage();
-    }
 }
 
 WindowPixmap *QPainterWindowPixmap::createChild(const QPointer<KWayland::Server::SubSurfaceInterface> &subSurface)
@@ -417,22 +466,102 @@ void QPainterWindowPixmap::updateBuffer()
     WindowPixmap::updateBuffer();
     const auto &b = buffer();
     if (b.isNull()) {
+        QObject::disconnect(m_bufferDestroyedConnection);
         m_image = QImage();
         return;
     }
-    if (b == oldBuffer) {
-        return;
+    if (b != oldBuffer) {
+        watchBuffer();
+#if HAVE_LINUX_DMABUF
+        if (b->linuxDmabufBuffer()) {
+            m_copyBuffers = true;
+        }
+#endif
     }
-    // perform deep copy
-    m_image = b->data().copy();
-    if (auto s = surface()) {
+    if (m_copyBuffers) {
+        copyDamage();
+    } else if (auto s = surface()) {
+        // painted straight from the held buffer, nothing to copy
         s->resetTrackedDamage();
     }
 }
 
+void QPainterWindowPixmap::watchBuffer()
+{
+    QObject::disconnect(m_bufferDestroyedConnection);
+    const auto b = buffer();
+    m_bufferDestroyedConnection = QObject::connect(b.data(), &KWayland::Server::BufferInterface::aboutToBeDestroyed, b.data(),
+        [this, b] {
+            QObject::disconnect(m_bufferDestroyedConnection);
+            if (m_copyBuffers || !b) {
+                return;
+            }
+            // the client destroyed the buffer while it is still shown, keep what it showed
+            m_image = b->data().copy();
+            m_copyBuffers = true;
+        }
+    );
+}
+
+void QPainterWindowPixmap::copyDamage()
+{
+    const auto &b = buffer();
+#if HAVE_LINUX_DMABUF
+    if (auto dmabuf = static_cast<DmabufBuffer*>(b->linuxDmabufBuffer())) {
+        copyDamage(dmabuf->beginCpuAccess(), dmabuf->flags() & KWayland::Server::LinuxDmabufUnstableV1Interface::YInverted);
+        dmabuf->endCpuAccess();
+        return;
+    }
+#endif
+    copyDamage(b->data());
+}
+
+void QPainterWindowPixmap::copyDamage(const QImage &data, bool yInverted)
+{
+    auto s = surface();
+    if (data.isNull()) {
+        return;
+    }
+    if (!s || m_image.size() != data.size() || m_image.format() != data.format()) {
+        m_image = yInverted ? data.mirrored() : data.copy();
+        if (s) {
+            s->resetTrackedDamage();
+        }
+        return;
+    }
+    const QRegion damage = s->trackedDamage();
+    s->resetTrackedDamage();
+    // damage is normalised, so needs converting up to match the buffer
+    const int scale = s->scale();
+    QPainter p(&m_image);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    for (const QRect &rect : damage) {
+        const QRect scaledRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale);
+        if (yInverted) {
+            // the rows of the buffer start at the bottom, copy the mirrored rows and flip them
+            const QRect sourceRect(scaledRect.x(), data.height() - scaledRect.y() - scaledRect.height(),
+                                   scaledRect.width(), scaledRect.height());
+            p.drawImage(scaledRect.topLeft(), data.copy(sourceRect).mirrored());
+        } else {
+            p.drawImage(scaledRect.topLeft(), data, scaledRect);
+        }
+    }
+}
+
+QImage QPainterWindowPixmap::image() const
+{
+    if (m_copyBuffers) {
+        return m_image;
+    }
+    if (const auto &b = buffer()) {
+        return b->data();
+    }
+    return QImage();
+}
+
 bool QPainterWindowPixmap::isValid() const
 {
-    if (!m_image.isNull()) {
+    if (m_copyBuffers && !m_image.isNull()) {
         return true;
     }
     return WindowPixmap::isValid();
@@ -26,8 +26,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "decorations/decorationrenderer.h"
 
+#include <config-kwin.h>
+
 namespace KWin {
 
+class LinuxDmabuf;
+
 class KWIN_EXPORT SceneQPainter : public Scene
 {
     Q_OBJECT
@@ -58,6 +62,13 @@ public:
 
     static SceneQPainter *createScene(QObject *parent);
 
+    /**
+     * @returns a transparent image of at least @p size to compose translucent windows in.
+     * Only the area of @p size is cleared. Hand it back with releaseScratchImage once done.
+     **/
+    QImage acquireScratchImage(const QSize &size);
+    void releaseScratchImage(const QImage &image);
+
 protected:
     virtual void paintBackground(QRegion region) override;
     virtual Scene::Window *createWindow(Toplevel *toplevel) override;
@@ -67,6 +78,10 @@ private:
     explicit SceneQPainter(QPainterBackend *backend, QObject *parent = nullptr);
     QScopedPointer<QPainterBackend> m_backend;
     QScopedPointer<QPainter> m_painter;
+#if HAVE_LINUX_DMABUF
+    QScopedPointer<LinuxDmabuf> m_dmabuf;
+#endif
+    QVector<QImage> m_scratchImages;
     class Window;
 };
 
@@ -93,13 +108,28 @@ public:
     bool isValid() const override;
 
     void updateBuffer() override;
-    const QImage &image();
+    /**
+     * The content of the surface. Unless the pixmap switched to keeping a copy this maps the
+     * held shm buffer, only one buffer can be accessed at a time, so the image has to be
+     * released before the image of another pixmap gets requested.
+     **/
+    QImage image() const;
 
 protected:
     WindowPixmap *createChild(const QPointer<KWayland::Server::SubSurfaceInterface> &subSurface) override;
 private:
     explicit QPainterWindowPixmap(const QPointer<KWayland::Server::SubSurfaceInterface> &subSurface, WindowPixmap *parent);
+    void watchBuffer();
+    void copyDamage();
+    void copyDamage(const QImage &data, bool yInverted = false);
+    /**
+     * Copy of the content, only kept once the client destroyed a buffer while it was still
+     * attached or attached a dmabuf, which is only mapped while copying. From then on the
+     * buffers are copied, limited to the damaged areas.
+     **/
     QImage m_image;
+    bool m_copyBuffers = false;
+    QMetaObject::Connection m_bufferDestroyedConnection;
 };
 
 class QPainterEffectFrame : public Scene::EffectFrame
@@ -191,12 +221,6 @@ QPainter* SceneQPainter::scenePainter() const
     return m_painter.data();
 }
 
-inline
-const QImage &QPainterWindowPixmap::image()
-{
-    return m_image;
-}
-
 } // KWin
 
 #endif // KWIN_SCENEQPAINTER_H
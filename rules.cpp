@@ -19,6 +19,7 @@
 #ifndef KCMRULES
 #include "client.h"
 #include "client_machine.h"
+#include "configcommitter.h"
 #include "screens.h"
 #include "workspace.h"
 #endif
@@ -1095,7 +1096,7 @@ void RuleBook::save()
         (*it)->write(cg);
         ++i;
     }
-    m_config->sync();
+    ConfigCommitter::sync(m_config);
 }
 
 void RuleBook::temporaryRulesMessage(const QString& message)
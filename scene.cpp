@@ -228,6 +228,7 @@ void Scene::paintGenericScreen(int orig_mask, ScreenPaintData)
         if (!w->isPaintingEnabled()) {
             continue;
         }
+        setVisibleInFrame(topw);
         phase2.append({w, infiniteRegion(), data.clip, data.mask, data.quads});
     }
 
@@ -357,6 +358,15 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
         // a higher opaque window
         data->region -= allclips;
 
+        // allclips holds the opaque areas of all windows above, independent of the damage
+        Toplevel *topw = data->window->window();
+        if (topw->surface() && !m_visibleWindows.contains(topw)) {
+            if ((data->mask & PAINT_WINDOW_TRANSFORMED) ||
+                    !((QRegion(topw->visibleRect()) & displayRegion) - allclips).isEmpty()) {
+                m_visibleWindows.insert(topw);
+            }
+        }
+
         // Here we rely on WindowPrePaintData::setTranslucent() to remove
         // the clip if needed.
         if (!data->clip.isEmpty() && !(data->mask & PAINT_WINDOW_TRANSFORMED)) {
@@ -471,6 +481,8 @@ void Scene::windowGeometryShapeChanged(Toplevel *c)
 
 void Scene::createStackingOrder(ToplevelList toplevels)
 {
+    // a new frame starts
+    m_visibleWindows.clear();
     // TODO: cache the stacking_order in case it has not changed
     foreach (Toplevel *c, toplevels) {
         assert(m_windows.contains(c));
@@ -602,13 +614,10 @@ void Scene::paintDesktopThumbnails(Scene::Window *w)
         }
         s_recursionCheck = w;
 
-        ScreenPaintData data;
         const QSize &screenSize = screens()->size();
         QSize size = screenSize;
 
         size.scale(item->width(), item->height(), Qt::KeepAspectRatio);
-        data *= QVector2D(size.width() / double(screenSize.width()),
-                          size.height() / double(screenSize.height()));
         const QPointF point = item->mapToScene(item->position());
         const qreal x = point.x() + w->x() + (item->width() - size.width())/2;
         const qreal y = point.y() + w->y() + (item->height() - size.height()) / 2;
@@ -616,13 +625,37 @@ void Scene::paintDesktopThumbnails(Scene::Window *w)
         QRegion clippingRegion = region;
         clippingRegion &= QRegion(wImpl->x(), wImpl->y(), wImpl->width(), wImpl->height());
         adjustClipRegion(item, clippingRegion);
-        data += QPointF(x, y);
-        const int desktopMask = PAINT_SCREEN_TRANSFORMED | PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_BACKGROUND_FIRST;
-        paintDesktop(item->desktop(), desktopMask, clippingRegion, data);
+        // the thumbnail might come out of a cache, so its windows don't necessarily get drawn
+        for (Window *window : qAsConst(stacking_order)) {
+            Toplevel *toplevel = window->window();
+            auto client = qobject_cast<AbstractClient*>(toplevel);
+            if (toplevel->isOnDesktop(item->desktop()) && !(client && client->isMinimized())) {
+                setVisibleInFrame(toplevel);
+            }
+        }
+        paintDesktopThumbnail(item->desktop(), QRectF(QPointF(x, y), size), clippingRegion);
         s_recursionCheck = NULL;
     }
 }
 
+void Scene::setVisibleInFrame(Toplevel *toplevel)
+{
+    if (toplevel->surface()) {
+        m_visibleWindows.insert(toplevel);
+    }
+}
+
+void Scene::paintDesktopThumbnail(int desktop, const QRectF &rect, const QRegion &clip)
+{
+    ScreenPaintData data;
+    const QSize &screenSize = screens()->size();
+    data *= QVector2D(rect.width() / double(screenSize.width()),
+                      rect.height() / double(screenSize.height()));
+    data += rect.topLeft();
+    const int desktopMask = PAINT_SCREEN_TRANSFORMED | PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_BACKGROUND_FIRST;
+    paintDesktop(desktop, desktopMask, clip, data);
+}
+
 void Scene::paintDesktop(int desktop, int mask, const QRegion &region, ScreenPaintData &data)
 {
     static_cast<EffectsHandlerImpl*>(effects)->paintDesktop(desktop, mask, region, data);
@@ -645,6 +678,8 @@ void Scene::finalDrawWindow(EffectWindowImpl* w, int mask, QRegion region, Windo
     if (waylandServer() && waylandServer()->isScreenLocked() && !w->window()->isLockScreen() && !w->window()->isInputMethod()) {
         return;
     }
+    // effects and thumbnails draw windows which are not visible in the stacking order
+    setVisibleInFrame(w->window());
     w->sceneWindow()->performPaint(mask, region, data);
 }
 
@@ -13,6 +13,7 @@
 
 #include <QElapsedTimer>
 #include <QMatrix4x4>
+#include <QSet>
 
 class QOpenGLFramebufferObject;
 
@@ -178,6 +179,32 @@ public:
         return {};
     }
 
+    /**
+     * What painting the last frame took on all screens together, meant for benchmarks.
+     **/
+    struct FrameCounters {
+        /**
+         * Windows drawn, a window shown on two screens counts twice.
+         **/
+        int windows = 0;
+        /**
+         * Draw calls issued to the GPU, 0 for scenes not rendering through OpenGL.
+         **/
+        int drawCalls = 0;
+    };
+    virtual FrameCounters frameCounters() const {
+        return {};
+    }
+
+    /**
+     * Whether @p toplevel was at least partly visible in the last painted frame. Windows which
+     * are minimized, on another desktop or covered by opaque windows are not. Only tracked for
+     * windows with a Wayland surface.
+     **/
+    bool isVisibleInLastFrame(Toplevel *toplevel) const {
+        return m_visibleWindows.contains(toplevel);
+    }
+
 Q_SIGNALS:
     void frameRendered();
     void resetCompositing();
@@ -224,6 +251,16 @@ protected:
     // the default is NOOP
     virtual void extendPaintRegion(QRegion &region, bool opaqueFullscreen);
     virtual void paintDesktop(int desktop, int mask, const QRegion &region, ScreenPaintData &data);
+    /**
+     * Paints @p desktop scaled into @p rect for a desktop thumbnail item, clipped to @p clip.
+     * The default implementation paints the whole desktop through the effects each time.
+     **/
+    virtual void paintDesktopThumbnail(int desktop, const QRectF &rect, const QRegion &clip);
+    /**
+     * Records that @p toplevel is shown in the frame being painted, be it in the stacking
+     * order, drawn by an effect or as part of a thumbnail.
+     **/
+    void setVisibleInFrame(Toplevel *toplevel);
     // compute time since the last repaint
     void updateTimeDiff();
     // saved data for 2nd pass of optimized screen painting
@@ -255,6 +292,8 @@ private:
     QVector< Window* > stacking_order;
     // how many times finalPaintScreen() has been called
     int m_paintScreenCount = 0;
+    // windows with a surface which were visible in the frame being painted
+    QSet<Toplevel*> m_visibleWindows;
 };
 
 /**
@@ -336,6 +375,10 @@ public:
     virtual QSharedPointer<GLTexture> windowTexture() {
         return {};
     }
+    /**
+     * Frees what windowTexture keeps for the next call, requires a current context.
+     **/
+    virtual void releaseWindowTexture() {}
 
 protected:
     WindowQuadList makeQuads(WindowQuadType type, const QRegion& reg, const QPoint &textureOffset = QPoint(0, 0), qreal textureScale = 1.0) const;
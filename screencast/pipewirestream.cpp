@@ -7,6 +7,7 @@
 */
 
 #include "pipewirestream.h"
+#include "composite.h"
 #include "cursor.h"
 #include "dmabuftexture.h"
 #include "kwingltexture.h"
@@ -16,6 +17,7 @@
 #include "main.h"
 #include "pipewirecore.h"
 #include "platform.h"
+#include "scene.h"
 #include "utils.h"
 #include "drm/egl_gbm_backend.h"
 
@@ -176,6 +178,14 @@ void PipeWireStream::onStreamAddBuffer(void *data, pw_buffer *buffer)
     }
 }
 
+static const int s_minFencePollInterval = 2;
+static const int s_maxFencePollInterval = 16;
+
+static bool makeSceneContextCurrent()
+{
+    return Compositor::self() && Compositor::self()->scene() && Compositor::self()->scene()->makeOpenGLContextCurrent();
+}
+
 void PipeWireStream::onStreamRemoveBuffer(void *data, pw_buffer *buffer)
 {
     PipeWireStream *stream = static_cast<PipeWireStream *>(data);
@@ -184,6 +194,16 @@ void PipeWireStream::onStreamRemoveBuffer(void *data, pw_buffer *buffer)
     struct spa_data *spa_data = spa_buffer->datas;
 
     if (spa_data->type == SPA_DATA_DmaBuf) {
+        for (auto it = stream->m_pendingFrames.begin(); it != stream->m_pendingFrames.end(); ++it) {
+            if (it->buffer == buffer) {
+                // without a context the sync cannot be deleted, it goes away with the context
+                if (makeSceneContextCurrent()) {
+                    glDeleteSync(it->sync);
+                }
+                stream->m_pendingFrames.erase(it);
+                break;
+            }
+        }
         stream->m_dmabufDataForPwBuffer.remove(buffer);
     } else if (spa_data->type == SPA_DATA_MemFd) {
         munmap (spa_data->data, spa_data->maxsize);
@@ -201,11 +221,26 @@ PipeWireStream::PipeWireStream(bool hasAlpha, const QSize &resolution, QObject *
     pwStreamEvents.remove_buffer = &PipeWireStream::onStreamRemoveBuffer;
     pwStreamEvents.state_changed = &PipeWireStream::onStreamStateChanged;
     pwStreamEvents.param_changed = &PipeWireStream::onStreamParamChanged;
+
+    // pending fences are polled with the next frame, the timer only covers an idle scene
+    // and backs off while the GPU is busy
+    m_fenceTimer.setSingleShot(true);
+    m_fenceTimer.setInterval(s_minFencePollInterval);
+    connect(&m_fenceTimer, &QTimer::timeout, this, &PipeWireStream::queueSignaledFrames);
+    if (Compositor::self() && Compositor::self()->scene()) {
+        connect(Compositor::self()->scene(), &Scene::frameRendered, this, &PipeWireStream::queueSignaledFrames);
+    }
 }
 
 PipeWireStream::~PipeWireStream()
 {
     m_stopped = true;
+    if (!m_pendingFrames.isEmpty() && makeSceneContextCurrent()) {
+        for (const PendingFrame &frame : qAsConst(m_pendingFrames)) {
+            glDeleteSync(frame.sync);
+        }
+    }
+    m_pendingFrames.clear();
     if (pwStream) {
         pw_stream_destroy(pwStream);
     }
@@ -347,6 +382,7 @@ void PipeWireStream::recordFrame(GLTexture *frameTexture, const QRegion &damaged
     }
 
     struct pw_buffer *buffer = pw_stream_dequeue_buffer(pwStream);
+    bool rendered = false;
 
     if (!buffer) {
         return;
@@ -475,6 +511,7 @@ void PipeWireStream::recordFrame(GLTexture *frameTexture, const QRegion &damaged
         ShaderManager::instance()->popShader();
 
         GLRenderTarget::popRenderTarget();
+        rendered = true;
     }
     frameTexture->unbind();
 #endif
@@ -484,7 +521,65 @@ void PipeWireStream::recordFrame(GLTexture *frameTexture, const QRegion &damaged
                         (spa_meta_cursor *) spa_buffer_find_meta_data (spa_buffer, SPA_META_Cursor, sizeof (spa_meta_cursor)));
     }
 
-    pw_stream_queue_buffer(pwStream, buffer);
+    if (rendered) {
+        queueFrame(buffer);
+    } else {
+        // the pixels got read back already
+        pw_stream_queue_buffer(pwStream, buffer);
+    }
+}
+
+static bool haveSyncFences()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        return hasGLVersion(3, 0);
+    }
+    return hasGLVersion(3, 2) || hasGLExtension(QByteArrayLiteral("GL_ARB_sync"));
+}
+
+void PipeWireStream::queueFrame(struct pw_buffer *buffer)
+{
+    if (!haveSyncFences()) {
+        glFinish();
+        pw_stream_queue_buffer(pwStream, buffer);
+        return;
+    }
+    // the flush makes the driver attach the implicit fence to the dmabuf and lets the fence
+    // below signal without anybody waiting on it
+    m_pendingFrames.append(PendingFrame{buffer, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+    glFlush();
+    queueSignaledFrames();
+}
+
+void PipeWireStream::queueSignaledFrames()
+{
+    if (m_pendingFrames.isEmpty()) {
+        return;
+    }
+    if (!makeSceneContextCurrent()) {
+        return;
+    }
+    int signaled = 0;
+    for (const PendingFrame &frame : qAsConst(m_pendingFrames)) {
+        if (glClientWaitSync(frame.sync, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+        glDeleteSync(frame.sync);
+        pw_stream_queue_buffer(pwStream, frame.buffer);
+        signaled++;
+    }
+    m_pendingFrames.remove(0, signaled);
+    if (m_pendingFrames.isEmpty()) {
+        m_fenceTimer.stop();
+        m_fenceTimer.setInterval(s_minFencePollInterval);
+        return;
+    }
+    if (signaled) {
+        m_fenceTimer.setInterval(s_minFencePollInterval);
+    } else {
+        m_fenceTimer.setInterval(qMin(m_fenceTimer.interval() * 2, s_maxFencePollInterval));
+    }
+    m_fenceTimer.start();
 }
 
 QRect PipeWireStream::cursorGeometry(Cursor *cursor) const
@@ -17,6 +17,10 @@
 #include <QObject>
 #include <QSharedPointer>
 #include <QSize>
+#include <QTimer>
+#include <QVector>
+
+#include <epoxy/gl.h>
 
 #include <pipewire/pipewire.h>
 #include <spa/param/format-utils.h>
@@ -68,6 +72,8 @@ private:
     void coreFailed(const QString &errorMessage);
     void sendCursorData(Cursor *cursor, spa_meta_cursor *spa_cursor);
     void newStreamParams();
+    void queueFrame(struct pw_buffer *buffer);
+    void queueSignaledFrames();
 
     QPoint softwareCursorHotspot() const;
     QImage softwareCursor() const;
@@ -99,6 +105,17 @@ private:
     QRect cursorGeometry(Cursor *cursor) const;
 
     QHash<struct pw_buffer *, QSharedPointer<DmaBufTexture>> m_dmabufDataForPwBuffer;
+
+    /**
+     * A dmabuf frame which got rendered but not handed to PipeWire yet, it is queued once the
+     * GPU passed @c sync instead of waiting for it on the compositor thread.
+     **/
+    struct PendingFrame {
+        struct pw_buffer *buffer;
+        GLsync sync;
+    };
+    QVector<PendingFrame> m_pendingFrames;
+    QTimer m_fenceTimer;
 };
 
 } // namespace KWin
@@ -23,6 +23,7 @@
 
 #include <KWayland/Server/display.h>
 #include <KWayland/Server/output_interface.h>
+#include <QPointer>
 
 namespace KWin
 {
@@ -52,6 +53,13 @@ public:
         connect(this, &PipeWireStream::startStreaming, this, &WindowStream::startFeeding);
     }
 
+    ~WindowStream() override {
+        // the scene window keeps the texture for the next frame, nobody asks for it anymore
+        if (m_toplevel && m_toplevel->effectWindow() && effects && effects->makeOpenGLContextCurrent()) {
+            m_toplevel->effectWindow()->sceneWindow()->releaseWindowTexture();
+        }
+    }
+
 private:
     void startFeeding() {
         auto scene = Compositor::self()->scene();
@@ -68,6 +76,8 @@ private:
     }
 
     void bufferToStream () {
+        // sub-surface commits damage the whole window as well, without damage the window
+        // texture and the last frame in the stream are still up to date
         if (m_damagedRegion.isEmpty()) {
             return;
         }
@@ -79,11 +89,10 @@ private:
         recordFrame(frameTexture.data(), m_damagedRegion);
         frameTexture->setYInverted(wasYInverted);
         m_damagedRegion = {};
-        glFinish(); // TODO: Don't stall the whole pipeline. Use EGL_ANDROID_native_fence_sync.
     }
 
     QRegion m_damagedRegion;
-    Toplevel *m_toplevel;
+    QPointer<Toplevel> m_toplevel;
 };
 
 void ScreencastManager::streamWindow(KWayland::Server::ScreencastStreamV1Interface *waylandStream, const QString &winid)
@@ -38,6 +38,8 @@
 #include <QDBusPendingCall>
 #include <QWidget>
 
+#include <algorithm>
+
 namespace KWin {
 
 // Mouse should not move more than this many pixels
@@ -1044,9 +1046,75 @@ void ScreenEdges::recreateEdges()
             }
         }
     }
+    updateEdgeIndex();
     qDeleteAll(oldEdges);
 }
 
+void ScreenEdges::updateEdgeIndex()
+{
+    m_verticalBands.clear();
+    m_horizontalBands.clear();
+    auto insert = [] (QVector<EdgeBand> &bands, Edge *edge, int start, int end) {
+        EdgeBand band{start, end, {edge}};
+        // merge with all overlapping bands, the merged band may reach further ones
+        for (auto it = bands.begin(); it != bands.end();) {
+            if (it->end < band.start || it->start > band.end) {
+                ++it;
+                continue;
+            }
+            band.start = qMin(band.start, it->start);
+            band.end = qMax(band.end, it->end);
+            band.edges << it->edges;
+            bands.erase(it);
+            it = bands.begin();
+        }
+        auto it = std::lower_bound(bands.begin(), bands.end(), band.start,
+            [] (const EdgeBand &other, int start) {
+                return other.start < start;
+            }
+        );
+        bands.insert(it, band);
+    };
+    for (Edge *edge : qAsConst(m_edges)) {
+        const QRect area = edge->approachGeometry().united(edge->geometry());
+        if (edge->isLeft() || edge->isRight()) {
+            insert(m_verticalBands, edge, area.left(), area.right());
+        } else if (edge->isTop() || edge->isBottom()) {
+            insert(m_horizontalBands, edge, area.top(), area.bottom());
+        }
+    }
+    // forget about deleted edges
+    for (auto it = m_approachingEdges.begin(); it != m_approachingEdges.end();) {
+        if (m_edges.contains(*it)) {
+            ++it;
+        } else {
+            it = m_approachingEdges.erase(it);
+        }
+    }
+}
+
+QVector<Edge*> ScreenEdges::edgesAt(const QPoint &pos) const
+{
+    QVector<Edge*> edges;
+    auto find = [&edges] (const QVector<EdgeBand> &bands, int value) {
+        auto it = std::upper_bound(bands.constBegin(), bands.constEnd(), value,
+            [] (int value, const EdgeBand &band) {
+                return value < band.start;
+            }
+        );
+        if (it == bands.constBegin()) {
+            return;
+        }
+        --it;
+        if (value <= it->end) {
+            edges << it->edges;
+        }
+    };
+    find(m_verticalBands, pos.x());
+    find(m_horizontalBands, pos.y());
+    return edges;
+}
+
 void ScreenEdges::createVerticalEdge(ElectricBorder border, const QRect &screen, const QRect &fullArea)
 {
     if (border != ElectricRight && border != KWin::ElectricLeft) {
@@ -1221,6 +1289,9 @@ void ScreenEdges::reserve(AbstractClient *client, ElectricBorder border)
             it++;
         }
     }
+    if (hadBorder) {
+        updateEdgeIndex();
+    }
 
     if (border != ElectricNone) {
         createEdgeForClient(client, border);
@@ -1314,6 +1385,7 @@ void ScreenEdges::createEdgeForClient(AbstractClient *client, ElectricBorder bor
         Edge *edge = createEdge(border, x, y, width, height, false);
         edge->setClient(client);
         m_edges.append(edge);
+        updateEdgeIndex();
         edge->reserve();
     } else {
         // we could not create an edge window, so don't allow the window to hide
@@ -1323,40 +1395,54 @@ void ScreenEdges::createEdgeForClient(AbstractClient *client, ElectricBorder bor
 
 void ScreenEdges::deleteEdgeForClient(AbstractClient* c)
 {
+    bool hadBorder = false;
     auto it = m_edges.begin();
     while (it != m_edges.end()) {
         if ((*it)->client() == c) {
+            hadBorder = true;
             delete *it;
             it = m_edges.erase(it);
         } else {
             it++;
         }
     }
+    if (hadBorder) {
+        updateEdgeIndex();
+    }
 }
 
 void ScreenEdges::check(const QPoint &pos, const QDateTime &now, bool forceNoPushBack)
 {
     bool activatedForClient = false;
-    for (auto it = m_edges.begin(); it != m_edges.end(); ++it) {
-        if (!(*it)->isReserved()) {
+    const QVector<Edge*> edges = edgesAt(pos);
+    for (Edge *edge : edges) {
+        if (!edge->isReserved()) {
             continue;
         }
-        if (!(*it)->activatesForPointer()) {
+        if (!edge->activatesForPointer()) {
             continue;
         }
-        if ((*it)->approachGeometry().contains(pos)) {
-            (*it)->startApproaching();
+        if (edge->approachGeometry().contains(pos)) {
+            edge->startApproaching();
         }
-        if ((*it)->client() != nullptr && activatedForClient) {
-            (*it)->markAsTriggered(pos, now);
+        if (edge->client() != nullptr && activatedForClient) {
+            edge->markAsTriggered(pos, now);
             continue;
         }
-        if ((*it)->check(pos, now, forceNoPushBack)) {
-            if ((*it)->client()) {
+        if (edge->check(pos, now, forceNoPushBack)) {
+            if (edge->client()) {
                 activatedForClient = true;
             }
         }
     }
+    if (activatedForClient) {
+        // also the client edges close by which were checked before the activated one
+        for (Edge *edge : edges) {
+            if (edge->client()) {
+                edge->markAsTriggered(pos, now);
+            }
+        }
+    }
 }
 
 bool ScreenEdges::isEntered(QMouseEvent *event)
@@ -1366,8 +1452,21 @@ bool ScreenEdges::isEntered(QMouseEvent *event)
     }
     bool activated = false;
     bool activatedForClient = false;
-    for (auto it = m_edges.begin(); it != m_edges.end(); ++it) {
-        Edge *edge = *it;
+    const QVector<Edge*> edges = edgesAt(event->globalPos());
+    if (!m_approachingEdges.isEmpty()) {
+        // the pointer left the approach area of edges which are not close anymore
+        const QVector<Edge*> approachingEdges = m_approachingEdges;
+        m_approachingEdges.clear();
+        for (Edge *edge : approachingEdges) {
+            if (edges.contains(edge)) {
+                continue;
+            }
+            if (edge->isReserved() && edge->activatesForPointer() && edge->isApproaching()) {
+                edge->stopApproaching();
+            }
+        }
+    }
+    for (Edge *edge : edges) {
         if (!edge->isReserved()) {
             continue;
         }
@@ -1385,6 +1484,9 @@ bool ScreenEdges::isEntered(QMouseEvent *event)
                 edge->stopApproaching();
             }
         }
+        if (edge->isApproaching()) {
+            m_approachingEdges << edge;
+        }
         if (edge->geometry().contains(event->globalPos())) {
             if (edge->check(event->globalPos(), QDateTime::fromMSecsSinceEpoch(event->timestamp()))) {
                 if (edge->client()) {
@@ -1394,9 +1496,9 @@ bool ScreenEdges::isEntered(QMouseEvent *event)
         }
     }
     if (activatedForClient) {
-        for (auto it = m_edges.constBegin(); it != m_edges.constEnd(); ++it) {
-            if ((*it)->client()) {
-                (*it)->markAsTriggered(event->globalPos(), QDateTime::fromMSecsSinceEpoch(event->timestamp()));
+        for (Edge *edge : edges) {
+            if (edge->client()) {
+                edge->markAsTriggered(event->globalPos(), QDateTime::fromMSecsSinceEpoch(event->timestamp()));
             }
         }
     }
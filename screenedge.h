@@ -372,6 +372,15 @@ private:
     ElectricBorderAction actionForTouchEdge(Edge *edge) const;
     void createEdgeForClient(AbstractClient *client, ElectricBorder border);
     void deleteEdgeForClient(AbstractClient *client);
+    /**
+     * Rebuilds the bands used to find the edges close to a pointer position.
+     * Has to be called whenever an edge gets added or removed.
+     **/
+    void updateEdgeIndex();
+    /**
+     * @returns the edges whose approach area or geometry might contain @p pos.
+     **/
+    QVector<Edge*> edgesAt(const QPoint &pos) const;
     bool m_desktopSwitching;
     bool m_desktopSwitchingMovingClients;
     bool m_deepinDisableScreenEdges; // disable left, right, top, bottom Edge windows
@@ -380,6 +389,21 @@ private:
     int m_reactivateThreshold;
     Qt::Orientations m_virtualDesktopLayout;
     QList<Edge*> m_edges;
+    /**
+     * A band is a range along the x (left and right edges including the corners) or y axis
+     * (top and bottom edges) together with the edges whose approach area overlaps it. The
+     * bands of an axis are sorted and disjoint, so a pointer position far away from all
+     * borders gets rejected with two binary searches.
+     **/
+    struct EdgeBand {
+        int start;
+        int end;
+        QVector<Edge*> edges;
+    };
+    QVector<EdgeBand> m_verticalBands;
+    QVector<EdgeBand> m_horizontalBands;
+    // edges which got approached by the pointer and need to be told once it leaves
+    QVector<Edge*> m_approachingEdges;
     KSharedConfig::Ptr m_config;
     ElectricBorderAction m_actionTopLeft;
     ElectricBorderAction m_actionTop;
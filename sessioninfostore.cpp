@@ -0,0 +1,131 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "sessioninfostore.h"
+#include "sm.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+template <typename K>
+static void removeFromBucket(QHash<K, QList<SessionInfo *>> &hash, const K &key, SessionInfo *info)
+{
+    auto it = hash.find(key);
+    if (it == hash.end()) {
+        return;
+    }
+    // entries are mostly taken in the order they got added, so this is the first one
+    it->removeOne(info);
+    if (it->isEmpty()) {
+        hash.erase(it);
+    }
+}
+
+SessionInfoStore::~SessionInfoStore()
+{
+    clear();
+}
+
+void SessionInfoStore::add(SessionInfo *info)
+{
+    m_bySession[Key(info->sessionId, info->windowRole)].append(info);
+    m_byResource[Key(info->resourceClass, info->resourceName)].append(info);
+    m_byCommand[CommandKey(Key(info->resourceClass, info->resourceName), info->wmCommand)].append(info);
+    if (info->tabGroup) {
+        m_byTabGroup[info->tabGroup].append(info);
+    }
+    ++m_count;
+}
+
+void SessionInfoStore::clear()
+{
+    // every entry is in exactly one resource bucket
+    for (const QList<SessionInfo *> &bucket : qAsConst(m_byResource)) {
+        qDeleteAll(bucket);
+    }
+    m_bySession.clear();
+    m_byResource.clear();
+    m_byCommand.clear();
+    m_byTabGroup.clear();
+    m_count = 0;
+}
+
+SessionInfo *SessionInfoStore::takeSessionManaged(const QByteArray &sessionId, const QByteArray &windowRole,
+                                                  const QByteArray &resourceName, const QByteArray &resourceClass,
+                                                  const Filter &filter)
+{
+    auto it = m_bySession.find(Key(sessionId, windowRole));
+    if (it == m_bySession.end()) {
+        return nullptr;
+    }
+    if (!windowRole.isEmpty()) {
+        return take(*it, filter);
+    }
+    return take(*it,
+        [&resourceName, &resourceClass, &filter] (const SessionInfo *info) {
+            return info->resourceName == resourceName
+                && info->resourceClass == resourceClass
+                && filter(info);
+        }
+    );
+}
+
+SessionInfo *SessionInfoStore::takeByResource(const QByteArray &resourceName, const QByteArray &resourceClass,
+                                              const QByteArray &wmCommand, const Filter &filter)
+{
+    const Key key(resourceClass, resourceName);
+    if (wmCommand.isEmpty()) {
+        auto it = m_byResource.find(key);
+        return it == m_byResource.end() ? nullptr : take(*it, filter);
+    }
+    auto it = m_byCommand.find(CommandKey(key, wmCommand));
+    return it == m_byCommand.end() ? nullptr : take(*it, filter);
+}
+
+void SessionInfoStore::setTabGroupClient(int tabGroup, Client *client)
+{
+    if (!tabGroup) {
+        return;
+    }
+    auto it = m_byTabGroup.find(tabGroup);
+    if (it == m_byTabGroup.end()) {
+        return;
+    }
+    for (SessionInfo *info : qAsConst(*it)) {
+        if (!info->tabGroupClient) {
+            info->tabGroupClient = client;
+        }
+    }
+    // all entries of the group got their client, entries added later start over
+    m_byTabGroup.erase(it);
+}
+
+SessionInfo *SessionInfoStore::take(QList<SessionInfo *> &bucket, const Filter &filter)
+{
+    auto it = std::find_if(bucket.constBegin(), bucket.constEnd(), filter);
+    if (it == bucket.constEnd()) {
+        return nullptr;
+    }
+    SessionInfo *info = *it;
+    // removing can drop the bucket itself
+    remove(info);
+    return info;
+}
+
+void SessionInfoStore::remove(SessionInfo *info)
+{
+    const Key resourceKey(info->resourceClass, info->resourceName);
+    removeFromBucket(m_bySession, Key(info->sessionId, info->windowRole), info);
+    removeFromBucket(m_byCommand, CommandKey(resourceKey, info->wmCommand), info);
+    removeFromBucket(m_byResource, resourceKey, info);
+    if (info->tabGroup) {
+        removeFromBucket(m_byTabGroup, info->tabGroup, info);
+    }
+    --m_count;
+}
+
+}
@@ -0,0 +1,94 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_SESSIONINFOSTORE_H
+#define KWIN_SESSIONINFOSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+#include <kwinglobals.h>
+
+#include <functional>
+
+namespace KWin
+{
+
+class Client;
+struct SessionInfo;
+
+/**
+ * @brief Holds the session entries of windows which still have to be restored.
+ *
+ * Every window that gets managed during session restore looks for its saved entry. Scanning all
+ * entries for every window makes restoring a large session quadratic, so the entries are indexed
+ * by the keys they get matched with: session id and window role for session managed windows,
+ * resource class, resource name and WM_COMMAND for all others. Among several matching entries
+ * the one added first is taken, like with a linear scan.
+ *
+ * The store owns the entries, a taken entry has to be deleted by the caller.
+ **/
+class KWIN_EXPORT SessionInfoStore
+{
+public:
+    typedef std::function<bool (const SessionInfo *)> Filter;
+
+    SessionInfoStore() = default;
+    ~SessionInfoStore();
+
+    /**
+     * Adds @p info and takes ownership of it.
+     **/
+    void add(SessionInfo *info);
+    /**
+     * Deletes all entries.
+     **/
+    void clear();
+    int count() const {
+        return m_count;
+    }
+    bool isEmpty() const {
+        return m_count == 0;
+    }
+
+    /**
+     * Takes the entry of a session managed window. If @p windowRole is empty, only entries
+     * without window role and with the same @p resourceName and @p resourceClass match.
+     **/
+    SessionInfo *takeSessionManaged(const QByteArray &sessionId, const QByteArray &windowRole,
+                                    const QByteArray &resourceName, const QByteArray &resourceClass,
+                                    const Filter &filter);
+    /**
+     * Takes the entry of a window which is not session managed. If @p wmCommand is empty, the
+     * WM_COMMAND of the entries is not compared.
+     **/
+    SessionInfo *takeByResource(const QByteArray &resourceName, const QByteArray &resourceClass,
+                                const QByteArray &wmCommand, const Filter &filter);
+
+    /**
+     * Sets @p client as tab group client of all entries in @p tabGroup which do not have one yet.
+     **/
+    void setTabGroupClient(int tabGroup, Client *client);
+
+private:
+    typedef QPair<QByteArray, QByteArray> Key;
+    typedef QPair<Key, QByteArray> CommandKey;
+
+    SessionInfo *take(QList<SessionInfo *> &bucket, const Filter &filter);
+    void remove(SessionInfo *info);
+
+    int m_count = 0;
+    // entries are appended, so every bucket is in insertion order
+    QHash<Key, QList<SessionInfo *>> m_bySession;
+    QHash<Key, QList<SessionInfo *>> m_byResource;
+    QHash<CommandKey, QList<SessionInfo *>> m_byCommand;
+    QHash<int, QList<SessionInfo *>> m_byTabGroup;
+};
+
+}
+
+#endif
@@ -15,6 +15,7 @@
 
 #include "workspace.h"
 #include "client.h"
+#include "configcommitter.h"
 #include <QDebug>
 #include <QFile>
 #include <QSocketNotifier>
@@ -44,6 +45,10 @@ static KConfig *sessionConfig(QString id, QString key)
 
 void Workspace::saveState(QSessionManager &sm)
 {
+    // the session manager may kill us once the session got saved, write pending changes now
+    if (ConfigCommitter::self()) {
+        ConfigCommitter::self()->flush();
+    }
     // If the session manager is ksmserver, save stacking
     // order, active window, active desktop etc. in phase 1,
     // as ksmserver assures no interaction will be done
@@ -86,11 +91,28 @@ void Workspace::commitData(QSessionManager &sm)
 
   \sa loadSessionInfo()
  */
+/*!
+  Maps the toplevels in \a order to their index. Looking up every stored
+  client in the stacking order would make saving a large session quadratic.
+ */
+static QHash<Toplevel*, int> stackingOrderIndexes(const ToplevelList &order)
+{
+    QHash<Toplevel*, int> indexes;
+    indexes.reserve(order.count());
+    for (int i = 0; i < order.count(); ++i) {
+        indexes.insert(order.at(i), i);
+    }
+    return indexes;
+}
+
 void Workspace::storeSession(KConfig* config, SMSavePhase phase)
 {
     KConfigGroup cg(config, "Session");
     int count =  0;
     int active_client = -1;
+    const bool storeClients = phase == SMSavePhase2 || phase == SMSavePhase2Full;
+    const QHash<Toplevel*, int> stackingOrder = storeClients
+            ? stackingOrderIndexes(unconstrained_stacking_order) : QHash<Toplevel*, int>();
 
     for (ClientList::Iterator it = clients.begin(); it != clients.end(); ++it) {
         Client* c = (*it);
@@ -109,8 +131,8 @@ void Workspace::storeSession(KConfig* config, SMSavePhase phase)
         count++;
         if (c->isActive())
             active_client = count;
-        if (phase == SMSavePhase2 || phase == SMSavePhase2Full)
-            storeClient(cg, count, c);
+        if (storeClients)
+            storeClient(cg, count, c, stackingOrder.value(c, -1));
     }
     if (phase == SMSavePhase0) {
         // it would be much simpler to save these values to the config file,
@@ -129,7 +151,7 @@ void Workspace::storeSession(KConfig* config, SMSavePhase phase)
     }
 }
 
-void Workspace::storeClient(KConfigGroup &cg, int num, Client *c)
+void Workspace::storeClient(KConfigGroup &cg, int num, Client *c, int stackingOrder)
 {
     c->setSessionActivityOverride(false); //make sure we get the real values
     QString n = QString::number(num);
@@ -161,7 +183,7 @@ void Workspace::storeClient(KConfigGroup &cg, int num, Client *c)
     cg.writeEntry(QLatin1String("userNoBorder") + n, c->userNoBorder());
     cg.writeEntry(QLatin1String("windowType") + n, windowTypeToTxt(c->windowType()));
     cg.writeEntry(QLatin1String("shortcut") + n, c->shortcut().toString());
-    cg.writeEntry(QLatin1String("stackingOrder") + n, unconstrained_stacking_order.indexOf(c));
+    cg.writeEntry(QLatin1String("stackingOrder") + n, stackingOrder);
     // KConfig doesn't support long so we need to live with less precision on 64-bit systems
     cg.writeEntry(QLatin1String("tabGroup") + n, static_cast<int>(reinterpret_cast<long>(c->tabGroup())));
     cg.writeEntry(QLatin1String("activities") + n, c->activities());
@@ -173,6 +195,7 @@ void Workspace::storeSubSession(const QString &name, QSet<QByteArray> sessionIds
     KConfigGroup cg(KSharedConfig::openConfig(), QLatin1String("SubSession: ") + name);
     int count =  0;
     int active_client = -1;
+    const QHash<Toplevel*, int> stackingOrder = stackingOrderIndexes(unconstrained_stacking_order);
     for (ClientList::Iterator it = clients.begin(); it != clients.end(); ++it) {
         Client* c = (*it);
         if (c->windowType() > NET::Splash) {
@@ -192,7 +215,7 @@ void Workspace::storeSubSession(const QString &name, QSet<QByteArray> sessionIds
         count++;
         if (c->isActive())
             active_client = count;
-        storeClient(cg, count, c);
+        storeClient(cg, count, c, stackingOrder.value(c, -1));
     }
     cg.writeEntry("count", count);
     cg.writeEntry("active", active_client);
@@ -221,7 +244,6 @@ void Workspace::addSessionInfo(KConfigGroup &cg)
     for (int i = 1; i <= count; i++) {
         QString n = QString::number(i);
         SessionInfo* info = new SessionInfo;
-        session.append(info);
         info->sessionId = cg.readEntry(QLatin1String("sessionId") + n, QString()).toLatin1();
         info->windowRole = cg.readEntry(QLatin1String("windowRole") + n, QString()).toLatin1();
         info->wmCommand = cg.readEntry(QLatin1String("wmCommand") + n, QString()).toLatin1();
@@ -250,6 +272,7 @@ void Workspace::addSessionInfo(KConfigGroup &cg)
         info->tabGroup = cg.readEntry(QLatin1String("tabGroup") + n, 0);
         info->tabGroupClient = NULL;
         info->activities = cg.readEntry(QLatin1String("activities") + n, QStringList());
+        session.add(info);
     }
 }
 
@@ -270,6 +293,10 @@ void Workspace::loadSubSessionInfo(const QString &name)
  */
 SessionInfo* Workspace::takeSessionInfo(Client* c)
 {
+    if (session.isEmpty()) {
+        // reading the session properties needs round trips to the X server
+        return nullptr;
+    }
     SessionInfo *realInfo = 0;
     QByteArray sessionId = c->sessionId();
     QByteArray windowRole = c->windowRole();
@@ -277,56 +304,26 @@ SessionInfo* Workspace::takeSessionInfo(Client* c)
     QByteArray resourceName = c->resourceName();
     QByteArray resourceClass = c->resourceClass();
 
-    // First search ``session''
+    auto typeMatch = [c] (const SessionInfo *info) {
+        return sessionInfoWindowTypeMatch(c, info);
+    };
     if (! sessionId.isEmpty()) {
         // look for a real session managed client (algorithm suggested by ICCCM)
-        foreach (SessionInfo * info, session) {
-            if (realInfo)
-                break;
-            if (info->sessionId == sessionId && sessionInfoWindowTypeMatch(c, info)) {
-                if (! windowRole.isEmpty()) {
-                    if (info->windowRole == windowRole) {
-                        realInfo = info;
-                        session.removeAll(info);
-                    }
-                } else {
-                    if (info->windowRole.isEmpty()
-                            && info->resourceName == resourceName
-                            && info->resourceClass == resourceClass) {
-                        realInfo = info;
-                        session.removeAll(info);
-                    }
-                }
-            }
-        }
+        realInfo = session.takeSessionManaged(sessionId, windowRole, resourceName, resourceClass, typeMatch);
     } else {
         // look for a sessioninfo with matching features.
-        foreach (SessionInfo * info, session) {
-            if (realInfo)
-                break;
-            if (info->resourceName == resourceName
-                    && info->resourceClass == resourceClass
-                    && sessionInfoWindowTypeMatch(c, info)) {
-                if (wmCommand.isEmpty() || info->wmCommand == wmCommand) {
-                    realInfo = info;
-                    session.removeAll(info);
-                }
-            }
-        }
+        realInfo = session.takeByResource(resourceName, resourceClass, wmCommand, typeMatch);
     }
 
     // Set tabGroupClient for other clients in the same group
     if (realInfo && realInfo->tabGroup) {
-        foreach (SessionInfo * info, session) {
-            if (!info->tabGroupClient && info->tabGroup == realInfo->tabGroup)
-                info->tabGroupClient = c;
-        }
+        session.setTabGroupClient(realInfo->tabGroup, c);
     }
 
     return realInfo;
 }
 
-bool Workspace::sessionInfoWindowTypeMatch(Client* c, SessionInfo* info)
+bool Workspace::sessionInfoWindowTypeMatch(Client* c, const SessionInfo* info)
 {
     if (info->windowType == -2) {
         // undefined (not really part of NET::WindowType)
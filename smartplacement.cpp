@@ -0,0 +1,198 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "smartplacement.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace KWin
+{
+
+/**
+ * @returns the smallest of the sorted @p edges which is greater than @p value.
+ **/
+static int nextEdge(const QVector<int> &edges, int value)
+{
+    const auto it = std::upper_bound(edges.constBegin(), edges.constEnd(), value);
+    return it == edges.constEnd() ? std::numeric_limits<int>::max() : *it;
+}
+
+namespace
+{
+
+/**
+ * The windows crossing a row of candidate positions.
+ *
+ * Within the row a window only differs in its horizontal extent, the vertical overlap times the
+ * weight is a constant factor. The overlap of the range [left, right] with all windows is
+ * G(right) - G(left) where G(t) sums up factor * (clamp(t, window.left, window.right) - window.left),
+ * which the prefix sums over the sorted edges give with two binary searches.
+ **/
+class Band
+{
+public:
+    void update(const QVector<SmartPlacement::Window> &windows, int y, int height) {
+        QVector<Edge> lefts;
+        QVector<Edge> rights;
+        const int bottom = y + height;
+        for (const SmartPlacement::Window &window : windows) {
+            if (y < window.bottom && window.top < bottom) {
+                const qint64 factor = qint64(window.weight) * (qMin(bottom, window.bottom) - qMax(y, window.top));
+                lefts << Edge{window.left, factor};
+                rights << Edge{window.right, factor};
+            }
+        }
+        fill(lefts, m_lefts, m_leftSums);
+        fill(rights, m_rights, m_rightSums);
+        m_y = y;
+        m_valid = true;
+    }
+
+    bool isValid(int y) const {
+        return m_valid && m_y == y;
+    }
+
+    qint64 overlap(int left, int right) const {
+        return sum(right) - sum(left);
+    }
+
+    /**
+     * @returns the first x after @p x where a window of @p width starts or stops overlapping.
+     **/
+    int nextX(int x, int width) const {
+        return qMin(nextEdge(m_rights, x), nextEdge(m_lefts, x + width) - width);
+    }
+
+private:
+    struct Edge {
+        int position;
+        qint64 factor;
+    };
+    struct Sums {
+        qint64 factors;
+        qint64 moments;
+    };
+
+    static void fill(QVector<Edge> &edges, QVector<int> &positions, QVector<Sums> &sums) {
+        std::sort(edges.begin(), edges.end(),
+            [] (const Edge &a, const Edge &b) {
+                return a.position < b.position;
+            }
+        );
+        positions.resize(edges.count());
+        sums.resize(edges.count() + 1);
+        sums[0] = Sums{0, 0};
+        for (int i = 0; i < edges.count(); ++i) {
+            positions[i] = edges.at(i).position;
+            sums[i + 1].factors = sums.at(i).factors + edges.at(i).factor;
+            sums[i + 1].moments = sums.at(i).moments + edges.at(i).factor * edges.at(i).position;
+        }
+    }
+
+    qint64 sum(int t) const {
+        // windows starting before t and windows ending at or before t
+        const Sums &started = m_leftSums.at(std::lower_bound(m_lefts.constBegin(), m_lefts.constEnd(), t) - m_lefts.constBegin());
+        const Sums &ended = m_rightSums.at(std::upper_bound(m_rights.constBegin(), m_rights.constEnd(), t) - m_rights.constBegin());
+        return t * (started.factors - ended.factors) - started.moments + ended.moments;
+    }
+
+    QVector<int> m_lefts;
+    QVector<int> m_rights;
+    QVector<Sums> m_leftSums;
+    QVector<Sums> m_rightSums;
+    int m_y = 0;
+    bool m_valid = false;
+};
+
+}
+
+SmartPlacement::SmartPlacement(const QVector<Window> &windows)
+    : m_windows(windows)
+{
+    m_tops.reserve(windows.count());
+    m_bottoms.reserve(windows.count());
+    for (const Window &window : windows) {
+        m_tops << window.top;
+        m_bottoms << window.bottom;
+    }
+    std::sort(m_tops.begin(), m_tops.end());
+    std::sort(m_bottoms.begin(), m_bottoms.end());
+}
+
+QPoint SmartPlacement::place(const QRect &area, const QSize &size) const
+{
+    const qint64 none = 0, h_wrong = -1, w_wrong = -2; // overlap types
+    qint64 overlap, min_overlap = 0;
+    int x = area.left(), y = area.top();
+    int x_optimal = x, y_optimal = y;
+
+    //client gabarit
+    const int ch = size.height() - 1;
+    const int cw = size.width() - 1;
+
+    bool first_pass = true;
+    Band band;
+
+    //loop over possible positions
+    do {
+        //test if enough room in x and y directions
+        if (y + ch > area.bottom() && ch < area.height()) {
+            overlap = h_wrong; // this throws the algorithm to an exit
+        } else if (x + cw > area.right()) {
+            overlap = w_wrong;
+        } else {
+            if (!band.isValid(y)) {
+                band.update(m_windows, y, ch);
+            }
+            overlap = band.overlap(x, x + cw);
+        }
+
+        // first time we get no overlap we stop.
+        if (overlap == none) {
+            x_optimal = x;
+            y_optimal = y;
+            break;
+        }
+
+        if (first_pass) {
+            first_pass = false;
+            min_overlap = overlap;
+        }
+        // save the best position and the minimum overlap up to now
+        else if (overlap >= none && overlap < min_overlap) {
+            min_overlap = overlap;
+            x_optimal = x;
+            y_optimal = y;
+        }
+
+        if (overlap > none) {
+            // move right to the first x where a window in the row starts or stops overlapping
+            int possible = area.right();
+            if (possible - cw > x) {
+                possible -= cw;
+            }
+            x = qMin(possible, band.nextX(x, cw));
+        } else if (overlap == w_wrong) {
+            // not enough room left in the row, go down to the first y where any window starts
+            // or stops overlapping
+            x = area.left();
+            int possible = area.bottom();
+            if (possible - ch > y) {
+                possible -= ch;
+            }
+            possible = qMin(possible, nextEdge(m_bottoms, y));
+            possible = qMin(possible, nextEdge(m_tops, y + ch) - ch);
+            y = possible;
+        }
+    } while ((overlap != none) && (overlap != h_wrong) && (y < area.bottom()));
+
+    if (ch >= area.height()) {
+        y_optimal = area.top();
+    }
+    return QPoint(x_optimal, y_optimal);
+}
+
+}
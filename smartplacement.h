@@ -0,0 +1,58 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_SMARTPLACEMENT_H
+#define KWIN_SMARTPLACEMENT_H
+
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * @brief Finds the position of least overlap for a new window, the core of Placement::placeSmart.
+ *
+ * The candidate positions are scanned row by row from the top left of the area. Each row only
+ * considers the windows crossing it, kept sorted by their edges, so both the overlap at a
+ * position and the next position to test are found without going over every window again.
+ * The candidates, the first position without overlap and the tie-breaking between positions of
+ * the same overlap are the same as in the original smart placement by Cristian Tibirna.
+ **/
+class SmartPlacement
+{
+public:
+    /**
+     * A window the new window should not cover. @c right and @c bottom are exclusive.
+     **/
+    struct Window {
+        int left;
+        int top;
+        int right;
+        int bottom;
+        /**
+         * How much covering the window counts, 16 for keep above windows and 0 for keep
+         * below ones.
+         **/
+        int weight;
+    };
+
+    explicit SmartPlacement(const QVector<Window> &windows);
+
+    /**
+     * @returns the top left position for a window of @p size inside @p area.
+     **/
+    QPoint place(const QRect &area, const QSize &size) const;
+
+private:
+    QVector<Window> m_windows;
+    QVector<int> m_tops;
+    QVector<int> m_bottoms;
+};
+
+}
+
+#endif
@@ -24,7 +24,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "tabboxconfig.h"
 #include "tabboxhandler.h"
 // Qt
+#include <QHash>
 #include <QIcon>
+#include <QSet>
 // TODO: remove with Qt 5, only for HTML escaping the caption
 #include <QTextDocument>
 #include <QTextStream>
@@ -158,6 +160,22 @@ QModelIndex ClientModel::index(QWeakPointer<TabBoxClient> client) const
     return createIndex(row, column);
 }
 
+static QVector<int> configKey(const TabBoxConfig &config)
+{
+    return QVector<int>() << config.clientDesktopMode()
+                          << config.clientActivitiesMode()
+                          << config.clientApplicationsMode()
+                          << config.clientMinimizedMode()
+                          << config.clientMultiScreenMode()
+                          << config.showDesktopMode()
+                          << config.clientSwitchingMode();
+}
+
+bool ClientModel::isUpToDate(int desktop) const
+{
+    return m_desktop == desktop && m_configKey == configKey(tabBox->config());
+}
+
 void ClientModel::createClientList(bool partialReset)
 {
     createClientList(tabBox->currentDesktop(), partialReset);
@@ -174,8 +192,10 @@ void ClientModel::createClientList(int desktop, bool partialReset)
         }
     }
 
-    m_clientList.clear();
-    QList< QWeakPointer< TabBoxClient > > stickyClients;
+    TabBoxClientList clients;
+    TabBoxClientList stickyClients;
+    // a modal dialog is found for its parent and again for itself, list it only once
+    QSet<TabBoxClient*> listed;
 
     switch(tabBox->config().clientSwitchingMode()) {
     case TabBoxConfig::FocusChainSwitching: {
@@ -188,9 +208,11 @@ void ClientModel::createClientList(int desktop, bool partialReset)
         }
         TabBoxClient* stop = c;
         do {
-            QWeakPointer<TabBoxClient> add = tabBox->clientToAddToList(c, desktop);
-            if (!add.isNull()) {
-                m_clientList += add;
+            QWeakPointer<TabBoxClient> add = tabBox->clientToAddToList(c, desktop, clients);
+            if (!add.isNull() && !listed.contains(add.data())) {
+                listed.insert(add.data());
+                // stickies stay in the list until moved to the front, so their modals are not added twice
+                clients += add;
                 if (add.data()->isFirstInTabBox()) {
                     stickyClients << add;
                 }
@@ -206,13 +228,14 @@ void ClientModel::createClientList(int desktop, bool partialReset)
         TabBoxClient* stop = c;
         int index = 0;
         while (c) {
-            QWeakPointer<TabBoxClient> add = tabBox->clientToAddToList(c, desktop);
-            if (!add.isNull()) {
+            QWeakPointer<TabBoxClient> add = tabBox->clientToAddToList(c, desktop, clients);
+            if (!add.isNull() && !listed.contains(add.data())) {
+                listed.insert(add.data());
                 if (start == add.data()) {
-                    m_clientList.removeAll(add);
-                    m_clientList.prepend(add);
-                } else
-                    m_clientList += add;
+                    clients.prepend(add);
+                } else {
+                    clients += add;
+                }
                 if (add.data()->isFirstInTabBox()) {
                     stickyClients << add;
                 }
@@ -229,17 +252,123 @@ void ClientModel::createClientList(int desktop, bool partialReset)
         break;
     }
     }
-    foreach (const QWeakPointer< TabBoxClient > &c, stickyClients) {
-        m_clientList.removeAll(c);
-        m_clientList.prepend(c);
+    // sticky clients go to the front, the last one found first
+    for (const QWeakPointer< TabBoxClient > &c : qAsConst(stickyClients)) {
+        clients.removeAll(c);
+        clients.prepend(c);
     }
     if (tabBox->config().clientApplicationsMode() != TabBoxConfig::AllWindowsCurrentApplication
-            && (tabBox->config().showDesktopMode() == TabBoxConfig::ShowDesktopClient || m_clientList.isEmpty())) {
+            && (tabBox->config().showDesktopMode() == TabBoxConfig::ShowDesktopClient || clients.isEmpty())) {
         QWeakPointer<TabBoxClient> desktopClient = tabBox->desktopClient();
-        if (!desktopClient.isNull())
-            m_clientList.append(desktopClient);
+        if (!desktopClient.isNull() && !listed.contains(desktopClient.data()))
+            clients.append(desktopClient);
+    }
+    m_desktop = desktop;
+    m_configKey = configKey(tabBox->config());
+    setClientList(clients);
+}
+
+bool ClientModel::RowState::operator==(const RowState &other) const
+{
+    return caption == other.caption
+        && desktopName == other.desktopName
+        && iconKey == other.iconKey
+        && minimized == other.minimized
+        && closeable == other.closeable;
+}
+
+ClientModel::RowState ClientModel::rowState(const QWeakPointer<TabBoxClient> &clientPointer) const
+{
+    RowState state;
+    QSharedPointer<TabBoxClient> client = clientPointer.toStrongRef();
+    if (!client) {
+        return state;
+    }
+    state.caption = client->caption();
+    state.desktopName = tabBox->desktopName(client.data());
+    state.iconKey = client->icon().cacheKey();
+    state.minimized = client->isMinimized();
+    state.closeable = client->isCloseable() && !client->isFirstInTabBox();
+    return state;
+}
+
+void ClientModel::setClientList(const TabBoxClientList &clients)
+{
+    // Update the rows in place instead of resetting the model. This way the views keep the
+    // delegates, and with them thumbnails and icons, of all clients which stay in the list.
+    QHash<TabBoxClient*, RowState> oldStates;
+    oldStates.reserve(m_clientList.count());
+    for (int i = 0; i < m_clientList.count(); ++i) {
+        oldStates.insert(m_clientList.at(i).data(), m_rowStates.at(i));
+    }
+    QSet<TabBoxClient*> remaining;
+    remaining.reserve(clients.count());
+    for (const QWeakPointer<TabBoxClient> &client : clients) {
+        remaining.insert(client.data());
+    }
+    for (int last = m_clientList.count() - 1; last >= 0; --last) {
+        if (remaining.contains(m_clientList.at(last).data())) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !remaining.contains(m_clientList.at(first - 1).data())) {
+            --first;
+        }
+        beginRemoveRows(QModelIndex(), first, last);
+        m_clientList.erase(m_clientList.begin() + first, m_clientList.begin() + last + 1);
+        endRemoveRows();
+        last = first;
+    }
+
+    // now the old list only contains clients of the new list, move or insert them into place
+    for (int i = 0; i < clients.count(); ++i) {
+        TabBoxClient *client = clients.at(i).data();
+        if (i < m_clientList.count() && m_clientList.at(i).data() == client) {
+            continue;
+        }
+        int from = -1;
+        for (int j = i + 1; j < m_clientList.count(); ++j) {
+            if (m_clientList.at(j).data() == client) {
+                from = j;
+                break;
+            }
+        }
+        if (from != -1) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), i);
+            m_clientList.move(from, i);
+            endMoveRows();
+        } else {
+            beginInsertRows(QModelIndex(), i, i);
+            m_clientList.insert(i, clients.at(i));
+            endInsertRows();
+        }
+    }
+    // clients listed twice before only got moved into place once
+    if (m_clientList.count() > clients.count()) {
+        beginRemoveRows(QModelIndex(), clients.count(), m_clientList.count() - 1);
+        m_clientList.erase(m_clientList.begin() + clients.count(), m_clientList.end());
+        endRemoveRows();
+    }
+    Q_ASSERT(m_clientList == clients);
+
+    // captions and states of the kept clients might have changed, new rows got read on insertion
+    m_rowStates.resize(m_clientList.count());
+    int firstChanged = -1;
+    for (int i = 0; i <= m_clientList.count(); ++i) {
+        bool changed = false;
+        if (i < m_clientList.count()) {
+            const RowState state = rowState(m_clientList.at(i));
+            auto it = oldStates.constFind(m_clientList.at(i).data());
+            changed = it != oldStates.constEnd() && !(it.value() == state);
+            m_rowStates[i] = state;
+        }
+        if (changed && firstChanged == -1) {
+            firstChanged = i;
+        } else if (!changed && firstChanged != -1) {
+            emit dataChanged(index(firstChanged, 0), index(i - 1, 0));
+            firstChanged = -1;
+        }
     }
-    reset();
 }
 
 void ClientModel::close(int i)
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "tabboxhandler.h"
 
 #include <QModelIndex>
+#include <QVector>
 /**
 * @file
 * This file defines the class ClientModel, the model for TabBoxClients.
@@ -79,7 +80,8 @@ public:
 
     /**
     * Generates a new list of TabBoxClients based on the current config.
-    * Calling this method will reset the model. If partialReset is true
+    * The model is updated with row insertions, moves and removals instead
+    * of being reset. If partialReset is true
     * the top of the list is kept as a starting point. If not the
     * current active client is used as the starting point to generate the
     * list.
@@ -98,6 +100,13 @@ public:
     TabBoxClientList clientList() const {
         return m_clientList;
     }
+    /**
+    * The list is created for one desktop and one config. The TabBox keeps it up to date
+    * while it is hidden, so showing it only needs to create the list again if either changed.
+    * @param desktop The desktop the list is needed for
+    * @return @c true if the list was created for @p desktop with the current config
+    */
+    bool isUpToDate(int desktop) const;
 
 public Q_SLOTS:
     void close(int index);
@@ -108,8 +117,27 @@ public Q_SLOTS:
     void activate(int index);
 
 private:
+    /**
+    * Updates the model to contain @p clients with row removals, moves and insertions.
+    */
+    void setClientList(const TabBoxClientList &clients);
+    /**
+    * What the delegates show of a client, to only emit dataChanged for rows which changed.
+    */
+    struct RowState {
+        QString caption;
+        QString desktopName;
+        qint64 iconKey = 0;
+        bool minimized = false;
+        bool closeable = false;
+        bool operator==(const RowState &other) const;
+    };
+    RowState rowState(const QWeakPointer<TabBoxClient> &client) const;
     TabBoxClientList m_clientList;
+    QVector<RowState> m_rowStates;
     int              m_viewColumnCount = 0;
+    int              m_desktop = -1;
+    QVector<int>     m_configKey;
 };
 
 } // namespace Tabbox
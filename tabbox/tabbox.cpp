@@ -42,6 +42,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "focuschain.h"
 #include "screenedge.h"
 #include "screens.h"
+#include "shell_client.h"
 #include "unmanaged.h"
 #include "virtualdesktops.h"
 #include "workspace.h"
@@ -250,7 +251,7 @@ bool TabBoxHandlerImpl::checkMultiScreen(TabBoxClient* client) const
     }
 }
 
-QWeakPointer<TabBoxClient> TabBoxHandlerImpl::clientToAddToList(TabBoxClient* client, int desktop) const
+QWeakPointer<TabBoxClient> TabBoxHandlerImpl::clientToAddToList(TabBoxClient* client, int desktop, const TabBoxClientList &clientList) const
 {
     if (!client) {
         return QWeakPointer<TabBoxClient>();
@@ -269,7 +270,7 @@ QWeakPointer<TabBoxClient> TabBoxHandlerImpl::clientToAddToList(TabBoxClient* cl
         AbstractClient* modal = current->findModal();
         if (modal == nullptr || modal == current)
             ret = current;
-        else if (!clientList().contains(modal->tabBoxClient()))
+        else if (!clientList.contains(modal->tabBoxClient()))
             ret = modal;
         else {
             // nothing
@@ -529,7 +530,41 @@ void TabBox::handlerReady()
 {
     m_tabBox->setConfig(m_defaultConfig);
     reconfigure();
+    // keep the client list live, so Alt+Tab only has to show it; the focus chain
+    // does not exist yet when the TabBox gets created
+    m_clientListUpdateTimer.setSingleShot(true);
+    m_clientListUpdateTimer.setInterval(0);
+    connect(&m_clientListUpdateTimer, &QTimer::timeout, this, &TabBox::updateClientList);
+    auto scheduleClientListUpdate = [this] {
+        m_clientListUpdateTimer.start();
+    };
+    connect(FocusChain::self(), &FocusChain::changed, this, scheduleClientListUpdate);
+    connect(VirtualDesktopManager::self(), &VirtualDesktopManager::currentChanged, this, scheduleClientListUpdate);
+    connect(screens(), &Screens::currentChanged, this, scheduleClientListUpdate);
+#ifdef KWIN_BUILD_ACTIVITIES
+    if (Activities::self()) {
+        connect(Activities::self(), &Activities::currentChanged, this, scheduleClientListUpdate);
+    }
+#endif
+    // the list filters on these client properties, none of them touches the focus chain
+    const auto clients = Workspace::self()->allClientList();
+    for (AbstractClient *client : clients) {
+        watchClient(client);
+    }
+    connect(Workspace::self(), &Workspace::clientAdded, this, &TabBox::watchClient);
+    connect(Workspace::self(), &Workspace::shellClientAdded, this, &TabBox::watchClient);
     m_ready = true;
+    m_clientListUpdateTimer.start();
+}
+
+void TabBox::watchClient(AbstractClient *client)
+{
+    auto schedule = static_cast<void (QTimer::*)()>(&QTimer::start);
+    connect(client, &AbstractClient::screenChanged, &m_clientListUpdateTimer, schedule);
+    connect(client, &AbstractClient::skipSwitcherChanged, &m_clientListUpdateTimer, schedule);
+    connect(client, &AbstractClient::minimizedChanged, &m_clientListUpdateTimer, schedule);
+    connect(client, &AbstractClient::activitiesChanged, &m_clientListUpdateTimer, schedule);
+    connect(client, &AbstractClient::desktopChanged, &m_clientListUpdateTimer, schedule);
 }
 
 template <typename Slot>
@@ -639,10 +674,24 @@ void TabBox::setMode(TabBoxMode mode)
   Resets the tab box to display the active client in TabBoxWindowsMode, or the
   current desktop in TabBoxDesktopListMode
  */
+void TabBox::updateClientList()
+{
+    // while shown the Workspace resets the TabBox on client changes, this is only for the hidden list
+    if (!m_ready || isGrabbed() || isDisplayed()) {
+        return;
+    }
+    m_tabBox->updateClientList();
+}
+
 void TabBox::reset(bool partial_reset)
 {
     switch(m_tabBox->config().tabBoxMode()) {
     case TabBoxConfig::ClientTabBox:
+        if (!partial_reset && m_clientListUpdateTimer.isActive()) {
+            // the focus chain changed right before, don't show the outdated list
+            m_clientListUpdateTimer.stop();
+            m_tabBox->updateClientList();
+        }
         m_tabBox->createModel(partial_reset);
         if (!partial_reset) {
             if (Workspace::self()->activeClient())
@@ -824,6 +873,8 @@ void TabBox::reconfigure()
     m_alternativeCurrentApplicationConfig.setClientApplicationsMode(TabBoxConfig::AllWindowsCurrentApplication);
 
     m_tabBox->setConfig(m_defaultConfig);
+    // compile the configured switcher ahead of the first walk through windows
+    QTimer::singleShot(0, m_tabBox, &TabBoxHandler::preloadSwitcher);
 
     m_delayShow = config.readEntry<bool>("ShowDelay", true);
     m_delayShowTime = config.readEntry<int>("DelayTime", 90);
@@ -1563,6 +1614,8 @@ void TabBox::close(bool abort)
     m_desktopGrab = false;
     m_noModifierGrab = false;
     m_allClientMinisize.clear();
+    // the list was not kept up to date while grabbed
+    m_clientListUpdateTimer.start();
 }
 
 void TabBox::accept(bool closeTabBox)
@@ -71,7 +71,7 @@ public:
     virtual void restack(TabBoxClient *c, TabBoxClient *under);
     virtual void shadeClient(TabBoxClient *c, bool b) const;
     virtual void activateCurrentClient() const;
-    virtual QWeakPointer< TabBoxClient > clientToAddToList(KWin::TabBox::TabBoxClient* client, int desktop) const;
+    virtual QWeakPointer< TabBoxClient > clientToAddToList(KWin::TabBox::TabBoxClient* client, int desktop, const TabBoxClientList &clientList) const;
     virtual QWeakPointer< TabBoxClient > desktopClient() const;
     virtual void activateAndClose();
     void highlightWindows(TabBoxClient *window = nullptr, QWindow *controller = nullptr) override;
@@ -260,8 +260,14 @@ private:
 private Q_SLOTS:
     void reconfigure();
     void globalShortcutChanged(QAction *action, const QKeySequence &seq);
+    void updateClientList();
 
 private:
+    /**
+     * Updates the hidden client list when a property @p client gets filtered on changes.
+     **/
+    void watchClient(AbstractClient *client);
+
     TabBoxMode m_tabBoxMode;
     TabBoxHandlerImpl* m_tabBox;
     bool m_delayShow;
@@ -270,6 +276,8 @@ private:
     QDateTime m_delaySwitch;
 
     QTimer m_delayedShowTimer;
+    // compresses focus chain and client changes into one update of the hidden client list
+    QTimer m_clientListUpdateTimer;
     int m_displayRefcount;
 
     TabBoxConfig m_defaultConfig;
@@ -75,6 +75,11 @@ public:
     void endHighlightWindows(bool abort = false);
 
     void show();
+    /**
+    * Creates the switcher of the current config, so that showing it does not
+    * have to load and compile the QML.
+    */
+    void preload();
     QQuickWindow *window() const;
     SwitcherItem *switcherItem() const;
 
@@ -101,6 +106,7 @@ public:
     bool m_lastRaisedClientWasMinimized;
 
 private:
+    void initQml();
     QObject *createSwitcherItem(bool desktopMode);
     bool isUseQSGSoftwareRender();
 };
@@ -335,21 +341,46 @@ bool TabBoxHandlerPrivate::isUseQSGSoftwareRender()
     }
     return false;
 }
-void TabBoxHandlerPrivate::show()
+void TabBoxHandlerPrivate::initQml()
 {
 #ifndef KWIN_UNIT_TEST
+    if (m_qmlContext.isNull()) {
 #ifdef __mips__
-    if(isUseQSGSoftwareRender()) {
-        QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
-    }
+        // has to happen before the first switcher window gets created
+        if(isUseQSGSoftwareRender()) {
+            QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
+        }
 #endif
-    if (m_qmlContext.isNull()) {
         qmlRegisterType<SwitcherItem>("org.kde.kwin", 2, 0, "Switcher");
         m_qmlContext.reset(new QQmlContext(Scripting::self()->qmlEngine()));
     }
     if (m_qmlComponent.isNull()) {
         m_qmlComponent.reset(new QQmlComponent(Scripting::self()->qmlEngine()));
     }
+#endif
+}
+
+void TabBoxHandlerPrivate::preload()
+{
+#ifndef KWIN_UNIT_TEST
+    if (isShown || !config.isShowTabBox() || !Scripting::self()) {
+        return;
+    }
+    const bool desktopMode = (config.tabBoxMode() == TabBoxConfig::DesktopTabBox);
+    const QMap<QString, QObject*> &tabBoxes = desktopMode ? m_desktopTabBoxes : m_clientTabBoxes;
+    if (tabBoxes.contains(config.layoutName())) {
+        return;
+    }
+    initQml();
+    // the created switcher stays hidden until show sets the model and makes it visible
+    createSwitcherItem(desktopMode);
+#endif
+}
+
+void TabBoxHandlerPrivate::show()
+{
+#ifndef KWIN_UNIT_TEST
+    initQml();
     const bool desktopMode = (config.tabBoxMode() == TabBoxConfig::DesktopTabBox);
     auto findMainItem = [this](const QMap<QString, QObject *> &tabBoxes) -> QObject* {
         auto it = tabBoxes.constFind(config.layoutName());
@@ -442,6 +473,11 @@ void TabBoxHandler::show()
     }
 }
 
+void TabBoxHandler::preloadSwitcher()
+{
+    d->preload();
+}
+
 void TabBoxHandler::initHighlightWindows()
 {
     if (isKWinCompositing()) {
@@ -641,7 +677,10 @@ void TabBoxHandler::createModel(bool partialReset)
 {
     switch(d->config.tabBoxMode()) {
     case TabBoxConfig::ClientTabBox: {
-        d->clientModel()->createClientList(partialReset);
+        // the list is kept up to date while hidden, see updateClientList
+        if (partialReset || !d->clientModel()->isUpToDate(currentDesktop())) {
+            d->clientModel()->createClientList(partialReset);
+        }
         // TODO: C++11 use lambda function
         bool lastRaised = false;
         bool lastRaisedSucc = false;
@@ -669,6 +708,14 @@ void TabBoxHandler::createModel(bool partialReset)
     }
 }
 
+void TabBoxHandler::updateClientList()
+{
+    if (d->config.tabBoxMode() != TabBoxConfig::ClientTabBox) {
+        return;
+    }
+    d->clientModel()->createClientList(false);
+}
+
 QModelIndex TabBoxHandler::first() const
 {
     QAbstractItemModel* model;
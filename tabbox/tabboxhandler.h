@@ -212,9 +212,10 @@ public:
     * @param client The client to be checked for inclusion
     * @param desktop The desktop the client should be on. This is irrelevant if allDesktops is set
     * @param allDesktops Add clients from all desktops or only from current
+    * @param clientList The list under construction, a modal dialog already in it is not added again
     * @return The client to be included in the list or NULL if it isn't to be included
     */
-    virtual QWeakPointer<TabBoxClient> clientToAddToList(TabBoxClient* client, int desktop) const = 0;
+    virtual QWeakPointer<TabBoxClient> clientToAddToList(TabBoxClient* client, int desktop, const TabBoxClientList &clientList) const = 0;
     /**
     * @return The first desktop window in the stacking order.
     */
@@ -280,6 +281,19 @@ public:
     * @param partialReset Keep the currently selected item or regenerate everything
     */
     void createModel(bool partialReset = false);
+    /**
+    * Brings the client list up to date while the TabBox is hidden, after the focus chain
+    * or the clients changed. A following createModel() does not need to create it again then
+    * unless the desktop or the config changed in between.
+    * Does nothing if the config is not a TabBoxConfig::ClientTabBox.
+    */
+    void updateClientList();
+
+    /**
+    * Loads and instantiates the switcher of the current config without showing it.
+    * The first show of the TabBox does not need to compile the QML then.
+    */
+    void preloadSwitcher();
 
     /**
     * @param desktop The desktop whose index should be retrieved
@@ -83,9 +83,15 @@ QRect Toplevel::decorationRect() const
 }
 
 void Toplevel::detectShape(Window id)
+{
+    Xcb::ShapeExtents extents = Xcb::Extensions::self()->fetchShape(id);
+    detectShape(extents);
+}
+
+void Toplevel::detectShape(Xcb::ShapeExtents &extents)
 {
     const bool wasShape = is_shape;
-    is_shape = Xcb::Extensions::self()->hasShape(id);
+    is_shape = Xcb::Extensions::self()->hasShape(extents);
     if (wasShape != is_shape) {
         emit shapedChanged();
     }
@@ -179,7 +185,12 @@ QByteArray Toplevel::wmCommand()
 
 void Toplevel::getWmClientMachine()
 {
-    m_clientMachine->resolve(window(), wmClientLeader());
+    if (info && (info->passedProperties2() & NET::WM2ClientMachine)) {
+        // fetched along with the other window properties
+        m_clientMachine->resolve(info->clientMachine(), window(), wmClientLeader());
+    } else {
+        m_clientMachine->resolve(window(), wmClientLeader());
+    }
 }
 
 /*!
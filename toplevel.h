@@ -554,6 +554,7 @@ protected:
     virtual ~Toplevel();
     void setWindowHandles(xcb_window_t client);
     void detectShape(Window id);
+    void detectShape(Xcb::ShapeExtents &extents);
     virtual void propertyNotifyEvent(xcb_property_notify_event_t *e);
     virtual void damageNotifyEvent();
     virtual void clientMessageEvent(xcb_client_message_event_t *e);
@@ -58,6 +58,7 @@ bool Unmanaged::track(Window w)
                           NET::WM2Opacity |
                           NET::WM2WindowRole |
                           NET::WM2WindowClass |
+                          NET::WM2ClientMachine |
                           NET::WM2OpaqueRegion);
     getResourceClass();
     getWmClientLeader();
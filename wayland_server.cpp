@@ -33,6 +33,9 @@
 #include <KWayland/Server/dpms_interface.h>
 #include <KWayland/Server/idle_interface.h>
 #include <KWayland/Server/idleinhibit_interface.h>
+#if HAVE_LINUX_DMABUF
+#include <KWayland/Server/linuxdmabuf_v1_interface.h>
+#endif
 #include <KWayland/Server/output_interface.h>
 #include <KWayland/Server/plasmashell_interface.h>
 #include <KWayland/Server/plasmavirtualdesktop_interface.h>
@@ -466,6 +469,17 @@ SurfaceInterface *WaylandServer::findForeignTransientForSurface(SurfaceInterface
     return m_XdgForeign->transientFor(surface);
 }
 
+#if HAVE_LINUX_DMABUF
+KWayland::Server::LinuxDmabufUnstableV1Interface *WaylandServer::linuxDmabuf()
+{
+    if (!m_linuxDmabuf) {
+        m_linuxDmabuf = m_display->createLinuxDmabufInterface(m_display);
+        m_linuxDmabuf->create();
+    }
+    return m_linuxDmabuf;
+}
+#endif
+
 void WaylandServer::shellClientShown(Toplevel *t)
 {
     ShellClient *c = dynamic_cast<ShellClient*>(t);
@@ -9,9 +9,11 @@
 #define KWIN_WAYLAND_SERVER_H
 
 #include <kwinglobals.h>
+#include <config-kwin.h>
 
 #include <QObject>
 #include <QPointer>
+#include <QSet>
 
 class QThread;
 class QProcess;
@@ -37,6 +39,7 @@ class CompositorInterface;
 class Display;
 class DataDeviceInterface;
 class IdleInterface;
+class LinuxDmabufUnstableV1Interface;
 class ShellInterface;
 class SeatInterface;
 class DataDeviceManagerInterface;
@@ -71,6 +74,7 @@ class ShellClient;
 
 class AbstractClient;
 class AbstractOutput;
+class DmabufBuffer;
 class Toplevel;
 
 class KWIN_EXPORT WaylandServer : public QObject
@@ -137,6 +141,23 @@ public:
         return m_grabClient;
     }
 
+    /**
+     * Creates the zwp_linux_dmabuf_v1 global on first use. Only done by a scene
+     * which can import dmabuf buffers, so clients do not see it otherwise.
+     **/
+#if HAVE_LINUX_DMABUF
+    KWayland::Server::LinuxDmabufUnstableV1Interface *linuxDmabuf();
+#endif
+    QSet<DmabufBuffer*> linuxDmabufBuffers() const {
+        return m_linuxDmabufBuffers;
+    }
+    void addLinuxDmabufBuffer(DmabufBuffer *buffer) {
+        m_linuxDmabufBuffers << buffer;
+    }
+    void removeLinuxDmabufBuffer(DmabufBuffer *buffer) {
+        m_linuxDmabufBuffers.remove(buffer);
+    }
+
     QList<ShellClient*> clients() const {
         return m_clients;
     }
@@ -274,6 +295,10 @@ private:
     KWayland::Server::AppMenuManagerInterface *m_appMenuManager = nullptr;
     KWayland::Server::ServerSideDecorationPaletteManagerInterface *m_paletteManager = nullptr;
     KWayland::Server::IdleInterface *m_idle = nullptr;
+#if HAVE_LINUX_DMABUF
+    KWayland::Server::LinuxDmabufUnstableV1Interface *m_linuxDmabuf = nullptr;
+#endif
+    QSet<DmabufBuffer*> m_linuxDmabufBuffers;
     KWayland::Server::XdgOutputManagerInterface *m_xdgOutputManager = nullptr;
     KWayland::Server::XdgDecorationManagerInterface *m_xdgDecorationManager = nullptr;
     KWayland::Server::ClientManagementInterface *m_clientManagement = nullptr;
@@ -0,0 +1,168 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "windowidentity.h"
+
+#include <KDesktopFile>
+
+#include <QCache>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QStandardPaths>
+#include <QtConcurrentRun>
+
+namespace KWin
+{
+
+KWIN_SINGLETON_FACTORY(WindowIdentity)
+
+// number of desktop files kept in the cache
+static const int s_cacheSize = 128;
+// a cached desktop file is used without looking at the file system for this many milliseconds
+static const qint64 s_revalidateInterval = 10000;
+
+/**
+ * The cache is shared with the worker threads, so it outlives the WindowIdentity
+ * if a lookup is still running on shutdown.
+ **/
+class WindowIdentity::Cache
+{
+public:
+    Cache() {
+        m_entries.setMaxCost(s_cacheSize);
+    }
+
+    bool recentIconName(const QString &desktopFile, QString *iconName);
+    QString iconName(const QString &desktopFile);
+
+private:
+    struct Entry {
+        QString path;
+        QDateTime lastModified;
+        QString iconName;
+        QElapsedTimer validated;
+    };
+    QMutex m_mutex;
+    QCache<QString, Entry> m_entries;
+};
+
+bool WindowIdentity::Cache::recentIconName(const QString &desktopFile, QString *iconName)
+{
+    QMutexLocker locker(&m_mutex);
+    const Entry *entry = m_entries.object(desktopFile);
+    if (!entry || !entry->validated.isValid() || entry->validated.hasExpired(s_revalidateInterval)) {
+        return false;
+    }
+    *iconName = entry->iconName;
+    return true;
+}
+
+QString WindowIdentity::Cache::iconName(const QString &desktopFile)
+{
+    // runs in a worker thread
+    const QString path = QDir::isAbsolutePath(desktopFile)
+            ? desktopFile : QStandardPaths::locate(QStandardPaths::ApplicationsLocation, desktopFile);
+    const QDateTime lastModified = path.isEmpty() ? QDateTime() : QFileInfo(path).lastModified();
+    {
+        QMutexLocker locker(&m_mutex);
+        if (Entry *entry = m_entries.object(desktopFile)) {
+            if (entry->path == path && entry->lastModified == lastModified) {
+                entry->validated.start();
+                return entry->iconName;
+            }
+        }
+    }
+
+    Entry *entry = new Entry;
+    entry->path = path;
+    entry->lastModified = lastModified;
+    if (!path.isEmpty()) {
+        KDesktopFile df(path);
+        entry->iconName = df.readIcon();
+    }
+    entry->validated.start();
+    const QString iconName = entry->iconName;
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(desktopFile, entry);
+    return iconName;
+}
+
+WindowIdentity::WindowIdentity(QObject *parent)
+    : QObject(parent)
+    , m_cache(std::make_shared<Cache>())
+{
+}
+
+WindowIdentity::~WindowIdentity()
+{
+    s_self = nullptr;
+}
+
+void WindowIdentity::resolveIconName(const QByteArray &desktopFileName, QObject *context, std::function<void (const QString &)> callback)
+{
+    QString desktopFile = QString::fromUtf8(desktopFileName);
+    if (!desktopFile.endsWith(QLatin1String(".desktop"))) {
+        desktopFile.append(QLatin1String(".desktop"));
+    }
+    QString iconName;
+    if (m_cache->recentIconName(desktopFile, &iconName)) {
+        callback(iconName);
+        return;
+    }
+
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, context,
+        [watcher, callback] {
+            callback(watcher->result());
+        }
+    );
+    connect(watcher, &QFutureWatcher<QString>::finished, watcher, &QObject::deleteLater);
+    const std::shared_ptr<Cache> cache = m_cache;
+    watcher->setFuture(QtConcurrent::run(
+        [cache, desktopFile] {
+            return cache->iconName(desktopFile);
+        }
+    ));
+}
+
+QByteArray WindowIdentity::gioDesktopFileName(int pid)
+{
+    if (pid <= 0) {
+        return QByteArray();
+    }
+    QFile f(QStringLiteral("/proc/%1/environ").arg(pid));
+    if (!f.open(QFile::ReadOnly)) {
+        return QByteArray();
+    }
+    const QByteArray environment = f.readAll();
+
+    QByteArray desktopFile;
+    bool trusted = false;
+    // walk the null separated variables in place instead of splitting the whole environment
+    for (int start = 0; start < environment.size();) {
+        int end = environment.indexOf('\0', start);
+        if (end < 0) {
+            end = environment.size();
+        }
+        const QByteArray variable = QByteArray::fromRawData(environment.constData() + start, end - start);
+        if (variable.startsWith("GIO_LAUNCHED_DESKTOP_FILE=")) {
+            desktopFile = variable.mid(qstrlen("GIO_LAUNCHED_DESKTOP_FILE="));
+        } else if (variable.startsWith("GIO_LAUNCHED_DESKTOP_FILE_PID=")) {
+            trusted |= variable.mid(qstrlen("GIO_LAUNCHED_DESKTOP_FILE_PID=")).toInt() == pid;
+        } else if (variable.startsWith("WINEPREFIX=")) {
+            trusted = true;
+        }
+        start = end + 1;
+    }
+    return trusted ? desktopFile : QByteArray();
+}
+
+}
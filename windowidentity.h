@@ -0,0 +1,58 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_WINDOWIDENTITY_H
+#define KWIN_WINDOWIDENTITY_H
+
+#include <QObject>
+
+#include <kwinglobals.h>
+
+#include <functional>
+#include <memory>
+
+namespace KWin
+{
+
+/**
+ * @brief Resolves the desktop file metadata of managed windows.
+ *
+ * Locating and parsing a desktop file hits the file system, doing that synchronously while
+ * managing a window stalls the compositor whenever a burst of windows gets mapped. The desktop
+ * files are therefore parsed in a worker thread and the results are kept in a LRU cache keyed by
+ * the desktop file, which is only parsed again if its path or modification time changed.
+ **/
+class KWIN_EXPORT WindowIdentity : public QObject
+{
+    Q_OBJECT
+public:
+    virtual ~WindowIdentity();
+
+    /**
+     * Resolves the icon name of the desktop file @p desktopFileName.
+     *
+     * @p callback is invoked in the main thread with the icon name, which is empty if the desktop
+     * file does not exist or does not name an icon. If the desktop file got resolved recently the
+     * callback is invoked right away, otherwise once the worker thread is done. The callback is
+     * dropped if @p context gets destroyed in the meantime.
+     **/
+    void resolveIconName(const QByteArray &desktopFileName, QObject *context, std::function<void (const QString &)> callback);
+
+    /**
+     * @returns the desktop file the process @p pid got launched with by GIO, according to
+     * GIO_LAUNCHED_DESKTOP_FILE in its environment. The variable is only trusted if it belongs
+     * to @p pid itself or to a Wine process, otherwise it got inherited from a parent.
+     **/
+    static QByteArray gioDesktopFileName(int pid);
+
+private:
+    class Cache;
+    std::shared_ptr<Cache> m_cache;
+    KWIN_SINGLETON(WindowIdentity)
+};
+
+}
+
+#endif
@@ -17,6 +17,7 @@
 #include "atoms.h"
 #include "client.h"
 #include "composite.h"
+#include "configcommitter.h"
 #include "cursor.h"
 #include "dbusinterface.h"
 #include "deleted.h"
@@ -44,6 +45,7 @@
 #include "virtualdesktops.h"
 #include "shell_client.h"
 #include "was_user_interaction_x11_filter.h"
+#include "windowidentity.h"
 #include "wayland_server.h"
 #include "surface_interface.h"
 #include "buffer_interface.h"
@@ -161,6 +163,7 @@ Workspace::Workspace(const QString &sessionKey)
     connect(qApp, &QGuiApplication::saveStateRequest, this, &Workspace::saveState);
 
     RuleBook::create(this)->load();
+    WindowIdentity::create(this);
 
     ScreenEdges::create(this);
 
@@ -457,10 +460,13 @@ void Workspace::captureWindowImage(int windowId, wl_resource *buffer)
 void Workspace::initWithX11()
 {
     if (!kwinApp()->x11Connection()) {
-        connect(kwinApp(), &Application::x11ConnectionChanged, this, &Workspace::initWithX11, Qt::UniqueConnection);
+        // the workspace comes up before Xwayland, which calls in once it is ready
+        return;
+    }
+    if (m_nullFocus) {
+        // already set up
         return;
     }
-    disconnect(kwinApp(), &Application::x11ConnectionChanged, this, &Workspace::initWithX11);
 
     atoms->retrieveHelpers();
 
@@ -639,14 +645,16 @@ Workspace::~Workspace()
     }
 
     delete RuleBook::self();
+    if (ConfigCommitter::self()) {
+        ConfigCommitter::self()->flush();
+    }
     kwinApp()->config()->sync();
 
     RootInfo::destroy();
     delete startup;
     delete Placement::self();
     delete client_keys_dialog;
-    foreach (SessionInfo * s, session)
-    delete s;
+    session.clear();
 
     qDeleteAll(m_windowStates);
     m_windowStates.clear();
@@ -1028,7 +1036,7 @@ void Workspace::slotCurrentDesktopChanged(uint oldDesktop, uint newDesktop)
     activateClientOnNewDesktop(newDesktop);
     updateSplitOutlineState(oldDesktop, newDesktop);
     kwinApp()->config()->group("Workspace").writeEntry("CurrentDesktop", newDesktop);
-    kwinApp()->config()->sync();
+    ConfigCommitter::sync(kwinApp()->config());
     emit currentDesktopChanged(oldDesktop, movingClient);
 }
 
@@ -11,6 +11,7 @@
 
 // kwin
 #include "sm.h"
+#include "sessioninfostore.h"
 #include "options.h"
 #include "utils.h"
 // Qt
@@ -72,6 +73,12 @@ public:
     bool workspaceEvent(xcb_generic_event_t*);
     bool workspaceEvent(QEvent*);
 
+    /**
+     * Sets up the X11 part of the workspace. Called on creation if the X11 connection exists
+     * already, otherwise the Xwayland integration calls it once the connection is set up.
+     **/
+    void initWithX11();
+
     bool hasClient(const Client*);
     bool hasClient(const AbstractClient*);
 
@@ -354,7 +361,7 @@ public:
     void checkTransients(xcb_window_t w);
 
     void storeSession(KConfig* config, SMSavePhase phase);
-    void storeClient(KConfigGroup &cg, int num, Client *c);
+    void storeClient(KConfigGroup &cg, int num, Client *c, int stackingOrder);
     void storeSubSession(const QString &name, QSet<QByteArray> sessionIds);
     void loadSubSessionInfo(const QString &name);
 
@@ -624,7 +631,6 @@ Q_SIGNALS:
 
 private:
     void init();
-    void initWithX11();
     void initShortcuts();
     template <typename Slot>
     void initShortcut(const QString &actionName, const QString &description, const QKeySequence &shortcut,
@@ -674,10 +680,10 @@ private:
     void loadSessionInfo(const QString &key);
     void addSessionInfo(KConfigGroup &cg);
 
-    QList<SessionInfo*> session;
+    SessionInfoStore session;
     static const char* windowTypeToTxt(NET::WindowType type);
     static NET::WindowType txtToWindowType(const char* txt);
-    static bool sessionInfoWindowTypeMatch(Client* c, SessionInfo* info);
+    static bool sessionInfoWindowTypeMatch(Client* c, const SessionInfo* info);
 
     void updateXStackingOrder();
 
@@ -481,12 +481,21 @@ int Extensions::damageNotifyEvent() const
 }
 
 bool Extensions::hasShape(xcb_window_t w) const
+{
+    ShapeExtents extents = fetchShape(w);
+    return hasShape(extents);
+}
+
+ShapeExtents Extensions::fetchShape(xcb_window_t w) const
 {
     if (!isShapeAvailable()) {
-        return false;
+        return ShapeExtents();
     }
-    ScopedCPointer<xcb_shape_query_extents_reply_t> extents(xcb_shape_query_extents_reply(
-        connection(), xcb_shape_query_extents_unchecked(connection(), w), NULL));
+    return ShapeExtents(w);
+}
+
+bool Extensions::hasShape(ShapeExtents &extents) const
+{
     if (extents.isNull()) {
         return false;
     }
@@ -18,6 +18,7 @@
 #include <xcb/xcb.h>
 #include <xcb/composite.h>
 #include <xcb/randr.h>
+#include <xcb/shape.h>
 
 #include <xcb/shm.h>
 
@@ -576,6 +577,7 @@ public:
 };
 
 XCB_WRAPPER(Pointer, xcb_query_pointer, xcb_window_t)
+XCB_WRAPPER(ShapeExtents, xcb_shape_query_extents, xcb_window_t)
 
 struct CurrentInputData : public WrapperData< xcb_get_input_focus_reply_t, xcb_get_input_focus_cookie_t >
 {
@@ -831,6 +833,37 @@ public:
     }
 };
 
+/**
+ * @brief A text property like WM_NAME, which may be encoded as UTF8_STRING or STRING.
+ **/
+class TextProperty : public Property
+{
+public:
+    TextProperty() = default;
+    explicit TextProperty(xcb_window_t w, xcb_atom_t p)
+        : Property(false, w, p, XCB_ATOM_ANY, 0, 10000)
+    {
+    }
+    /**
+     * @brief Decodes the text of the property.
+     *
+     * @param utf8String The UTF8_STRING atom.
+     * @returns the simplified text, a null string if the property is not set or in another encoding.
+     **/
+    inline QString toString(xcb_atom_t utf8String) {
+        bool ok = false;
+        const QByteArray utf8 = toByteArray(8, utf8String, &ok);
+        if (ok) {
+            return QString::fromUtf8(utf8).simplified();
+        }
+        const QByteArray local8Bit = toByteArray(8, XCB_ATOM_STRING, &ok);
+        if (ok) {
+            return QString::fromLocal8Bit(local8Bit).simplified();
+        }
+        return QString();
+    }
+};
+
 class TransientFor : public Property
 {
 public:
@@ -1230,6 +1263,12 @@ public:
     bool isShapeInputAvailable() const;
     int shapeNotifyEvent() const;
     bool hasShape(xcb_window_t w) const;
+    /**
+     * Queries the shape extents of @p w without waiting for the reply, the query is only
+     * sent if the shape extension is available.
+     **/
+    ShapeExtents fetchShape(xcb_window_t w) const;
+    bool hasShape(ShapeExtents &extents) const;
     bool isRandrAvailable() const {
         return m_randr.present;
     }
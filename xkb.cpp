@@ -16,11 +16,14 @@
 // Qt
 #include <QTemporaryFile>
 #include <QKeyEvent>
+#include <QtConcurrentRun>
 // xkbcommon
 #include <xkbcommon/xkbcommon.h>
 #include <xkbcommon/xkbcommon-compose.h>
 #include <xkbcommon/xkbcommon-keysyms.h>
 // system
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
 #include <bitset>
@@ -34,6 +37,9 @@ Q_LOGGING_CATEGORY(KWIN_XKB, "kwin_xkbcommon", QtCriticalMsg)
 namespace KWin
 {
 
+// how many keymaps compiled from names are kept, including the active one
+static const int s_keymapCacheSize = 4;
+
 static void xkbLogHandler(xkb_context *context, xkb_log_level priority, const char *format, va_list args)
 {
     Q_UNUSED(context)
@@ -109,6 +115,9 @@ Xkb::Xkb(QObject *parent)
 
 Xkb::~Xkb()
 {
+    if (m_compiling) {
+        m_compileWatcher->waitForFinished();
+    }
     xkb_compose_state_unref(m_compose.state);
     xkb_compose_table_unref(m_compose.table);
     xkb_state_unref(m_state);
@@ -116,27 +125,6 @@ Xkb::~Xkb()
     xkb_context_unref(m_context);
 }
 
-void Xkb::reconfigure()
-{
-    if (!m_context) {
-        return;
-    }
-
-    xkb_keymap *keymap = nullptr;
-    if (!qEnvironmentVariableIsSet("KWIN_XKB_DEFAULT_KEYMAP")) {
-        keymap = loadKeymapFromConfig();
-    }
-    if (!keymap) {
-        qCDebug(KWIN_XKB) << "Could not create xkb keymap from configuration";
-        keymap = loadDefaultKeymap();
-    }
-    if (keymap) {
-        updateKeymap(keymap);
-    } else {
-        qCDebug(KWIN_XKB) << "Could not create default xkb keymap";
-    }
-}
-
 static bool stringIsEmptyOrNull(const char *str)
 {
     return str == nullptr || str[0] == '\0';
@@ -167,12 +155,182 @@ static void applyEnvironmentRules(xkb_rule_names &ruleNames)
     }
 }
 
-xkb_keymap *Xkb::loadKeymapFromConfig()
+static QByteArray fromRuleName(const char *name)
+{
+    return name ? QByteArray(name) : QByteArray();
+}
+
+static const char *toRuleName(const QByteArray &name)
+{
+    return name.isNull() ? nullptr : name.constData();
+}
+
+static CompiledKeymap::Names toNames(const xkb_rule_names &ruleNames)
+{
+    return CompiledKeymap::Names{
+        fromRuleName(ruleNames.rules),
+        fromRuleName(ruleNames.model),
+        fromRuleName(ruleNames.layout),
+        fromRuleName(ruleNames.variant),
+        fromRuleName(ruleNames.options)
+    };
+}
+
+static bool sameName(const QByteArray &a, const QByteArray &b)
+{
+    // xkbcommon picks the default for a null name but not for an empty one
+    return a.isNull() == b.isNull() && a == b;
+}
+
+bool CompiledKeymap::Names::operator==(const Names &other) const
+{
+    return sameName(rules, other.rules)
+        && sameName(model, other.model)
+        && sameName(layout, other.layout)
+        && sameName(variant, other.variant)
+        && sameName(options, other.options);
+}
+
+uint qHash(const CompiledKeymap::Names &names, uint seed)
+{
+    uint hash = seed;
+    for (const QByteArray *name : {&names.rules, &names.model, &names.layout, &names.variant, &names.options}) {
+        hash = hash * 31 + qHash(*name, seed) + (name->isNull() ? 0 : 1);
+    }
+    return hash;
+}
+
+CompiledKeymap::CompiledKeymap(xkb_keymap *keymap, int fd, quint32 size)
+    : m_keymap(keymap)
+    , m_fd(fd)
+    , m_size(size)
+{
+}
+
+CompiledKeymap::~CompiledKeymap()
+{
+    xkb_keymap_unref(m_keymap);
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+QSharedPointer<CompiledKeymap> CompiledKeymap::compile(const Names &names)
+{
+    xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    if (!context) {
+        qCDebug(KWIN_XKB) << "Could not create xkb context";
+        return QSharedPointer<CompiledKeymap>();
+    }
+    xkb_context_set_log_level(context, XKB_LOG_LEVEL_DEBUG);
+    xkb_context_set_log_fn(context, &xkbLogHandler);
+
+    const xkb_rule_names ruleNames = {
+        .rules = toRuleName(names.rules),
+        .model = toRuleName(names.model),
+        .layout = toRuleName(names.layout),
+        .variant = toRuleName(names.variant),
+        .options = toRuleName(names.options)
+    };
+    xkb_keymap *keymap = xkb_keymap_new_from_names(context, &ruleNames, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    // the keymap holds its own reference to the context
+    xkb_context_unref(context);
+    if (!keymap) {
+        return QSharedPointer<CompiledKeymap>();
+    }
+    return create(keymap);
+}
+
+static bool writeAll(int fd, const char *data, quint32 size)
+{
+    quint32 written = 0;
+    while (written < size) {
+        const ssize_t result = write(fd, data + written, size - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += result;
+    }
+    return true;
+}
+
+static int createKeymapFd(const char *keymapString, quint32 size)
+{
+#ifdef F_SEAL_SEAL
+    int fd = memfd_create("kwin-xkb-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd >= 0) {
+        if (writeAll(fd, keymapString, size)) {
+            // clients get the same file, none of them may change it for the others
+            fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+            return fd;
+        }
+        close(fd);
+    }
+#endif
+    QTemporaryFile tmp;
+    if (!tmp.open()) {
+        return -1;
+    }
+    unlink(tmp.fileName().toUtf8().constData());
+    if (!writeAll(tmp.handle(), keymapString, size)) {
+        return -1;
+    }
+    return fcntl(tmp.handle(), F_DUPFD_CLOEXEC, 0);
+}
+
+QSharedPointer<CompiledKeymap> CompiledKeymap::create(xkb_keymap *keymap)
+{
+    Q_ASSERT(keymap);
+    ScopedCPointer<char> keymapString(xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1));
+    if (keymapString.isNull()) {
+        return QSharedPointer<CompiledKeymap>(new CompiledKeymap(keymap, -1, 0));
+    }
+    const quint32 size = qstrlen(keymapString.data()) + 1;
+    const int fd = createKeymapFd(keymapString.data(), size);
+    if (fd < 0) {
+        qCDebug(KWIN_XKB) << "Could not create keymap file";
+    }
+    return QSharedPointer<CompiledKeymap>(new CompiledKeymap(keymap, fd, fd < 0 ? 0 : size));
+}
+
+void Xkb::reconfigure()
+{
+    if (!m_context) {
+        return;
+    }
+
+    m_requestedNames = configuredNames();
+    m_keymapRequested = true;
+    requestKeymap();
+}
+
+void Xkb::requestKeymap()
 {
-    // load config
-    if (!m_config) {
-        return nullptr;
+    // a layout used before applies right away, others get compiled in a thread while the
+    // current keymap stays active
+    if (const auto keymap = cachedKeymap(m_requestedNames)) {
+        m_keymapRequested = false;
+        updateKeymap(keymap);
+        return;
     }
+    if (!m_compiling) {
+        compileKeymap(m_requestedNames);
+    }
+}
+
+CompiledKeymap::Names Xkb::configuredNames() const
+{
+    if (!qEnvironmentVariableIsSet("KWIN_XKB_DEFAULT_KEYMAP") && m_config) {
+        return namesFromConfig();
+    }
+    return defaultNames();
+}
+
+CompiledKeymap::Names Xkb::namesFromConfig() const
+{
     const KConfigGroup config = m_config->group("Layout");
     const QByteArray model = config.readEntry("Model", "pc104").toLocal8Bit();
     const QByteArray layout = config.readEntry("LayoutList", "").toLocal8Bit();
@@ -186,14 +344,100 @@ xkb_keymap *Xkb::loadKeymapFromConfig()
         .options = options.constData()
     };
     applyEnvironmentRules(ruleNames);
-    return xkb_keymap_new_from_names(m_context, &ruleNames, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    return toNames(ruleNames);
 }
 
-xkb_keymap *Xkb::loadDefaultKeymap()
+CompiledKeymap::Names Xkb::defaultNames() const
 {
     xkb_rule_names ruleNames = {};
     applyEnvironmentRules(ruleNames);
-    return xkb_keymap_new_from_names(m_context, &ruleNames, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    return toNames(ruleNames);
+}
+
+void Xkb::compileKeymap(const CompiledKeymap::Names &names)
+{
+    if (!m_compileWatcher) {
+        m_compileWatcher = new QFutureWatcher<QSharedPointer<CompiledKeymap>>(this);
+        connect(m_compileWatcher, &QFutureWatcher<QSharedPointer<CompiledKeymap>>::finished, this, &Xkb::keymapCompiled);
+    }
+    const CompiledKeymap::Names fallback = defaultNames();
+    m_compilingNames = names;
+    m_compiling = true;
+    m_compileWatcher->setFuture(QtConcurrent::run(
+        [names, fallback] {
+            QSharedPointer<CompiledKeymap> keymap = CompiledKeymap::compile(names);
+            if (!keymap && names != fallback) {
+                qCDebug(KWIN_XKB) << "Could not create xkb keymap from configuration";
+                keymap = CompiledKeymap::compile(fallback);
+            }
+            if (!keymap) {
+                qCDebug(KWIN_XKB) << "Could not create default xkb keymap";
+            }
+            return keymap;
+        }
+    ));
+}
+
+void Xkb::keymapCompiled()
+{
+    // waitForKeymap may have handled the compilation before the watcher reported it
+    if (!m_compiling || !m_compileWatcher->isFinished()) {
+        return;
+    }
+    m_compiling = false;
+    const QSharedPointer<CompiledKeymap> keymap = m_compileWatcher->result();
+    if (keymap) {
+        cacheKeymap(m_compilingNames, keymap);
+    }
+    if (!m_keymapRequested) {
+        return;
+    }
+    if (m_compilingNames != m_requestedNames) {
+        // the configuration changed during the compilation
+        requestKeymap();
+        return;
+    }
+    m_keymapRequested = false;
+    if (keymap) {
+        updateKeymap(keymap);
+    }
+}
+
+QSharedPointer<CompiledKeymap> Xkb::cachedKeymap(const CompiledKeymap::Names &names)
+{
+    const QSharedPointer<CompiledKeymap> keymap = m_keymapCache.value(names);
+    if (keymap) {
+        m_keymapCacheOrder.move(m_keymapCacheOrder.indexOf(names), 0);
+    }
+    return keymap;
+}
+
+void Xkb::cacheKeymap(const CompiledKeymap::Names &names, const QSharedPointer<CompiledKeymap> &keymap)
+{
+    if (m_keymapCache.contains(names)) {
+        m_keymapCacheOrder.removeOne(names);
+    }
+    m_keymapCache.insert(names, keymap);
+    m_keymapCacheOrder.prepend(names);
+    // each keymap holds its compiled tables and a file, keep only the recent ones
+    for (int i = m_keymapCacheOrder.count() - 1; i >= 0 && m_keymapCacheOrder.count() > s_keymapCacheSize; --i) {
+        const CompiledKeymap::Names &evicted = m_keymapCacheOrder.at(i);
+        if (m_keymapCache.value(evicted) == m_compiledKeymap) {
+            continue;
+        }
+        m_keymapCache.remove(evicted);
+        m_keymapCacheOrder.removeAt(i);
+    }
+}
+
+bool Xkb::waitForKeymap()
+{
+    // the first keys at startup may arrive before the keymap is compiled
+    while (!m_keymap && m_compiling) {
+        m_compileWatcher->waitForFinished();
+        keymapCompiled();
+    }
+    return m_keymap != nullptr;
 }
 
 void Xkb::installKeymap(int fd, uint32_t size)
@@ -212,24 +456,25 @@ void Xkb::installKeymap(int fd, uint32_t size)
         return;
     }
     m_ownership = Ownership::Client;
-    updateKeymap(keymap);
+    m_keymapRequested = false;
+    updateKeymap(CompiledKeymap::create(keymap));
 }
 
-void Xkb::updateKeymap(xkb_keymap *keymap)
+void Xkb::updateKeymap(const QSharedPointer<CompiledKeymap> &keymap)
 {
     Q_ASSERT(keymap);
-    xkb_state *state = xkb_state_new(keymap);
+    xkb_state *state = xkb_state_new(keymap->keymap());
     if (!state) {
         qCDebug(KWIN_XKB) << "Could not create XKB state";
-        xkb_keymap_unref(keymap);
         return;
     }
     // now release the old ones
     xkb_state_unref(m_state);
     xkb_keymap_unref(m_keymap);
 
-    m_keymap = keymap;
+    m_keymap = xkb_keymap_ref(keymap->keymap());
     m_state = state;
+    m_compiledKeymap = keymap;
 
     m_shiftModifier   = xkb_keymap_mod_get_index(m_keymap, XKB_MOD_NAME_SHIFT);
     m_capsModifier    = xkb_keymap_mod_get_index(m_keymap, XKB_MOD_NAME_CAPS);
@@ -271,6 +516,7 @@ void Xkb::updateKeymap(xkb_keymap *keymap)
     createKeymapFile();
     forwardModifiers();
     updateModifiers();
+    emit keymapChanged();
 }
 
 void Xkb::createKeymapFile()
@@ -279,40 +525,16 @@ void Xkb::createKeymapFile()
         return;
     }
     // TODO: uninstall keymap on server?
-    if (!m_keymap) {
-        return;
-    }
-
-    ScopedCPointer<char> keymapString(xkb_keymap_get_as_string(m_keymap, XKB_KEYMAP_FORMAT_TEXT_V1));
-    if (keymapString.isNull()) {
-        return;
-    }
-    const uint size = qstrlen(keymapString.data()) + 1;
-
-    QTemporaryFile *tmp = new QTemporaryFile(this);
-    if (!tmp->open()) {
-        delete tmp;
-        return;
-    }
-    unlink(tmp->fileName().toUtf8().constData());
-    if (!tmp->resize(size)) {
-        delete tmp;
-        return;
-    }
-    uchar *address = tmp->map(0, size);
-    if (!address) {
+    if (!m_compiledKeymap || m_compiledKeymap->fd() < 0) {
         return;
     }
-    if (qstrncpy(reinterpret_cast<char*>(address), keymapString.data(), size) == nullptr) {
-        delete tmp;
-        return;
-    }
-    m_seat->setKeymap(tmp->handle(), size);
+    // all clients share the sealed file of the keymap, it stays open as long as the keymap is used
+    m_seat->setKeymap(m_compiledKeymap->fd(), m_compiledKeymap->size());
 }
 
 void Xkb::updateModifiers(uint32_t modsDepressed, uint32_t modsLatched, uint32_t modsLocked, uint32_t group)
 {
-    if (!m_keymap || !m_state) {
+    if (!waitForKeymap() || !m_state) {
         return;
     }
     xkb_state_update_mask(m_state, modsDepressed, modsLatched, modsLocked, 0, 0, group);
@@ -355,7 +577,7 @@ void Xkb::updateKey(uint32_t key, InputRedirection::KeyboardKeyState state)
         m_kwinScreenOn = ScreenStatus::AlreadyScreenOn;
         emit ledsChanged(0);
     }
-    if (!m_keymap || !m_state) {
+    if (!waitForKeymap() || !m_state) {
         return;
     }
     xkb_state_update_key(m_state, key + 8, static_cast<xkb_key_direction>(state));
@@ -8,7 +8,10 @@
 #define KWIN_XKB_H
 #include "input.h"
 
+#include <QFutureWatcher>
+#include <QHash>
 #include <QObject>
+#include <QSharedPointer>
 #include <QtDBus>
 
 #include <kwin_export.h>
@@ -45,6 +48,63 @@ enum KWIN_EXPORT ScreenStatus {
     AlreadyScreenOn
 };
 
+/**
+ * @brief A compiled keymap together with the file it is handed out to clients in.
+ *
+ * The keymap gets serialized once into a sealed memfd, all Wayland clients including Xwayland
+ * get the same file descriptor, they can map it but not modify it.
+ **/
+class KWIN_EXPORT CompiledKeymap
+{
+public:
+    /**
+     * The RMLVO names a keymap gets compiled from, null and empty names differ.
+     **/
+    struct Names {
+        QByteArray rules;
+        QByteArray model;
+        QByteArray layout;
+        QByteArray variant;
+        QByteArray options;
+        bool operator==(const Names &other) const;
+        bool operator!=(const Names &other) const {
+            return !(*this == other);
+        }
+    };
+
+    ~CompiledKeymap();
+
+    /**
+     * Compiles the keymap for @p names with an xkb context of its own, so it is safe to call
+     * from any thread. The keymap may only be used by one thread at a time.
+     * @returns the keymap or @c nullptr if it does not compile.
+     **/
+    static QSharedPointer<CompiledKeymap> compile(const Names &names);
+    /**
+     * Takes over the reference to @p keymap and creates the file for it.
+     **/
+    static QSharedPointer<CompiledKeymap> create(xkb_keymap *keymap);
+
+    xkb_keymap *keymap() const {
+        return m_keymap;
+    }
+    int fd() const {
+        return m_fd;
+    }
+    quint32 size() const {
+        return m_size;
+    }
+
+private:
+    CompiledKeymap(xkb_keymap *keymap, int fd, quint32 size);
+    Q_DISABLE_COPY(CompiledKeymap)
+    xkb_keymap *m_keymap;
+    int m_fd;
+    quint32 m_size;
+};
+
+KWIN_EXPORT uint qHash(const CompiledKeymap::Names &names, uint seed = 0);
+
 class KWIN_EXPORT Xkb : public QObject, protected QDBusContext
 {
     Q_OBJECT
@@ -59,6 +119,12 @@ public:
         m_numLockConfig = std::move(config);
     }
     void reconfigure();
+    /**
+     * Whether a keymap compiles in a thread, for auto tests.
+     **/
+    bool isCompilingKeymap() const {
+        return m_compiling;
+    }
 
     void installKeymap(int fd, uint32_t size);
     void updateModifiers(uint32_t modsDepressed, uint32_t modsLatched, uint32_t modsLocked, uint32_t group);
@@ -121,11 +187,22 @@ public Q_SLOTS:
     }
 Q_SIGNALS:
     void ledsChanged(const LEDs &leds);
+    /**
+     * Emitted when a new keymap became active, after reconfigure() this may be later.
+     **/
+    void keymapChanged();
 
 private:
-    xkb_keymap *loadKeymapFromConfig();
-    xkb_keymap *loadDefaultKeymap();
-    void updateKeymap(xkb_keymap *keymap);
+    CompiledKeymap::Names configuredNames() const;
+    CompiledKeymap::Names namesFromConfig() const;
+    CompiledKeymap::Names defaultNames() const;
+    void requestKeymap();
+    void compileKeymap(const CompiledKeymap::Names &names);
+    void keymapCompiled();
+    QSharedPointer<CompiledKeymap> cachedKeymap(const CompiledKeymap::Names &names);
+    void cacheKeymap(const CompiledKeymap::Names &names, const QSharedPointer<CompiledKeymap> &keymap);
+    bool waitForKeymap();
+    void updateKeymap(const QSharedPointer<CompiledKeymap> &keymap);
     void createKeymapFile();
     void updateModifiers();
     void updateConsumedModifiers(uint32_t key);
@@ -169,6 +246,24 @@ private:
 
     QPointer<KWayland::Server::SeatInterface> m_seat;
     static ScreenStatus m_kwinScreenOn;
+
+    /**
+     * The active keymap and its file. The keymaps compiled from names stay cached, the active
+     * one and the few used before it.
+     **/
+    QSharedPointer<CompiledKeymap> m_compiledKeymap;
+    QHash<CompiledKeymap::Names, QSharedPointer<CompiledKeymap>> m_keymapCache;
+    // the names of the cached keymaps, most recently used first
+    QList<CompiledKeymap::Names> m_keymapCacheOrder;
+    /**
+     * The names the configuration asked for last, a compilation for other names finishing
+     * is cached but not applied. A keymap installed by a client drops the request.
+     **/
+    CompiledKeymap::Names m_requestedNames;
+    bool m_keymapRequested = false;
+    CompiledKeymap::Names m_compilingNames;
+    bool m_compiling = false;
+    QFutureWatcher<QSharedPointer<CompiledKeymap>> *m_compileWatcher = nullptr;
 };
 
 inline
@@ -7,10 +7,12 @@
 
 #include "xwayland.h"
 #include "databridge.h"
+#include "xwaylandsocket.h"
 
 #include "wayland_server.h"
 #include "main_wayland.h"
 #include "utils.h"
+#include "workspace.h"
 
 #include <KLocalizedString>
 
@@ -98,6 +100,46 @@ Xwayland::~Xwayland()
 }
 
 void Xwayland::init()
+{
+    start();
+}
+
+bool Xwayland::listen()
+{
+    m_socket.reset(new XwaylandSocket);
+    if (!m_socket->isValid()) {
+        std::cerr << "Failed to reserve an X11 display, starting Xwayland right away" << std::endl;
+        m_socket.reset();
+        return false;
+    }
+    const QByteArray display = m_socket->name().toUtf8();
+    std::cout << "X-Server waiting for clients on display " << display.constData() << std::endl;
+    setenv("DISPLAY", display.constData(), true);
+    auto env = m_app->processStartupEnvironment();
+    env.insert(QStringLiteral("DISPLAY"), QString::fromUtf8(display));
+    m_app->setProcessStartupEnvironment(env);
+
+    const auto fds = m_socket->fileDescriptors();
+    for (int fd : fds) {
+        QSocketNotifier *notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this,
+            [this] {
+                // Xwayland accepts the pending connection itself, the notifiers are
+                // still inside their activated signal, so only delete them later
+                for (QSocketNotifier *notifier : qAsConst(m_socketNotifiers)) {
+                    notifier->setEnabled(false);
+                    notifier->deleteLater();
+                }
+                m_socketNotifiers.clear();
+                start();
+            }
+        );
+        m_socketNotifiers << notifier;
+    }
+    return true;
+}
+
+void Xwayland::start()
 {
     int pipeFds[2];
     if (pipe(pipeFds) != 0) {
@@ -140,11 +182,29 @@ void Xwayland::init()
     env.insert("WAYLAND_SOCKET", QByteArray::number(wlfd));
     env.insert("EGL_PLATFORM", QByteArrayLiteral("DRM"));
     m_xwaylandProcess->setProcessEnvironment(env);
-    m_xwaylandProcess->setArguments({QStringLiteral("-displayfd"),
-                           QString::number(pipeFds[1]),
-                           QStringLiteral("-rootless"),
-                           QStringLiteral("-wm"),
-                           QString::number(fd)});
+    QStringList arguments;
+    QVector<int> listenFds;
+    if (m_socket) {
+        // the listening sockets stay with KWin, Xwayland gets inheritable copies
+        arguments << m_socket->name();
+        const auto fds = m_socket->fileDescriptors();
+        for (int socketFd : fds) {
+            const int listenFd = dup(socketFd);
+            if (listenFd < 0) {
+                std::cerr << "FATAL ERROR: failed to pass the X11 display socket to Xwayland" << std::endl;
+                Q_EMIT criticalError(20);
+                return;
+            }
+            arguments << QStringLiteral("-listen") << QString::number(listenFd);
+            listenFds << listenFd;
+        }
+    }
+    arguments << QStringLiteral("-displayfd")
+              << QString::number(pipeFds[1])
+              << QStringLiteral("-rootless")
+              << QStringLiteral("-wm")
+              << QString::number(fd);
+    m_xwaylandProcess->setArguments(arguments);
     m_xwaylandFailConnection = connect(m_xwaylandProcess, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error), this,
         [this] (QProcess::ProcessError error) {
             if (error == QProcess::FailedToStart) {
@@ -157,7 +217,10 @@ void Xwayland::init()
     );
     const int xDisplayPipe = pipeFds[0];
     connect(m_xwaylandProcess, &QProcess::started, this,
-        [this, xDisplayPipe] {
+        [this, xDisplayPipe, listenFds] {
+            for (int listenFd : listenFds) {
+                close(listenFd);
+            }
             QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
             QObject::connect(watcher, &QFutureWatcher<void>::finished, this, &Xwayland::continueStartupWithX, Qt::QueuedConnection);
             QObject::connect(watcher, &QFutureWatcher<void>::finished, watcher, &QFutureWatcher<void>::deleteLater, Qt::QueuedConnection);
@@ -193,7 +256,8 @@ void Xwayland::createX11Connection()
     m_xcbScreen = iter.data;
     Q_ASSERT(m_xcbScreen);
 
-    m_app->setX11Connection(c);
+    // the listeners of x11ConnectionChanged need the atoms, it gets emitted once they exist
+    m_app->setX11Connection(c, false);
     // we don't support X11 multi-head in Wayland
     m_app->setX11ScreenNumber(screenNumber);
     m_app->setX11RootWindow(defaultScreen()->root);
@@ -250,16 +314,21 @@ void Xwayland::continueStartupWithX()
         return;
     }
 
+    Q_EMIT m_app->x11ConnectionChanged();
+
     auto env = m_app->processStartupEnvironment();
     env.insert(QStringLiteral("DISPLAY"), QString::fromUtf8(qgetenv("DISPLAY")));
     m_app->setProcessStartupEnvironment(env);
 
-    m_app->startSession();
-    m_app->createWorkspace();
+    // the workspace comes up while Xwayland starts, it takes over the X11 windows now
+    if (Workspace::self()) {
+        Workspace::self()->initWithX11();
+    }
 
     Xcb::sync(); // Trigger possible errors, there's still a chance to abort
 
-    m_app->notifyKSplash();
+    m_app->markStartupStep(QByteArrayLiteral("xwayland"));
+    Q_EMIT started();
 }
 
 DragEventReply Xwayland::dragMoveFilter(Toplevel *target, QPoint pos)
@@ -11,7 +11,11 @@
 
 #include <xcb/xproto.h>
 
+#include <QScopedPointer>
+#include <QVector>
+
 class QProcess;
+class QSocketNotifier;
 
 class xcb_screen_t;
 
@@ -22,6 +26,7 @@ class ApplicationWaylandAbstract;
 namespace Xwl
 {
 class DataBridge;
+class XwaylandSocket;
 
 class Xwayland : public XwaylandInterface
 {
@@ -32,7 +37,16 @@ public:
     Xwayland(ApplicationWaylandAbstract *app, QObject *parent = nullptr);
     virtual ~Xwayland();
 
+    /**
+     * Starts Xwayland right away, it picks a free display itself.
+     **/
     void init();
+    /**
+     * Reserves a display and listens on its socket, Xwayland only gets started once the first
+     * X11 client connects. DISPLAY is set when this returns.
+     * @returns @c false if no display could be reserved, init() needs to be used then.
+     **/
+    bool listen();
     void prepareDestroy();
 
     xcb_screen_t *xcbScreen() const {
@@ -44,8 +58,13 @@ public:
 
 Q_SIGNALS:
     void criticalError(int code);
+    /**
+     * Emitted when the X11 connection is set up and the workspace manages X11 windows.
+     **/
+    void started();
 
 private:
+    void start();
     void createX11Connection();
     void continueStartupWithX();
 
@@ -58,6 +77,8 @@ private:
     xcb_screen_t *m_xcbScreen = nullptr;
     const xcb_query_extension_reply_t *m_xfixes = nullptr;
     DataBridge *m_dataBridge = nullptr;
+    QScopedPointer<XwaylandSocket> m_socket;
+    QVector<QSocketNotifier *> m_socketNotifiers;
 
     ApplicationWaylandAbstract *m_app;
 };
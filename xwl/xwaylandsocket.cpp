@@ -0,0 +1,156 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "xwaylandsocket.h"
+
+#include <QFile>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+static const int s_maxDisplay = 32;
+
+/**
+ * Creates the lock file of a display, taking over lock files of servers which are gone.
+ **/
+static bool lockDisplay(const QString &path)
+{
+    const QByteArray fileName = QFile::encodeName(path);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        const int fd = open(fileName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0444);
+        if (fd >= 0) {
+            const QByteArray pid = QByteArray::number(getpid()).rightJustified(10, ' ') + '\n';
+            const bool written = write(fd, pid.constData(), pid.size()) == pid.size();
+            close(fd);
+            if (!written) {
+                unlink(fileName.constData());
+            }
+            return written;
+        }
+        if (errno != EEXIST) {
+            return false;
+        }
+        QFile lockFile(path);
+        if (!lockFile.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        bool ok = false;
+        const pid_t owner = lockFile.readAll().trimmed().toInt(&ok);
+        if (!ok || owner <= 0 || kill(owner, 0) == 0 || errno != ESRCH) {
+            return false;
+        }
+        if (unlink(fileName.constData()) != 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+static int listenOn(const QByteArray &path, bool abstract)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    // the name of an abstract socket starts with a null byte
+    const int offset = abstract ? 1 : 0;
+    if (path.size() + offset >= int(sizeof(address.sun_path))) {
+        return -1;
+    }
+    memcpy(address.sun_path + offset, path.constData(), path.size());
+    const socklen_t size = offsetof(sockaddr_un, sun_path) + offset + path.size() + (abstract ? 0 : 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), size) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+XwaylandSocket::XwaylandSocket()
+{
+    if (mkdir("/tmp/.X11-unix", 01777) == 0) {
+        chmod("/tmp/.X11-unix", 01777);
+    }
+    for (int display = 0; display < s_maxDisplay; ++display) {
+        if (tryDisplay(display)) {
+            break;
+        }
+    }
+}
+
+XwaylandSocket::~XwaylandSocket()
+{
+    cleanup();
+}
+
+QString XwaylandSocket::name() const
+{
+    return QStringLiteral(":%1").arg(m_display);
+}
+
+bool XwaylandSocket::tryDisplay(int display)
+{
+    m_lockFilePath = QStringLiteral("/tmp/.X%1-lock").arg(display);
+    if (!lockDisplay(m_lockFilePath)) {
+        m_lockFilePath.clear();
+        return false;
+    }
+    m_socketFilePath = QStringLiteral("/tmp/.X11-unix/X%1").arg(display);
+    const QByteArray socketPath = QFile::encodeName(m_socketFilePath);
+    // the display is locked by us, a socket file left behind is stale
+    unlink(socketPath.constData());
+    int fd = listenOn(socketPath, false);
+    if (fd < 0) {
+        cleanup();
+        return false;
+    }
+    m_fileDescriptors << fd;
+#ifdef Q_OS_LINUX
+    fd = listenOn(socketPath, true);
+    if (fd < 0) {
+        cleanup();
+        return false;
+    }
+    m_fileDescriptors << fd;
+#endif
+    m_display = display;
+    return true;
+}
+
+void XwaylandSocket::cleanup()
+{
+    for (int fd : qAsConst(m_fileDescriptors)) {
+        close(fd);
+    }
+    m_fileDescriptors.clear();
+    if (!m_socketFilePath.isEmpty()) {
+        unlink(QFile::encodeName(m_socketFilePath).constData());
+        m_socketFilePath.clear();
+    }
+    if (!m_lockFilePath.isEmpty()) {
+        unlink(QFile::encodeName(m_lockFilePath).constData());
+        m_lockFilePath.clear();
+    }
+    m_display = -1;
+}
+
+}
+}
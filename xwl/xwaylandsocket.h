@@ -0,0 +1,57 @@
+// Copyright (C) 2022 Uniontech Technology Co., Ltd.
+// SPDX-FileCopyrightText: 2022 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef KWIN_XWL_XWAYLANDSOCKET
+#define KWIN_XWL_XWAYLANDSOCKET
+
+#include <QString>
+#include <QVector>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+/**
+ * @brief The listening sockets of an X11 display owned by KWin instead of Xwayland.
+ *
+ * Reserves the first free display number with its lock file and listens on the display's
+ * socket, so clients can connect before Xwayland runs. Xwayland takes the sockets over
+ * with its -listen argument. The lock file and the socket file get removed again on destruction.
+ **/
+class XwaylandSocket
+{
+public:
+    XwaylandSocket();
+    ~XwaylandSocket();
+
+    bool isValid() const {
+        return m_display != -1;
+    }
+    /**
+     * @returns the display name, for example ":1".
+     **/
+    QString name() const;
+    /**
+     * @returns the listening sockets, the file system one and on Linux the abstract one.
+     **/
+    QVector<int> fileDescriptors() const {
+        return m_fileDescriptors;
+    }
+
+private:
+    bool tryDisplay(int display);
+    void cleanup();
+
+    int m_display = -1;
+    QString m_lockFilePath;
+    QString m_socketFilePath;
+    QVector<int> m_fileDescriptors;
+};
+
+}
+}
+
+#endif